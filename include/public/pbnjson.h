@@ -111,6 +111,7 @@ extern "C" {
 #include "pbnjson/c/jerror.h"
 #include "pbnjson/c/jobject.h"
 #include "pbnjson/c/jschema.h"
+#include "pbnjson/c/jschema_generated.h"
 #include "pbnjson/c/jparse_stream.h"
 #include "pbnjson/c/jvalue_stringify.h"
 #include "pbnjson/c/jquery.h"
@@ -107,5 +107,6 @@ The following examples will show how to use it.
 #include "pbnjson/cxx/JResult.h"
 #include "pbnjson/cxx/JValidator.h"
 #include "pbnjson/cxx/JQuery.h"
+#include "pbnjson/cxx/JArena.h"
 
 #endif /* PJSONCXX_H_ */
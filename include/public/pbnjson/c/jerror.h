@@ -17,6 +17,7 @@
 #ifndef INCLUDE_PUBLIC_PBNJSON_C_JERROR_H_
 #define INCLUDE_PUBLIC_PBNJSON_C_JERROR_H_
 
+#include <stdbool.h>
 #include <string.h>
 #include "japi.h"
 
@@ -25,6 +26,15 @@
  */
 typedef struct jerror jerror;
 
+/**
+ * @brief Position in the parsed JSON text
+ */
+typedef struct jlocation {
+	size_t offset;  ///< Byte offset from the beginning of the text
+	size_t line;    ///< Line number, starting from 1
+	size_t column;  ///< Byte offset in the line, starting from 1
+} jlocation;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -55,6 +65,18 @@ PJSON_API void jerror_free(jerror *error);
  */
 PJSON_API int jerror_to_string(jerror *error, char *str, size_t size);
 
+/**
+ * Get the position in the parsed text where the error occurred.
+ *
+ * Syntax errors point to the place where the text can't be parsed further,
+ * validation errors point right after the value which doesn't match the schema.
+ *
+ * @param error    pbnjson error information.
+ * @param location Location to fill.
+ * @return true if the error has location, false for errors not related to parsed text.
+ */
+PJSON_API bool jerror_get_location(const jerror *error, jlocation *location);
+
 #ifdef __cplusplus
 }
 #endif
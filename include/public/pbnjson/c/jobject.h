@@ -93,6 +93,8 @@ extern "C" {
  *
  * @note Returns NULL if passed reference points to NULL
  * @note It is useless to call this API on the result of jnull() or jstring_empty(), although it is safe (effectively a NO-OP).
+ * @note The thread that created the value counts its references without atomic operations, so copying
+ *       and releasing is cheapest there. Other threads may share the value as well, but at a higher cost.
  */
 PJSON_API jvalue_ref jvalue_copy(jvalue_ref val);
 
@@ -142,10 +144,27 @@ PJSON_API int jvalue_compare(const jvalue_ref val, const jvalue_ref other) NON_N
  *
  * It is safe to call this as many times as you want on jnull(), jstring_empty(), or NULL.
  *
+ * If the last reference is released by a thread other than the one that created the value, the value
+ * may be freed later by its creator, when it creates values next time, calls j_release_pending or exits.
+ *
  * @param val A pointer to a value reference to release ownership for.  In DEBUG mode, the reference is changed to some garbage value afterwards.
  */
 PJSON_API void j_release(jvalue_ref *val);
 
+/**
+ * @brief Complete the releases other threads have passed to the calling thread.
+ *
+ * A thread counts the references to the values it has created without atomic operations.
+ * When other threads release such values, the creator finishes the release: it frees the
+ * values the next time it creates a value or when it exits. A thread that builds DOMs for
+ * others and then only waits (a producer handing documents to workers) should call this
+ * function once in a while, e.g. when it wakes up, otherwise the DOMs the workers have
+ * released stay allocated till it creates values again.
+ *
+ * @return Number of values whose releases have been completed, the freed ones included
+ */
+PJSON_API size_t j_release_pending(void);
+
 /**
  * @brief Returns a reference to a value representing an invalid JSON null value.
  *
@@ -221,6 +240,42 @@ PJSON_API bool jvalue_check_schema(jvalue_ref val, const JSchemaInfoRef schema)
  */
 PJSON_API bool jvalue_validate(const jvalue_ref val, const jschema_ref schema, jerror **err) NON_NULL(1, 2);
 
+/**
+ * @brief Check validity of jvalue against the schema, checking repeated subtrees once.
+ *
+ * Same as @ref jvalue_validate, but every object or array found valid against
+ * a subschema is remembered for the rest of the call. Subtrees structurally equal
+ * to a remembered one aren't validated again against the same subschema. This pays
+ * off for documents repeating big subtrees, otherwise plain @ref jvalue_validate is faster.
+ * Note, that jvalue_validate remembers only the subtrees shared by reference.
+ *
+ * @param val A reference to the JSON object to check
+ * @param schema A schema
+ * @param err pbnjson error information
+ * @return true, if val is valid against schema, false otherwise
+ */
+PJSON_API bool jvalue_validate_dedup(const jvalue_ref val, const jschema_ref schema, jerror **err) NON_NULL(1, 2);
+
+/**
+ * @brief Find all the schemas accepting jvalue in one pass over it.
+ *
+ * Equivalent to calling @ref jvalue_validate for every schema, but the value
+ * is traversed once, and every event is checked against the schemas, which
+ * haven't failed yet. Scalar properties of objects are checked before the nested
+ * objects and arrays, so the schemas are told apart early by discriminating
+ * properties like "method" or "type". The traversal stops as soon as no
+ * candidate is left.
+ *
+ * @param val A reference to the JSON value to check
+ * @param schemas Candidate schemas
+ * @param count Number of the schemas
+ * @param matches Array of at least count elements, receives indexes of the accepting
+ *                schemas in ascending order
+ * @return Number of the schemas accepting val
+ */
+PJSON_API size_t jvalue_validate_many(const jvalue_ref val, const jschema_ref schemas[], size_t count,
+                                      size_t *matches) NON_NULL(1, 2, 4);
+
 /**
  * @brief jvalue_apply_schema is similar to jvalue_check_schema.
  *
@@ -348,6 +403,28 @@ PJSON_API jvalue_ref jobject_create_var(jobject_key_value item, ...);
  */
 PJSON_API jvalue_ref jobject_create_hint(int capacityHint);
 
+/**
+ * @brief Create a JSON object from parallel arrays of keys and values.
+ *
+ * Create a JSON object from parallel arrays of keys and values. This is cheaper than
+ * calling jobject_put for every key: the new object can't be referenced by any of the
+ * values, so no hierarchy checks are done, and each key is hashed once.
+ *
+ * Keys are only borrowed, so the same array of keys (e.g. created once with
+ * J_CSTR_TO_JVAL) can be used to build any number of objects. Ownership of the values
+ * is transferred to the object, NULL and invalid values are stored as JSON null.
+ *
+ * @param keys Non-empty JSON strings to use as the keys
+ * @param values Values to put under the keys
+ * @param count Number of elements in both arrays
+ *
+ * @return A JSON object, or an invalid value if a key isn't a non-empty string or
+ *         if there are duplicate keys. The values are released in that case.
+ *
+ * @see jobject_put
+ */
+PJSON_API jvalue_ref jobject_create_from_arrays(jvalue_ref const keys[], jvalue_ref const values[], size_t count);
+
 /**
  * @brief Check if a JSON value reference an object or not.
  *
@@ -742,6 +819,11 @@ PJSON_API bool jarray_append(jvalue_ref arr, jvalue_ref val) NON_NULL(1, 2);
  * @param ownership What to do with the elements going from array2 into array1.  You can transfer ownership (meaning the element is then owned
  *                  by array1) or copy (meaning a copy of the element is used to insert into array1 when splicing, but array2 retains ownership as well)
  *
+ * The element pointers are moved in blocks, so the cost doesn't depend on the amount of references taken or released.
+ * With SPLICE_TRANSFER the range [begin, end) is removed from array2, which shrinks accordingly.
+ * Only the inserted elements are checked for cycles, elements spliced within the same array are never checked.
+ * Transferring elements of an array into itself isn't supported.
+ *
  * @see jarray_splice_inject
  * @see jarray_splice_append
  */
@@ -956,6 +1038,44 @@ static inline void jstring_free_buffer(raw_buffer str)
  */
 PJSON_API raw_buffer jstring_get_fast(jvalue_ref str) NON_NULL(1);
 
+/**
+ * @brief Create an iterator through the chunks of the string
+ *
+ * Large string values parsed by the DOM parser are stored as a chain of chunks
+ * (see jdomparser_set_string_chunking). The iterator passes through them without
+ * flattening the string, like jstring_get_fast does on its first call. Other strings
+ * have a single chunk. Serialization, comparison, copying and validation of the
+ * value walk the chunks as well, only jstring_get_fast makes the flat text.
+ *
+ * NOTE: It is assumed that ownership of str is maintained for the lifetime of the iterator by the caller.
+ *
+ * @param iter Pointer to an iterator instance to be initialized
+ * @param str The JSON string to iterate over
+ * @return true if iterator was created, false if the JSON value isn't a string.
+ */
+PJSON_API bool jstring_chunk_iter_init(jstring_chunk_iter *iter, jvalue_ref str);
+
+/**
+ * @brief Obtain the next chunk of the string
+ *
+ * Typical usage is the following:
+  @code
+    jstring_chunk_iter it;
+    raw_buffer chunk;
+
+    jstring_chunk_iter_init(&it, str);
+    while (jstring_chunk_iter_next(&it, &chunk))
+    {
+        // Do whatever is needed with the chunk
+    }
+  @endcode
+ *
+ * @param iter The iterator to use
+ * @param chunk Buffer to capture the chunk, which is not NULL-terminated and never empty.
+ * @return true if the chunk is obtained, false if the end is reached.
+ */
+PJSON_API bool jstring_chunk_iter_next(jstring_chunk_iter *iter, raw_buffer *chunk);
+
 /**
  * @brief Determines whether or not this JSON string matches another JSON string
  *
@@ -1351,6 +1471,199 @@ PJSON_API jvalue_ref jboolean_create(bool value) PURE_FUNC;
  */
 PJSON_API ConversionResultFlags jboolean_get(jvalue_ref val, bool *value) NON_NULL(1);
 
+/*** JSON Snapshot operations ***/
+
+/**
+ * @brief Create a snapshot holder for a DOM shared between threads.
+ *
+ * The snapshot publishes immutable versions of a DOM. Readers pin the current version
+ * without taking locks, while a writer publishes the next one. Published DOM must not be
+ * modified by anyone; build a new version (see jvalue_duplicate) and publish it instead.
+ *
+ * Pinned DOM may be read from any number of threads with read-only accessors. Note that
+ * jvalue_stringify caches the text inside the value, so it isn't read-only.
+ *
+ * @param dom The first version. Ownership is transferred to the snapshot.
+ * @return The snapshot, NULL on failure
+ *
+ * @see jsnapshot_publish
+ * @see jsnapshot_pin
+ */
+PJSON_API jsnapshot_ref jsnapshot_create(jvalue_ref dom);
+
+/**
+ * @brief Free the snapshot with its versions. No version may be pinned.
+ */
+PJSON_API void jsnapshot_free(jsnapshot_ref snapshot);
+
+/**
+ * @brief Publish the next version of the DOM atomically.
+ *
+ * Readers pinning the snapshot after the call returns get the new version. The previous
+ * version is freed as soon as it isn't pinned anymore: either right away, or when the
+ * snapshot is published or reclaimed next time. Publishing is serialized between writers.
+ *
+ * @param snapshot The snapshot
+ * @param dom The new version. Ownership is transferred to the snapshot.
+ *
+ * @see jsnapshot_reclaim
+ */
+PJSON_API void jsnapshot_publish(jsnapshot_ref snapshot, jvalue_ref dom) NON_NULL(1);
+
+/**
+ * @brief Free the previous versions that have been unpinned since the last publication.
+ *
+ * @return Number of versions still waiting for their readers
+ */
+PJSON_API size_t jsnapshot_reclaim(jsnapshot_ref snapshot) NON_NULL(1);
+
+/**
+ * @brief Pin the current version of the DOM.
+ *
+ * Pinning doesn't take locks and doesn't touch reference counters of the DOM,
+ * so it scales with the number of reader threads. The version stays valid until
+ * it is unpinned, possibly from another thread.
+ *
+ * @param snapshot The snapshot
+ * @return The pinned version
+ *
+ * @see jsnapshot_version_get
+ * @see jsnapshot_unpin
+ */
+PJSON_API jsnapshot_version_ref jsnapshot_pin(jsnapshot_ref snapshot) NON_NULL(1);
+
+/**
+ * @brief Get the DOM of the pinned version.
+ *
+ * @return DOM owned by the version. Use jvalue_copy to keep it past jsnapshot_unpin.
+ */
+PJSON_API jvalue_ref jsnapshot_version_get(jsnapshot_version_ref version) NON_NULL(1);
+
+/**
+ * @brief Unpin the version returned by jsnapshot_pin.
+ */
+PJSON_API void jsnapshot_unpin(jsnapshot_version_ref version) NON_NULL(1);
+
+/*** JSON Shared memory operations ***/
+
+/**
+ * @brief Place a copy of the DOM into a new named shared memory segment.
+ *
+ * The segment holds a read-only DOM that other processes attach and query with the usual
+ * accessors (jobject_get, jarray_get, jstring_get_fast, ...) without parsing the
+ * JSON again. Values in the segment refer to each other by offsets, so it works at any
+ * mapping address. Identical object keys are stored once.
+ *
+ * The segment is created with mode 0644 and stays in the system until jshared_unlink.
+ * Processes attaching the name before this function returns get an error.
+ *
+ * @param name POSIX shared memory name, like "/config"
+ * @param dom The DOM to copy
+ * @param err Error information. Pass NULL if it isn't required.
+ * @return true if the segment is created
+ *
+ * @see jshared_attach
+ */
+PJSON_API bool jshared_publish(const char *name, jvalue_ref dom, jerror **err) NON_NULL(1, 2);
+
+/**
+ * @brief Map the segment created by jshared_publish, possibly in another process.
+ *
+ * @param name POSIX shared memory name
+ * @param err Error information. Pass NULL if it isn't required.
+ * @return The attached segment, NULL on failure
+ *
+ * @see jshared_root
+ * @see jshared_detach
+ */
+PJSON_API jshared_ref jshared_attach(const char *name, jerror **err) NON_NULL(1);
+
+/**
+ * @brief Get the DOM of the attached segment.
+ *
+ * Values of the segment aren't reference counted: jvalue_copy and j_release do nothing,
+ * and they may be read from any number of threads. Functions modifying objects or arrays
+ * refuse them; use jvalue_duplicate to get a modifiable copy. The values stay valid until
+ * jshared_detach, even if they are put into other DOMs.
+ *
+ * @return DOM owned by the segment
+ */
+PJSON_API jvalue_ref jshared_root(jshared_ref shared) NON_NULL(1);
+
+/**
+ * @brief Unmap the segment. Its values mustn't be used afterwards.
+ */
+PJSON_API void jshared_detach(jshared_ref shared);
+
+/**
+ * @brief Remove the segment name from the system.
+ *
+ * The memory is released when the last process detaches it.
+ *
+ * @return true if the name has been removed
+ */
+PJSON_API bool jshared_unlink(const char *name) NON_NULL(1);
+
+/**
+ * @brief Repack a long-lived DOM into one contiguous block.
+ *
+ * DOMs built up by many edits end up scattered over the heap. The compacted copy has
+ * the layout of a shared segment (see jshared_publish) in a single heap block: values
+ * in depth-first order, strings and raw numbers inline next to their nodes, object
+ * members ordered for a binary search. The DOM is replaced in place from the caller's
+ * view: the reference in *dom is released and replaced with the root of the block.
+ * Other references to the old DOM keep seeing it as it was.
+ *
+ * The compacted values are reference counted as a whole: a reference to any of them
+ * keeps the block alive, and they may be copied and released from any thread.
+ * Functions modifying objects or arrays refuse them; use jvalue_duplicate to get
+ * a modifiable copy.
+ *
+ * @param dom The reference to the DOM to compact, a null or a boolean is left as is
+ * @return true on success, false on failure, *dom isn't changed then
+ */
+PJSON_API bool jvalue_compact(jvalue_ref *dom) NON_NULL(1);
+
+/*** JSON Arena operations ***/
+
+/**
+ * @brief Create an arena for the values of a short-lived scope, like a request.
+ *
+ * While the arena is current for a thread, the values the thread creates (parsers,
+ * jobject_create, jstring_create, jvalue_duplicate, ...) are bump allocated from the arena.
+ * Arena values aren't reference counted: jvalue_copy and j_release do nothing, and all of
+ * them are released at once by jarena_free. Values created outside of the arena and put
+ * into arena objects or arrays are released then as usual.
+ *
+ * Arena values mustn't outlive the arena. To keep one, make its jvalue_duplicate while
+ * no arena is current. Schemas never use the arena.
+ *
+ * @return The arena, NULL if out of memory
+ *
+ * @see jarena_set_current
+ */
+PJSON_API jarena_ref jarena_create(void);
+
+/**
+ * @brief Make the arena current for the calling thread.
+ *
+ * @param arena The arena, NULL to allocate values from the heap
+ * @return The arena which was current before, to be restored at the end of the scope
+ */
+PJSON_API jarena_ref jarena_set_current(jarena_ref arena);
+
+/**
+ * @brief Get the number of bytes taken from the arena by its values.
+ */
+PJSON_API size_t jarena_size(jarena_ref arena) NON_NULL(1);
+
+/**
+ * @brief Release the arena with all its values.
+ *
+ * The arena mustn't be current for any thread.
+ */
+PJSON_API void jarena_free(jarena_ref arena);
+
 /**
  * @brief Convenience method to construct a jobject_key_value structure.
  *
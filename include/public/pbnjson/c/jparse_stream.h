@@ -54,6 +54,22 @@ extern "C" {
  */
 PJSON_API jvalue_ref jdom_fcreate(const char *file, const jschema_ref schema, jerror **err) NON_NULL(1, 2);
 
+/**
+ * @brief Returns the DOM structure of the JSON document contained within the given, possibly compressed, file.
+ *
+ * Gzip and zstd compressed files are recognized by their content and decompressed on the fly,
+ * other files are parsed as is. The file is decompressed in small chunks on a separate thread while the
+ * parser consumes the chunks already decompressed, so memory use doesn't grow with the size of the input.
+ * Support of every format depends on the libraries available at build time.
+ *
+ * @param file The c-string representing the path to parse.
+ * @param schema The schema to use for validation of the input.
+ * @param err Error pointer. Will be set to non-null value in case of failure.
+ * @return An opaque reference handle to the DOM.  Use jis_valid to determine whether or
+ *         not parsing succeeded.
+ */
+PJSON_API jvalue_ref jdom_fcreate_compressed(const char *file, const jschema_ref schema, jerror **err) NON_NULL(1, 2);
+
 /**
  * @brief Returns the DOM structure of the JSON document contained within the given file.
  *
@@ -178,6 +194,46 @@ PJSON_API void jsax_changeContext(JSAXContextRef saxCtxt, void *userCtxt);
  */
 PJSON_API void* jsax_getContext(JSAXContextRef saxCtxt);
 
+/**
+ * @brief Returns the position of the current parsing event in the text
+ *
+ * Can be called from the parsing callbacks to find out where the value or the key
+ * has been parsed. Lines are counted only when the position is asked for.
+ *
+ * @param saxCtxt Parsing context passed to the callback
+ * @param location Location right after the value or the key of the event
+ * @return false if the context doesn't belong to a parser (for example, the context of
+ *         an error reported by jvalue validation).
+ *
+ * @see jsaxparser_get_location
+ */
+PJSON_API bool jsax_get_location(JSAXContextRef saxCtxt, jlocation *location);
+
+/**
+ * @brief Select the tokenizer of the parsers
+ *
+ * The tokenizer splits JSON text into the parsing events. The selection is
+ * process-wide and applies to the parsers initialized afterwards, parsers in
+ * progress keep their tokenizer. "yajl" is the default one.
+ *
+ * @param name Name of the tokenizer, see jparse_tokenizer_name
+ * @return false if there is no tokenizer with such name
+ */
+PJSON_API bool jparse_set_tokenizer(const char *name);
+
+/**
+ * @brief Name of the tokenizer used by the new parsers
+ */
+PJSON_API const char *jparse_get_tokenizer(void);
+
+/**
+ * @brief Enumerate available tokenizers
+ *
+ * @param index Index of the tokenizer, starting from 0
+ * @return Name of the tokenizer, or NULL past the last one
+ */
+PJSON_API const char *jparse_tokenizer_name(size_t index);
+
 /**
  * @brief Create and initialize SAX stream parser
  *
@@ -218,6 +274,20 @@ jsaxparser_ref jsaxparser_create(JSchemaInfoRef schemaInfo, PJSAXCallbacks *call
  */
 PJSON_API bool jsaxparser_feed(jsaxparser_ref parser, const char *buf, int buf_len);
 
+/**
+ * @brief Parse the content of the given, possibly compressed, file.
+ *
+ * The file is decompressed in chunks the same way as in jdom_fcreate_compressed, and every chunk is passed
+ * to jsaxparser_feed. Call jsaxparser_end afterwards to complete parsing.
+ *
+ * @param parser Pointer to SAX parser
+ * @param file The c-string representing the path to parse.
+ * @param err Error pointer. Will be set to non-null value if the file can't be read or decompressed.
+ *            Parsing errors are reported by jsaxparser_get_error.
+ * @return false on error
+ */
+PJSON_API bool jsaxparser_feed_compressed(jsaxparser_ref parser, const char *file, jerror **err);
+
 /**
  * @brief Finalize stream parsing
  *
@@ -247,6 +317,38 @@ PJSON_API void jsaxparser_release(jsaxparser_ref *parser);
  */
 PJSON_API const char* jsaxparser_get_error(jsaxparser_ref parser);
 
+/**
+ * @brief Return the position of the parser in the text
+ *
+ * Return the position of the parser in the text fed so far. Within the parsing callbacks it's the position
+ * right after the value or the key of the event. After jsaxparser_feed/jsaxparser_end has returned false,
+ * it's the position where parsing has stopped, which is also reported by jerror_get_location.
+ *
+ * @param parser Pointer to SAX parser
+ * @param location Location to fill
+ * @return false if the parser is NULL
+ */
+PJSON_API bool jsaxparser_get_location(jsaxparser_ref parser, jlocation *location);
+
+/**
+ * @brief Deliver long string values in fragments
+ *
+ * String values which take at least threshold bytes in the text aren't gathered in
+ * memory as a whole. Their content is unescaped as the text is fed, and passed to
+ * the callback in fragments instead of m_string. The last fragment, which may be
+ * empty, comes with last set. Object keys and shorter strings are passed as usual.
+ *
+ * Strings are validated as a whole, so the fragments are delivered only when the
+ * parser doesn't validate the values, that is its schema is jschema_all().
+ * Call it before the first jsaxparser_feed.
+ *
+ * @param parser Pointer to SAX parser
+ * @param callback Callback receiving the fragments, it returns 0 to stop parsing.
+ * @param threshold Length of the text of the shortest string to split, 0 to pass all strings whole.
+ * @return false if the schema of the parser needs strings whole
+ */
+PJSON_API bool jsaxparser_set_string_fragments(jsaxparser_ref parser, jsax_string_fragment callback, size_t threshold);
+
 /**
  * @brief Create and initialize DOM stream parser
  *
@@ -311,6 +413,31 @@ PJSON_API void jdomparser_release(jdomparser_ref *parser);
  */
 PJSON_API const char* jdomparser_get_error(jdomparser_ref parser);
 
+/**
+ * @brief Return the position of the parser in the text
+ *
+ * @param parser Pointer to DOM parser
+ * @param location Location to fill
+ * @return false if the parser is NULL
+ *
+ * @see jsaxparser_get_location
+ */
+PJSON_API bool jdomparser_get_location(jdomparser_ref parser, jlocation *location);
+
+/**
+ * @brief Store long string values as chains of chunks
+ *
+ * The DOM parser initialized with jdomparser_new or jdomparser_init receives string values
+ * of 64 KiB and longer in fragments (see jsaxparser_set_string_fragments), and stores them
+ * as chains of chunks, iterated by jstring_chunk_iter_next. jstring_get_fast makes the text
+ * of such string contiguous on demand. The function changes the threshold.
+ *
+ * @param parser Pointer to DOM parser
+ * @param threshold Length of the text of the shortest string to store in chunks, 0 to store all strings whole.
+ * @return false if the schema of the parser needs strings whole
+ */
+PJSON_API bool jdomparser_set_string_chunking(jdomparser_ref parser, size_t threshold);
+
 /**
  * @brief Return root jvalue for parsed JSON
  *
@@ -321,6 +448,121 @@ PJSON_API const char* jdomparser_get_error(jdomparser_ref parser);
  */
 PJSON_API jvalue_ref jdomparser_get_result(jdomparser_ref parser);
 
+/**
+ * @brief Output function of the JSON re-formatter
+ *
+ * @param ctxt Context given to jreformatter_new()
+ * @param buf Next piece of the output
+ * @param len Length of the piece
+ * @return false to stop re-formatting
+ */
+typedef bool (*jreformat_write)(void *ctxt, const char *buf, size_t len);
+
+/**
+ * @brief Create stream re-formatter
+ *
+ * The re-formatter parses JSON chunk-by-chunk and writes it back in the
+ * chosen format without building a DOM: minified if indent is NULL,
+ * pretty-printed (like jvalue_prettify()) otherwise. Memory usage doesn't
+ * depend on the document size, the output is passed to the write function
+ * in pieces of limited size. Strings are copied to the output with the escapes
+ * of the input. A string split between the fed chunks is written with the
+ * escapes of jvalue_stringify() instead, as are the strings of hashed values.
+ *
+ * @param schema The schema to validate the input, jschema_all() to accept any JSON
+ * @param indent Indent for pretty-printed format or NULL for minified output.
+ *               Allowed symbols: \n, \v, \f, \t, \r and space.
+ * @param write Output function
+ * @param ctxt Context for the output function
+ * @return pointer to the re-formatter
+ */
+PJSON_API jreformatter_ref jreformatter_new(const jschema_ref schema, const char *indent,
+                                            jreformat_write write, void *ctxt) NON_NULL(1, 3);
+
+/**
+ * @brief Transformation applied by a re-formatter rule
+ */
+typedef enum {
+	JREFORMAT_KEEP,     ///< Keep the value. Once a keep rule is added, everything else is dropped.
+	JREFORMAT_DROP,     ///< Drop the value (with its key in an object)
+	JREFORMAT_REPLACE,  ///< Replace the value with a constant
+	JREFORMAT_HASH,     ///< Replace the value with hex SHA-256 digest of its minified text
+} jreformat_action;
+
+/**
+ * @brief Add projection/redaction rule to the re-formatter
+ *
+ * Values are selected by JSON Pointer (RFC 6901), with the extension that
+ * the segment "*" matches any member of an object or element of an array:
+ * the pointer of segments "users", "*" and "password" selects passwords of
+ * all the users. Rules are matched
+ * against the input paths while parsing, so dropped and replaced subtrees
+ * are skipped without being serialized. If several rules select the same
+ * value, the earliest added one applies. Rules of the descendants of kept
+ * values still apply, the content of replaced and hashed values is not
+ * filtered.
+ *
+ * Rules should be added before the first jreformatter_feed().
+ *
+ * @param reformatter Pointer to the re-formatter
+ * @param pointer JSON Pointer of the values, "" selects the whole document
+ * @param action What to do with the selected values
+ * @param replacement Value to output instead of the selected one for JREFORMAT_REPLACE, ignored otherwise
+ * @return false if pointer is malformed or replacement is missing
+ */
+PJSON_API bool jreformatter_add_rule(jreformatter_ref reformatter, const char *pointer,
+                                     jreformat_action action, jvalue_ref replacement) NON_NULL(1, 2);
+
+/**
+ * @brief Re-format part of JSON from input buffer
+ *
+ * @param reformatter Pointer to the re-formatter
+ * @param buf Input buffer
+ * @param buf_len Input buffer length
+ * @return false on error
+ */
+PJSON_API bool jreformatter_feed(jreformatter_ref reformatter, const char *buf, int buf_len);
+
+/**
+ * @brief Finalize re-formatting and flush the rest of the output
+ *
+ * @param reformatter Pointer to the re-formatter
+ * @return false on error
+ */
+PJSON_API bool jreformatter_end(jreformatter_ref reformatter);
+
+/**
+ * @brief Release re-formatter created by jreformatter_new
+ *
+ * @param reformatter Pointer to the re-formatter
+ */
+PJSON_API void jreformatter_release(jreformatter_ref *reformatter);
+
+/**
+ * @brief Return error description. It can be called when jreformatter_feed/jreformatter_end has returned false
+ *
+ * @param reformatter Pointer to the re-formatter
+ * @return Pointer to string with error description. The pointer should not be released manually.
+ *         It will be released in jreformatter_release.
+ */
+PJSON_API const char* jreformatter_get_error(jreformatter_ref reformatter);
+
+/**
+ * @brief Re-format JSON from the buffer
+ *
+ * Same as feeding the whole input to a re-formatter, see jreformatter_new().
+ *
+ * @param input JSON to re-format
+ * @param schema The schema to validate the input
+ * @param indent Indent for pretty-printed format or NULL for minified output
+ * @param write Output function
+ * @param ctxt Context for the output function
+ * @param err pbnjson error information
+ * @return true on success
+ */
+PJSON_API bool jreformat(raw_buffer input, const jschema_ref schema, const char *indent,
+                         jreformat_write write, void *ctxt, jerror **err) NON_NULL(2, 4);
+
 #ifdef __cplusplus
 }
 #endif
@@ -32,6 +32,7 @@ typedef int (*jsax_object_key)(JSAXContextRef ctxt, const char *key, size_t keyL
 typedef int (*jsax_object_end)(JSAXContextRef ctxt);
 typedef int (*jsax_array_start)(JSAXContextRef ctxt);
 typedef int (*jsax_array_end)(JSAXContextRef ctxt);
+typedef int (*jsax_string_fragment)(JSAXContextRef ctxt, const char *fragment, size_t fragmentLen, bool last);
 
 /**
   * @brief The structure contains set of callbacks, that will be called during parsing of JSON string. The structure is used in JSON SAX parser
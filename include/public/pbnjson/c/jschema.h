@@ -224,6 +224,63 @@ PJSON_API jschema_ref jschema_jcreate(jvalue_ref input, jerror **err);
  */
 PJSON_API jschema_ref jschema_fcreate(const char *file, jerror **err);
 
+/**
+ * Creates an empty reloadable set of schema files.
+ *
+ * The set keeps compiled schemas of its files together with every document they
+ * reference by "$ref" (resolved as files relative to the referring one).
+ * jschema_set_refresh() re-reads only the changed files and rebuilds only the schemas
+ * depending on them, then publishes the new version at once. Schemas taken from
+ * the set before stay valid until released, so in-flight validations finish
+ * against the version they have started with.
+ *
+ * @return A new schema set
+ */
+PJSON_API jschema_set_ref jschema_set_new(void);
+
+/**
+ * Releases the schema set. Schemas taken from the set stay valid until released.
+ *
+ * @param set The set to release
+ */
+PJSON_API void jschema_set_release(jschema_set_ref *set) NON_NULL(1);
+
+/**
+ * Adds a schema file to the set, compiling it with all the referenced documents.
+ *
+ * @param set The schema set
+ * @param file The file path to the schema
+ * @param err pbnjson error information
+ * @return true on success, false if the schema or any document it references
+ *         can't be loaded. The set isn't changed then.
+ */
+PJSON_API bool jschema_set_add_file(jschema_set_ref set, const char *file, jerror **err) NON_NULL(1, 2);
+
+/**
+ * Returns the current version of a schema from the set. The call is thread-safe.
+ *
+ * @param set The schema set
+ * @param file The file path, exactly as given to jschema_set_add_file()
+ * @return A reference to the schema, which should be released by jschema_release(),
+ *         or NULL if the file isn't in the set
+ */
+PJSON_API jschema_ref jschema_set_get(jschema_set_ref set, const char *file) NON_NULL(1, 2);
+
+/**
+ * Checks the files of the set for modifications and rebuilds affected schemas.
+ *
+ * Files are compared by modification time, size and inode, so the call is cheap
+ * when nothing has changed and may be issued periodically or from a file system
+ * watch. Changed documents are parsed again, schemas, which don't reference them,
+ * are kept as they are. Either all the affected schemas are rebuilt and published
+ * together, or the set is left unchanged.
+ *
+ * @param set The schema set
+ * @param err pbnjson error information
+ * @return Number of rebuilt schemas, or -1 if some of them couldn't be rebuilt
+ */
+PJSON_API int jschema_set_refresh(jschema_set_ref set, jerror **err) NON_NULL(1);
+
 #ifdef __cplusplus
 }
 #endif
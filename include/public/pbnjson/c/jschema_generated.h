@@ -0,0 +1,269 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef J_SCHEMA_GENERATED_H_
+#define J_SCHEMA_GENERATED_H_
+
+#include "japi.h"
+#include "jtypes.h"
+#include "jschema_types.h"
+#include "compiler/nonnull_attribute.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \file
+ * Support functions for the validators generated by pbnjson_schemac.
+ *
+ * The generated code checks types, keys and sizes by itself. The checks
+ * below share the implementation with the schema interpreter, so that
+ * both give identical results: numbers are compared exactly in decimal,
+ * and patterns are matched by the same regular expression engine.
+ */
+
+/**
+ * Number constant of a schema, parsed on the first use
+ */
+typedef struct jschema_gen_number {
+	const char *text;         /**< Decimal text, NULL if the constraint isn't set */
+	void *parsed;             /**< Should be initialized to NULL */
+} jschema_gen_number;
+
+/**
+ * Numeric constraints of a schema
+ */
+typedef struct jschema_gen_number_limits {
+	jschema_gen_number minimum;
+	jschema_gen_number maximum;
+	jschema_gen_number multiple_of;
+	bool exclusive_minimum;
+	bool exclusive_maximum;
+	bool integer;             /**< The number should be an integer */
+} jschema_gen_number_limits;
+
+/**
+ * Pattern of a schema, compiled on the first use
+ */
+typedef struct jschema_gen_pattern {
+	const char *source;       /**< ECMA-262 regular expression */
+	void *matcher;            /**< Should be initialized to NULL */
+} jschema_gen_pattern;
+
+/**
+ * Check the number against the numeric constraints
+ *
+ * @param number JSON number
+ * @param limits Constraints to check
+ * @return true if the number satisfies all the constraints
+ */
+PJSON_API bool jschema_gen_check_number(jvalue_ref number, jschema_gen_number_limits *limits) NON_NULL(1, 2);
+
+/**
+ * Check the text of a number against the numeric constraints
+ *
+ * @param str Number as it appears in JSON
+ * @param len Length of the text
+ * @param limits Constraints to check
+ * @return true if the number satisfies all the constraints
+ */
+PJSON_API bool jschema_gen_check_number_text(const char *str, size_t len, jschema_gen_number_limits *limits) NON_NULL(1, 3);
+
+/**
+ * Check if the number is equal to one of the constants, as in "enum"
+ *
+ * @param number JSON number
+ * @param constants Constants to compare with
+ * @param count Number of the constants
+ * @return true if some constant is equal to the number
+ */
+PJSON_API bool jschema_gen_number_in(jvalue_ref number, jschema_gen_number *constants, size_t count) NON_NULL(1, 2);
+
+/**
+ * Check if the text of a number is equal to one of the constants, as in "enum"
+ *
+ * @param str Number as it appears in JSON
+ * @param len Length of the text
+ * @param constants Constants to compare with
+ * @param count Number of the constants
+ * @return true if some constant is equal to the number
+ */
+PJSON_API bool jschema_gen_number_in_text(const char *str, size_t len, jschema_gen_number *constants, size_t count) NON_NULL(1, 3);
+
+/**
+ * Check if the pattern matches somewhere in the string
+ *
+ * @param pattern Pattern, which is compiled and stored on the first call
+ * @param str UTF-8 string
+ * @param len Length of the string in bytes
+ * @return true if the pattern matches, false if it doesn't or can't be compiled
+ */
+PJSON_API bool jschema_gen_match(jschema_gen_pattern *pattern, const char *str, size_t len) NON_NULL(1);
+
+/**
+ * Check if all the elements of the array are distinct, as in "uniqueItems"
+ *
+ * @param arr JSON array
+ * @return true if the array has no duplicates
+ */
+PJSON_API bool jschema_gen_unique_items(jvalue_ref arr) NON_NULL(1);
+
+/**
+ * @name Event-driven validation
+ *
+ * The generated validators check the values as the parser reports them, without
+ * building a DOM, unless the schema uses combinators ("allOf", "anyOf", "oneOf",
+ * "not", "extends") or other checks of a whole value ("uniqueItems", several
+ * schemas for one property). Such validators build the value from the events,
+ * and check it with the DOM code when it's complete.
+ * @{
+ */
+
+/**
+ * Kind of a parser event
+ */
+typedef enum jschema_gen_event_type {
+	JSCHEMA_GEN_NULL,
+	JSCHEMA_GEN_BOOLEAN,
+	JSCHEMA_GEN_NUMBER,
+	JSCHEMA_GEN_STRING,
+	JSCHEMA_GEN_OBJECT_START,
+	JSCHEMA_GEN_OBJECT_KEY,
+	JSCHEMA_GEN_OBJECT_END,
+	JSCHEMA_GEN_ARRAY_START,
+	JSCHEMA_GEN_ARRAY_END,
+} jschema_gen_event_type;
+
+/**
+ * Parser event, as the callbacks of jsaxparser see it
+ */
+typedef struct jschema_gen_event {
+	jschema_gen_event_type type;
+	const char *str;          /**< Text of a number, a string or a key */
+	size_t len;               /**< Length of the text in bytes */
+	bool boolean;             /**< Value of a boolean */
+} jschema_gen_event;
+
+typedef struct jschema_gen_sax_state jschema_gen_sax_state;
+typedef struct jschema_gen_frame jschema_gen_frame;
+
+/**
+ * Check of a value, which starts with the event. Objects and arrays push a frame.
+ */
+typedef bool (*jschema_gen_value_func)(jschema_gen_sax_state *s, const jschema_gen_event *e);
+
+/**
+ * Check of the events inside of an object or an array. The frame is popped at its end.
+ */
+typedef bool (*jschema_gen_frame_func)(jschema_gen_sax_state *s, jschema_gen_frame *f, const jschema_gen_event *e);
+
+/**
+ * Object or array being checked
+ */
+struct jschema_gen_frame {
+	jschema_gen_frame_func check;
+	jschema_gen_value_func value;   /**< Check of the value of the current property */
+	size_t count;                   /**< Properties or items seen, nesting of an unchecked value */
+	uint64_t seen;                  /**< Bits of the required properties seen */
+};
+
+/**
+ * Validator generated by pbnjson_schemac
+ */
+typedef struct jschema_gen_validator {
+	jschema_gen_value_func events;        /**< Event-driven check, NULL if the value is checked as a DOM */
+	bool (*validate)(jvalue_ref value);   /**< Check of a DOM value */
+} jschema_gen_validator;
+
+/**
+ * State of the event-driven validation of one value, opaque for the users
+ */
+struct jschema_gen_sax_state {
+	const jschema_gen_validator *validator;
+	jschema_gen_frame *frames;
+	size_t depth;
+	size_t capacity;
+	bool started;
+	void *dom;                /**< Value being built for the validators without events */
+};
+
+/**
+ * Prepare the validation of a value
+ *
+ * @param s State to initialize
+ * @param validator Generated validator, like <name>_validator
+ */
+PJSON_API void jschema_gen_sax_init(jschema_gen_sax_state *s, const jschema_gen_validator *validator) NON_NULL(1, 2);
+
+/**
+ * Release the resources of the validation
+ */
+PJSON_API void jschema_gen_sax_clear(jschema_gen_sax_state *s) NON_NULL(1);
+
+/**
+ * Check the next parser event
+ *
+ * @param s Validation state
+ * @param e Event of the parser
+ * @return false if the value is invalid, the validation can't continue then
+ */
+PJSON_API bool jschema_gen_sax_check(jschema_gen_sax_state *s, const jschema_gen_event *e) NON_NULL(1, 2);
+
+/**
+ * Check if the whole value has been checked successfully
+ */
+PJSON_API bool jschema_gen_sax_complete(const jschema_gen_sax_state *s) NON_NULL(1);
+
+/**
+ * Schema for the parsers and jvalue_validate, which checks values with the generated code
+ *
+ * The schema is used like the one from jschema_create: jsaxparser_new, jdomparser_new
+ * and JDomParser drive the generated code by the parser events. Default values
+ * aren't inserted into the DOM, the generated code ignores "default".
+ *
+ * @param validator Generated validator, like <name>_validator
+ * @return New schema, which should be released with jschema_release
+ */
+PJSON_API jschema_ref jschema_gen_create(const jschema_gen_validator *validator) NON_NULL(1);
+
+/** @} */
+
+/**
+ * @name Helpers of the generated event-driven code
+ * @{
+ */
+
+/** Start checking an object or an array with the function */
+PJSON_API bool jschema_gen_sax_push(jschema_gen_sax_state *s, jschema_gen_frame_func check) NON_NULL(1, 2);
+
+/** Finish the object or the array on the top */
+PJSON_API void jschema_gen_sax_pop(jschema_gen_sax_state *s) NON_NULL(1);
+
+/** Check of a value, which accepts anything */
+PJSON_API bool jschema_gen_sax_any(jschema_gen_sax_state *s, const jschema_gen_event *e) NON_NULL(1, 2);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* J_SCHEMA_GENERATED_H_ */
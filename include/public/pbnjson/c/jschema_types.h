@@ -26,6 +26,7 @@ extern "C" {
 #endif
 
 typedef struct jschema* jschema_ref;
+typedef struct jschema_set* jschema_set_ref;
 
 typedef enum {
 	/// the external ref resolved perfectly
@@ -38,6 +38,11 @@ typedef struct jvalue* jvalue_ref;
 
 typedef struct jsaxparser *jsaxparser_ref;
 typedef struct jdomparser *jdomparser_ref;
+typedef struct jreformatter *jreformatter_ref;
+typedef struct jsnapshot *jsnapshot_ref;
+typedef struct jsnapshot_version *jsnapshot_version_ref;
+typedef struct jshared *jshared_ref;
+typedef struct jarena *jarena_ref;
 
 /**
   * @brief Iterator through JSON DOM object
@@ -72,6 +77,16 @@ typedef struct {
 	size_t m_len;
 } raw_buffer;
 
+/**
+ * @brief Iterator through the chunks of a JSON string
+ */
+typedef struct {
+	/// Internal structure iterator. Should not be used directly
+	const void *m_chunk;
+	/// Internal structure iterator. Should not be used directly
+	raw_buffer m_rest;
+} jstring_chunk_iter;
+
 /**
  * A structure representing a key/value pair in a JSON object.
  */
@@ -0,0 +1,100 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef INCLUDE_PUBLIC_PBNJSON_CXX_JARENA_H_
+#define INCLUDE_PUBLIC_PBNJSON_CXX_JARENA_H_
+
+#include "../c/jobject.h"
+#include "JValue.h"
+
+namespace pbnjson {
+
+/**
+ * Arena is a scope, like a request handler, whose values are released at once.
+ *
+ * While the Arena object lives, the DOM values created by its thread (JDomParser,
+ * Object(), Array(), JValue constructors, duplicate(), ...) are bump allocated from
+ * one arena. Copying and destroying such JValues costs nothing, and the memory is
+ * released by the Arena destructor in one shot.
+ *
+ * The values mustn't outlive the Arena: use copyOut() for any value that escapes
+ * the scope. Arenas nest, the inner one is used until it's destroyed.
+ *
+ * @code
+ * JValue handle(const std::string &request)
+ * {
+ *     pbnjson::Arena arena;
+ *     JValue input = JDomParser::fromString(request);
+ *     ...
+ *     return arena.copyOut(reply);
+ * }
+ * @endcode
+ *
+ * @see jarena_create
+ */
+class Arena
+{
+public:
+	/**
+	 * Create the arena and make it current for the calling thread
+	 */
+	Arena()
+		: arena(jarena_create())
+		, previous(jarena_set_current(arena))
+	{}
+
+	/**
+	 * Restore the previous arena and release all the values of this one
+	 */
+	~Arena()
+	{
+		jarena_set_current(previous);
+		jarena_free(arena);
+	}
+
+	/**
+	 * Make a deep copy of the value that outlives the arena
+	 *
+	 * @param value Value to copy, from this arena or not
+	 * @return Copy allocated on the heap, or in the enclosing arena
+	 */
+	JValue copyOut(const JValue &value) const
+	{
+		jarena_set_current(previous);
+		JValue copy = value.duplicate();
+		jarena_set_current(arena);
+		return copy;
+	}
+
+	/**
+	 * Return the number of bytes taken by the values of the arena
+	 */
+	size_t size() const
+	{
+		return arena ? jarena_size(arena) : 0;
+	}
+
+private:
+	Arena(const Arena &);
+	Arena& operator=(const Arena &);
+
+	jarena_ref arena;
+	jarena_ref previous;
+};
+
+}
+
+#endif /* INCLUDE_PUBLIC_PBNJSON_CXX_JARENA_H_ */
@@ -1138,6 +1138,42 @@ public:
 		: JValue(l)
 	{ }
 #endif
+
+	/**
+	 * Create a JSON object from parallel lists of keys and values.
+	 *
+	 * Keys are shared with the new object, so the same list of keys can be reused
+	 * to build many objects cheaply.
+	 *
+	 * @param keys Non-empty JSON strings to use as the keys
+	 * @param values Values to put under the keys
+	 *
+	 * @note The object is invalid if the lists have different sizes, a key isn't a
+	 *       non-empty string or there are duplicate keys.
+	 *
+	 * @see jobject_create_from_arrays
+	 */
+	JObject(const std::vector<JValue> &keys, const std::vector<JValue> &values)
+		: JValue(createFromArrays(keys, values))
+	{ }
+
+private:
+	static jvalue_ref createFromArrays(const std::vector<JValue> &keys, const std::vector<JValue> &values)
+	{
+		if (keys.size() != values.size())
+			return jinvalid();
+		if (keys.empty())
+			return jobject_create();
+
+		std::vector<jvalue_ref> rawKeys(keys.size());
+		std::vector<jvalue_ref> rawValues(values.size());
+		for (size_t i = 0; i < keys.size(); ++i)
+		{
+			rawKeys[i] = keys[i].peekRaw();
+			rawValues[i] = jvalue_copy(values[i].peekRaw());
+		}
+		return jobject_create_from_arrays(&rawKeys[0], &rawValues[0], keys.size());
+	}
 };
 
 /**
@@ -0,0 +1,262 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "dom_node_allocator.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <compiler/builtins.h>
+
+#if DOM_NODE_USE_MALLOC
+
+void *dom_node_alloc(size_t size)
+{
+	return malloc(size);
+}
+
+void *dom_node_alloc0(size_t size)
+{
+	return calloc(1, size);
+}
+
+void dom_node_free(size_t size, void *mem)
+{
+	(void) size;
+	free(mem);
+}
+
+#else
+
+#define NODE_ALIGN        16
+#define NODE_MIN_SIZE     32
+#define NODE_CLASSES      ((DOM_NODE_MAX_SIZE - NODE_MIN_SIZE) / NODE_ALIGN + 1)
+#define MAGAZINE_CAPACITY 64
+#define SLAB_SIZE         (64 * 1024)
+
+// Released node. The head node of a magazine kept in the depot
+// also links the next magazine and remembers the length of its own.
+typedef struct free_node {
+	struct free_node *next;
+	struct free_node *next_magazine;
+	size_t count;
+} free_node;
+
+_Static_assert(sizeof(free_node) <= NODE_MIN_SIZE, "Released node should fit the smallest size class");
+_Static_assert(SLAB_SIZE >= MAGAZINE_CAPACITY * DOM_NODE_MAX_SIZE, "Slab should fit a magazine of the biggest nodes");
+
+typedef struct magazine {
+	free_node *head;
+	size_t count;
+} magazine;
+
+// Loaded magazine serves the requests, previous one is always either full or empty.
+// The pair prevents thrashing against the depot on alloc/free sequences at the boundary.
+typedef struct node_cache {
+	magazine loaded;
+	magazine previous;
+} node_cache;
+
+typedef struct thread_cache {
+	node_cache classes[NODE_CLASSES];
+	bool registered;
+} thread_cache;
+
+// Full magazines shared between threads and the slab being carved for the size class
+typedef struct depot {
+	free_node *magazines;
+	char *slab_pos;
+	char *slab_end;
+} depot;
+
+static depot depots[NODE_CLASSES];
+static pthread_mutex_t depot_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static _Thread_local thread_cache tls_cache;
+static pthread_key_t cache_key;
+static pthread_once_t cache_key_once = PTHREAD_ONCE_INIT;
+
+static inline size_t size_class(size_t size)
+{
+	assert(size <= DOM_NODE_MAX_SIZE);
+	return size <= NODE_MIN_SIZE ? 0 : (size - NODE_MIN_SIZE + NODE_ALIGN - 1) / NODE_ALIGN;
+}
+
+static inline size_t class_size(size_t cls)
+{
+	return NODE_MIN_SIZE + cls * NODE_ALIGN;
+}
+
+static inline void magazine_swap(node_cache *c)
+{
+	magazine tmp = c->loaded;
+	c->loaded = c->previous;
+	c->previous = tmp;
+}
+
+// Should be called with depot_lock held
+static void depot_push(size_t cls, magazine *m)
+{
+	if (!m->count)
+		return;
+
+	m->head->count = m->count;
+	m->head->next_magazine = depots[cls].magazines;
+	depots[cls].magazines = m->head;
+
+	m->head = NULL;
+	m->count = 0;
+}
+
+// Should be called with depot_lock held
+static magazine depot_pop(size_t cls)
+{
+	depot *d = &depots[cls];
+	magazine m = { NULL, 0 };
+
+	if (d->magazines) {
+		m.head = d->magazines;
+		m.count = m.head->count;
+		d->magazines = m.head->next_magazine;
+		return m;
+	}
+
+	// No magazines to reuse, carve a fresh one from the slab
+	size_t node_size = class_size(cls);
+	size_t bytes = node_size * MAGAZINE_CAPACITY;
+	if ((size_t)(d->slab_end - d->slab_pos) < bytes) {
+		char *slab = (char *) malloc(SLAB_SIZE);
+		if (UNLIKELY(!slab))
+			return m;
+		d->slab_pos = slab;
+		d->slab_end = slab + SLAB_SIZE;
+	}
+
+	// Link nodes in the address order to keep consequent allocations adjacent
+	for (size_t i = MAGAZINE_CAPACITY; i > 0; --i) {
+		free_node *n = (free_node *) (d->slab_pos + (i - 1) * node_size);
+		n->next = m.head;
+		m.head = n;
+	}
+	m.count = MAGAZINE_CAPACITY;
+	d->slab_pos += bytes;
+
+	return m;
+}
+
+// Return everything cached by the exiting thread to the depot
+static void cache_flush(void *data)
+{
+	thread_cache *cache = (thread_cache *) data;
+
+	pthread_mutex_lock(&depot_lock);
+	for (size_t cls = 0; cls < NODE_CLASSES; ++cls) {
+		depot_push(cls, &cache->classes[cls].loaded);
+		depot_push(cls, &cache->classes[cls].previous);
+	}
+	pthread_mutex_unlock(&depot_lock);
+
+	// Destructors of other keys may still release nodes, they'll register the cache again
+	cache->registered = false;
+}
+
+static void cache_key_create(void)
+{
+	pthread_key_create(&cache_key, cache_flush);
+}
+
+static void cache_register(void)
+{
+	pthread_once(&cache_key_once, cache_key_create);
+	pthread_setspecific(cache_key, &tls_cache);
+	tls_cache.registered = true;
+}
+
+static bool cache_reload(node_cache *c, size_t cls)
+{
+	assert(c->loaded.count == 0 && c->previous.count == 0);
+
+	pthread_mutex_lock(&depot_lock);
+	c->loaded = depot_pop(cls);
+	pthread_mutex_unlock(&depot_lock);
+
+	return c->loaded.count != 0;
+}
+
+void *dom_node_alloc(size_t size)
+{
+	if (UNLIKELY(size > DOM_NODE_MAX_SIZE))
+		return malloc(size);
+
+	if (UNLIKELY(!tls_cache.registered))
+		cache_register();
+
+	size_t cls = size_class(size);
+	node_cache *c = &tls_cache.classes[cls];
+	if (UNLIKELY(c->loaded.count == 0)) {
+		if (c->previous.count)
+			magazine_swap(c);
+		else if (!cache_reload(c, cls))
+			return NULL;
+	}
+
+	free_node *n = c->loaded.head;
+	c->loaded.head = n->next;
+	--c->loaded.count;
+	return n;
+}
+
+void *dom_node_alloc0(size_t size)
+{
+	void *mem = dom_node_alloc(size);
+	if (LIKELY(mem != NULL))
+		memset(mem, 0, size);
+	return mem;
+}
+
+void dom_node_free(size_t size, void *mem)
+{
+	if (UNLIKELY(mem == NULL))
+		return;
+
+	if (UNLIKELY(size > DOM_NODE_MAX_SIZE)) {
+		free(mem);
+		return;
+	}
+
+	if (UNLIKELY(!tls_cache.registered))
+		cache_register();
+
+	size_t cls = size_class(size);
+	node_cache *c = &tls_cache.classes[cls];
+	if (UNLIKELY(c->loaded.count == MAGAZINE_CAPACITY)) {
+		if (c->previous.count) {
+			pthread_mutex_lock(&depot_lock);
+			depot_push(cls, &c->previous);
+			pthread_mutex_unlock(&depot_lock);
+		}
+		magazine_swap(c);
+	}
+
+	free_node *n = (free_node *) mem;
+	n->next = c->loaded.head;
+	c->loaded.head = n;
+	++c->loaded.count;
+}
+
+#endif /* DOM_NODE_USE_MALLOC */
@@ -0,0 +1,88 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef DOM_NODE_ALLOCATOR_H_
+#define DOM_NODE_ALLOCATOR_H_
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+	Size-class slab allocator for DOM nodes (jobject, jarray, jnum and
+	short jstring instances).
+
+	Every thread keeps a pair of magazines (free lists of a fixed capacity)
+	per size class, so allocation and release are plain pointer operations
+	in the common case. Full magazines are exchanged with the global depot
+	in one batch under a lock, therefore nodes released by a thread other
+	than the one which allocated them are returned to circulation in batches
+	as well. Memory of the slabs is kept for reuse for the process lifetime.
+
+	Requests bigger than DOM_NODE_MAX_SIZE are served by malloc().
+*/
+
+/// Biggest allocation size served from the slabs
+#define DOM_NODE_MAX_SIZE 256
+
+// Memory checkers can't look inside of the slabs, let them track every node.
+// GCC announces AddressSanitizer with __SANITIZE_ADDRESS__, clang with __has_feature.
+#if defined(__has_feature)
+# if __has_feature(address_sanitizer)
+#  define DOM_NODE_SANITIZED 1
+# endif
+#endif
+#if defined(__SANITIZE_ADDRESS__)
+# define DOM_NODE_SANITIZED 1
+#endif
+
+#if PJSON_DOM_NODE_MALLOC || DOM_NODE_SANITIZED
+# define DOM_NODE_USE_MALLOC 1
+#else
+# define DOM_NODE_USE_MALLOC 0
+#endif
+
+/**
+ * @brief Allocate a block of the given size
+ * @param size Size of the block
+ * @return Pointer to uninitialized memory or NULL if allocation failed
+ */
+void *dom_node_alloc(size_t size);
+
+/**
+ * @brief Allocate a block of the given size filled with zeros
+ * @param size Size of the block
+ * @return Pointer to zeroed memory or NULL if allocation failed
+ */
+void *dom_node_alloc0(size_t size);
+
+/**
+ * @brief Release a block obtained from dom_node_alloc() or dom_node_alloc0()
+ * @param size Size of the block, exactly as it was requested
+ * @param mem Block to release. NULL is ignored.
+ */
+void dom_node_free(size_t size, void *mem);
+
+/// Allocate zeroed memory for a structure of the given type
+#define dom_node_new0(type) ((type *) dom_node_alloc0(sizeof(type)))
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //DOM_NODE_ALLOCATOR_H_
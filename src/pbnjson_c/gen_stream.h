@@ -32,4 +32,7 @@ typedef enum TopLevelType TopLevelType;
 
 PJSON_LOCAL JStreamRef jstreamInternal(TopLevelType type, const char *indent);
 
+// Appends the string value chunk by chunk, chunked strings aren't flattened
+PJSON_LOCAL JStreamRef jstream_string_chunks(JStreamRef stream, jvalue_ref str);
+
 #endif /* GEN_STREAM_H_ */
@@ -0,0 +1,369 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "input_stream.h"
+
+#include <errno.h>
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+#include <glib.h>
+#include <compiler/builtins.h>
+#include <compression.h>
+
+#include "liblog.h"
+
+#define INPUT_CHUNK_SIZE (64 * 1024)
+#define INPUT_QUEUE_LENGTH 4
+
+typedef enum {
+	INPUT_PLAIN,
+	INPUT_GZIP,
+	INPUT_ZSTD,
+} input_format;
+
+typedef struct {
+	char data[INPUT_CHUNK_SIZE];
+	size_t len;
+} input_chunk;
+
+// Ring of decoded chunks. The decoder fills the chunks after the filled ones,
+// the consumer drains them from the head, each without holding the lock.
+typedef struct {
+	int fd;
+	input_format format;
+
+	input_chunk chunks[INPUT_QUEUE_LENGTH];
+	size_t head;
+	size_t count;
+	bool finished;   // No more chunks will be filled
+	bool cancelled;  // The consumer has gone
+	char *error;
+	GMutex lock;
+	GCond cond;
+
+	// Owned by the decoder
+	input_chunk *fill;
+	char raw[INPUT_CHUNK_SIZE];
+	size_t raw_len;
+} input_stream;
+
+static input_format detect_format(const unsigned char *buf, size_t len)
+{
+	if (len >= 2 && buf[0] == 0x1f && buf[1] == 0x8b)
+		return INPUT_GZIP;
+	if (len >= 4 && buf[0] == 0x28 && buf[1] == 0xb5 && buf[2] == 0x2f && buf[3] == 0xfd)
+		return INPUT_ZSTD;
+	return INPUT_PLAIN;
+}
+
+static void set_error(input_stream *s, const char *format, ...)
+{
+	va_list ap;
+	va_start(ap, format);
+	char *error = g_strdup_vprintf(format, ap);
+	va_end(ap);
+
+	g_mutex_lock(&s->lock);
+	if (s->error)
+		g_free(error);
+	else
+		s->error = error;
+	g_mutex_unlock(&s->lock);
+}
+
+// Read the next portion of the file into the raw buffer
+static bool read_raw(input_stream *s, size_t *len)
+{
+	ssize_t res;
+	do {
+		res = read(s->fd, s->raw, sizeof(s->raw));
+	} while (res < 0 && errno == EINTR);
+
+	if (res < 0) {
+		set_error(s, "Can't read file: %s", strerror(errno));
+		return false;
+	}
+	*len = res;
+	return true;
+}
+
+// Chunk to decode into, NULL if the consumer has gone
+static input_chunk *chunk_to_fill(input_stream *s)
+{
+	if (s->fill && s->fill->len < INPUT_CHUNK_SIZE)
+		return s->fill;
+
+	g_mutex_lock(&s->lock);
+	if (s->fill)
+	{
+		s->count++;
+		g_cond_signal(&s->cond);
+	}
+	while (s->count == INPUT_QUEUE_LENGTH && !s->cancelled)
+		g_cond_wait(&s->cond, &s->lock);
+	s->fill = s->cancelled ? NULL : &s->chunks[(s->head + s->count) % INPUT_QUEUE_LENGTH];
+	g_mutex_unlock(&s->lock);
+
+	if (s->fill)
+		s->fill->len = 0;
+	return s->fill;
+}
+
+static bool decode_plain(input_stream *s)
+{
+	// The raw buffer holds the beginning of the file used to detect the format
+	size_t len = s->raw_len;
+	for (;;)
+	{
+		input_chunk *chunk = chunk_to_fill(s);
+		if (!chunk)
+			return false;
+
+		size_t n = MIN(len, INPUT_CHUNK_SIZE - chunk->len);
+		memcpy(chunk->data + chunk->len, s->raw, n);
+		chunk->len += n;
+		if (n < len)
+		{
+			memmove(s->raw, s->raw + n, len - n);
+			len -= n;
+			continue;
+		}
+
+		if (!read_raw(s, &len))
+			return false;
+		if (!len)
+			return true;
+	}
+}
+
+#ifdef HAVE_ZLIB
+static bool decode_gzip(input_stream *s)
+{
+	z_stream zs = { 0 };
+	// Gzip header only, raw zlib streams aren't recognized
+	if (inflateInit2(&zs, 15 + 16) != Z_OK)
+	{
+		set_error(s, "Can't initialize gzip decoder");
+		return false;
+	}
+
+	bool result = false;
+	int status = Z_OK;
+	zs.next_in = (Bytef *) s->raw;
+	zs.avail_in = s->raw_len;
+	for (;;)
+	{
+		if (!zs.avail_in)
+		{
+			size_t len;
+			if (!read_raw(s, &len))
+				goto out;
+			if (!len)
+				break;
+			zs.next_in = (Bytef *) s->raw;
+			zs.avail_in = len;
+		}
+
+		// Concatenated members form a single stream
+		if (status == Z_STREAM_END)
+			inflateReset(&zs);
+
+		// Output may still be pending in the decoder when the chunk gets full
+		do {
+			input_chunk *chunk = chunk_to_fill(s);
+			if (!chunk)
+				goto out;
+
+			zs.next_out = (Bytef *) chunk->data + chunk->len;
+			zs.avail_out = INPUT_CHUNK_SIZE - chunk->len;
+			status = inflate(&zs, Z_NO_FLUSH);
+			chunk->len = INPUT_CHUNK_SIZE - zs.avail_out;
+
+			if (status != Z_OK && status != Z_STREAM_END && status != Z_BUF_ERROR)
+			{
+				set_error(s, "Can't decompress gzip input: %s", zs.msg ? zs.msg : "corrupted data");
+				goto out;
+			}
+		} while (status == Z_OK && !zs.avail_out);
+	}
+
+	if (status != Z_STREAM_END)
+		set_error(s, "Can't decompress gzip input: unexpected end of file");
+	else
+		result = true;
+
+out:
+	inflateEnd(&zs);
+	return result;
+}
+#endif
+
+#ifdef HAVE_ZSTD
+static bool decode_zstd(input_stream *s)
+{
+	ZSTD_DStream *zs = ZSTD_createDStream();
+	if (!zs)
+	{
+		set_error(s, "Can't initialize zstd decoder");
+		return false;
+	}
+
+	bool result = false;
+	// Set when a frame has been completed and no input of the next one has come yet
+	bool frame_done = true;
+	ZSTD_inBuffer in = { s->raw, s->raw_len, 0 };
+	for (;;)
+	{
+		if (in.pos == in.size)
+		{
+			size_t len;
+			if (!read_raw(s, &len))
+				goto out;
+			if (!len)
+				break;
+			in.size = len;
+			in.pos = 0;
+		}
+
+		// Output may still be pending in the decoder when the chunk gets full.
+		// Zero status means the frame is complete and flushed; the decoder is
+		// ready for the next frame then, and must not be asked for more output.
+		size_t status;
+		ZSTD_outBuffer output;
+		do {
+			input_chunk *chunk = chunk_to_fill(s);
+			if (!chunk)
+				goto out;
+
+			size_t consumed = in.pos;
+			output = (ZSTD_outBuffer) { chunk->data, INPUT_CHUNK_SIZE, chunk->len };
+			status = ZSTD_decompressStream(zs, &output, &in);
+			chunk->len = output.pos;
+
+			if (ZSTD_isError(status))
+			{
+				set_error(s, "Can't decompress zstd input: %s", ZSTD_getErrorName(status));
+				goto out;
+			}
+			if (status == 0)
+				frame_done = true;
+			else if (in.pos != consumed)
+				frame_done = false;
+		} while (status && output.pos == output.size);
+	}
+
+	if (!frame_done)
+	{
+		set_error(s, "Can't decompress zstd input: unexpected end of file");
+		goto out;
+	}
+	result = true;
+
+out:
+	ZSTD_freeDStream(zs);
+	return result;
+}
+#endif
+
+static gpointer decode(gpointer data)
+{
+	input_stream *s = data;
+
+	if (read_raw(s, &s->raw_len))
+	{
+		switch (s->format = detect_format((const unsigned char *) s->raw, s->raw_len))
+		{
+		case INPUT_PLAIN:
+			decode_plain(s);
+			break;
+		case INPUT_GZIP:
+#ifdef HAVE_ZLIB
+			decode_gzip(s);
+#else
+			set_error(s, "Can't decompress gzip input: built without zlib");
+#endif
+			break;
+		case INPUT_ZSTD:
+#ifdef HAVE_ZSTD
+			decode_zstd(s);
+#else
+			set_error(s, "Can't decompress zstd input: built without zstd");
+#endif
+			break;
+		}
+	}
+
+	g_mutex_lock(&s->lock);
+	if (s->fill && s->fill->len)
+		s->count++;
+	s->finished = true;
+	g_cond_signal(&s->cond);
+	g_mutex_unlock(&s->lock);
+
+	return NULL;
+}
+
+bool input_stream_read(int fd, input_stream_feed feed, void *ctxt, jerror **err)
+{
+	input_stream *s = g_new0(input_stream, 1);
+	s->fd = fd;
+	g_mutex_init(&s->lock);
+	g_cond_init(&s->cond);
+
+	GThread *decoder = g_thread_new("pbnjson-decode", decode, s);
+
+	bool result = true;
+	for (;;)
+	{
+		g_mutex_lock(&s->lock);
+		while (!s->count && !s->finished)
+			g_cond_wait(&s->cond, &s->lock);
+		bool empty = !s->count;
+		g_mutex_unlock(&s->lock);
+
+		if (empty)
+			break;
+
+		input_chunk *chunk = &s->chunks[s->head];
+		result = feed(ctxt, chunk->data, chunk->len);
+
+		g_mutex_lock(&s->lock);
+		s->head = (s->head + 1) % INPUT_QUEUE_LENGTH;
+		s->count--;
+		s->cancelled = !result;
+		g_cond_signal(&s->cond);
+		g_mutex_unlock(&s->lock);
+
+		if (!result)
+			break;
+	}
+
+	g_thread_join(decoder);
+
+	if (s->error)
+	{
+		jerror_set(err, JERROR_TYPE_INVALID_PARAMETERS, s->error);
+		result = false;
+	}
+
+	g_free(s->error);
+	g_cond_clear(&s->cond);
+	g_mutex_clear(&s->lock);
+	g_free(s);
+
+	return result;
+}
@@ -0,0 +1,42 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <stdbool.h>
+
+#include "jerror_internal.h"
+
+/**
+ * @brief Consumer of the decoded input. Returns false to stop reading.
+ */
+typedef bool (*input_stream_feed)(void *ctxt, const char *buf, int buf_len);
+
+/**
+ * @brief Decode the file and pass its content to the consumer chunk by chunk
+ *
+ * Gzip (zlib) and zstd compressed files are recognized by their magic bytes, and
+ * the rest of files are passed as is. Decoding runs on a separate thread, which
+ * stays a few chunks ahead of the consumer, so that only the chunks in flight
+ * are held in memory no matter how big the file is.
+ *
+ * @param fd File descriptor to read. It isn't closed.
+ * @param feed The consumer, called on the calling thread.
+ * @param ctxt Context for the consumer.
+ * @param err Error pointer, set if the input can't be read or decoded.
+ * @return false if reading, decoding or the consumer failed.
+ */
+bool input_stream_read(int fd, input_stream_feed feed, void *ctxt, jerror **err);
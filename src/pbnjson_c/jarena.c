@@ -0,0 +1,145 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <jobject.h>
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <compiler/builtins.h>
+
+#include "jobject_internal.h"
+#include "liblog.h"
+
+#define ARENA_ALIGN          8
+#define ARENA_MIN_CHUNK_SIZE (4 * 1024)
+#define ARENA_MAX_CHUNK_SIZE (256 * 1024)
+
+#define ARENA_ALIGN_SIZE(size) (((size) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+
+// Every block is preceded by the link to the previously allocated one,
+// so that the values are found for destruction without walking the DOMs.
+typedef struct arena_block {
+	struct arena_block *prev;
+} arena_block;
+
+typedef struct arena_chunk {
+	struct arena_chunk *prev;
+	size_t size;
+} arena_chunk;
+
+_Static_assert(sizeof(arena_block) % ARENA_ALIGN == 0, "Arena block header should keep the alignment");
+_Static_assert(sizeof(arena_chunk) % ARENA_ALIGN == 0, "Arena chunk header should keep the alignment");
+
+struct jarena {
+	arena_chunk *chunks;    // The last chunk, blocks are carved from it
+	char *pos;
+	char *end;
+	arena_block *blocks;    // The last block
+	size_t size;
+};
+
+static _Thread_local jarena_ref current_arena;
+
+jarena_ref jarena_create(void)
+{
+	return calloc(1, sizeof(struct jarena));
+}
+
+jarena_ref jarena_set_current(jarena_ref arena)
+{
+	jarena_ref previous = current_arena;
+	current_arena = arena;
+	return previous;
+}
+
+jarena_ref jarena_current(void)
+{
+	return current_arena;
+}
+
+size_t jarena_size(jarena_ref arena)
+{
+	return arena->size;
+}
+
+static bool arena_grow(jarena_ref arena, size_t size)
+{
+	// Chunks grow with the arena, so small scopes stay small and big ones make few allocations
+	size_t chunk_size = arena->chunks ? arena->chunks->size * 2 : ARENA_MIN_CHUNK_SIZE;
+	if (chunk_size > ARENA_MAX_CHUNK_SIZE)
+		chunk_size = ARENA_MAX_CHUNK_SIZE;
+	if (chunk_size < sizeof(arena_chunk) + size)
+		chunk_size = sizeof(arena_chunk) + size;
+
+	arena_chunk *chunk = malloc(chunk_size);
+	if (UNLIKELY(!chunk))
+		return false;
+
+	chunk->prev = arena->chunks;
+	chunk->size = chunk_size;
+	arena->chunks = chunk;
+	arena->pos = (char *) (chunk + 1);
+	arena->end = (char *) chunk + chunk_size;
+	return true;
+}
+
+void *jarena_alloc0(jarena_ref arena, size_t size)
+{
+	size_t block_size = sizeof(arena_block) + ARENA_ALIGN_SIZE(size);
+	if (UNLIKELY((size_t)(arena->end - arena->pos) < block_size) && !arena_grow(arena, block_size))
+		return NULL;
+
+	arena_block *block = (arena_block *) arena->pos;
+	arena->pos += block_size;
+	arena->size += block_size;
+
+	block->prev = arena->blocks;
+	arena->blocks = block;
+
+	void *mem = block + 1;
+	memset(mem, 0, size);
+	return mem;
+}
+
+void jarena_discard(jarena_ref arena, void *mem)
+{
+	arena_block *block = (arena_block *) mem - 1;
+	assert(arena->blocks == block);
+	arena->blocks = block->prev;
+}
+
+void jarena_free(jarena_ref arena)
+{
+	if (!arena)
+		return;
+
+	assert(arena != current_arena);
+
+	// Values outside of the arena may be owned by the arena values,
+	// every value is destroyed before any memory is released.
+	for (arena_block *block = arena->blocks; block; block = block->prev)
+		(void) jvalue_destroy((jvalue_ref) (block + 1));
+
+	arena_chunk *chunk = arena->chunks;
+	while (chunk) {
+		arena_chunk *prev = chunk->prev;
+		free(chunk);
+		chunk = prev;
+	}
+
+	free(arena);
+}
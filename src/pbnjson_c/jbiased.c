@@ -0,0 +1,297 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <jobject.h>
+
+#include <assert.h>
+#include <pthread.h>
+#include <glib.h>
+#include <compiler/builtins.h>
+
+#include "jobject_internal.h"
+#include "dom_node_allocator.h"
+
+// Biased reference counting.
+//
+// A value has two counters: m_biased belongs to the owner thread, m_refCnt is shared
+// by the others. Their sum is the number of references, but either part alone may be
+// anything, including negative m_refCnt when other threads release the references
+// copied by the owner. Once the owner's counter drops to zero, the owner sets MERGED,
+// and m_refCnt counts all the references from then on.
+//
+// When another thread would take m_refCnt below zero, it leaves the counter as is
+// and passes its reference to the owner through the queue instead. The owner merges
+// the queued values when it creates values next time, when one of its values is merged,
+// in j_release_pending() or when it exits. The values of the owner that has already
+// exited are merged by the releasing thread itself.
+//
+// Owner records are identified by 32-bit numbers to keep the values small. The record
+// of an exited thread isn't reused while some of its values aren't merged.
+
+#define OWNER_CHUNK_SIZE 256
+#define OWNER_CHUNKS     256
+
+typedef struct owner {
+	GMutex lock;
+	GPtrArray *queue;     // Values passed by the other threads, under the lock
+	gint pending;         // The queue isn't empty, checked without the lock
+	bool dead;            // The thread has exited, under the lock
+	size_t created;       // Values created biased, changed only by the owner
+	size_t merged;        // Values merged or freed by the owner
+	size_t outstanding;   // Values left biased when the thread exited, under the lock
+	uint32_t id;
+	uint32_t next_free;
+} owner;
+
+static owner *owner_chunks[OWNER_CHUNKS];
+static uint32_t owner_count = 1;        // Id 0 stands for values which aren't biased
+static uint32_t owner_free;
+static GMutex owners_lock;
+
+static _Thread_local owner *current_owner;
+_Thread_local uint32_t jbiased_current J_BIASED_TLS_MODEL;
+
+static pthread_key_t owner_key;
+static pthread_once_t owner_key_once = PTHREAD_ONCE_INIT;
+
+static owner *owner_get(uint32_t id)
+{
+	owner *chunk = g_atomic_pointer_get(&owner_chunks[id / OWNER_CHUNK_SIZE]);
+	return &chunk[id % OWNER_CHUNK_SIZE];
+}
+
+static owner *owner_alloc(void)
+{
+	owner *o = NULL;
+
+	g_mutex_lock(&owners_lock);
+	if (owner_free) {
+		o = owner_get(owner_free);
+		owner_free = o->next_free;
+	} else if (owner_count < OWNER_CHUNKS * OWNER_CHUNK_SIZE) {
+		uint32_t id = owner_count;
+		if (id % OWNER_CHUNK_SIZE == 0 || id == 1) {
+			owner *chunk = g_new0(owner, OWNER_CHUNK_SIZE);
+			for (size_t i = 0; i < OWNER_CHUNK_SIZE; ++i) {
+				g_mutex_init(&chunk[i].lock);
+				chunk[i].id = id - id % OWNER_CHUNK_SIZE + i;
+			}
+			g_atomic_pointer_set(&owner_chunks[id / OWNER_CHUNK_SIZE], chunk);
+		}
+		o = owner_get(id);
+		++owner_count;
+	}
+	g_mutex_unlock(&owners_lock);
+
+	// Too many threads with values left behind, the new ones count atomically
+	if (UNLIKELY(!o))
+		return NULL;
+
+	o->queue = g_ptr_array_new();
+	o->pending = 0;
+	o->dead = false;
+	o->created = 0;
+	o->merged = 0;
+	o->outstanding = 0;
+	return o;
+}
+
+static void owner_recycle(owner *o)
+{
+	g_ptr_array_free(o->queue, TRUE);
+	o->queue = NULL;
+
+	g_mutex_lock(&owners_lock);
+	o->next_free = owner_free;
+	owner_free = o->id;
+	g_mutex_unlock(&owners_lock);
+}
+
+static void value_free(jvalue_ref val)
+{
+	size_t size = jvalue_destroy(val);
+	if (size)
+		dom_node_free(size, val);
+}
+
+// Merge the counters of the value, for which the caller holds the queued reference.
+// Returns true if the value hasn't been merged before.
+static bool value_merge(jvalue_ref val)
+{
+	int biased = jbiased_get(val);
+	jbiased_set(val, 0);
+
+	gint old, new;
+	do {
+		old = g_atomic_int_get(&val->m_refCnt);
+		assert(old & J_BIASED_QUEUED);
+		new = ((old & ~J_BIASED_QUEUED) | J_BIASED_MERGED) + (biased - 1) * J_BIASED_ONE;
+	} while (!g_atomic_int_compare_and_exchange(&val->m_refCnt, old, new));
+
+	bool merged_now = !(old & J_BIASED_MERGED);
+	if (new == J_BIASED_MERGED)
+		value_free(val);
+	return merged_now;
+}
+
+static void owner_drain(owner *o)
+{
+	g_mutex_lock(&o->lock);
+	GPtrArray *queue = o->queue;
+	o->queue = g_ptr_array_new();
+	g_atomic_int_set(&o->pending, 0);
+	g_mutex_unlock(&o->lock);
+
+	// Freed values release their children, which may be queued again
+	for (guint i = 0; i < queue->len; ++i)
+		if (value_merge(g_ptr_array_index(queue, i)))
+			++o->merged;
+	g_ptr_array_free(queue, TRUE);
+}
+
+static void owner_exit(void *data)
+{
+	owner *o = (owner *) data;
+	assert(o == current_owner);
+
+	bool unused;
+	while (true) {
+		g_mutex_lock(&o->lock);
+		if (o->queue->len == 0) {
+			o->dead = true;
+			o->outstanding = o->created - o->merged;
+			unused = o->outstanding == 0;
+			g_mutex_unlock(&o->lock);
+			break;
+		}
+		g_mutex_unlock(&o->lock);
+		owner_drain(o);
+	}
+
+	// Destructors of other keys may still release values, they'll go the shared way
+	current_owner = NULL;
+	jbiased_current = 0;
+
+	if (unused)
+		owner_recycle(o);
+}
+
+static void owner_key_create(void)
+{
+	pthread_key_create(&owner_key, owner_exit);
+}
+
+static owner *owner_register(void)
+{
+	owner *o = owner_alloc();
+	if (!o)
+		return NULL;
+
+	pthread_once(&owner_key_once, owner_key_create);
+	pthread_setspecific(owner_key, o);
+	current_owner = o;
+	jbiased_current = o->id;
+	return o;
+}
+
+void jbiased_own(jvalue_ref val)
+{
+	owner *o = current_owner;
+	if (UNLIKELY(!o) && !(o = owner_register()))
+		return;
+
+	if (UNLIKELY(g_atomic_int_get(&o->pending)))
+		owner_drain(o);
+
+	val->m_owner = o->id;
+	val->m_biased = 1;
+	val->m_refCnt = 0;
+	++o->created;
+}
+
+void jbiased_forget(jvalue_ref val)
+{
+	assert(val->m_owner == jbiased_current && jbiased_get(val) == 1);
+	++current_owner->merged;
+}
+
+void jbiased_merge(jvalue_ref val)
+{
+	assert(val->m_owner == jbiased_current && jbiased_get(val) == 0);
+
+	owner *o = current_owner;
+	++o->merged;
+
+	// Other threads hold no references, if they haven't counted any
+	gint old = (gint) g_atomic_int_or((guint *) &val->m_refCnt, J_BIASED_MERGED);
+	if (old == 0)
+		value_free(val);
+
+	if (UNLIKELY(g_atomic_int_get(&o->pending)))
+		owner_drain(o);
+}
+
+size_t j_release_pending(void)
+{
+	owner *o = current_owner;
+	if (!o)
+		return 0;
+
+	// Values freed by the drain may queue their children once more
+	size_t merged = o->merged;
+	while (g_atomic_int_get(&o->pending))
+		owner_drain(o);
+	return o->merged - merged;
+}
+
+void jbiased_release(jvalue_ref val)
+{
+	gint old, new;
+	bool queue;
+	do {
+		old = g_atomic_int_get(&val->m_refCnt);
+		// The owner holds the rest of the references, our one should be counted by it
+		queue = !(old & (J_BIASED_MERGED | J_BIASED_QUEUED)) && old < J_BIASED_ONE;
+		new = queue ? old | J_BIASED_QUEUED : old - J_BIASED_ONE;
+	} while (!g_atomic_int_compare_and_exchange(&val->m_refCnt, old, new));
+
+	if (!queue) {
+		if (new == J_BIASED_MERGED)
+			value_free(val);
+		return;
+	}
+
+	owner *o = owner_get(val->m_owner);
+	g_mutex_lock(&o->lock);
+	if (!o->dead) {
+		g_ptr_array_add(o->queue, val);
+		g_atomic_int_set(&o->pending, 1);
+		g_mutex_unlock(&o->lock);
+		return;
+	}
+	g_mutex_unlock(&o->lock);
+
+	// Nobody touches the owner's counter anymore, merge it here
+	if (!value_merge(val))
+		return;
+
+	g_mutex_lock(&o->lock);
+	bool unused = --o->outstanding == 0;
+	g_mutex_unlock(&o->lock);
+
+	if (unused)
+		owner_recycle(o);
+}
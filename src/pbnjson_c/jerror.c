@@ -36,6 +36,8 @@ jerror *jerror_duplicate(const jerror *other)
 		copy = g_slice_new(jerror);
 		copy->type = other->type;
 		copy->message = g_strdup(other->message);
+		copy->located = other->located;
+		copy->location = other->location;
 	}
 	return copy;
 }
@@ -52,7 +54,21 @@ int jerror_to_string(jerror *err, char *str, size_t size)
 {
 	if (!err) return -1;
 
-	return snprintf(str, size, "%s error. %s", error_type_str[err->type], err->message);
+	if (!err->located)
+		return snprintf(str, size, "%s error. %s", error_type_str[err->type], err->message);
+
+	return snprintf(str, size, "%s error. %s (line %zu, column %zu, offset %zu)",
+	                error_type_str[err->type], err->message,
+	                err->location.line, err->location.column, err->location.offset);
+}
+
+bool jerror_get_location(const jerror *err, jlocation *location)
+{
+	if (!err || !err->located)
+		return false;
+
+	*location = err->location;
+	return true;
 }
 
 /******************************************************************************
@@ -61,7 +77,7 @@ int jerror_to_string(jerror *err, char *str, size_t size)
 
 static jerror *jerror_new(jerror_type type, const char *str)
 {
-	jerror *err = g_slice_new(jerror);
+	jerror *err = g_slice_new0(jerror);
 	err->type = type;
 	err->message = g_strdup(str);
 	return err;
@@ -105,3 +121,19 @@ void jerror_set_formatted(jerror **err, jerror_type type, const char *format, ..
 
 	va_end (args);
 }
+
+/**
+ * Function to set the place in the parsed text, where the error occurred.
+ * The location of the first report is kept.
+ *
+ * @param err      pbnjson error information.
+ * @param location position in the text.
+ */
+void jerror_set_location(jerror *err, const jlocation *location)
+{
+	if (!err || err->located)
+		return;
+
+	err->located = true;
+	err->location = *location;
+}
@@ -18,6 +18,7 @@
 #define SRC_PBNJSON_C_JERROR_INTERNAL_H_
 
 #include <compiler/format_attribute.h>
+#include <jerror.h>
 
 typedef enum {
 	JERROR_TYPE_SCHEMA = 0,
@@ -30,10 +31,14 @@ typedef enum {
 typedef struct jerror {
 	jerror_type type;
 	char        *message;
+	bool        located;
+	jlocation   location;
 } jerror;
 
 void jerror_set(jerror **error, jerror_type type, const char *str);
 void jerror_set_formatted(jerror **err, jerror_type type, const char *format, ...)
 	PRINTF_FORMAT_FUNC(3, 4);
 
+void jerror_set_location(jerror *err, const jlocation *location);
+
 #endif /* SRC_PBNJSON_C_JERROR_INTERNAL_H_ */
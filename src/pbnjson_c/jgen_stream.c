@@ -137,6 +137,83 @@ static ActualStream* val_str(ActualStream* stream, raw_buffer str)
 	return stream;
 }
 
+// Escape sequence of the character as yajl_gen_string() writes it, 0 if the character
+// goes as is. The sequence is stored to out unless it's NULL.
+static size_t escape_char(unsigned char c, char *out)
+{
+	static const char hex[] = "0123456789ABCDEF";
+	char escaped;
+	switch (c) {
+	case '"': escaped = '"'; break;
+	case '\\': escaped = '\\'; break;
+#if YAJL_VERSION < 20000
+	case '/': escaped = '/'; break;
+#endif
+	case '\b': escaped = 'b'; break;
+	case '\f': escaped = 'f'; break;
+	case '\n': escaped = 'n'; break;
+	case '\r': escaped = 'r'; break;
+	case '\t': escaped = 't'; break;
+	default:
+		if (c >= 0x20)
+			return 0;
+		if (out) {
+			memcpy(out, "\\u00", 4);
+			out[4] = hex[c >> 4];
+			out[5] = hex[c & 0xF];
+		}
+		return 6;
+	}
+	if (out) {
+		out[0] = '\\';
+		out[1] = escaped;
+	}
+	return 2;
+}
+
+static ActualStream* val_str_chunks(ActualStream* stream, jvalue_ref str)
+{
+	SANITY_CHECK_POINTER(stream);
+	CHECK_HANDLE(stream);
+
+	// yajl_gen_string() takes the text in one piece only. The chunks are escaped the
+	// same way into a buffer, which lives till yajl copies it as a raw value.
+	jstring_chunk_iter it;
+	raw_buffer chunk;
+	size_t len = 2;
+	jstring_chunk_iter_init(&it, str);
+	while (jstring_chunk_iter_next(&it, &chunk)) {
+		for (size_t i = 0; i < chunk.m_len; ++i) {
+			size_t escaped = escape_char(chunk.m_str[i], NULL);
+			len += escaped ? escaped : 1;
+		}
+	}
+
+	char *quoted = malloc(len);
+	if (UNLIKELY(!quoted)) {
+		stream->error = GEN_GENERIC_ERROR;
+		return stream;
+	}
+
+	char *pos = quoted;
+	*pos++ = '"';
+	jstring_chunk_iter_init(&it, str);
+	while (jstring_chunk_iter_next(&it, &chunk)) {
+		for (size_t i = 0; i < chunk.m_len; ++i) {
+			size_t escaped = escape_char(chunk.m_str[i], pos);
+			if (escaped)
+				pos += escaped;
+			else
+				*pos++ = chunk.m_str[i];
+		}
+	}
+	*pos++ = '"';
+
+	yajl_gen_number(stream->handle, quoted, len);
+	free(quoted);
+	return stream;
+}
+
 static ActualStream* val_bool(ActualStream* stream, bool boolean)
 {
 	SANITY_CHECK_POINTER(stream);
@@ -251,6 +328,11 @@ static struct __JStream yajl_stream_generator =
 	(jFinish)finish_stream
 };
 
+JStreamRef jstream_string_chunks(JStreamRef stream, jvalue_ref str)
+{
+	return (JStreamRef)val_str_chunks((ActualStream*)stream, str);
+}
+
 JStreamRef jstreamInternal(TopLevelType type, const char *indent)
 {
 	ActualStream* stream = (ActualStream*)calloc(1, sizeof(ActualStream));
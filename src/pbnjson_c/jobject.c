@@ -43,6 +43,7 @@
 #include <unistd.h>
 
 #include "dom_string_memory_pool.h"
+#include "dom_node_allocator.h"
 
 #ifdef DBG_C_MEM
 #define PJ_LOG_MEM(...) PJ_LOG_INFO(__VA_ARGS__)
@@ -132,6 +133,7 @@ static jstring JEMPTY_STR = {
 };
 
 static jvalue_ref jnumber_duplicate (jvalue_ref num) NON_NULL(1);
+static jvalue_ref jstring_duplicate(jvalue_ref str) NON_NULL(1);
 static bool jstring_equal_internal(jvalue_ref str, jvalue_ref other) NON_NULL(1, 2);
 static inline bool jstring_equal_internal2(jvalue_ref str, raw_buffer *other) NON_NULL(1, 2);
 static bool jstring_equal_internal3(raw_buffer *str, raw_buffer *other) NON_NULL(1, 2);
@@ -147,7 +149,7 @@ static bool jis_const(jvalue_ref val)
 	case JV_BOOL:
 		return true;
 	default:
-		return UNLIKELY(val == &JEMPTY_STR.m_value);
+		return UNLIKELY(val == &JEMPTY_STR.m_value) || jis_borrowed(val);
 	}
 }
 
@@ -182,12 +184,55 @@ void jvalue_init (jvalue_ref val, JValueType type)
 	val->m_type = type;
 }
 
+// Zeroed memory of a new value, taken from the arena of the thread if there's one
+static void *jvalue_alloc0(size_t size, JValueType type)
+{
+	jarena_ref arena = jarena_current();
+	jvalue_ref val = arena ? jarena_alloc0(arena, size) : dom_node_alloc0(size);
+	if (UNLIKELY(val == NULL))
+		return NULL;
+
+	jvalue_init(val, type);
+	if (arena)
+		val->m_refCnt = J_ARENA_REFCNT;
+	else
+		jbiased_own(val);
+	return val;
+}
+
+// Release memory of the value which hasn't been completely constructed
+static void jvalue_free_node(jvalue_ref val, size_t size)
+{
+	if (jis_arena(val)) {
+		jarena_discard(jarena_current(), val);
+		return;
+	}
+
+	if (jis_biased(val))
+		jbiased_forget(val);
+	dom_node_free(size, val);
+}
+
 jvalue_ref jvalue_copy (jvalue_ref val)
 {
 	if (val == NULL) return NULL;
 
 	SANITY_CHECK_POINTER(val);
-	assert(s_inGdb || val->m_refCnt > 0);
+	assert(s_inGdb || jis_referenced(val));
+
+	if (jis_biased(val)) {
+		int biased = jbiased_get(val);
+		if (LIKELY(val->m_owner == jbiased_current && biased > 0))
+			jbiased_set(val, biased + 1);
+		else
+			g_atomic_int_add(&val->m_refCnt, J_BIASED_ONE);
+		return val;
+	}
+
+	if (jis_compact(val)) {
+		jcompact_copy(val);
+		return val;
+	}
 
 	if (jis_const(val)) return val;
 
@@ -200,7 +245,8 @@ jvalue_ref jvalue_duplicate (jvalue_ref val)
 	jvalue_ref result = val;
 	SANITY_CHECK_POINTER(val);
 
-	if (jis_const(val)) return result;
+	// Shared and arena values are duplicated to let the copy outlive them
+	if (jis_const(val) && !jis_borrowed(val)) return result;
 
 	if (jis_object (val)) {
 		result = jobject_create_hint (jobject_size (val));
@@ -210,8 +256,9 @@ jvalue_ref jvalue_duplicate (jvalue_ref val)
 		jobject_iter_init(&it, val);
 		while (jobject_iter_next(&it, &pair))
 		{
+			jvalue_ref keyCopy = jis_borrowed(pair.key) ? jvalue_duplicate (pair.key) : jvalue_copy (pair.key);
 			jvalue_ref valueCopy = jvalue_duplicate (pair.value);
-			if (!jobject_put (result, jvalue_copy (pair.key), valueCopy)) {
+			if (!jobject_put (result, keyCopy, valueCopy)) {
 				j_release (&result);
 				result = NULL;
 				break;
@@ -231,7 +278,7 @@ jvalue_ref jvalue_duplicate (jvalue_ref val)
 	} else {
 		// string, number, & boolean are immutable, so no need to do an actual duplication
 		if (jis_string(val)) {
-			result = jstring_create_copy(jstring_get_fast(val));
+			result = jstring_duplicate(val);
 		} else if (jis_number(val)) {
 			result = jnumber_duplicate(val);
 		} else
@@ -311,8 +358,47 @@ int jvalue_compare(const jvalue_ref val1, const jvalue_ref val2)
 static void j_destroy_object (jvalue_ref obj) NON_NULL(1);
 static void j_destroy_array (jvalue_ref arr) NON_NULL(1);
 static void j_destroy_string (jvalue_ref str) NON_NULL(1);
+static size_t j_string_alloc_size (jvalue_ref str) NON_NULL(1);
 static void j_destroy_number (jvalue_ref num) NON_NULL(1);
 
+size_t jvalue_destroy(jvalue_ref val)
+{
+	_jbuffer *str = &val->m_string;
+	if (str->destructor) {
+		PJ_LOG_MEM("Freeing string representation of jvalue %p", str->buffer.m_str);
+		str->destructor(str);
+	}
+
+	_jbuffer *buf = &val->m_file;
+	if (buf->destructor)
+		buf->destructor(buf);
+
+	switch (val->m_type) {
+		case JV_OBJECT:
+			j_destroy_object (val);
+			return sizeof(jobject);
+		case JV_ARRAY:
+			j_destroy_array (val);
+			return sizeof(jarray);
+		case JV_STR:
+		{
+			// Destruction kills the buffer, so the size should be taken first
+			size_t size = j_string_alloc_size(val);
+			j_destroy_string (val);
+			return size;
+		}
+		case JV_NUM:
+			j_destroy_number (val);
+			return sizeof(jnum);
+		case JV_BOOL:
+		case JV_NULL:
+			PJ_LOG_ERR("Invalid program state - should've already returned from j_release before this point");
+			assert(false);
+			break;
+	}
+	return 0;
+}
+
 void j_release (jvalue_ref *val)
 {
 	SANITY_CHECK_POINTER(val);
@@ -321,6 +407,23 @@ void j_release (jvalue_ref *val)
 		SANITY_KILL_POINTER(*val);
 		return;
 	}
+	if (jis_biased(*val)) {
+		int biased = jbiased_get(*val);
+		if (LIKELY((*val)->m_owner == jbiased_current && biased > 0)) {
+			jbiased_set(*val, --biased);
+			if (UNLIKELY(biased == 0))
+				jbiased_merge(*val);
+		} else {
+			jbiased_release(*val);
+		}
+		SANITY_KILL_POINTER(*val);
+		return;
+	}
+	if (UNLIKELY(jis_compact(*val))) {
+		jcompact_release(*val);
+		SANITY_KILL_POINTER(*val);
+		return;
+	}
 	if (UNLIKELY(jis_const(*val))) {
 		SANITY_KILL_POINTER(*val);
 		return;
@@ -330,40 +433,10 @@ void j_release (jvalue_ref *val)
 
 	if (g_atomic_int_dec_and_test(&(*val)->m_refCnt)) {
 		TRACE_REF("freeing because refcnt is 0: %s", *val, jvalue_tostring(*val, jschema_all()));
-		_jbuffer *str = &(*val)->m_string;
-		if (str->destructor) {
-			PJ_LOG_MEM("Freeing string representation of jvalue %p", str->buffer.m_str);
-			str->destructor(str);
-		}
-
-		_jbuffer *buf = &(*val)->m_file;
-		if (buf->destructor)
-			buf->destructor(buf);
-
+		size_t size = jvalue_destroy(*val);
 		PJ_LOG_MEM("Freeing %p", *val);
-		switch ((*val)->m_type) {
-			case JV_OBJECT:
-				j_destroy_object (*val);
-				g_slice_free1(sizeof(jobject), *val);
-				break;
-			case JV_ARRAY:
-				j_destroy_array (*val);
-				g_slice_free1(sizeof(jarray), *val);
-				break;
-			case JV_STR:
-				j_destroy_string (*val);
-				free(*val);
-				break;
-			case JV_NUM:
-				j_destroy_number (*val);
-				g_slice_free1(sizeof(jnum), *val);
-				break;
-			case JV_BOOL:
-			case JV_NULL:
-				PJ_LOG_ERR("Invalid program state - should've already returned from j_release before this point");
-				assert(false);
-				break;
-		}
+		if (size)
+			dom_node_free(size, *val);
 	} else if (UNLIKELY((*val)->m_refCnt < 0)) {
 		PJ_LOG_ERR("reference counter messed up - memory corruption and/or random crashes are possible");
 		assert(false);
@@ -411,6 +484,21 @@ jvalue_ref jnull ()
 	return &JNULL;
 }
 
+jvalue_ref jshared_link_deref(jshared_link const *link)
+{
+	switch (*link)
+	{
+	case J_SHARED_LINK_NULL:
+		return &JNULL;
+	case J_SHARED_LINK_FALSE:
+		return &JFALSE.m_value;
+	case J_SHARED_LINK_TRUE:
+		return &JTRUE.m_value;
+	default:
+		return (jvalue_ref)((char const *)link + *link);
+	}
+}
+
 /************************* JSON OBJECT API **************************************/
 
 static unsigned long key_hash_raw (raw_buffer const *str) NON_NULL(1);
@@ -441,6 +529,11 @@ static bool check_insert_sanity(jvalue_ref parent, jvalue_ref child)
 		return false;
 	}
 
+	// Shared values can't refer to the values outside of their segment
+	if (jis_shared(child)) {
+		return true;
+	}
+
 	// Then check recursively child's children (if child is an array or an object)
 	if (jis_array(child)) {
 		for (int i = 0; i < jarray_size(child); i++) {
@@ -491,14 +584,13 @@ static void _ObjKeyValDestroy(gpointer data)
 
 jvalue_ref jobject_create ()
 {
-	jobject *new_obj = g_slice_new0(jobject);
+	jobject *new_obj = (jobject *) jvalue_alloc0(sizeof(jobject), JV_OBJECT);
 	CHECK_ALLOC_RETURN_NULL(new_obj);
-	jvalue_init((jvalue_ref)new_obj, JV_OBJECT);
 	new_obj->m_members = g_hash_table_new_full(ObjKeyHash, ObjKeyEqual,
 	                                           _ObjKeyValDestroy, _ObjKeyValDestroy);
 	if (!new_obj->m_members)
 	{
-		free(new_obj);
+		jvalue_free_node((jvalue_ref)new_obj, sizeof(jobject));
 		return NULL;
 	}
 	TRACE_REF("created", new_obj);
@@ -548,11 +640,53 @@ jvalue_ref jobject_create_hint (int capacityHint)
 	return jobject_create();
 }
 
+jvalue_ref jobject_create_from_arrays (jvalue_ref const keys[], jvalue_ref const values[], size_t count)
+{
+	jvalue_ref new_object = jobject_create ();
+	size_t i = 0;
+
+	if (new_object) {
+		GHashTable *members = jobject_deref(new_object)->m_members;
+
+		for (; i < count; i++) {
+			jvalue_ref key = keys[i];
+			if (UNLIKELY(!jis_string(key) || jstring_size(key) == 0)) {
+				PJ_LOG_ERR("Object key #%zu isn't a non-empty string", i);
+				break;
+			}
+
+			jvalue_ref val = values[i];
+			if (val == NULL || !jis_valid(val))
+				val = jnull ();
+
+			// Nobody can refer to the new object, so cycles aren't possible
+			guint size = g_hash_table_size(members);
+			g_hash_table_replace(members, jvalue_copy(key), val);
+			if (UNLIKELY(g_hash_table_size(members) == size)) {
+				PJ_LOG_ERR("Duplicate object key \"%.*s\"", (int)jstring_size(key), jstring_get_fast(key).m_str);
+				++i;
+				break;
+			}
+		}
+
+		if (LIKELY(i == count))
+			return new_object;
+
+		j_release(&new_object);
+	}
+
+	for (; i < count; i++) {
+		jvalue_ref val = values[i];
+		j_release(&val);
+	}
+	return jinvalid();
+}
+
 bool jis_object (jvalue_ref val)
 {
 	SANITY_CHECK_POINTER(val);
 	CHECK_POINTER_RETURN_VALUE(val, false);
-	assert((s_inGdb || val->m_refCnt > 0) && "val is garbage");
+	assert((s_inGdb || jis_referenced(val)) && "val is garbage");
 
 	return val->m_type == JV_OBJECT;
 }
@@ -586,7 +720,7 @@ static bool jobject_equal(jvalue_ref obj, jvalue_ref other)
 
 static int qsort_helper(const void* p1, const void* p2)
 {
-	return jstring_compare(* (const jvalue_ref const *)p1, * (const jvalue_ref const *)p2);
+	return jstring_compare(((const jobject_key_value *)p1)->key, ((const jobject_key_value *)p2)->key);
 }
 
 static int jobject_compare(const jvalue_ref obj1, const jvalue_ref obj2)
@@ -599,38 +733,29 @@ static int jobject_compare(const jvalue_ref obj1, const jvalue_ref obj2)
 
 	const ssize_t obj1_size = jobject_size(obj1);
 	const ssize_t obj2_size = jobject_size(obj2);
-	jvalue_ref obj1_keys[obj1_size];
-	jvalue_ref obj2_keys[obj2_size];
+	jobject_key_value obj1_pairs[obj1_size];
+	jobject_key_value obj2_pairs[obj2_size];
 
-	GHashTableIter iter;
-	g_hash_table_iter_init (&iter, jobject_deref(obj1)->m_members);
-
-	gpointer key;
+	jobject_iter iter;
+	jobject_iter_init(&iter, obj1);
 	for (ssize_t i = 0; i < obj1_size; ++i)
-	{
-		(void) g_hash_table_iter_next(&iter, &key, NULL);
-		obj1_keys[i] = (jvalue_ref)key;
-	}
+		(void) jobject_iter_next(&iter, &obj1_pairs[i]);
 
-	g_hash_table_iter_init (&iter, jobject_deref(obj2)->m_members);
+	jobject_iter_init(&iter, obj2);
 	for (ssize_t i = 0; i < obj2_size; ++i)
-	{
-		(void) g_hash_table_iter_next(&iter, &key, NULL);
-		obj2_keys[i] = (jvalue_ref)key;
-	}
+		(void) jobject_iter_next(&iter, &obj2_pairs[i]);
 
-	qsort(obj1_keys, obj1_size, sizeof(jvalue_ref), qsort_helper);
-	qsort(obj2_keys, obj2_size, sizeof(jvalue_ref), qsort_helper);
+	qsort(obj1_pairs, obj1_size, sizeof(jobject_key_value), qsort_helper);
+	qsort(obj2_pairs, obj2_size, sizeof(jobject_key_value), qsort_helper);
 	ssize_t size = obj1_size < obj2_size ? obj1_size : obj2_size;
 
 	for (ssize_t i = 0; i < size; ++i)
 	{
-		int result = jstring_compare(obj1_keys[i], obj2_keys[i]);
+		int result = jstring_compare(obj1_pairs[i].key, obj2_pairs[i].key);
 		if (result != 0)
 			return result;
 
-		result = jvalue_compare((jvalue_ref)g_hash_table_lookup(jobject_deref(obj1)->m_members, obj1_keys[i]),
-							   (jvalue_ref)g_hash_table_lookup(jobject_deref(obj2)->m_members, obj2_keys[i]));
+		result = jvalue_compare(obj1_pairs[i].value, obj2_pairs[i].value);
 
 		if (result != 0)
 			return result;
@@ -639,12 +764,35 @@ static int jobject_compare(const jvalue_ref obj1, const jvalue_ref obj2)
 	return obj1_size - obj2_size;
 }
 
+// Members of a shared object are ordered, so the key is found by the binary search
+static jvalue_ref jshared_object_lookup(jvalue_ref obj, raw_buffer key)
+{
+	jshared_object const *shared = jshared_object_deref(obj);
+
+	size_t low = 0, high = shared->m_size;
+	while (low < high) {
+		size_t middle = low + (high - low) / 2;
+		jshared_member const *member = &shared->m_members[middle];
+
+		int result = jshared_key_compare(jstring_deref_buffer(jshared_link_deref(&member->key)), key);
+		if (result == 0)
+			return jshared_link_deref(&member->value);
+		if (result < 0)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+	return NULL;
+}
+
 size_t jobject_size(jvalue_ref obj)
 {
 	SANITY_CHECK_POINTER(obj);
 
 	CHECK_CONDITION_RETURN_VALUE(!jis_object(obj), 0, "Attempt to retrieve size from something not an object %p", obj);
 
+	if (jis_shared(obj))
+		return jshared_object_deref(obj)->m_size;
 	if (!jobject_deref(obj)->m_members)
 		return 0;
 	return g_hash_table_size(jobject_deref(obj)->m_members);
@@ -674,10 +822,12 @@ bool jobject_get_exists2 (jvalue_ref obj, jvalue_ref key, jvalue_ref *value)
 	CHECK_CONDITION_RETURN_VALUE(jis_null(obj), false, "Attempt to cast null %p to object", obj);
 	CHECK_CONDITION_RETURN_VALUE(!jis_object(obj), false, "Attempt to cast type %d to object (%d)", obj->m_type, JV_OBJECT);
 
-	if (!jobject_deref(obj)->m_members)
+	if (jis_shared(obj))
+		result = jshared_object_lookup(obj, jstring_deref_buffer(key));
+	else if (!jobject_deref(obj)->m_members)
 		return false;
-
-	result = g_hash_table_lookup(jobject_deref(obj)->m_members, key);
+	else
+		result = g_hash_table_lookup(jobject_deref(obj)->m_members, key);
 	if (!result)
 		return false;
 
@@ -836,12 +986,34 @@ bool jobject_put (jvalue_ref obj, jvalue_ref key, jvalue_ref val)
 	return false;
 }
 
+// Iterator over a shared object reuses the storage of the hash table iterator.
+// The tag takes the place of the hash table pointer to tell them apart.
+typedef struct {
+	void const *tag;
+	jshared_member const *pos;
+	jshared_member const *end;
+} jshared_iter;
+
+_Static_assert(sizeof(jshared_iter) <= sizeof(GHashTableIter), "jshared_iter should fit jobject_iter");
+
+static const char jshared_iter_tag;
+
 // JSON Object iterators
 bool jobject_iter_init(jobject_iter *iter, jvalue_ref obj)
 {
 	SANITY_CHECK_POINTER(obj);
 
 	CHECK_CONDITION_RETURN_VALUE(!jis_object(obj), false, "Cannot iterate over non-object");
+
+	if (jis_shared(obj)) {
+		jshared_object const *shared = jshared_object_deref(obj);
+		jshared_iter *it = (jshared_iter *) &iter->m_iter;
+		it->tag = &jshared_iter_tag;
+		it->pos = shared->m_members;
+		it->end = shared->m_members + shared->m_size;
+		return true;
+	}
+
 	CHECK_CONDITION_RETURN_VALUE(!jobject_deref(obj)->m_members, false, "The object isn't iterable");
 
 	g_hash_table_iter_init(&iter->m_iter, jobject_deref(obj)->m_members);
@@ -850,6 +1022,16 @@ bool jobject_iter_init(jobject_iter *iter, jvalue_ref obj)
 
 bool jobject_iter_next(jobject_iter *iter, jobject_key_value *keyval)
 {
+	jshared_iter *it = (jshared_iter *) &iter->m_iter;
+	if (UNLIKELY(it->tag == &jshared_iter_tag)) {
+		if (it->pos == it->end)
+			return false;
+		keyval->key = jshared_link_deref(&it->pos->key);
+		keyval->value = jshared_link_deref(&it->pos->value);
+		++it->pos;
+		return true;
+	}
+
 	return g_hash_table_iter_next(&iter->m_iter,
 	                              (gpointer *)&keyval->key, (gpointer *)&keyval->value);
 }
@@ -905,9 +1087,8 @@ static void j_destroy_array (jvalue_ref arr)
 
 jvalue_ref jarray_create (jarray_opts opts)
 {
-	jarray *new_array = g_slice_new0(jarray);
+	jarray *new_array = (jarray *) jvalue_alloc0(sizeof(jarray), JV_ARRAY);
 	CHECK_ALLOC_RETURN_NULL(new_array);
-	jvalue_init((jvalue_ref)new_array, JV_ARRAY);
 
 	new_array->m_capacity = ARRAY_BUCKET_SIZE;
 	TRACE_REF("created", new_array);
@@ -960,7 +1141,7 @@ bool jis_array (jvalue_ref val)
 {
 	SANITY_CHECK_POINTER(val);
 	CHECK_POINTER_RETURN_VALUE(val, false);
-	assert(s_inGdb || val->m_refCnt > 0);
+	assert(s_inGdb || jis_referenced(val));
 
 	return val->m_type == JV_ARRAY;
 }
@@ -1020,6 +1201,8 @@ static inline ssize_t jarray_size_unsafe (jvalue_ref arr)
 	assert(arr != NULL);
 	assert(arr->m_type == JV_ARRAY);
 
+	if (jis_shared(arr))
+		return jshared_array_deref(arr)->m_size;
 	return jarray_deref(arr)->m_size;
 }
 
@@ -1064,13 +1247,21 @@ static jvalue_ref* jarray_get_unsafe (jvalue_ref arr, ssize_t index)
 	return &jarray_deref(arr)->m_smallBucket [index];
 }
 
+// Element of the array in any representation, NULL for unassigned ones
+static jvalue_ref jarray_peek_unsafe (jvalue_ref arr, ssize_t index)
+{
+	if (jis_shared(arr))
+		return jshared_link_deref(&jshared_array_deref(arr)->m_items[index]);
+	return *jarray_get_unsafe(arr, index);
+}
+
 jvalue_ref jarray_get (jvalue_ref arr, ssize_t index)
 {
 	jvalue_ref result;
 
 	CHECK_CONDITION_RETURN_VALUE(!valid_index_bounded(arr, index), jinvalid(), "Attempt to get array element from %p with out-of-bounds index value %zd", arr, index);
 
-	result = * (jarray_get_unsafe (arr, index));
+	result = jarray_peek_unsafe (arr, index);
 	if (result == NULL)
 	// need to fix up in case we haven't assigned anything to that space - it's initialized to NULL (JSON undefined)
 	result = jinvalid ();
@@ -1108,6 +1299,7 @@ static void jarray_remove_unsafe (jvalue_ref arr, ssize_t index)
 bool jarray_remove (jvalue_ref arr, ssize_t index)
 {
 	CHECK_CONDITION_RETURN_VALUE(!valid_index_bounded(arr, index), false, "Attempt to get array element from %p with out-of-bounds index value %zd", arr, index);
+	CHECK_CONDITION_RETURN_VALUE(jis_shared(arr), false, "Attempt to modify shared array %p", arr);
 
 	jarray_remove_unsafe (arr, index);
 
@@ -1147,6 +1339,8 @@ static bool jarray_put_unsafe (jvalue_ref arr, ssize_t index, jvalue_ref val)
 	SANITY_CHECK_POINTER(arr);
 	assert(jis_array(arr));
 
+	CHECK_CONDITION_RETURN_VALUE(jis_shared(arr), false, "Attempt to modify shared array %p", arr);
+
 	if (!check_insert_sanity(arr, val)) {
 		PJ_LOG_ERR("Error in object hierarchy. Inserting jvalue would create an illegal cyclic dependency");
 		return false;
@@ -1249,6 +1443,7 @@ bool jarray_insert(jvalue_ref arr, ssize_t index, jvalue_ref val)
 
 	CHECK_CONDITION_RETURN_VALUE(!jis_array(arr), false, "Array to insert into isn't a valid reference to a JSON DOM node: %p", arr);
 	CHECK_CONDITION_RETURN_VALUE(index < 0, false, "Invalid index - must be >= 0: %zd", index);
+	CHECK_CONDITION_RETURN_VALUE(jis_shared(arr), false, "Attempt to modify shared array %p", arr);
 
 	if (!check_insert_sanity(arr, val)) {
 		PJ_LOG_ERR("Error in object hierarchy. Inserting jvalue would create an illegal cyclic dependency");
@@ -1277,14 +1472,18 @@ bool jarray_insert(jvalue_ref arr, ssize_t index, jvalue_ref val)
 }
 
 // Helper function to check insert sanity for jarray_splice
-static bool jarray_splice_check_insert_sanity(jvalue_ref arr, jvalue_ref arr2)
+static bool jarray_splice_check_insert_sanity(jvalue_ref arr, jvalue_ref arr2, ssize_t begin, ssize_t end)
 {
 	assert(jis_array(arr));
 	assert(jis_array(arr2));
 
-	for (int i = 0; i < jarray_size(arr2); i++) {
-		jvalue_ref arr_elem = jarray_get(arr2, i);
-		if (!check_insert_sanity(arr, arr_elem)) {
+	// Elements of the array itself can't introduce a new cycle
+	if (arr == arr2)
+		return true;
+
+	for (ssize_t i = begin; i < end; i++) {
+		jvalue_ref arr_elem = jarray_peek_unsafe(arr2, i);
+		if (arr_elem && !check_insert_sanity(arr, arr_elem)) {
 			return false;
 		}
 	}
@@ -1292,91 +1491,138 @@ static bool jarray_splice_check_insert_sanity(jvalue_ref arr, jvalue_ref arr2)
 	return true;
 }
 
-bool jarray_splice (jvalue_ref array, ssize_t index, ssize_t toRemove, jvalue_ref array2, ssize_t begin, ssize_t end, JSpliceOwnership ownership)
+// Copy count element pointers starting from index into buffer
+static void jarray_read_unsafe (jvalue_ref arr, ssize_t index, jvalue_ref *buffer, ssize_t count)
 {
-	ssize_t i, j;
-	size_t removable = toRemove;
-	jvalue_ref *valueInOtherArray;
-	jvalue_ref valueToInsert;
+	if (jis_shared(arr)) {
+		for (ssize_t i = 0; i < count; i++)
+			buffer[i] = jarray_peek_unsafe(arr, index + i);
+		return;
+	}
+
+	assert(index + count <= jarray_deref(arr)->m_capacity);
+
+	ssize_t small = index < ARRAY_BUCKET_SIZE ? MIN(count, ARRAY_BUCKET_SIZE - index) : 0;
+	if (small > 0)
+		memcpy(buffer, &jarray_deref(arr)->m_smallBucket[index], small * sizeof(jvalue_ref));
+	if (count > small)
+		memcpy(buffer + small, jarray_get_unsafe(arr, index + small), (count - small) * sizeof(jvalue_ref));
+}
+
+// Copy count element pointers from buffer into the array starting from index
+static void jarray_write_unsafe (jvalue_ref arr, ssize_t index, jvalue_ref const *buffer, ssize_t count)
+{
+	assert(index + count <= jarray_deref(arr)->m_capacity);
 
-	if (LIKELY(removable)) {
+	ssize_t small = index < ARRAY_BUCKET_SIZE ? MIN(count, ARRAY_BUCKET_SIZE - index) : 0;
+	if (small > 0)
+		memcpy(&jarray_deref(arr)->m_smallBucket[index], buffer, small * sizeof(jvalue_ref));
+	if (count > small)
+		memcpy(jarray_get_unsafe(arr, index + small), buffer + small, (count - small) * sizeof(jvalue_ref));
+}
+
+// Move count element pointers from index from to index to like memmove() does.
+// Only the part in the small bucket is moved element by element.
+static void jarray_move_unsafe (jvalue_ref arr, ssize_t to, ssize_t from, ssize_t count)
+{
+	assert(MAX(to, from) + count <= jarray_deref(arr)->m_capacity);
+
+	if (to == from || count <= 0)
+		return;
+
+	if (to < from) {
+		ssize_t i = 0;
+		for (; i < count && to + i < ARRAY_BUCKET_SIZE; i++)
+			*jarray_get_unsafe(arr, to + i) = *jarray_get_unsafe(arr, from + i);
+		if (i < count)
+			memmove(jarray_get_unsafe(arr, to + i), jarray_get_unsafe(arr, from + i), (count - i) * sizeof(jvalue_ref));
+	} else {
+		// Tail of the source in the big bucket goes first
+		ssize_t small = MIN(count, MAX(0, ARRAY_BUCKET_SIZE - from));
+		if (small < count)
+			memmove(jarray_get_unsafe(arr, to + small), jarray_get_unsafe(arr, from + small), (count - small) * sizeof(jvalue_ref));
+		for (ssize_t i = small - 1; i >= 0; i--)
+			*jarray_get_unsafe(arr, to + i) = *jarray_get_unsafe(arr, from + i);
+	}
+}
+
+static void jarray_clear_unsafe (jvalue_ref arr, ssize_t index, ssize_t count)
+{
+	for (ssize_t i = index; i < index + count && i < ARRAY_BUCKET_SIZE; i++)
+		jarray_deref(arr)->m_smallBucket[i] = NULL;
+	if (index + count > ARRAY_BUCKET_SIZE) {
+		ssize_t big = MAX(index, ARRAY_BUCKET_SIZE);
+		memset(jarray_get_unsafe(arr, big), 0, (index + count - big) * sizeof(jvalue_ref));
+	}
+}
+
+bool jarray_splice (jvalue_ref array, ssize_t index, ssize_t toRemove, jvalue_ref array2, ssize_t begin, ssize_t end, JSpliceOwnership ownership)
+{
+	if (LIKELY(toRemove)) {
 		CHECK_CONDITION_RETURN_VALUE(!valid_index_bounded(array, index), false, "Splice index is invalid");
 		CHECK_CONDITION_RETURN_VALUE(!valid_index_bounded(array, index + toRemove - 1), false, "To remove amount is out of bounds of array");
 	} else {
 		SANITY_CHECK_POINTER(array);
 		CHECK_CONDITION_RETURN_VALUE(!jis_array(array), false, "Array isn't valid %p", array);
 		if (index < 0) index = 0;
+		if (index > jarray_size_unsafe(array)) index = jarray_size_unsafe(array);
 	}
 	CHECK_CONDITION_RETURN_VALUE(begin >= end, false, "Invalid range to copy from second array: [%zd, %zd)", begin, end); // set notation
 	CHECK_CONDITION_RETURN_VALUE(!valid_index_bounded(array2, begin), false, "Start index is invalid for second array");
 	CHECK_CONDITION_RETURN_VALUE(!valid_index_bounded(array2, end - 1), false, "End index is invalid for second array");
 	CHECK_CONDITION_RETURN_VALUE(toRemove < 0, false, "Invalid amount %zd to remove during splice", toRemove);
+	CHECK_CONDITION_RETURN_VALUE(array == array2 && ownership == SPLICE_TRANSFER, false, "Can't transfer elements of %p into itself", array);
+	CHECK_CONDITION_RETURN_VALUE(jis_shared(array), false, "Attempt to modify shared array %p", array);
+	CHECK_CONDITION_RETURN_VALUE(jis_shared(array2) && ownership == SPLICE_TRANSFER, false, "Can't transfer elements out of shared array %p", array2);
 
-	if (!jarray_splice_check_insert_sanity(array, array2)) {
+	if (!jarray_splice_check_insert_sanity(array, array2, begin, end)) {
 		PJ_LOG_ERR("Error in object hierarchy. Splicing array would create an illegal cyclic dependency");
 		return false;
 	}
 
-	for (i = index, j = begin; removable && j < end; i++, removable--, j++) {
-		assert(valid_index_bounded(array, i));
-		assert(valid_index_bounded(array2, j));
-		valueInOtherArray = jarray_get_unsafe(array2, j);
-		valueToInsert = *valueInOtherArray;
-		assert(valueInOtherArray != NULL);
-		switch (ownership) {
-			case SPLICE_TRANSFER:
-				*valueInOtherArray = NULL;
-				jarray_size_decrement_unsafe (array2);
-				break;
-			case SPLICE_NOCHANGE:
-				break;
-			case SPLICE_COPY:
-				valueToInsert = jvalue_copy(valueToInsert);
-				break;
-		}
-		jarray_put_unsafe (array, i, valueToInsert);
+	ssize_t count = end - begin;
+	ssize_t size = jarray_size_unsafe(array);
+	ssize_t newSize = size - toRemove + count;
+	if (!jarray_expand_capacity_unsafe(array, newSize)) {
+		PJ_LOG_WARN("Failed to expand array to splice elements - memory allocation problem?");
+		return false;
 	}
 
-	if (removable != 0) {
-		assert (j == end);
-		assert (toRemove > end - begin);
+	// Take the inserted elements out first, the arrays may be the same
+	jvalue_ref stackBuffer[ARRAY_BUCKET_SIZE];
+	jvalue_ref *items = count <= ARRAY_BUCKET_SIZE ? stackBuffer : malloc(count * sizeof(jvalue_ref));
+	CHECK_ALLOC_RETURN_VALUE(items, false);
+	jarray_read_unsafe(array2, begin, items, count);
 
-		while (removable) {
-			jarray_remove_unsafe (array, i);
-			removable--;
-		}
-	} else if (j < end) {
-		assert (toRemove < end - begin);
-		assert (removable == 0);
-
-		jarray_expand_capacity_unsafe (array, jarray_size_unsafe (array) + (end - j));
-
-		// insert any remaining elements that don't overlap the amount to remove
-		for (; j < end; j++, i++) {
-			assert(valid_index_bounded(array2, j));
-
-			valueInOtherArray = jarray_get_unsafe(array2, j);
-			valueToInsert = *valueInOtherArray;
-			assert(valueInOtherArray != NULL);
-			switch (ownership) {
-				case SPLICE_TRANSFER:
-					*valueInOtherArray = NULL;
-					jarray_size_decrement_unsafe (array2);
-					break;
-				case SPLICE_NOCHANGE:
-					break;
-				case SPLICE_COPY:
-					valueToInsert = jvalue_copy(valueToInsert);
-					break;
-			}
-			if (UNLIKELY(!jarray_insert(array, i, valueToInsert))) {
-				PJ_LOG_ERR("How did this happen? Failed to insert %zd from second array into %zd of first array", j, i);
-				return false;
-			}
+	switch (ownership) {
+		case SPLICE_TRANSFER: {
+			// Close the gap in the source array at once
+			ssize_t size2 = jarray_size_unsafe(array2);
+			jarray_move_unsafe(array2, begin, end, size2 - end);
+			jarray_clear_unsafe(array2, size2 - count, count);
+			jarray_size_set_unsafe(array2, size2 - count);
+			break;
 		}
-	} else {
-		assert (toRemove == end - begin);
+		case SPLICE_NOCHANGE:
+			break;
+		case SPLICE_COPY:
+			for (ssize_t i = 0; i < count; i++)
+				if (items[i])
+					items[i] = jvalue_copy(items[i]);
+			break;
 	}
+
+	for (ssize_t i = index; i < index + toRemove; i++)
+		j_release(jarray_get_unsafe(array, i));
+
+	jarray_move_unsafe(array, index + count, index + toRemove, size - index - toRemove);
+	if (newSize < size)
+		jarray_clear_unsafe(array, newSize, size - newSize);
+	jarray_write_unsafe(array, index, items, count);
+	jarray_size_set_unsafe(array, newSize);
+
+	if (items != stackBuffer)
+		free(items);
 	return true;
 }
 
@@ -1387,7 +1633,7 @@ bool jarray_splice_inject (jvalue_ref array, ssize_t index, jvalue_ref arrayToIn
 
 bool jarray_splice_append (jvalue_ref array, jvalue_ref arrayToAppend, JSpliceOwnership ownership)
 {
-	return jarray_splice (array, jarray_size (array) - 1, 0, arrayToAppend, 0, jarray_size (arrayToAppend), ownership);
+	return jarray_splice (array, jarray_size (array), 0, arrayToAppend, 0, jarray_size (arrayToAppend), ownership);
 }
 
 bool jarray_has_duplicates(jvalue_ref arr)
@@ -1400,10 +1646,10 @@ bool jarray_has_duplicates(jvalue_ref arr)
 
 	for (ssize_t i = 0; i < size - 1; ++i)
 	{
-		jvalue_ref jvali = *jarray_get_unsafe(arr, i);
+		jvalue_ref jvali = jarray_peek_unsafe(arr, i);
 		for (ssize_t j = i + 1; j < size; ++j)
 		{
-			if (jvalue_equal(jvali, *jarray_get_unsafe(arr, j)))
+			if (jvalue_equal(jvali, jarray_peek_unsafe(arr, j)))
 				return true;
 		}
 	}
@@ -1416,11 +1662,55 @@ bool jarray_has_duplicates(jvalue_ref arr)
 #define SANITY_CHECK_JSTR_BUFFER(jval)					\
 	do {								\
 		SANITY_CHECK_POINTER(jval);				\
-		SANITY_CHECK_POINTER(jstring_deref(jval)->m_data.m_str);	\
-		SANITY_CHECK_MEMORY(jstring_deref(jval)->m_data.m_str, jstring_deref(jval)->m_data.m_len);	\
+		SANITY_CHECK_POINTER(jstring_deref_buffer(jval).m_str);	\
+		SANITY_CHECK_MEMORY(jstring_deref_buffer(jval).m_str, jstring_deref_buffer(jval).m_len);	\
 		SANITY_CHECK_POINTER(jstring_deref(jval)->m_dealloc);	\
 	} while (0)
 
+typedef struct jstring_chunk {
+	struct jstring_chunk *m_next;
+	size_t m_len;
+	char m_data[];
+} jstring_chunk;
+
+typedef struct {
+	jstring m_header;          // m_dealloc is jstring_free_flat, m_data.m_len counts all the chunks
+	jstring_chunk *m_first;
+	jstring_chunk **m_link;    // Link to the last chunk, which has room for JSTRING_CHUNK_SIZE bytes till the string is complete
+} jstring_chunked;
+
+// Releases the flat text of a chunked string, and marks such strings
+static void jstring_free_flat(void *buffer)
+{
+	free(buffer);
+}
+
+static inline bool jis_chunked(jvalue_ref str)
+{
+	return jstring_deref(str)->m_dealloc == jstring_free_flat;
+}
+
+bool jstring_is_chunked(jvalue_ref str)
+{
+	return !jis_shared(str) && jis_chunked(str);
+}
+
+/**
+ * @brief Size of the memory block holding the string node
+ *
+ * Copied strings keep their buffer right after the header (see jstring_create_copy()),
+ * the rest reference an external buffer.
+ */
+static size_t j_string_alloc_size (jvalue_ref str)
+{
+	jstring *jstr = jstring_deref(str);
+	if (jis_chunked(str))
+		return sizeof(jstring_chunked);
+	if (jstr->m_data.m_str == ((jstring_inline *)jstr)->m_buf)
+		return sizeof(jstring_inline) + jstr->m_data.m_len + 1;
+	return sizeof(jstring);
+}
+
 static void j_destroy_string (jvalue_ref str)
 {
 	SANITY_CHECK_POINTER(str);
@@ -1432,6 +1722,14 @@ static void j_destroy_string (jvalue_ref str)
 		return;
 	}
 #endif
+	if (jis_chunked(str)) {
+		jstring_chunk *chunk = ((jstring_chunked *)str)->m_first;
+		while (chunk) {
+			jstring_chunk *next = chunk->m_next;
+			free(chunk);
+			chunk = next;
+		}
+	}
 	if (jstring_deref(str)->m_dealloc) {
 		PJ_LOG_MEM("Destroying string %p", jstring_deref(str)->m_data.m_str);
 		jstring_deref(str)->m_dealloc((char*)jstring_deref(str)->m_data.m_str);
@@ -1447,7 +1745,8 @@ bool jis_string_unsafe (jvalue_ref str)
 static unsigned long key_hash (jvalue_ref key)
 {
 	assert(jis_string_unsafe(key));
-	return key_hash_raw (&jstring_deref(key)->m_data);
+	raw_buffer str = jstring_deref_buffer(key);
+	return key_hash_raw (&str);
 }
 
 jvalue_ref jstring_empty ()
@@ -1469,9 +1768,8 @@ jvalue_ref jstring_create_utf8 (const char *cstring, ssize_t length)
 jvalue_ref jstring_create_copy (raw_buffer str)
 {
 	// size include 1 byte for ASCII and UTF-8 terminator
-	jstring_inline *new_str = (jstring_inline*) calloc (1, sizeof(jstring_inline) + str.m_len + 1);
+	jstring_inline *new_str = (jstring_inline*) jvalue_alloc0(sizeof(jstring_inline) + str.m_len + 1, JV_STR);
 	CHECK_POINTER_RETURN_NULL(new_str);
-	jvalue_init((jvalue_ref)new_str, JV_STR);
 
 	memcpy(new_str->m_buf, str.m_str, str.m_len);
 	new_str->m_header.m_dealloc = NULL;
@@ -1487,22 +1785,20 @@ bool jis_string (jvalue_ref str)
 		SANITY_CHECK_JSTR_BUFFER(str);
 #endif
 	CHECK_POINTER_RETURN_VALUE(str, false);
-	assert(s_inGdb || str->m_refCnt > 0);
+	assert(s_inGdb || jis_referenced(str));
 
 	return jis_string_unsafe(str);
 }
 
 jvalue_ref jstring_create_from_pool_internal(dom_string_memory_pool* pool, const char *data, size_t len)
 {
-	jstring *string = calloc(1, sizeof(jstring));
+	jstring *string = (jstring *) jvalue_alloc0(sizeof(jstring), JV_STR);
 	CHECK_POINTER_RETURN_NULL(string);
 
 	char *buffer = dom_string_memory_pool_alloc(pool, len + 1);
 	memcpy(buffer, data, len);
 	buffer[len] = '\0';
 
-	jvalue_init((jvalue_ref)string, JV_STR);
-
 	string->m_dealloc = dom_string_memory_pool_mark_as_free;
 	string->m_data = j_str_to_buffer(buffer, len);
 
@@ -1513,9 +1809,8 @@ jvalue_ref jnumber_create_from_pool_internal(dom_string_memory_pool* pool, const
 {
 	assert(data != NULL && len > 0);
 
-	jnum *new_number = g_slice_new0(jnum);
+	jnum *new_number = (jnum *) jvalue_alloc0(sizeof(jnum), JV_NUM);
 	CHECK_ALLOC_RETURN_NULL(new_number);
-	jvalue_init((jvalue_ref)new_number, JV_NUM);
 
 	char *buffer = dom_string_memory_pool_alloc(pool, len + 1);
 	memcpy(buffer, data, len);
@@ -1529,6 +1824,84 @@ jvalue_ref jnumber_create_from_pool_internal(dom_string_memory_pool* pool, const
 	return (jvalue_ref)new_number;
 }
 
+jvalue_ref jstring_chunked_create(void)
+{
+	jstring_chunked *new_str = (jstring_chunked *) jvalue_alloc0(sizeof(jstring_chunked), JV_STR);
+	CHECK_ALLOC_RETURN_NULL(new_str);
+
+	new_str->m_header.m_dealloc = jstring_free_flat;
+	new_str->m_link = &new_str->m_first;
+
+	TRACE_REF("created", new_str);
+	return (jvalue_ref)new_str;
+}
+
+bool jstring_chunked_append(jvalue_ref str, const char *data, size_t len, bool last)
+{
+	assert(jis_chunked(str));
+	jstring_chunked *jstr = (jstring_chunked *)str;
+
+	// Fragments are small or large as they come, chunks are filled up to the size
+	while (len) {
+		jstring_chunk *chunk = *jstr->m_link;
+		if (chunk && chunk->m_len == JSTRING_CHUNK_SIZE) {
+			jstr->m_link = &chunk->m_next;
+			chunk = NULL;
+		}
+		if (!chunk) {
+			chunk = malloc(sizeof(jstring_chunk) + JSTRING_CHUNK_SIZE);
+			CHECK_ALLOC_RETURN_VALUE(chunk, false);
+			chunk->m_next = NULL;
+			chunk->m_len = 0;
+			*jstr->m_link = chunk;
+		}
+
+		size_t n = MIN(len, JSTRING_CHUNK_SIZE - chunk->m_len);
+		memcpy(chunk->m_data + chunk->m_len, data, n);
+		chunk->m_len += n;
+		jstr->m_header.m_data.m_len += n;
+		data += n;
+		len -= n;
+	}
+
+	jstring_chunk *tail = *jstr->m_link;
+	if (last && tail && tail->m_len < JSTRING_CHUNK_SIZE) {
+		// Nothing is appended anymore, the last chunk gives the spare room back
+		jstring_chunk *shrunk = realloc(tail, sizeof(jstring_chunk) + tail->m_len);
+		if (shrunk)
+			*jstr->m_link = shrunk;
+	}
+	return true;
+}
+
+raw_buffer jstring_flatten(jvalue_ref str)
+{
+	jstring *jstr = jstring_deref(str);
+	if (!jis_chunked(str))
+		return jstr->m_data;
+
+	size_t len = jstr->m_data.m_len;
+	char *flat = malloc(len + 1);
+	CHECK_ALLOC_RETURN_VALUE(flat, j_str_to_buffer(NULL, 0));
+
+	char *pos = flat;
+	for (jstring_chunk *chunk = ((jstring_chunked *)str)->m_first; chunk; chunk = chunk->m_next) {
+		memcpy(pos, chunk->m_data, chunk->m_len);
+		pos += chunk->m_len;
+	}
+	*pos = '\0';
+
+	// Readers in other threads may be flattening the string too, the first copy wins.
+	// The chunks stay, iterators may be passing through them.
+	const char *expected = NULL;
+	if (!__atomic_compare_exchange_n(&jstr->m_data.m_str, &expected, flat, false,
+	                                 __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+		free(flat);
+		return j_str_to_buffer(expected, len);
+	}
+	return j_str_to_buffer(flat, len);
+}
+
 jvalue_ref jstring_create_nocopy (raw_buffer val)
 {
 	return jstring_create_nocopy_full (val, NULL);
@@ -1544,9 +1917,8 @@ jvalue_ref jstring_create_nocopy_full (raw_buffer val, jdeallocator buffer_deall
 		return &JEMPTY_STR.m_value;
 	}
 
-	jstring *new_string = (jstring *) calloc(1, sizeof(jstring));
+	jstring *new_string = (jstring *) jvalue_alloc0(sizeof(jstring), JV_STR);
 	CHECK_ALLOC_RETURN_NULL(new_string);
-	jvalue_init((jvalue_ref)new_string, JV_STR);
 
 	new_string->m_dealloc = buffer_dealloc;
 	new_string->m_data = val;
@@ -1562,8 +1934,7 @@ ssize_t jstring_size (jvalue_ref str)
 	SANITY_CHECK_JSTR_BUFFER(str);
 	CHECK_CONDITION_RETURN_VALUE(!jis_string(str), 0, "Invalid parameter - %d is not a string (%d)", str->m_type, JV_STR);
 
-	assert(jstring_deref(str)->m_data.m_str);
-
+	// The length of a chunked string is known without flattening it
 	return jstring_deref(str)->m_data.m_len;
 }
 
@@ -1573,17 +1944,48 @@ raw_buffer jstring_get (jvalue_ref str)
 	char *str_copy;
 
 	// performs the error checking for us as well
-	raw_buffer raw_str = jstring_get_fast (str);
-	if (UNLIKELY(raw_str.m_str == NULL)) return raw_str;
+	jstring_chunk_iter it;
+	if (UNLIKELY(!jstring_chunk_iter_init(&it, str))) return j_str_to_buffer (NULL, 0);
 
-	str_copy = calloc (raw_str.m_len + 1, sizeof(char));
+	size_t len = jstring_deref(str)->m_data.m_len;
+	str_copy = calloc (len + 1, sizeof(char));
 	if (str_copy == NULL) {
 		return j_str_to_buffer (NULL, 0);
 	}
 
-	memcpy (str_copy, raw_str.m_str, raw_str.m_len);
+	// A chunked string is copied chunk by chunk, it isn't flattened
+	raw_buffer chunk;
+	char *pos = str_copy;
+	while (jstring_chunk_iter_next(&it, &chunk)) {
+		memcpy (pos, chunk.m_str, chunk.m_len);
+		pos += chunk.m_len;
+	}
 
-	return j_str_to_buffer (str_copy, raw_str.m_len);
+	return j_str_to_buffer (str_copy, len);
+}
+
+// Copy of the string, a chunked one is copied chunk by chunk
+static jvalue_ref jstring_duplicate(jvalue_ref str)
+{
+	if (!jstring_is_chunked(str))
+		return jstring_create_copy(jstring_deref_buffer(str));
+
+	size_t len = jstring_deref(str)->m_data.m_len;
+	jstring_inline *new_string = (jstring_inline *) jvalue_alloc0(sizeof(jstring_inline) + len + 1, JV_STR);
+	CHECK_ALLOC_RETURN_NULL(new_string);
+
+	jstring_chunk_iter it;
+	jstring_chunk_iter_init(&it, str);
+	raw_buffer chunk;
+	char *pos = new_string->m_buf;
+	while (jstring_chunk_iter_next(&it, &chunk)) {
+		memcpy(pos, chunk.m_str, chunk.m_len);
+		pos += chunk.m_len;
+	}
+	*pos = '\0';
+
+	new_string->m_header.m_data = j_str_to_buffer(new_string->m_buf, len);
+	return (jvalue_ref)new_string;
 }
 
 raw_buffer jstring_get_fast (jvalue_ref str)
@@ -1591,22 +1993,108 @@ raw_buffer jstring_get_fast (jvalue_ref str)
 	SANITY_CHECK_JSTR_BUFFER(str);
 	CHECK_CONDITION_RETURN_VALUE(!jis_string(str), j_str_to_buffer(NULL, 0), "Invalid API use - attempting to get string buffer for non JSON string %p", str);
 
-	return jstring_deref(str)->m_data;
+	return jstring_deref_buffer(str);
+}
+
+bool jstring_chunk_iter_init(jstring_chunk_iter *iter, jvalue_ref str)
+{
+	CHECK_POINTER_RETURN_VALUE(iter, false);
+	CHECK_CONDITION_RETURN_VALUE(!jis_string(str), false, "Invalid API use - attempting to iterate over non JSON string %p", str);
+
+	if (jis_chunked(str)) {
+		iter->m_chunk = ((jstring_chunked *)str)->m_first;
+		iter->m_rest = j_str_to_buffer(NULL, 0);
+	} else {
+		iter->m_chunk = NULL;
+		iter->m_rest = jstring_deref_buffer(str);
+	}
+	return true;
+}
+
+bool jstring_chunk_iter_next(jstring_chunk_iter *iter, raw_buffer *chunk)
+{
+	CHECK_POINTER_RETURN_VALUE(iter, false);
+	CHECK_POINTER_RETURN_VALUE(chunk, false);
+
+	if (iter->m_chunk) {
+		const jstring_chunk *current = iter->m_chunk;
+		*chunk = j_str_to_buffer(current->m_data, current->m_len);
+		iter->m_chunk = current->m_next;
+		return true;
+	}
+	if (iter->m_rest.m_len) {
+		*chunk = iter->m_rest;
+		iter->m_rest = j_str_to_buffer(NULL, 0);
+		return true;
+	}
+	return false;
+}
+
+// Compares the first len bytes of the strings piece by piece, chunked strings aren't flattened
+static int jstring_compare_text(jvalue_ref str1, jvalue_ref str2, size_t len)
+{
+	jstring_chunk_iter it1, it2;
+	jstring_chunk_iter_init(&it1, str1);
+	jstring_chunk_iter_init(&it2, str2);
+
+	raw_buffer piece1 = j_str_to_buffer(NULL, 0);
+	raw_buffer piece2 = j_str_to_buffer(NULL, 0);
+	while (len) {
+		if (!piece1.m_len && !jstring_chunk_iter_next(&it1, &piece1))
+			break;
+		if (!piece2.m_len && !jstring_chunk_iter_next(&it2, &piece2))
+			break;
+
+		size_t size = MIN(MIN(piece1.m_len, piece2.m_len), len);
+		int result = memcmp(piece1.m_str, piece2.m_str, size);
+		if (result != 0)
+			return result;
+
+		piece1.m_str += size;
+		piece1.m_len -= size;
+		piece2.m_str += size;
+		piece2.m_len -= size;
+		len -= size;
+	}
+	return 0;
 }
 
 static bool jstring_equal_internal(jvalue_ref str, jvalue_ref other)
 {
 	SANITY_CHECK_JSTR_BUFFER(str);
 	SANITY_CHECK_JSTR_BUFFER(other);
-	return str == other ||
-			jstring_equal_internal2(str, &jstring_deref(other)->m_data);
+	if (str == other)
+		return true;
+	if (UNLIKELY(jstring_is_chunked(str) || jstring_is_chunked(other))) {
+		size_t len = jstring_deref(str)->m_data.m_len;
+		return len == jstring_deref(other)->m_data.m_len &&
+				jstring_compare_text(str, other, len) == 0;
+	}
+	raw_buffer other_data = jstring_deref_buffer(other);
+	return jstring_equal_internal2(str, &other_data);
 }
 
 static inline bool jstring_equal_internal2(jvalue_ref str, raw_buffer *other)
 {
 	SANITY_CHECK_JSTR_BUFFER(str);
 	SANITY_CHECK_MEMORY(other->m_str, other->m_len);
-	return jstring_equal_internal3(&jstring_deref(str)->m_data, other);
+	if (UNLIKELY(jstring_is_chunked(str))) {
+		if (jstring_deref(str)->m_data.m_len != other->m_len)
+			return false;
+
+		jstring_chunk_iter it;
+		jstring_chunk_iter_init(&it, str);
+		raw_buffer chunk;
+		const char *pos = other->m_str;
+		while (jstring_chunk_iter_next(&it, &chunk)) {
+			if (memcmp(chunk.m_str, pos, chunk.m_len) != 0)
+				return false;
+			pos += chunk.m_len;
+		}
+		return true;
+	}
+	raw_buffer data = jstring_deref_buffer(str);
+	return jstring_equal_internal3(&data, other);
 }
 
 static bool jstring_equal_internal3(raw_buffer *str, raw_buffer *other)
@@ -1652,7 +2140,7 @@ static int jstring_compare(const jvalue_ref str1, const jvalue_ref str2)
 	ssize_t str2_size = jstring_size(str2);
 	ssize_t size = str1_size < str2_size ? str1_size : str2_size;
 
-	int result = memcmp(jstring_deref(str1)->m_data.m_str, jstring_deref(str2)->m_data.m_str, size);
+	int result = jstring_compare_text(str1, str2, size);
 	if (result != 0)
 		return result;
 
@@ -1688,7 +2176,7 @@ jvalue_ref jnumber_duplicate (jvalue_ref num)
 
 	switch (jnum_deref(num)->m_type) {
 	case NUM_RAW:
-		return jnumber_create(jnum_deref(num)->value.raw);
+		return jnumber_create(jnum_deref_buffer(num));
 	case NUM_FLOAT:
 		return jnumber_create_f64(jnum_deref(num)->value.floating);
 	case NUM_INT:
@@ -1729,9 +2217,8 @@ jvalue_ref jnumber_create_unsafe (raw_buffer str, jdeallocator strFree)
 	CHECK_POINTER_RETURN_VALUE(str.m_str, jinvalid());
 	CHECK_CONDITION_RETURN_VALUE(str.m_len == 0, jinvalid(), "Invalid length parameter for numeric string %s", str.m_str);
 
-	jnum *new_number = g_slice_new0(jnum);
+	jnum *new_number = (jnum *) jvalue_alloc0(sizeof(jnum), JV_NUM);
 	CHECK_ALLOC_RETURN_NULL(new_number);
-	jvalue_init((jvalue_ref)new_number, JV_NUM);
 
 	new_number->m_type = NUM_RAW;
 	new_number->value.raw = str;
@@ -1746,9 +2233,8 @@ jvalue_ref jnumber_create_f64 (double number)
 	CHECK_CONDITION_RETURN_VALUE(isnan(number), jinvalid(), "NaN has no representation in JSON");
 	CHECK_CONDITION_RETURN_VALUE(isinf(number), jinvalid(), "Infinity has no representation in JSON");
 
-	jnum *new_number = g_slice_new0(jnum);
+	jnum *new_number = (jnum *) jvalue_alloc0(sizeof(jnum), JV_NUM);
 	CHECK_ALLOC_RETURN_NULL(new_number);
-	jvalue_init((jvalue_ref)new_number, JV_NUM);
 
 	new_number->m_type = NUM_FLOAT;
 	new_number->value.floating = number;
@@ -1764,9 +2250,8 @@ jvalue_ref jnumber_create_i32 (int32_t number)
 
 jvalue_ref jnumber_create_i64 (int64_t number)
 {
-	jnum *new_number = g_slice_new0(jnum);
+	jnum *new_number = (jnum *) jvalue_alloc0(sizeof(jnum), JV_NUM);
 	CHECK_ALLOC_RETURN_NULL(new_number);
-	jvalue_init((jvalue_ref)new_number, JV_NUM);
 
 	new_number->m_type = NUM_INT;
 	new_number->value.integer = number;
@@ -1777,9 +2262,8 @@ jvalue_ref jnumber_create_i64 (int64_t number)
 
 jvalue_ref jnumber_create_converted(raw_buffer raw)
 {
-	jnum *new_number = g_slice_new0(jnum);
+	jnum *new_number = (jnum *) jvalue_alloc0(sizeof(jnum), JV_NUM);
 	CHECK_ALLOC_RETURN_NULL(new_number);
-	jvalue_init((jvalue_ref)new_number, JV_NUM);
 
 	if (CONV_OK != jstr_to_i64(&raw, &new_number->value.integer)) {
 		new_number->m_error = jstr_to_double(&raw, &new_number->value.floating);
@@ -1809,13 +2293,14 @@ int jnumber_compare(jvalue_ref number, jvalue_ref toCompare)
 			return jnumber_compare_i64(number, jnum_deref(toCompare)->value.integer);
 		case NUM_RAW:
 		{
+			raw_buffer raw = jnum_deref_buffer(toCompare);
 			int64_t asInt;
 			double asFloat;
-			if (CONV_OK == jstr_to_i64(&jnum_deref(toCompare)->value.raw, &asInt))
+			if (CONV_OK == jstr_to_i64(&raw, &asInt))
 				return jnumber_compare_i64(number, asInt);
-			if (CONV_OK != jstr_to_double(&jnum_deref(toCompare)->value.raw, &asFloat)) {
+			if (CONV_OK != jstr_to_double(&raw, &asFloat)) {
 				PJ_LOG_ERR("Comparing against something that can't be represented as a float: '%.*s'",
-						(int)jnum_deref(toCompare)->value.raw.m_len, jnum_deref(toCompare)->value.raw.m_str);
+						(int)raw.m_len, raw.m_str);
 			}
 			return jnumber_compare_f64(number, asFloat);
 		}
@@ -1840,15 +2325,16 @@ int jnumber_compare_i64(jvalue_ref number, int64_t toCompare)
 				(jnum_deref(number)->value.integer < toCompare ? -1 : 0);
 		case NUM_RAW:
 		{
+			raw_buffer raw = jnum_deref_buffer(number);
 			int64_t asInt;
-			if (CONV_OK == jstr_to_i64(&jnum_deref(number)->value.raw, &asInt)) {
+			if (CONV_OK == jstr_to_i64(&raw, &asInt)) {
 				return asInt > toCompare ? 1 :
 						(asInt < toCompare ? -1 : 0);
 			}
 			double asFloat;
-			if (CONV_OK != jstr_to_double(&jnum_deref(number)->value.raw, &asFloat)) {
+			if (CONV_OK != jstr_to_double(&raw, &asFloat)) {
 				PJ_LOG_ERR("Comparing '%"PRId64 "' against something that can't be represented as a float: '%.*s'",
-						toCompare, (int)jnum_deref(number)->value.raw.m_len, jnum_deref(number)->value.raw.m_str);
+						toCompare, (int)raw.m_len, raw.m_str);
 			}
 			return asFloat > toCompare ? 1 : (asFloat < toCompare ? -1 : 0);
 		}
@@ -1873,15 +2359,16 @@ int jnumber_compare_f64(jvalue_ref number, double toCompare)
 				(jnum_deref(number)->value.integer < toCompare ? -1 : 0);
 		case NUM_RAW:
 		{
+			raw_buffer raw = jnum_deref_buffer(number);
 			int64_t asInt;
-			if (CONV_OK == jstr_to_i64(&jnum_deref(number)->value.raw, &asInt)) {
+			if (CONV_OK == jstr_to_i64(&raw, &asInt)) {
 				return asInt > toCompare ? 1 :
 						(asInt < toCompare ? -1 : 0);
 			}
 			double asFloat;
-			if (CONV_OK != jstr_to_double(&jnum_deref(number)->value.raw, &asFloat)) {
+			if (CONV_OK != jstr_to_double(&raw, &asFloat)) {
 				PJ_LOG_ERR("Comparing '%lf' against something that can't be represented as a float: '%.*s'",
-						toCompare, (int)jnum_deref(number)->value.raw.m_len, jnum_deref(number)->value.raw.m_str);
+						toCompare, (int)raw.m_len, raw.m_str);
 			}
 			return asFloat > toCompare ? 1 : (asFloat < toCompare ? -1 : 0);
 		}
@@ -1901,7 +2388,7 @@ bool jis_number (jvalue_ref num)
 {
 	SANITY_CHECK_POINTER(num);
 	CHECK_POINTER_RETURN_VALUE(num, false);
-	assert(s_inGdb || num->m_refCnt > 0);
+	assert(s_inGdb || jis_referenced(num));
 
 	return num->m_type == JV_NUM;
 }
@@ -1941,9 +2428,12 @@ ConversionResultFlags jnumber_get_i32 (jvalue_ref num, int32_t *number)
 		case NUM_INT:
 			return ji64_to_i32 (jnum_deref(num)->value.integer, number) | jnum_deref(num)->m_error;
 		case NUM_RAW:
-			assert(jnum_deref(num)->value.raw.m_str != NULL);
-			assert(jnum_deref(num)->value.raw.m_len > 0);
-			return jstr_to_i32 (&jnum_deref(num)->value.raw, number) | jnum_deref(num)->m_error;
+		{
+			raw_buffer raw = jnum_deref_buffer(num);
+			assert(raw.m_str != NULL);
+			assert(raw.m_len > 0);
+			return jstr_to_i32 (&raw, number) | jnum_deref(num)->m_error;
+		}
 		default:
 			PJ_LOG_ERR("internal error - numeric type is unrecognized (%d)", (int)jnum_deref(num)->m_type);
 			assert(false);
@@ -1966,9 +2456,12 @@ ConversionResultFlags jnumber_get_i64 (jvalue_ref num, int64_t *number)
 			*number = jnum_deref(num)->value.integer;
 			return jnum_deref(num)->m_error;
 		case NUM_RAW:
-			assert(jnum_deref(num)->value.raw.m_str != NULL);
-			assert(jnum_deref(num)->value.raw.m_len > 0);
-			return jstr_to_i64 (&jnum_deref(num)->value.raw, number) | jnum_deref(num)->m_error;
+		{
+			raw_buffer raw = jnum_deref_buffer(num);
+			assert(raw.m_str != NULL);
+			assert(raw.m_len > 0);
+			return jstr_to_i64 (&raw, number) | jnum_deref(num)->m_error;
+		}
 		default:
 			PJ_LOG_ERR("internal error - numeric type is unrecognized (%d)", (int)jnum_deref(num)->m_type);
 			assert(false);
@@ -1991,9 +2484,12 @@ ConversionResultFlags jnumber_get_f64 (jvalue_ref num, double *number)
 		case NUM_INT:
 			return ji64_to_double (jnum_deref(num)->value.integer, number) | jnum_deref(num)->m_error;
 		case NUM_RAW:
-			assert(jnum_deref(num)->value.raw.m_str != NULL);
-			assert(jnum_deref(num)->value.raw.m_len > 0);
-			return jstr_to_double (&jnum_deref(num)->value.raw, number) | jnum_deref(num)->m_error;
+		{
+			raw_buffer raw = jnum_deref_buffer(num);
+			assert(raw.m_str != NULL);
+			assert(raw.m_len > 0);
+			return jstr_to_double (&raw, number) | jnum_deref(num)->m_error;
+		}
 		default:
 			PJ_LOG_ERR("internal error - numeric type is unrecognized (%d)", (int)jnum_deref(num)->m_type);
 			assert(false);
@@ -2014,10 +2510,13 @@ ConversionResultFlags jnumber_get_raw (jvalue_ref num, raw_buffer *result)
 		case NUM_INT:
 			return CONV_NOT_A_RAW_NUM;
 		case NUM_RAW:
-			assert(jnum_deref(num)->value.raw.m_str != NULL);
-			assert(jnum_deref(num)->value.raw.m_len > 0);
-			*result = jnum_deref(num)->value.raw;
+		{
+			raw_buffer raw = jnum_deref_buffer(num);
+			assert(raw.m_str != NULL);
+			assert(raw.m_len > 0);
+			*result = raw;
 			return CONV_OK;
+		}
 		default:
 			PJ_LOG_ERR("internal error - numeric type is unrecognized (%d)", (int)jnum_deref(num)->m_type);
 			assert(false);
@@ -2030,7 +2529,7 @@ ConversionResultFlags jnumber_get_raw (jvalue_ref num, raw_buffer *result)
 bool jis_boolean (jvalue_ref jval)
 {
 	SANITY_CHECK_POINTER(jval);
-	assert(s_inGdb || jval->m_refCnt > 0);
+	assert(s_inGdb || jis_referenced(jval));
 	assert( jval->m_type != JV_BOOL || jval == &JTRUE.m_value || jval == &JFALSE.m_value );
 	return jval->m_type == JV_BOOL;
 }
@@ -2073,7 +2572,7 @@ ConversionResultFlags jboolean_get (jvalue_ref val, bool *value)
 
 	CHECK_POINTER_MSG_RETURN_VALUE(val, CONV_NOT_A_BOOLEAN, "Attempting to use a C NULL as a JSON value reference");
 	CHECK_POINTER_MSG_RETURN_VALUE(value, (jis_boolean(val) ? CONV_OK : CONV_NOT_A_BOOLEAN), "Non-recommended API use - value is not pointing to a valid boolean");
-	assert(val->m_refCnt > 0);
+	assert(jis_referenced(val));
 	assert( val->m_type != JV_BOOL || val == &JTRUE.m_value || val == &JFALSE.m_value );
 
 	switch (val->m_type) {
@@ -18,9 +18,13 @@
 #define JOBJECT_INTERNAL_H_
 
 #include <stdbool.h>
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
 #include <japi.h>
 #include <jtypes.h>
 #include <glib.h>
+#include <compiler/builtins.h>
 #include "jconversion.h"
 #include "jerror.h"
 
@@ -35,6 +39,8 @@ typedef struct _jbuffer {
 struct jvalue {
 	JValueType m_type;
 	int m_refCnt;
+	uint32_t m_owner;   // Thread counting its references in m_biased, 0 if there's none
+	int m_biased;
 	_jbuffer m_string;
 	_jbuffer m_file;
 };
@@ -104,6 +110,49 @@ typedef struct PJSON_LOCAL {
 
 _Static_assert(offsetof(jobject, m_value) == 0, "jobject and jobject.m_value should have the same addresses");
 
+/*
+ * Values placed into a shared memory segment by jshared.c. They are never modified
+ * nor reference counted, so the segment may be mapped read-only by many processes.
+ * Links between the values are offsets from the link itself, thus the segment
+ * works at any mapping address.
+ */
+#define J_SHARED_REFCNT INT_MAX
+
+// Offsets that can't point to a value (they fall into the link itself)
+#define J_SHARED_LINK_NULL  0
+#define J_SHARED_LINK_FALSE 1
+#define J_SHARED_LINK_TRUE  2
+
+typedef ptrdiff_t jshared_link;
+
+// Strings and raw numbers keep their text right after the header,
+// jstring.m_data.m_str and jnum.value.raw.m_str are NULL.
+typedef struct {
+	jnum m_header;
+	char m_buf[];
+} jnum_inline;
+
+typedef struct PJSON_LOCAL {
+	// m_value should always be the first field
+	jvalue m_value;
+	ssize_t m_size;
+	jshared_link m_items[];
+} jshared_array;
+
+_Static_assert(offsetof(jshared_array, m_value) == 0, "jshared_array and jshared_array.m_value should have the same addresses");
+
+typedef struct {
+	jshared_link key;
+	jshared_link value;
+} jshared_member;
+
+typedef struct PJSON_LOCAL {
+	// The header has no hash table, so the functions modifying objects refuse it
+	jobject m_header;
+	size_t m_size;
+	jshared_member m_members[];   // Ordered by the key length, then by the key bytes
+} jshared_object;
+
 extern PJSON_LOCAL jvalue JNULL;
 
 void PJSON_LOCAL jvalue_init (jvalue_ref val, JValueType type);
@@ -130,9 +179,157 @@ inline static jarray* jarray_deref(jvalue_ref array) { return (jarray*)array; }
 
 inline static jobject* jobject_deref(jvalue_ref array) { return (jobject*)array; }
 
+// Other threads may be counting references at the same time, the special values never change
+inline static int jvalue_refcnt(jvalue_ref val) { return __atomic_load_n(&val->m_refCnt, __ATOMIC_RELAXED); }
+
+inline static bool jis_shared(jvalue_ref val) { return UNLIKELY(jvalue_refcnt(val) == J_SHARED_REFCNT); }
+
+inline static jshared_array* jshared_array_deref(jvalue_ref array) { return (jshared_array*)array; }
+
+inline static jshared_object* jshared_object_deref(jvalue_ref obj) { return (jshared_object*)obj; }
+
+/*
+ * Values allocated from a jarena. They aren't reference counted, the arena destroys
+ * them all at once.
+ */
+#define J_ARENA_REFCNT (INT_MAX - 1)
+
+inline static bool jis_arena(jvalue_ref val) { return UNLIKELY(jvalue_refcnt(val) == J_ARENA_REFCNT); }
+
+// Lifetime of shared and arena values isn't controlled by the reference counter
+inline static bool jis_borrowed(jvalue_ref val) { return UNLIKELY(jvalue_refcnt(val) >= J_ARENA_REFCNT); }
+
+// Arena of the calling thread, NULL if values are allocated from the heap
+PJSON_LOCAL jarena_ref jarena_current(void);
+
+// Zeroed memory from the arena, destroyed with jvalue_destroy when the arena is released
+PJSON_LOCAL void *jarena_alloc0(jarena_ref arena, size_t size);
+
+// Forget the block just returned by jarena_alloc0, which hasn't become a value
+PJSON_LOCAL void jarena_discard(jarena_ref arena, void *mem);
+
+// Release everything the value owns but its own memory, return the size of the memory
+PJSON_LOCAL size_t jvalue_destroy(jvalue_ref val);
+
+/*
+ * Biased reference counting of the heap values, see jbiased.c. The thread that
+ * created the value counts its references in m_biased with plain operations, others
+ * count theirs in m_refCnt atomically. For such values m_refCnt holds the count
+ * multiplied by J_BIASED_ONE and the flags.
+ */
+#define J_BIASED_MERGED 1   // m_biased is merged, m_refCnt counts all the references
+#define J_BIASED_QUEUED 2   // The value waits for the owner to merge its counter
+#define J_BIASED_ONE    4
+
+// Initial-exec model keeps the access cheap in the shared library
+#define J_BIASED_TLS_MODEL __attribute__((tls_model("initial-exec")))
+
+// Owner id of the calling thread, 0 until it creates a value
+extern PJSON_LOCAL _Thread_local uint32_t jbiased_current J_BIASED_TLS_MODEL;
+
+inline static bool jis_biased(jvalue_ref val) { return val->m_owner != 0; }
+
+// The owner's counter is read by other threads only as a hint
+inline static int jbiased_get(jvalue_ref val) { return __atomic_load_n(&val->m_biased, __ATOMIC_RELAXED); }
+
+inline static void jbiased_set(jvalue_ref val, int count) { __atomic_store_n(&val->m_biased, count, __ATOMIC_RELAXED); }
+
+// Make the calling thread the owner of the new heap value
+PJSON_LOCAL void jbiased_own(jvalue_ref val);
+
+// Forget the new value of the calling thread, which hasn't been constructed
+PJSON_LOCAL void jbiased_forget(jvalue_ref val);
+
+// Merge the owner's counter that has dropped to zero, the value may be freed
+PJSON_LOCAL void jbiased_merge(jvalue_ref val);
+
+// Release the reference through the shared counter, the value may be freed
+PJSON_LOCAL void jbiased_release(jvalue_ref val);
+
+/*
+ * Values of a DOM compacted by jvalue_compact, see jshared.c. They have the layout
+ * of the shared values, but live in a heap block whose counter counts the references
+ * to all of them. m_biased keeps the offset of the value from the block start.
+ */
+inline static bool jis_compact(jvalue_ref val) { return jis_shared(val) && val->m_biased != 0; }
+
+// Count one more reference to the block of the value
+PJSON_LOCAL void jcompact_copy(jvalue_ref val);
+
+// Release the reference to the block of the value, the block may be freed
+PJSON_LOCAL void jcompact_release(jvalue_ref val);
+
+// Sanity check of the reference counter for the assertions, a biased one can't be checked
+inline static bool jis_referenced(jvalue_ref val)
+{
+	return jis_biased(val) || jvalue_refcnt(val) > 0;
+}
+
+// The value is likely referenced from several places, exact for the owner thread only
+inline static bool jis_multiref(jvalue_ref val)
+{
+	if (!jis_biased(val))
+		return jvalue_refcnt(val) > 1;
+	int shared = jvalue_refcnt(val);
+	return jbiased_get(val) + (shared - (shared & (J_BIASED_ONE - 1))) / J_BIASED_ONE > 1;
+}
+
+/*
+ * Large strings parsed in fragments keep their text in a chain of chunks, see
+ * jparse_stream.c. Their m_data.m_str stays NULL till some reader needs the text
+ * in one piece.
+ */
+#define JSTRING_CHUNK_SIZE (64 * 1024)
+
+// Empty chunked string to append the fragments to
+PJSON_LOCAL jvalue_ref jstring_chunked_create(void);
+
+// Append the fragment, the last one completes the string
+PJSON_LOCAL bool jstring_chunked_append(jvalue_ref str, const char *data, size_t len, bool last);
+
+// The string keeps its text in chunks. Readers inside the library walk them with
+// jstring_chunk_iter rather than flattening the string.
+PJSON_LOCAL bool jstring_is_chunked(jvalue_ref str);
+
+// Text of the string in one piece, made once for a chunked string. Only
+// jstring_get_fast() needs it, it promises a contiguous buffer to the caller.
+PJSON_LOCAL raw_buffer jstring_flatten(jvalue_ref str);
+
+inline static raw_buffer jstring_deref_buffer(jvalue_ref str)
+{
+	if (jis_shared(str))
+		return (raw_buffer) { ((jstring_inline *)str)->m_buf, jstring_deref(str)->m_data.m_len };
+	// Pairs with the release in jstring_flatten, the flat text may be made by another thread
+	const char *data = __atomic_load_n(&jstring_deref(str)->m_data.m_str, __ATOMIC_ACQUIRE);
+	if (UNLIKELY(!data))
+		return jstring_flatten(str);
+	return (raw_buffer) { data, jstring_deref(str)->m_data.m_len };
+}
+
+// Order of the members in a shared object
+inline static int jshared_key_compare(raw_buffer key, raw_buffer other)
+{
+	if (key.m_len != other.m_len)
+		return key.m_len < other.m_len ? -1 : 1;
+	return memcmp(key.m_str, other.m_str, key.m_len);
+}
+
+inline static raw_buffer jnum_deref_buffer(jvalue_ref num)
+{
+	if (jis_shared(num))
+		return (raw_buffer) { ((jnum_inline *)num)->m_buf, jnum_deref(num)->value.raw.m_len };
+	return jnum_deref(num)->value.raw;
+}
+
 void _jbuffer_munmap(_jbuffer *buf);
 void _jbuffer_free(_jbuffer *buf);
 
+PJSON_LOCAL jvalue_ref jshared_link_deref(jshared_link const *link);
+
+// Keep the text generated for the shared value until the segment is detached,
+// or the compacted value until its block is freed
+PJSON_LOCAL const char *jshared_keep_string(jvalue_ref val, char *str);
+
 jvalue_ref jstring_create_from_pool_internal(dom_string_memory_pool *pool, const char* data, size_t len);
 jvalue_ref jnumber_create_from_pool_internal(dom_string_memory_pool *pool, const char* data, size_t len);
 
@@ -17,8 +17,6 @@
 #include <jparse_stream.h>
 #include <jobject.h>
 
-#include <yajl/yajl_parse.h>
-#include "yajl_compat.h"
 #include "liblog.h"
 #include "jobject_internal.h"
 #include "jparse_stream_internal.h"
@@ -26,39 +24,46 @@
 #include "key_dictionary.h"
 #include <assert.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <pthread.h>
 #include <string.h>
 #include <glib.h>
 
 #include <inttypes.h>
 #include <sys/mman.h>
+#include <unistd.h>
 #include "dom_string_memory_pool.h"
+#include "input_stream.h"
+#include "validation/everything_validator.h"
 
 #define DOM_POOL_SIZE 4
 
+// String values the DOM parser stores in chunks by default
+#define DOM_STRING_CHUNKING_THRESHOLD JSTRING_CHUNK_SIZE
+
 //Dummy PJSAXCallbacks for DOM parsing
 static int dummy_dom_boolean(void *context, int value) { return 1; }
-static int dummy_dom_string(void *context, const char *string, yajl_size_t len) { return 1; }
+static int dummy_dom_number(void *context, const char *number, size_t len) { return 1; }
+static int dummy_dom_string(void *context, const unsigned char *string, size_t len) { return 1; }
 static int dummy_dom_context(void *context) { return 1; }
 
-static yajl_callbacks no_callbacks =
-{
-	dummy_dom_context, // yajl_null
-	dummy_dom_boolean, // yajl_boolean
-	NULL, // yajl_integer
-	NULL, // yajl_double
-	dummy_dom_string, // yajl_number
-	(pj_yajl_string)dummy_dom_string, // yajl_string
-	dummy_dom_context, // yajl_start_map
-	(pj_yajl_map_key)dummy_dom_string, // yajl_map_key
-	dummy_dom_context, // yajl_end_map
-	dummy_dom_context, // yajl_start_array
-	dummy_dom_context, // yajl_end_array
+static const tokenizer_callbacks no_callbacks =
+{
+	.m_null = dummy_dom_context,
+	.m_boolean = dummy_dom_boolean,
+	.m_number = dummy_dom_number,
+	.m_string = dummy_dom_string,
+	.m_objStart = dummy_dom_context,
+	.m_objKey = dummy_dom_string,
+	.m_objEnd = dummy_dom_context,
+	.m_arrStart = dummy_dom_context,
+	.m_arrEnd = dummy_dom_context,
 };
 
 static bool jsax_parse_internal(PJSAXCallbacks *parser, raw_buffer input, const jschema_ref schema, void **ctxt, jerror **err);
 // TODO: deprecated
 static bool jsax_parse_internal_old(PJSAXCallbacks *parser, raw_buffer input, JSchemaInfoRef schemaInfo, void **ctxt);
+static bool parse_text(jsaxparser_ref parser, const char *buf, int buf_len);
 
 static inline jvalue_ref createOptimalString(dom_string_memory_pool* pool, JDOMOptimization opt, const char *str, size_t strLen)
 {
@@ -203,17 +208,8 @@ int dom_number(JSAXContextRef ctxt, const char *number, size_t numberLen)
 	return 0;
 }
 
-int dom_string(JSAXContextRef ctxt, const char *string, size_t stringLen)
+static int dom_put_string(JSAXContextRef ctxt, DomInfo *data, jvalue_ref jstr)
 {
-	DomInfo *data = getDOMInfo(ctxt);
-	dom_string_memory_pool *pool = getDOMPool(ctxt);
-
-	CHECK_CONDITION_RETURN_PARSER_ERROR(data == NULL, 0,
-	                                    &ctxt->m_error,
-	                                    "string encountered without any context");
-
-	jvalue_ref jstr = createOptimalString(pool, data->m_optInformation, string, stringLen);
-
 	do {
 		if (data->m_value == NULL) {
 			if (data->m_prev != NULL)
@@ -239,6 +235,42 @@ int dom_string(JSAXContextRef ctxt, const char *string, size_t stringLen)
 	return 0;
 }
 
+int dom_string(JSAXContextRef ctxt, const char *string, size_t stringLen)
+{
+	DomInfo *data = getDOMInfo(ctxt);
+	dom_string_memory_pool *pool = getDOMPool(ctxt);
+
+	CHECK_CONDITION_RETURN_PARSER_ERROR(data == NULL, 0,
+	                                    &ctxt->m_error,
+	                                    "string encountered without any context");
+
+	jvalue_ref jstr = createOptimalString(pool, data->m_optInformation, string, stringLen);
+	return dom_put_string(ctxt, data, jstr);
+}
+
+static int dom_string_fragment(JSAXContextRef ctxt, const char *fragment, size_t fragmentLen, bool last)
+{
+	DomInfo *data = getDOMInfo(ctxt);
+	struct jdomcontext *dctxt = (struct jdomcontext*)jsax_getContext(ctxt);
+
+	CHECK_CONDITION_RETURN_PARSER_ERROR(data == NULL, 0,
+	                                    &ctxt->m_error,
+	                                    "string encountered without any context");
+
+	if (!dctxt->fragments)
+		dctxt->fragments = jstring_chunked_create();
+	if (UNLIKELY(!dctxt->fragments || !jstring_chunked_append(dctxt->fragments, fragment, fragmentLen, last))) {
+		jerror_set(&ctxt->m_error, JERROR_TYPE_SYNTAX, "Failed to allocate space for new string");
+		return 0;
+	}
+	if (!last)
+		return 1;
+
+	jvalue_ref jstr = dctxt->fragments;
+	dctxt->fragments = NULL;
+	return dom_put_string(ctxt, data, jstr);
+}
+
 int dom_object_start(JSAXContextRef ctxt)
 {
 	DomInfo *data = getDOMInfo(ctxt);
@@ -423,7 +455,7 @@ jvalue_ref jdom_create(raw_buffer input, const jschema_ref schema, jerror **err)
 	jdomparser_init(&parser, schema);
 	parser.context.string_pool = dom_string_memory_pool_create();
 
-	if (jdomparser_feed(&parser, input.m_str, input.m_len) && jdomparser_end(&parser)) {
+	if (parse_text(&parser.saxparser, input.m_str, input.m_len) && jdomparser_end(&parser)) {
 		jval = jdomparser_get_result(&parser);
 	}
 	else if (err && !(*err)) {
@@ -445,7 +477,7 @@ jvalue_ref jdom_parse(raw_buffer input, JDOMOptimizationFlags optimizationMode,
 		return jinvalid();
 	}
 
-	if (!jdomparser_feed(&parser, input.m_str, input.m_len) || !jdomparser_end((&parser))) {
+	if (!parse_text(&parser.saxparser, input.m_str, input.m_len) || !jdomparser_end((&parser))) {
 		jdomparser_deinit(&parser);
 		return jinvalid();
 	}
@@ -481,6 +513,66 @@ jvalue_ref jdom_fcreate(const char *file, const jschema_ref schema, jerror **err
 	return result;
 }
 
+static bool feed_saxparser(void *ctxt, const char *buf, int buf_len)
+{
+	return jsaxparser_feed((jsaxparser_ref) ctxt, buf, buf_len);
+}
+
+static int open_input(const char *file, jerror **err)
+{
+	int fd = open(file, O_RDONLY);
+	if (fd == -1) {
+		jerror_set_formatted(err, JERROR_TYPE_INVALID_PARAMETERS,
+		                     "Can't open file: %s", file);
+	}
+	return fd;
+}
+
+jvalue_ref jdom_fcreate_compressed(const char *file, const jschema_ref schema, jerror **err)
+{
+	CHECK_POINTER_RETURN_VALUE(file, jinvalid());
+	CHECK_POINTER_RETURN_VALUE(schema, jinvalid());
+
+	int fd = open_input(file, err);
+	if (fd == -1)
+		return jinvalid();
+
+	jvalue_ref jval = jinvalid();
+	struct jdomparser parser;
+
+	jdomparser_init(&parser, schema);
+	parser.context.string_pool = dom_string_memory_pool_create();
+
+	if (input_stream_read(fd, feed_saxparser, &parser.saxparser, err) && jdomparser_end(&parser)) {
+		jval = jdomparser_get_result(&parser);
+	}
+	else if (err && !(*err)) {
+		*err = parser.saxparser.internalCtxt.m_error;
+		parser.saxparser.internalCtxt.m_error = NULL;
+	}
+
+	jdomparser_deinit(&parser);
+	dom_string_memory_pool_destroy(parser.context.string_pool);
+	close(fd);
+
+	return jval;
+}
+
+bool jsaxparser_feed_compressed(jsaxparser_ref parser, const char *file, jerror **err)
+{
+	CHECK_POINTER_RETURN_VALUE(parser, false);
+	CHECK_POINTER_RETURN_VALUE(file, false);
+
+	int fd = open_input(file, err);
+	if (fd == -1)
+		return false;
+
+	bool result = input_stream_read(fd, feed_saxparser, parser, err);
+	close(fd);
+
+	return result;
+}
+
 jvalue_ref jdom_parse_file(const char *file, JSchemaInfoRef schemaInfo, JFileOptimizationFlags flags)
 {
 	CHECK_POINTER_RETURN_NULL(file);
@@ -516,127 +608,204 @@ void* jsax_getContext(JSAXContextRef saxCtxt)
 	return saxCtxt->ctxt;
 }
 
+bool jsax_get_location(JSAXContextRef saxCtxt, jlocation *location)
+{
+	CHECK_POINTER_RETURN_VALUE(saxCtxt, false);
+
+	if (!saxCtxt->m_parser)
+		return false;
+	return jsaxparser_get_location(saxCtxt->m_parser, location);
+}
+
+bool jparse_set_tokenizer(const char *name)
+{
+	CHECK_POINTER_RETURN_VALUE(name, false);
+
+	const tokenizer_backend *backend = tokenizer_backend_find(name);
+	if (!backend)
+		return false;
+	tokenizer_backend_select(backend);
+	return true;
+}
+
+const char *jparse_get_tokenizer(void)
+{
+	return tokenizer_backend_current()->name;
+}
+
+const char *jparse_tokenizer_name(size_t index)
+{
+	const tokenizer_backend *backend = tokenizer_backend_at(index);
+	return backend ? backend->name : NULL;
+}
+
+// Keys are told from string values only for the fragments, see tokenize_fragmented
+static inline bool tracking(JSAXContextRef spring)
+{
+	return UNLIKELY(spring->m_parser && spring->m_parser->on_fragment);
+}
+
+static void track_value(jsaxparser_ref parser)
+{
+	GByteArray *open = parser->containers;
+	parser->key_next = open->len && open->data[open->len - 1] == '{';
+}
+
+static void track_open(jsaxparser_ref parser, guint8 container)
+{
+	g_byte_array_append(parser->containers, &container, 1);
+	parser->key_next = container == '{';
+}
+
+static void track_close(jsaxparser_ref parser)
+{
+	if (parser->containers->len)
+		g_byte_array_set_size(parser->containers, parser->containers->len - 1);
+	track_value(parser);
+}
+
 int my_bounce_start_map(void *ctxt)
 {
 	JSAXContextRef spring = (JSAXContextRef)ctxt;
-	assert(spring->m_handlers->yajl_start_map);
+	assert(spring->m_handlers->m_objStart);
 
 	ValidationEvent e = validation_event_obj_start();
 	if (!validation_check(&e, spring->validation_state, ctxt))
 		return false;
 
-	return spring->m_handlers->yajl_start_map(ctxt);
+	if (tracking(spring))
+		track_open(spring->m_parser, '{');
+	return spring->m_handlers->m_objStart(ctxt);
 }
 
-int my_bounce_map_key(void *ctxt, const unsigned char *str, yajl_size_t strLen)
+int my_bounce_map_key(void *ctxt, const unsigned char *str, size_t strLen)
 {
 	JSAXContextRef spring = (JSAXContextRef)ctxt;
-	assert(spring->m_handlers->yajl_map_key);
+	assert(spring->m_handlers->m_objKey);
 
 	ValidationEvent e = validation_event_obj_key((char const *) str, strLen);
 	if (!validation_check(&e, spring->validation_state, ctxt))
 		return false;
 
-	return spring->m_handlers->yajl_map_key(ctxt, str, strLen);
+	if (tracking(spring))
+		spring->m_parser->key_next = false;
+	return spring->m_handlers->m_objKey(ctxt, str, strLen);
 }
 
 int my_bounce_end_map(void *ctxt)
 {
 	JSAXContextRef spring = (JSAXContextRef)ctxt;
-	assert(spring->m_handlers->yajl_end_map);
+	assert(spring->m_handlers->m_objEnd);
 
 	ValidationEvent e = validation_event_obj_end();
 	if (!validation_check(&e, spring->validation_state, ctxt))
 		return false;
 
-	return spring->m_handlers->yajl_end_map(ctxt);
+	if (tracking(spring))
+		track_close(spring->m_parser);
+	return spring->m_handlers->m_objEnd(ctxt);
 }
 
 int my_bounce_start_array(void *ctxt)
 {
 	JSAXContextRef spring = (JSAXContextRef)ctxt;
-	assert(spring->m_handlers->yajl_start_array);
+	assert(spring->m_handlers->m_arrStart);
 
 	ValidationEvent e = validation_event_arr_start();
 	if (!validation_check(&e, spring->validation_state, ctxt))
 		return false;
 
-	return spring->m_handlers->yajl_start_array(ctxt);
+	if (tracking(spring))
+		track_open(spring->m_parser, '[');
+	return spring->m_handlers->m_arrStart(ctxt);
 }
 
 int my_bounce_end_array(void *ctxt)
 {
 	JSAXContextRef spring = (JSAXContextRef)ctxt;
-	assert(spring->m_handlers->yajl_end_array);
+	assert(spring->m_handlers->m_arrEnd);
 
 	ValidationEvent e = validation_event_arr_end();
 	if (!validation_check(&e, spring->validation_state, ctxt))
 		return false;
 
-	return spring->m_handlers->yajl_end_array(ctxt);
+	if (tracking(spring))
+		track_close(spring->m_parser);
+	return spring->m_handlers->m_arrEnd(ctxt);
 }
 
-int my_bounce_string(void *ctxt, const unsigned char *str, yajl_size_t strLen)
+int my_bounce_string(void *ctxt, const unsigned char *str, size_t strLen)
 {
 	JSAXContextRef spring = (JSAXContextRef)ctxt;
-	assert(spring->m_handlers->yajl_string);
+	assert(spring->m_handlers->m_string);
 
 	ValidationEvent e = validation_event_string((char const *) str, strLen);
 	if (!validation_check(&e, spring->validation_state, ctxt))
 		return false;
 
-	return spring->m_handlers->yajl_string(ctxt, str, strLen);
+	if (tracking(spring)) {
+		jsaxparser_ref parser = spring->m_parser;
+		track_value(parser);
+		// The fragments of the split string have been passed already
+		if (parser->placeholder)
+			return parser->placeholder > 0;
+	}
+	return spring->m_handlers->m_string(ctxt, str, strLen);
 }
 
-int my_bounce_number(void *ctxt, const char *numberVal, yajl_size_t numberLen)
+int my_bounce_number(void *ctxt, const char *numberVal, size_t numberLen)
 {
 	JSAXContextRef spring = (JSAXContextRef)ctxt;
-	assert(spring->m_handlers->yajl_number);
+	assert(spring->m_handlers->m_number);
 
 	ValidationEvent e = validation_event_number(numberVal, numberLen);
 	if (!validation_check(&e, spring->validation_state, ctxt))
 		return false;
 
-	return spring->m_handlers->yajl_number(ctxt, numberVal, numberLen);
+	if (tracking(spring))
+		track_value(spring->m_parser);
+	return spring->m_handlers->m_number(ctxt, numberVal, numberLen);
 }
 
 int my_bounce_boolean(void *ctxt, int boolVal)
 {
 	JSAXContextRef spring = (JSAXContextRef)ctxt;
-	assert(spring->m_handlers->yajl_boolean);
+	assert(spring->m_handlers->m_boolean);
 
 	ValidationEvent e = validation_event_boolean(boolVal);
 	if (!validation_check(&e, spring->validation_state, ctxt))
 		return false;
 
-	return spring->m_handlers->yajl_boolean(ctxt, boolVal);
+	if (tracking(spring))
+		track_value(spring->m_parser);
+	return spring->m_handlers->m_boolean(ctxt, boolVal);
 }
 
 int my_bounce_null(void *ctxt)
 {
 	JSAXContextRef spring = (JSAXContextRef)ctxt;
-	assert(spring->m_handlers->yajl_null);
+	assert(spring->m_handlers->m_null);
 
 	ValidationEvent e = validation_event_null();
 	if (!validation_check(&e, spring->validation_state, ctxt))
 		return false;
 
-	return spring->m_handlers->yajl_null(ctxt);
+	if (tracking(spring))
+		track_value(spring->m_parser);
+	return spring->m_handlers->m_null(ctxt);
 }
 
-static yajl_callbacks my_bounce =
+static const tokenizer_callbacks my_bounce =
 {
-	my_bounce_null,
-	my_bounce_boolean,
-	NULL, // yajl_integer,
-	NULL, // yajl_double
-	my_bounce_number,
-	my_bounce_string,
-	my_bounce_start_map,
-	my_bounce_map_key,
-	my_bounce_end_map,
-	my_bounce_start_array,
-	my_bounce_end_array,
+	.m_null = my_bounce_null,
+	.m_boolean = my_bounce_boolean,
+	.m_number = my_bounce_number,
+	.m_string = my_bounce_string,
+	.m_objStart = my_bounce_start_map,
+	.m_objKey = my_bounce_map_key,
+	.m_objEnd = my_bounce_end_map,
+	.m_arrStart = my_bounce_start_array,
+	.m_arrEnd = my_bounce_end_array,
 };
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -645,46 +814,46 @@ static yajl_callbacks my_bounce =
 static bool inject_default_jnull(void *ctxt, jvalue_ref ref)
 {
 	JSAXContextRef context = (JSAXContextRef)ctxt;
-	return context->m_handlers->yajl_null(context);
+	return context->m_handlers->m_null(context);
 }
 
 //Helper function for jobject_to_string_append()
 static bool inject_default_jkeyvalue(void *ctxt, jvalue_ref ref)
 {
 	JSAXContextRef context = (JSAXContextRef)ctxt;
-	raw_buffer raw = jstring_deref(ref)->m_data;
-	return context->m_handlers->yajl_map_key(context, (unsigned char*)raw.m_str, raw.m_len);
+	raw_buffer raw = jstring_deref_buffer(ref);
+	return context->m_handlers->m_objKey(context, (unsigned char*)raw.m_str, raw.m_len);
 }
 
 static bool inject_default_jobject_start(void *ctxt, jvalue_ref ref)
 {
 	JSAXContextRef context = (JSAXContextRef)ctxt;
-	return context->m_handlers->yajl_start_map(context);
+	return context->m_handlers->m_objStart(context);
 }
 
 static bool inject_default_jobject_end(void *ctxt, jvalue_ref ref)
 {
 	JSAXContextRef context = (JSAXContextRef)ctxt;
-	return context->m_handlers->yajl_end_map(context);
+	return context->m_handlers->m_objEnd(context);
 }
 
 static bool inject_default_jarray_start(void *ctxt, jvalue_ref ref)
 {
 	JSAXContextRef context = (JSAXContextRef)ctxt;
-	return context->m_handlers->yajl_start_array(context);
+	return context->m_handlers->m_arrStart(context);
 }
 
 static bool inject_default_jarray_end(void *ctxt, jvalue_ref ref)
 {
 	JSAXContextRef context = (JSAXContextRef)ctxt;
-	return context->m_handlers->yajl_end_array(context);
+	return context->m_handlers->m_arrEnd(context);
 }
 
 static bool inject_default_jnumber_raw(void *ctxt, jvalue_ref ref)
 {
 	JSAXContextRef context = (JSAXContextRef)ctxt;
-	raw_buffer raw = jnum_deref(ref)->value.raw;
-	return context->m_handlers->yajl_number(context, raw.m_str, raw.m_len);
+	raw_buffer raw = jnum_deref_buffer(ref);
+	return context->m_handlers->m_number(context, raw.m_str, raw.m_len);
 }
 
 static bool inject_default_jnumber_double(void *ctxt, jvalue_ref ref)
@@ -692,7 +861,7 @@ static bool inject_default_jnumber_double(void *ctxt, jvalue_ref ref)
 	char buf[24];
 	int len = snprintf(buf, sizeof(buf), "%.14lg", jnum_deref(ref)->value.floating);
 	JSAXContextRef context = (JSAXContextRef)ctxt;
-	return context->m_handlers->yajl_number(context, buf, len);
+	return context->m_handlers->m_number(context, buf, len);
 }
 
 static bool inject_default_jnumber_int(void *ctxt, jvalue_ref ref)
@@ -700,20 +869,20 @@ static bool inject_default_jnumber_int(void *ctxt, jvalue_ref ref)
 	char buf[24];
 	int len = snprintf(buf, sizeof(buf), "%" PRId64, jnum_deref(ref)->value.integer);
 	JSAXContextRef context = (JSAXContextRef)ctxt;
-	return context->m_handlers->yajl_number(context, buf, len);
+	return context->m_handlers->m_number(context, buf, len);
 }
 
 static bool inject_default_jstring(void *ctxt, jvalue_ref ref)
 {
 	JSAXContextRef context = (JSAXContextRef)ctxt;
-	raw_buffer raw = jstring_deref(ref)->m_data;
-	return context->m_handlers->yajl_string(context, (unsigned char*)raw.m_str, raw.m_len);
+	raw_buffer raw = jstring_deref_buffer(ref);
+	return context->m_handlers->m_string(context, (unsigned char*)raw.m_str, raw.m_len);
 }
 
 static bool inject_default_jbool(void *ctxt, jvalue_ref ref)
 {
 	JSAXContextRef context = (JSAXContextRef)ctxt;
-	return context->m_handlers->yajl_boolean(context, jboolean_deref(ref)->value);
+	return context->m_handlers->m_boolean(context, jboolean_deref(ref)->value);
 }
 
 static struct TraverseCallbacks traverse = {
@@ -734,7 +903,7 @@ static bool on_default_property(ValidationState *s, char const *key, jvalue_ref
 {
 	JSAXContextRef spring = (JSAXContextRef) ctxt;
 
-	if (!spring->m_handlers->yajl_map_key(ctxt, (unsigned char const *) key, strlen(key)))
+	if (!spring->m_handlers->m_objKey(ctxt, (unsigned char const *) key, strlen(key)))
 		return false;
 
 	return jvalue_traverse(value, &traverse, spring);
@@ -767,42 +936,39 @@ static Notification jparse_notification =
 	.error_func = &validation_error,
 };
 
-static bool handle_yajl_error(yajl_status parseResult,
-                              yajl_handle handle,
-                              const char *buf, int buf_len,
-                              JSchemaInfoRef schemaInfo,
-                              PJSAXContext *internalCtxt)
+static bool handle_tokenizer_error(jsaxparser_ref parser,
+                                   const char *buf, int buf_len,
+                                   JSchemaInfoRef schemaInfo,
+                                   PJSAXContext *internalCtxt)
 {
-	switch (parseResult)
+	switch (parser->status)
 	{
-	case yajl_status_ok:
+	case TOKENIZER_OK:
 		return true;
-	case yajl_status_client_canceled:
+	case TOKENIZER_CANCELED:
 		if (!schemaInfo || !schemaInfo->m_errHandler ||
 		    !schemaInfo->m_errHandler->m_unknown(schemaInfo->m_errHandler->m_ctxt, internalCtxt))
 		{
 			return false;
 		}
 		return true;
-#if YAJL_VERSION < 20000
-	case yajl_status_insufficient_data:
+	case TOKENIZER_INCOMPLETE:
 		if (!schemaInfo || !schemaInfo->m_errHandler ||
 		    !schemaInfo->m_errHandler->m_parser(schemaInfo->m_errHandler->m_ctxt, internalCtxt))
 		{
 			return false;
 		}
 		return true;
-#endif
-	case yajl_status_error:
+	case TOKENIZER_ERROR:
 	default:
-		internalCtxt->errorDescription = (char*)yajl_get_error(handle, 1, (unsigned char *)buf, buf_len);
+		internalCtxt->errorDescription = parser->backend->get_error(parser->handle, buf, buf_len);
 		if (!schemaInfo || !schemaInfo->m_errHandler ||
 		    !schemaInfo->m_errHandler->m_unknown(schemaInfo->m_errHandler->m_ctxt, internalCtxt))
 		{
-			yajl_free_error(handle, (unsigned char*)internalCtxt->errorDescription);
+			parser->backend->free_error(parser->handle, internalCtxt->errorDescription);
 			return false;
 		}
-		yajl_free_error(handle, (unsigned char*)internalCtxt->errorDescription);
+		parser->backend->free_error(parser->handle, internalCtxt->errorDescription);
 		return true;
 	}
 }
@@ -816,7 +982,7 @@ static bool jsax_parse_internal(PJSAXCallbacks *callbacks,
 	struct jsaxparser parser;
 	jsaxparser_init(&parser, schema, callbacks, callback_ctxt);
 
-	if (!jsaxparser_feed(&parser, input.m_str, input.m_len) || !jsaxparser_end(&parser)) {
+	if (!parse_text(&parser, input.m_str, input.m_len) || !jsaxparser_end(&parser)) {
 		if (err && !(*err))
 		{
 			*err = parser.internalCtxt.m_error;
@@ -841,7 +1007,7 @@ static bool jsax_parse_internal_old(PJSAXCallbacks *callbacks,
 	if (!jsaxparser_init_old(&parser, schemaInfo, callbacks, callback_ctxt))
 		return false;
 
-	if (!jsaxparser_feed(&parser, input.m_str, input.m_len) || !jsaxparser_end(&parser)) {
+	if (!parse_text(&parser, input.m_str, input.m_len) || !jsaxparser_end(&parser)) {
 		jsaxparser_deinit(&parser);
 		return false;
 	}
@@ -977,6 +1143,33 @@ void jsaxparser_release(jsaxparser_ref *parser)
 	jsaxparser_free_memory(*parser);
 }
 
+// User callbacks with the dummy ones in place of the missing
+static void set_callbacks(jsaxparser_ref parser, PJSAXCallbacks *callback)
+{
+	parser->callbacks = no_callbacks;
+	if (callback == NULL)
+		return;
+
+	if (callback->m_null)
+		parser->callbacks.m_null = (tokenizer_null)callback->m_null;
+	if (callback->m_boolean)
+		parser->callbacks.m_boolean = (tokenizer_boolean)callback->m_boolean;
+	if (callback->m_number)
+		parser->callbacks.m_number = (tokenizer_number)callback->m_number;
+	if (callback->m_string)
+		parser->callbacks.m_string = (tokenizer_string)callback->m_string;
+	if (callback->m_objStart)
+		parser->callbacks.m_objStart = (tokenizer_context)callback->m_objStart;
+	if (callback->m_objKey)
+		parser->callbacks.m_objKey = (tokenizer_string)callback->m_objKey;
+	if (callback->m_objEnd)
+		parser->callbacks.m_objEnd = (tokenizer_context)callback->m_objEnd;
+	if (callback->m_arrStart)
+		parser->callbacks.m_arrStart = (tokenizer_context)callback->m_arrStart;
+	if (callback->m_arrEnd)
+		parser->callbacks.m_arrEnd = (tokenizer_context)callback->m_arrEnd;
+}
+
 void jsaxparser_init(jsaxparser_ref parser, const jschema_ref schema, PJSAXCallbacks *callback, void *callback_ctxt)
 {
 	memset(parser, 0, sizeof(struct jsaxparser) - sizeof(mem_pool_t));
@@ -990,21 +1183,7 @@ void jsaxparser_init(jsaxparser_ref parser, const jschema_ref schema, PJSAXCallb
 		parser->uri_resolver = schema->uri_resolver;
 	}
 
-	if (callback == NULL) {
-		parser->yajl_cb = no_callbacks;
-	} else {
-		parser->yajl_cb.yajl_null = callback->m_null ? (pj_yajl_null)callback->m_null : no_callbacks.yajl_null;
-		parser->yajl_cb.yajl_boolean = callback->m_boolean ? (pj_yajl_boolean)callback->m_boolean : no_callbacks.yajl_boolean;
-		parser->yajl_cb.yajl_integer = NULL;
-		parser->yajl_cb.yajl_double = NULL;
-		parser->yajl_cb.yajl_number = callback->m_number ? (pj_yajl_number)callback->m_number : no_callbacks.yajl_number;
-		parser->yajl_cb.yajl_string = callback->m_string ? (pj_yajl_string)callback->m_string : no_callbacks.yajl_string;
-		parser->yajl_cb.yajl_start_map = callback->m_objStart ? (pj_yajl_start_map)callback->m_objStart : no_callbacks.yajl_start_map;
-		parser->yajl_cb.yajl_map_key = callback->m_objKey ? (pj_yajl_map_key)callback->m_objKey : no_callbacks.yajl_map_key;
-		parser->yajl_cb.yajl_end_map = callback->m_objEnd ? (pj_yajl_end_map)callback->m_objEnd : no_callbacks.yajl_end_map;
-		parser->yajl_cb.yajl_start_array = callback->m_arrStart ? (pj_yajl_start_array)callback->m_arrStart : no_callbacks.yajl_start_array;
-		parser->yajl_cb.yajl_end_array = callback->m_arrEnd ? (pj_yajl_end_array)callback->m_arrEnd : no_callbacks.yajl_end_array;
-	}
+	set_callbacks(parser, callback);
 
 	parser->errorHandler.m_parser = jerr_parser;
 	parser->errorHandler.m_schema = jerr_schema;
@@ -1014,12 +1193,13 @@ void jsaxparser_init(jsaxparser_ref parser, const jschema_ref schema, PJSAXCallb
 	PJSAXContext __internalCtxt =
 	{
 		.ctxt = callback_ctxt,
-		.m_handlers = &parser->yajl_cb,
+		.m_handlers = &parser->callbacks,
 		.m_errors = &parser->errorHandler,
 		.m_error_code = 0,
 		.errorDescription = NULL,
 		.validation_state = &parser->validation_state,
-		.m_error = NULL
+		.m_error = NULL,
+		.m_parser = parser
 	};
 	parser->internalCtxt = __internalCtxt;
 
@@ -1029,29 +1209,8 @@ void jsaxparser_init(jsaxparser_ref parser, const jschema_ref schema, PJSAXCallb
 	                        &jparse_notification);
 
 	mempool_init(&parser->memory_pool);
-	yajl_alloc_funcs allocFuncs = {
-		mempool_malloc,
-		mempool_realloc,
-		mempool_free,
-		&parser->memory_pool
-	};
-	const bool allow_comments = true;
-
-#if YAJL_VERSION < 20000
-	yajl_parser_config yajl_opts =
-	{
-		allow_comments,
-		0, // currently only UTF-8 will be supported for input.
-	};
-
-	parser->handle = yajl_alloc(&my_bounce, &yajl_opts, &allocFuncs, &parser->internalCtxt);
-#else
-	parser->handle = yajl_alloc(&my_bounce, &allocFuncs, &parser->internalCtxt);
-	yajl_config(parser->handle, yajl_allow_comments, allow_comments ? 1 : 0);
-
-	// currently only UTF-8 will be supported for input.
-	yajl_config(parser->handle, yajl_dont_validate_strings, 1);
-#endif // YAJL_VERSION
+	parser->backend = tokenizer_backend_current();
+	parser->handle = parser->backend->create(&my_bounce, &parser->internalCtxt, &parser->memory_pool);
 }
 
 // TODO: Deprecated. Use jsaxparser_init instead
@@ -1068,21 +1227,7 @@ bool jsaxparser_init_old(jsaxparser_ref parser, JSchemaInfoRef schemaInfo, PJSAX
 		parser->uri_resolver = schemaInfo->m_schema->uri_resolver;
 	}
 
-	if (callback == NULL) {
-		parser->yajl_cb = no_callbacks;
-	} else {
-		parser->yajl_cb.yajl_null = callback->m_null ? (pj_yajl_null)callback->m_null : no_callbacks.yajl_null;
-		parser->yajl_cb.yajl_boolean = callback->m_boolean ? (pj_yajl_boolean)callback->m_boolean : no_callbacks.yajl_boolean;
-		parser->yajl_cb.yajl_integer = NULL;
-		parser->yajl_cb.yajl_double = NULL;
-		parser->yajl_cb.yajl_number = callback->m_number ? (pj_yajl_number)callback->m_number : no_callbacks.yajl_number;
-		parser->yajl_cb.yajl_string = callback->m_string ? (pj_yajl_string)callback->m_string : no_callbacks.yajl_string;
-		parser->yajl_cb.yajl_start_map = callback->m_objStart ? (pj_yajl_start_map)callback->m_objStart : no_callbacks.yajl_start_map;
-		parser->yajl_cb.yajl_map_key = callback->m_objKey ? (pj_yajl_map_key)callback->m_objKey : no_callbacks.yajl_map_key;
-		parser->yajl_cb.yajl_end_map = callback->m_objEnd ? (pj_yajl_end_map)callback->m_objEnd : no_callbacks.yajl_end_map;
-		parser->yajl_cb.yajl_start_array = callback->m_arrStart ? (pj_yajl_start_array)callback->m_arrStart : no_callbacks.yajl_start_array;
-		parser->yajl_cb.yajl_end_array = callback->m_arrEnd ? (pj_yajl_end_array)callback->m_arrEnd : no_callbacks.yajl_end_array;
-	}
+	set_callbacks(parser, callback);
 
 	parser->errorHandler.m_parser = err_parser;
 	parser->errorHandler.m_schema = err_schema;
@@ -1097,57 +1242,33 @@ bool jsaxparser_init_old(jsaxparser_ref parser, JSchemaInfoRef schemaInfo, PJSAX
 	PJSAXContext __internalCtxt =
 	{
 		.ctxt = (callback_ctxt != NULL ? callback_ctxt : NULL),
-		.m_handlers = &parser->yajl_cb,
+		.m_handlers = &parser->callbacks,
 		.m_errors = &parser->errorHandler,
 		.m_error_code = 0,
 		.errorDescription = NULL,
 		.validation_state = &parser->validation_state,
-		.m_error = NULL
+		.m_error = NULL,
+		.m_parser = parser
 	};
 	parser->internalCtxt = __internalCtxt;
 
 	mempool_init(&parser->memory_pool);
-	yajl_alloc_funcs allocFuncs = {
-		mempool_malloc,
-		mempool_realloc,
-		mempool_free,
-		&parser->memory_pool
-	};
-	const bool allow_comments = true;
-
-#if YAJL_VERSION < 20000
-	yajl_parser_config yajl_opts =
-	{
-		allow_comments,
-		0, // currently only UTF-8 will be supported for input.
-	};
-
-	parser->handle = yajl_alloc(&my_bounce, &yajl_opts, &allocFuncs, &parser->internalCtxt);
-#else
-	parser->handle = yajl_alloc(&my_bounce, &allocFuncs, &parser->internalCtxt);
-	yajl_config(parser->handle, yajl_allow_comments, allow_comments ? 1 : 0);
-
-	// currently only UTF-8 will be supported for input.
-	yajl_config(parser->handle, yajl_dont_validate_strings, 1);
-#endif // YAJL_VERSION
+	parser->backend = tokenizer_backend_current();
+	parser->handle = parser->backend->create(&my_bounce, &parser->internalCtxt, &parser->memory_pool);
 
 	return true;
 }
 
-static bool jsaxparser_process_error(jsaxparser_ref parser, const char *buf, int buf_len, bool final_stage)
+static bool jsaxparser_process_error(jsaxparser_ref parser, const char *buf, int buf_len)
 {
-	if (
-#if YAJL_VERSION < 20000
-		(final_stage || yajl_status_insufficient_data != parser->status) &&
-#endif
-		!handle_yajl_error(parser->status, parser->handle, buf, buf_len, parser->schemaInfo, &parser->internalCtxt) )
+	if (!handle_tokenizer_error(parser, buf, buf_len, parser->schemaInfo, &parser->internalCtxt))
 	{
-		if (parser->yajlError) {
-			yajl_free_error(parser->handle, (unsigned char*)parser->yajlError);
-			parser->yajlError = NULL;
+		if (parser->tokenizerError) {
+			parser->backend->free_error(parser->handle, parser->tokenizerError);
+			parser->tokenizerError = NULL;
 		}
-		parser->yajlError = (char*)yajl_get_error(parser->handle, 1, (unsigned char*)buf, buf_len);
-		jerror_set(&parser->internalCtxt.m_error, JERROR_TYPE_SYNTAX, parser->yajlError);
+		parser->tokenizerError = parser->backend->get_error(parser->handle, buf, buf_len);
+		jerror_set(&parser->internalCtxt.m_error, JERROR_TYPE_SYNTAX, parser->tokenizerError);
 		return false;
 	}
 
@@ -1161,8 +1282,8 @@ const char *jsaxparser_get_error(jsaxparser_ref parser)
 	if (parser->schemaError)
 		return parser->schemaError;
 
-	if (parser->yajlError)
-		return parser->yajlError;
+	if (parser->tokenizerError)
+		return parser->tokenizerError;
 
 	if (parser->internalCtxt.m_error)
 		return parser->internalCtxt.m_error->message;
@@ -1170,29 +1291,361 @@ const char *jsaxparser_get_error(jsaxparser_ref parser)
 	return NULL;
 }
 
+// Stream offset of the tokenizer position
+static size_t tokenizer_offset(jsaxparser_ref parser)
+{
+	tokenizer_piece *piece = &parser->piece;
+	if (!piece->input)
+		return parser->location.offset + parser->location.text_len;
+
+	size_t consumed = piece->fed;
+	if (!piece->synthetic)
+		consumed += parser->backend->bytes_consumed(parser->handle);
+	if (!piece->filtered)
+		return piece->offset + MIN(consumed, piece->input_len);
+
+	if (!piece->mapped)
+	{
+		if (piece->map_capacity < piece->input_len + 1)
+		{
+			g_free(piece->map);
+			piece->map_capacity = piece->input_len + 1;
+			piece->map = g_new(uint32_t, piece->map_capacity);
+		}
+		piece->filtered_len = trivia_filter_map(piece->trivia_state, piece->input, piece->input_len, piece->map);
+		piece->mapped = true;
+	}
+
+	if (consumed >= piece->filtered_len)
+		return piece->offset + piece->input_len;
+	return piece->offset + piece->map[consumed];
+}
+
+bool jsaxparser_string_token(jsaxparser_ref parser, raw_buffer *token)
+{
+	tokenizer_piece *piece = &parser->piece;
+	if (!piece->input || piece->synthetic)
+		return false;
+
+	const char *start = piece->part;
+	const char *end = start + parser->backend->bytes_consumed(parser->handle);
+	if (end == start || end[-1] != '"')
+		return false;
+
+	// The opening quote is the nearest unescaped one. If the token or the backslashes
+	// before a quote reach the beginning of the part, they may have started before it.
+	for (const char *p = end - 1; p > start; --p)
+	{
+		if (p[-1] != '"')
+			continue;
+
+		const char *quote = p - 1;
+		const char *escapes = quote;
+		while (escapes > start && escapes[-1] == '\\')
+			--escapes;
+		if (escapes == start)
+			return false;
+		if ((quote - escapes) % 2 == 0)
+		{
+			*token = j_str_to_buffer(quote, end - quote);
+			return true;
+		}
+		p = escapes + 1;
+	}
+	return false;
+}
+
+// Remember where parsing has stopped, and report it with the error
+static bool parse_failed(jsaxparser_ref parser)
+{
+	if (!parser->failed)
+	{
+		text_location_get(&parser->location, tokenizer_offset(parser), &parser->failure);
+		parser->failed = true;
+	}
+	jerror_set_location(parser->internalCtxt.m_error, &parser->failure);
+	return false;
+}
+
+// Pass the part of the piece at the offset to the tokenizer. A synthetic text stands
+// for the input at the offset.
+static bool tokenize(jsaxparser_ref parser, const char *text, size_t len, size_t offset, bool synthetic)
+{
+	parser->piece.fed = offset;
+	parser->piece.part = text;
+	parser->piece.synthetic = synthetic;
+	parser->status = parser->backend->parse(parser->handle, text, len);
+	return jsaxparser_process_error(parser, text, len);
+}
+
+static int pass_fragment(void *ctxt, const char *fragment, size_t len, bool last)
+{
+	jsaxparser_ref parser = (jsaxparser_ref) ctxt;
+	return parser->on_fragment(&parser->internalCtxt, fragment, len, last);
+}
+
+// The tokenizer gets an empty string for the split one, and goes on with the event
+static bool tokenize_placeholder(jsaxparser_ref parser, size_t offset, bool accepted)
+{
+	parser->placeholder = accepted ? 1 : -1;
+	bool result = tokenize(parser, "\"\"", 2, offset, true);
+	parser->placeholder = 0;
+	return result;
+}
+
+static bool fragments_out_of_memory(jsaxparser_ref parser)
+{
+	jerror_set(&parser->internalCtxt.m_error, JERROR_TYPE_SYNTAX, "Failed to allocate space for new string");
+	return false;
+}
+
+// Unescape the text of the string value from p. The location of the text is its offset
+// from the piece text, or the beginning of the piece without it.
+static bool unescape_value(jsaxparser_ref parser, const char **p, const char *end, const char *text)
+{
+	string_fragments *f = &parser->fragments;
+
+	// Locations within the fragment callbacks are at the text passed
+	parser->piece.fed = text ? *p - text : 0;
+	parser->piece.synthetic = true;
+
+	switch (string_fragments_unescape(f, p, end, pass_fragment, parser))
+	{
+	case FRAGMENTS_MORE:
+		return true;
+	case FRAGMENTS_CLOSED:
+		f->state = FRAGMENTS_TOKEN;
+		return tokenize_placeholder(parser, text ? *p - text : 0, true);
+	case FRAGMENTS_CANCELED:
+		tokenize_placeholder(parser, parser->piece.fed, false);
+		return false;
+	case FRAGMENTS_INVALID:
+	default:
+	{
+		// The tokenizer reports the string as it does the short ones
+		char invalid[sizeof(f->seq) + 1];
+		size_t len = string_fragments_invalid(f, invalid);
+		if (tokenize(parser, invalid, len, text ? *p - text : 0, true))
+			jerror_set(&parser->internalCtxt.m_error, JERROR_TYPE_SYNTAX, "Invalid string");
+		return false;
+	}
+	}
+}
+
+/*
+ * Long string values are taken out of the text, and passed in fragments. Other text
+ * goes to the tokenizer as it is, but it's cut before every string that may be long:
+ * once the tokenizer has got the text before the string, it's known if the string
+ * is a key. Strings spanning the pieces are held till it's known if they are long.
+ */
+static bool tokenize_fragmented(jsaxparser_ref parser, const char *text, size_t len)
+{
+	string_fragments *f = &parser->fragments;
+	const char *p = text;
+	const char *end = text + len;
+	const char *fed = text;   // Text before it has been passed to the tokenizer
+
+	while (p < end)
+	{
+		switch (f->state)
+		{
+		case FRAGMENTS_TOKEN:
+		{
+			const char *quote = memchr(p, '"', end - p);
+			if (!quote)
+			{
+				p = end;
+				break;
+			}
+
+			f->escaped = false;
+			const char *close = string_fragments_scan(f, quote + 1, end);
+			size_t string_len = (close ? close : end) - (quote + 1);
+			if (close && string_len < f->threshold)
+			{
+				p = close + 1;
+				break;
+			}
+
+			if (quote > fed && !tokenize(parser, fed, quote - fed, fed - text, false))
+				return false;
+			fed = quote;
+
+			if (parser->key_next)
+			{
+				f->state = close ? FRAGMENTS_TOKEN : FRAGMENTS_STRING;
+				p = close ? close + 1 : end;
+			}
+			else if (!close && string_len < f->threshold)
+			{
+				f->held_len = 0;
+				if (!string_fragments_hold(f, quote, end - quote))
+					return fragments_out_of_memory(parser);
+				f->state = FRAGMENTS_HELD;
+				p = fed = end;
+			}
+			else
+			{
+				if (!string_fragments_begin(f))
+					return fragments_out_of_memory(parser);
+				f->state = FRAGMENTS_VALUE;
+				p = fed = quote + 1;
+			}
+			break;
+		}
+		case FRAGMENTS_STRING:
+		{
+			const char *close = string_fragments_scan(f, p, end);
+			if (close)
+				f->state = FRAGMENTS_TOKEN;
+			p = close ? close + 1 : end;
+			break;
+		}
+		case FRAGMENTS_HELD:
+		{
+			// The held string starts before the piece
+			const char *close = string_fragments_scan(f, p, end);
+			size_t string_len = f->held_len - 1 + ((close ? close : end) - p);
+			if (string_len < f->threshold)
+			{
+				if (!close)
+				{
+					if (!string_fragments_hold(f, p, end - p))
+						return fragments_out_of_memory(parser);
+					p = fed = end;
+					break;
+				}
+
+				// Short after all, the tokenizer gets it as usual
+				if (!tokenize(parser, f->held, f->held_len, 0, true))
+					return false;
+				f->held_len = 0;
+				f->state = FRAGMENTS_TOKEN;
+				p = close + 1;
+				break;
+			}
+
+			if (!string_fragments_begin(f))
+				return fragments_out_of_memory(parser);
+			f->state = FRAGMENTS_VALUE;
+			const char *held = f->held + 1;
+			bool unescaped = unescape_value(parser, &held, f->held + f->held_len, NULL);
+			f->held_len = 0;
+			if (!unescaped)
+				return false;
+			break;
+		}
+		case FRAGMENTS_VALUE:
+			if (!unescape_value(parser, &p, end, text))
+				return false;
+			fed = p;
+			break;
+		}
+	}
+
+	return fed == end || tokenize(parser, fed, end - fed, fed - text, false);
+}
+
+static bool tokenize_text(jsaxparser_ref parser, const char *text, size_t len)
+{
+	if (parser->on_fragment)
+		return tokenize_fragmented(parser, text, len);
+	return tokenize(parser, text, len, 0, false);
+}
+
+// Parse the next chunk, which stays referenced for location lookups till the next one
+static bool parse_text(jsaxparser_ref parser, const char *buf, int buf_len)
+{
+	tokenizer_piece *piece = &parser->piece;
+	text_location_begin(&parser->location, buf, buf_len);
+
+	// Runs of whitespace and comments are collapsed before they reach the tokenizer
+	const char *end = buf + buf_len;
+	do {
+		piece->input = buf;
+		piece->offset = parser->location.offset + (buf - parser->location.text);
+		piece->trivia_state = parser->trivia.state;
+		piece->mapped = false;
+
+		size_t len;
+		const char *text = trivia_filter_next(&parser->trivia, &buf, end, &len);
+		piece->input_len = buf - piece->input;
+		piece->filtered = text != piece->input;
+
+		if (!tokenize_text(parser, text, len))
+			return parse_failed(parser);
+	} while (buf != end);
+
+	piece->input = NULL;
+	return true;
+}
+
 bool jsaxparser_feed(jsaxparser_ref parser, const char *buf, int buf_len)
 {
-	parser->status = yajl_parse(parser->handle, (unsigned char *)buf, buf_len);
+	bool result = parse_text(parser, buf, buf_len);
 
-	return jsaxparser_process_error(parser, buf, buf_len, false);
+	// The caller may release the chunk afterwards
+	text_location_skip(&parser->location);
+	return result;
 }
 
 bool jsaxparser_end(jsaxparser_ref parser)
 {
-#if YAJL_VERSION < 20000
-	parser->status = yajl_parse_complete(parser->handle);
-#else
-	parser->status = yajl_complete_parse(parser->handle);
-#endif
+	parser->piece.input = NULL;
+
+	const char *rest = trivia_filter_finish(&parser->trivia);
+	if (*rest && !tokenize_text(parser, rest, strlen(rest)))
+		return parse_failed(parser);
 
-	return jsaxparser_process_error(parser, "", 0, true);
+	// The tokenizer reports the string unterminated at the end
+	string_fragments *f = &parser->fragments;
+	if (f->state == FRAGMENTS_HELD && !tokenize(parser, f->held, f->held_len, 0, true))
+		return parse_failed(parser);
+	if (f->state == FRAGMENTS_VALUE && !tokenize(parser, "\"", 1, 0, true))
+		return parse_failed(parser);
+
+	parser->status = parser->backend->finish(parser->handle);
+	if (!jsaxparser_process_error(parser, "", 0))
+		return parse_failed(parser);
+	return true;
+}
+
+bool jsaxparser_set_string_fragments(jsaxparser_ref parser, jsax_string_fragment callback, size_t threshold)
+{
+	CHECK_POINTER_RETURN_VALUE(parser, false);
+
+	if (!callback || !threshold) {
+		parser->on_fragment = NULL;
+		return true;
+	}
+	// Any other validator may need the whole string
+	if (parser->validator != EVERYTHING_VALIDATOR)
+		return false;
+
+	if (!parser->containers)
+		parser->containers = g_byte_array_new();
+	parser->on_fragment = callback;
+	parser->fragments.threshold = threshold;
+	return true;
+}
+
+bool jsaxparser_get_location(jsaxparser_ref parser, jlocation *location)
+{
+	CHECK_POINTER_RETURN_VALUE(parser, false);
+	CHECK_POINTER_RETURN_VALUE(location, false);
+
+	if (parser->failed)
+		*location = parser->failure;
+	else
+		text_location_get(&parser->location, tokenizer_offset(parser), location);
+	return true;
 }
 
 void jsaxparser_deinit(jsaxparser_ref parser)
 {
-	if (parser->yajlError) {
-		yajl_free_error(parser->handle, (unsigned char*)parser->yajlError);
-		parser->yajlError = NULL;
+	if (parser->tokenizerError) {
+		parser->backend->free_error(parser->handle, parser->tokenizerError);
+		parser->tokenizerError = NULL;
 	}
 
 	if (parser->schemaError) {
@@ -1201,9 +1654,17 @@ void jsaxparser_deinit(jsaxparser_ref parser)
 	}
 
 	validation_state_clear(&parser->validation_state);
+	trivia_filter_clear(&parser->trivia);
+	string_fragments_clear(&parser->fragments);
+	if (parser->containers) {
+		g_byte_array_free(parser->containers, TRUE);
+		parser->containers = NULL;
+	}
+	g_free(parser->piece.map);
+	parser->piece.map = NULL;
 
 	if (parser->handle) {
-		yajl_free(parser->handle);
+		parser->backend->destroy(parser->handle);
 		parser->handle = NULL;
 	}
 
@@ -1211,7 +1672,7 @@ void jsaxparser_deinit(jsaxparser_ref parser)
 }
 
 /**
- * DomParser pool type for YAJL parser
+ * DomParser pool type for the stream parser
  */
 typedef struct domparser_pool_t {
 	struct jdomparser stack[DOM_POOL_SIZE];
@@ -1304,6 +1765,7 @@ void jdomparser_init(jdomparser_ref parser, const jschema_ref schema)
 	parser->context.context = &parser->topLevelContext;
 
 	jsaxparser_init(&parser->saxparser, schema, &dom_callbacks, &parser->context);
+	jdomparser_set_string_chunking(parser, DOM_STRING_CHUNKING_THRESHOLD);
 }
 
 bool jdomparser_init_old(jdomparser_ref parser, JSchemaInfoRef schemaInfo, JDOMOptimizationFlags optimizationMode)
@@ -1334,6 +1796,8 @@ void jdomparser_deinit(jdomparser_ref parser)
 	}
 
 	j_release(&parser->topLevelContext.m_value);
+	if (parser->context.fragments)
+		j_release(&parser->context.fragments);
 
 	jsaxparser_deinit(&parser->saxparser);
 }
@@ -1343,6 +1807,20 @@ const char *jdomparser_get_error(jdomparser_ref parser)
 	return jsaxparser_get_error(&parser->saxparser);
 }
 
+bool jdomparser_get_location(jdomparser_ref parser, jlocation *location)
+{
+	CHECK_POINTER_RETURN_VALUE(parser, false);
+
+	return jsaxparser_get_location(&parser->saxparser, location);
+}
+
+bool jdomparser_set_string_chunking(jdomparser_ref parser, size_t threshold)
+{
+	CHECK_POINTER_RETURN_VALUE(parser, false);
+
+	return jsaxparser_set_string_fragments(&parser->saxparser, dom_string_fragment, threshold);
+}
+
 jvalue_ref jdomparser_get_result(jdomparser_ref parser)
 {
 	return jvalue_copy(parser->topLevelContext.m_value);
@@ -20,8 +20,8 @@
 #include <jtypes.h>
 #include <jcallbacks.h>
 #include <jparse_stream.h>
-#include "yajl_compat.h"
 #include "jschema_types_internal.h"
+#include "tokenizer.h"
 #include "jerror_internal.h"
 #include "parser_memory_pool.h"
 #include "validation/validation_state.h"
@@ -29,6 +29,9 @@
 #include "validation/validation_api.h"
 #include "validation/nothing_validator.h"
 #include "dom_string_memory_pool.h"
+#include "trivia_filter.h"
+#include "string_fragments.h"
+#include "text_location.h"
 
 int dom_null(JSAXContextRef ctxt);
 int dom_boolean(JSAXContextRef ctxt, bool value);
@@ -41,27 +44,15 @@ int dom_array_start(JSAXContextRef ctxt);
 int dom_array_end(JSAXContextRef ctxt);
 
 int my_bounce_start_map(void *ctxt);
-int my_bounce_map_key(void *ctxt, const unsigned char *str, yajl_size_t strLen);
+int my_bounce_map_key(void *ctxt, const unsigned char *str, size_t strLen);
 int my_bounce_end_map(void *ctxt);
 int my_bounce_start_array(void *ctxt);
 int my_bounce_end_array(void *ctxt);
-int my_bounce_string(void *ctxt, const unsigned char *str, yajl_size_t strLen);
-int my_bounce_number(void *ctxt, const char *numberVal, yajl_size_t numberLen);
+int my_bounce_string(void *ctxt, const unsigned char *str, size_t strLen);
+int my_bounce_number(void *ctxt, const char *numberVal, size_t numberLen);
 int my_bounce_boolean(void *ctxt, int boolVal);
 int my_bounce_null(void *ctxt);
 
-typedef int(* pj_yajl_null )(void *ctx);
-typedef int(* pj_yajl_boolean )(void *ctx, int boolVal);
-typedef int(* pj_yajl_integer )(void *ctx, long integerVal);
-typedef int(* pj_yajl_double )(void *ctx, double doubleVal);
-typedef int(* pj_yajl_number )(void *ctx, const char *numberVal, yajl_size_t numberLen);
-typedef int(* pj_yajl_string )(void *ctx, const unsigned char *stringVal, yajl_size_t stringLen);
-typedef int(* pj_yajl_start_map )(void *ctx);
-typedef int(* pj_yajl_map_key )(void *ctx, const unsigned char *key, yajl_size_t stringLen);
-typedef int(* pj_yajl_end_map )(void *ctx);
-typedef int(* pj_yajl_start_array )(void *ctx);
-typedef int(* pj_yajl_end_array )(void *ctx);
-
 typedef struct DomInfo {
 	JDOMOptimization m_optInformation;
 	/**
@@ -80,24 +71,54 @@ typedef struct DomInfo {
 
 typedef struct __JSAXContext PJSAXContext;
 
+/**
+ * Piece of the input passed to the tokenizer, to map tokenizer offsets back to the input
+ */
+typedef struct {
+	const char *input;     // NULL when there is no input being parsed
+	size_t input_len;
+	size_t filtered_len;
+	size_t offset;         // Stream offset of the input
+	int trivia_state;      // Trivia filter state before the piece
+	bool filtered;         // The tokenizer gets the text from the filter scratch
+	bool mapped;           // The map is built for the piece
+	uint32_t *map;         // Input offsets of the filtered text
+	size_t map_capacity;
+	size_t fed;            // Offset in the filtered text of the part being tokenized
+	const char *part;      // Text of the part, as the tokenizer gets it
+	bool synthetic;        // The tokenizer gets a text standing for the part, see string_fragments.h
+} tokenizer_piece;
+
 struct jsaxparser {
-	yajl_handle handle;
+	const tokenizer_backend *backend;
+	tokenizer *handle;
 	PJSAXContext internalCtxt;
-	yajl_callbacks yajl_cb;
+	tokenizer_callbacks callbacks;
 	Validator *validator;
 	UriResolver *uri_resolver;
 	ValidationState validation_state;
-	yajl_status status;
+	tokenizer_status status;
 	JSchemaInfoRef schemaInfo;
 	struct JErrorCallbacks errorHandler;
 	char *schemaError;
-	char *yajlError;
+	char *tokenizerError;
+	trivia_filter trivia;
+	text_location location;
+	tokenizer_piece piece;
+	bool failed;
+	jlocation failure;     // Where parsing has stopped
+	jsax_string_fragment on_fragment;   // Long string values are passed in fragments, if set
+	string_fragments fragments;
+	GByteArray *containers;             // Open objects and arrays, to tell keys from values for the fragments
+	bool key_next;
+	int placeholder;       // The tokenizer gets an empty string for a split one: 1, -1 if a fragment is refused
 	mem_pool_t memory_pool; //should be the last field
 };
 
 struct jdomcontext {
 	DomInfo *context;
 	dom_string_memory_pool *string_pool;
+	jvalue_ref fragments;  // Chunked string being parsed
 };
 
 struct jdomparser {
@@ -151,6 +172,18 @@ void jsaxparser_deinit(jsaxparser_ref parser);
  */
 void jsaxparser_free_memory(jsaxparser_ref parser);
 
+/**
+ * @brief jsaxparser_string_token Input text of the string of the current event
+ *
+ * Can be called from the string and key callbacks. The token is the string as
+ * it's written in the input, with the quotes and the escapes.
+ *
+ * @param parser Pointer to SAX parser
+ * @param token Text of the token, valid till the callback returns
+ * @return false if the token has been split between the parts of the input
+ */
+bool jsaxparser_string_token(jsaxparser_ref parser, raw_buffer *token);
+
 /**
  * @brief jdomparser_alloc_memory Create DOM parser
  * @return pointer to DOM parser
@@ -0,0 +1,706 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include "jparse_stream_internal.h"
+#include "jerror_internal.h"
+#include "jvalue_stringify.h"
+
+#include <glib.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <compiler/builtins.h>
+
+#define REFORMAT_BUFFER_SIZE  4096
+#define REFORMAT_DEFAULT_INDENT "  "
+#define REFORMAT_ANY_SEGMENT "*"
+
+typedef struct reformat_rule {
+	jreformat_action action;
+	char **segments;       // Unescaped segments of the JSON Pointer
+	size_t segments_count;
+	char *replacement;     // Serialized replacement for JREFORMAT_REPLACE
+} reformat_rule;
+
+// Open container of the filtered document
+typedef struct filter_frame {
+	bool array;
+	size_t index;          // Input index of the next array element
+	guint alive_offset;    // Rules, which may select descendants, are
+	guint alive_count;     // kept in jreformatter.alive
+	bool kept;             // Inside of a value selected by a keep rule
+} filter_frame;
+
+// What to do with the value which starts with the current event
+typedef enum {
+	VALUE_EMIT,
+	VALUE_DROP,
+	VALUE_REPLACE,
+	VALUE_HASH,
+} value_action;
+
+// Output state saved while a value is hashed
+typedef struct hash_state {
+	GChecksum *checksum;
+	char *indent;
+	size_t depth;
+	bool first;
+} hash_state;
+
+struct jreformatter {
+	struct jsaxparser saxparser;
+
+	jreformat_write write;
+	void *write_ctxt;
+	bool write_failed;
+
+	char *indent;          // NULL for minified output
+	size_t indent_len;
+
+	// Formatting state. No stack is needed: a closed container is always
+	// a non-first element of its parent.
+	size_t depth;
+	bool first;            // No elements in the current container yet
+	bool after_key;        // The next value belongs to the key just written
+
+	// Filtering state, used only if there are rules
+	GPtrArray *rules;
+	bool has_keep;
+	GArray *frames;        // filter_frame
+	GArray *alive;         // guint indexes of rules
+	bool pending;          // Action of the next value is decided by its key
+	value_action pending_action;
+	bool pending_kept;
+	const reformat_rule *pending_rule;
+	size_t skip_depth;     // Nesting level inside of a dropped value
+	hash_state hash;
+
+	size_t len;
+	char buf[REFORMAT_BUFFER_SIZE];
+};
+
+static bool flush(jreformatter_ref r)
+{
+	if (r->len && !r->write_failed)
+		r->write_failed = !r->write(r->write_ctxt, r->buf, r->len);
+	r->len = 0;
+	return !r->write_failed;
+}
+
+static bool emit(jreformatter_ref r, const char *data, size_t len)
+{
+	if (UNLIKELY(r->hash.checksum != NULL))
+	{
+		g_checksum_update(r->hash.checksum, (const guchar *) data, len);
+		return true;
+	}
+
+	if (UNLIKELY(r->len + len > sizeof(r->buf)))
+	{
+		if (!flush(r))
+			return false;
+		// Long pieces go straight to the output
+		if (len > sizeof(r->buf))
+		{
+			r->write_failed = !r->write(r->write_ctxt, data, len);
+			return !r->write_failed;
+		}
+	}
+	memcpy(r->buf + r->len, data, len);
+	r->len += len;
+	return true;
+}
+
+static bool emit_char(jreformatter_ref r, char c)
+{
+	if (UNLIKELY(r->len == sizeof(r->buf) || r->hash.checksum != NULL))
+		return emit(r, &c, 1);
+	r->buf[r->len++] = c;
+	return true;
+}
+
+static bool emit_newline(jreformatter_ref r, size_t depth)
+{
+	if (!emit_char(r, '\n'))
+		return false;
+	for (size_t i = 0; i < depth; ++i)
+		if (!emit(r, r->indent, r->indent_len))
+			return false;
+	return true;
+}
+
+// Separator and whitespace before a key or a value
+static bool emit_prefix(jreformatter_ref r)
+{
+	if (r->after_key)
+	{
+		r->after_key = false;
+		return !r->indent || emit_char(r, ' ');
+	}
+
+	if (r->depth == 0)
+		return true;
+
+	if (!r->first && !emit_char(r, ','))
+		return false;
+	r->first = false;
+	return !r->indent || emit_newline(r, r->depth);
+}
+
+// Final newline after the top-level value, like yajl_gen does in beautify mode
+static bool emit_suffix(jreformatter_ref r)
+{
+	return r->depth || !r->indent || emit_char(r, '\n');
+}
+
+static bool emit_escaped(jreformatter_ref r, const char *str, size_t len)
+{
+	static const char hex[] = "0123456789ABCDEF";
+
+	if (!emit_char(r, '"'))
+		return false;
+
+	// Copy runs of characters, which don't need escaping, at once
+	size_t start = 0;
+	for (size_t i = 0; i < len; ++i)
+	{
+		unsigned char c = str[i];
+		if (LIKELY(c >= 0x20 && c != '"' && c != '\\'))
+			continue;
+
+		if (!emit(r, str + start, i - start))
+			return false;
+		start = i + 1;
+
+		char esc[6] = { '\\', 0 };
+		size_t esc_len = 2;
+		switch (c)
+		{
+		case '"':  esc[1] = '"'; break;
+		case '\\': esc[1] = '\\'; break;
+		case '\b': esc[1] = 'b'; break;
+		case '\f': esc[1] = 'f'; break;
+		case '\n': esc[1] = 'n'; break;
+		case '\r': esc[1] = 'r'; break;
+		case '\t': esc[1] = 't'; break;
+		default:
+			memcpy(esc + 1, "u00", 3);
+			esc[4] = hex[c >> 4];
+			esc[5] = hex[c & 0xf];
+			esc_len = 6;
+			break;
+		}
+		if (!emit(r, esc, esc_len))
+			return false;
+	}
+
+	return emit(r, str + start, len - start) && emit_char(r, '"');
+}
+
+// Strings go out as they're written in the input. Only the ones split between the
+// fed chunks, and the text of hashed values, are escaped again from the parsed text.
+static bool emit_string(jreformatter_ref r, const char *str, size_t len)
+{
+	raw_buffer token;
+	if (LIKELY(r->hash.checksum == NULL) && jsaxparser_string_token(&r->saxparser, &token))
+		return emit(r, token.m_str, token.m_len);
+	return emit_escaped(r, str, len);
+}
+
+static void reformat_rule_free(gpointer data)
+{
+	reformat_rule *rule = (reformat_rule *) data;
+	g_strfreev(rule->segments);
+	g_free(rule->replacement);
+	g_free(rule);
+}
+
+// Split JSON Pointer into unescaped segments
+static char **parse_pointer(const char *pointer, size_t *count)
+{
+	if (*pointer && *pointer != '/')
+		return NULL;
+
+	char **segments = *pointer ? g_strsplit(pointer + 1, "/", -1) : g_new0(char *, 1);
+	for (*count = 0; segments[*count]; ++*count)
+	{
+		char *out = segments[*count];
+		for (const char *in = out; *in; ++in)
+		{
+			if (*in != '~')
+			{
+				*out++ = *in;
+				continue;
+			}
+			++in;
+			if (*in != '0' && *in != '1')
+			{
+				g_strfreev(segments);
+				return NULL;
+			}
+			*out++ = *in == '0' ? '~' : '/';
+		}
+		*out = '\0';
+	}
+	return segments;
+}
+
+static inline bool filtering(jreformatter_ref r)
+{
+	return r->rules->len && !r->hash.checksum;
+}
+
+static inline filter_frame *top_frame(jreformatter_ref r)
+{
+	return r->frames->len ? &g_array_index(r->frames, filter_frame, r->frames->len - 1) : NULL;
+}
+
+// Match rules against the next value inside of the current container.
+// Rules, which may select descendants of the value, are left at the end
+// of the alive array.
+static void filter_enter(jreformatter_ref r, const char *segment, size_t segment_len)
+{
+	filter_frame *parent = top_frame(r);
+	size_t level = r->frames->len;
+	const reformat_rule *selected = NULL;
+	bool kept = parent ? parent->kept : false;
+	bool keep_below = false;
+
+	guint begin = 0, end = r->rules->len;
+	if (parent)
+	{
+		begin = parent->alive_offset;
+		end = parent->alive_offset + parent->alive_count;
+	}
+	g_array_set_size(r->alive, end);
+
+	for (guint i = begin; i < end; ++i)
+	{
+		guint index = parent ? g_array_index(r->alive, guint, i) : i;
+		const reformat_rule *rule = g_ptr_array_index(r->rules, index);
+		if (parent)
+		{
+			const char *expected = rule->segments[level - 1];
+			if (strcmp(expected, REFORMAT_ANY_SEGMENT) &&
+			    (strlen(expected) != segment_len || memcmp(expected, segment, segment_len)))
+				continue;
+		}
+
+		if (rule->segments_count == level)
+		{
+			if (!selected)
+				selected = rule;
+		}
+		else
+		{
+			keep_below |= rule->action == JREFORMAT_KEEP;
+			g_array_append_val(r->alive, index);
+		}
+	}
+
+	r->pending = true;
+	r->pending_rule = selected;
+	r->pending_action = VALUE_EMIT;
+	if (selected && selected->action == JREFORMAT_KEEP)
+		kept = true;
+	else if (selected && selected->action == JREFORMAT_DROP)
+		r->pending_action = VALUE_DROP;
+	else if (selected && selected->action == JREFORMAT_REPLACE)
+		r->pending_action = VALUE_REPLACE;
+	else if (selected && selected->action == JREFORMAT_HASH)
+		r->pending_action = VALUE_HASH;
+	else if (r->has_keep && !kept && !keep_below)
+		r->pending_action = VALUE_DROP;
+	r->pending_kept = kept;
+}
+
+static void filter_enter_element(jreformatter_ref r)
+{
+	filter_frame *parent = top_frame(r);
+	if (!parent)
+	{
+		filter_enter(r, NULL, 0);
+		return;
+	}
+
+	char index[24];
+	int len = snprintf(index, sizeof(index), "%zu", parent->index++);
+	filter_enter(r, index, len);
+}
+
+static void filter_push(jreformatter_ref r, bool array)
+{
+	filter_frame *parent = top_frame(r);
+	guint offset = parent ? parent->alive_offset + parent->alive_count : r->rules->len;
+	filter_frame frame = {
+		.array = array,
+		.index = 0,
+		.alive_offset = offset,
+		.alive_count = r->alive->len - offset,
+		.kept = r->pending_kept,
+	};
+	g_array_append_val(r->frames, frame);
+}
+
+static void filter_pop(jreformatter_ref r)
+{
+	g_array_set_size(r->alive, top_frame(r)->alive_offset);
+	g_array_set_size(r->frames, r->frames->len - 1);
+}
+
+static void hash_begin(jreformatter_ref r)
+{
+	r->hash.checksum = g_checksum_new(G_CHECKSUM_SHA256);
+	r->hash.indent = r->indent;
+	r->hash.depth = r->depth;
+	r->hash.first = r->first;
+
+	// Digest of the minified text doesn't depend on the output format
+	r->indent = NULL;
+	r->depth = 0;
+	r->first = true;
+}
+
+static bool hash_end(jreformatter_ref r)
+{
+	const char *digest = g_checksum_get_string(r->hash.checksum);
+	char hex[65];
+	g_strlcpy(hex, digest, sizeof(hex));
+	g_checksum_free(r->hash.checksum);
+
+	r->hash.checksum = NULL;
+	r->indent = r->hash.indent;
+	r->depth = r->hash.depth;
+	r->first = r->hash.first;
+
+	return emit_escaped(r, hex, strlen(hex)) && emit_suffix(r);
+}
+
+// Decide what to do with the value starting with the current event.
+// Replacement is written right away.
+static value_action begin_value(jreformatter_ref r, bool *ok)
+{
+	*ok = true;
+	if (!filtering(r))
+		return VALUE_EMIT;
+
+	filter_frame *parent = top_frame(r);
+	if (!parent || parent->array)
+		filter_enter_element(r);
+	r->pending = false;
+
+	switch (r->pending_action)
+	{
+	case VALUE_REPLACE:
+		*ok = emit_prefix(r) &&
+		      emit(r, r->pending_rule->replacement, strlen(r->pending_rule->replacement)) &&
+		      emit_suffix(r);
+		break;
+	case VALUE_HASH:
+		*ok = emit_prefix(r);
+		hash_begin(r);
+		break;
+	default:
+		break;
+	}
+	return r->pending_action;
+}
+
+// Complete the value, which has just been written
+static bool end_value(jreformatter_ref r)
+{
+	if (UNLIKELY(r->hash.checksum != NULL) && r->depth == 0)
+		return hash_end(r);
+	return true;
+}
+
+static inline jreformatter_ref get_reformatter(JSAXContextRef ctxt)
+{
+	return (jreformatter_ref) jsax_getContext(ctxt);
+}
+
+static int reformat_open(JSAXContextRef ctxt, char bracket)
+{
+	jreformatter_ref r = get_reformatter(ctxt);
+	if (UNLIKELY(r->skip_depth))
+	{
+		++r->skip_depth;
+		return 1;
+	}
+
+	bool ok;
+	value_action action = begin_value(r, &ok);
+	if (action == VALUE_DROP || action == VALUE_REPLACE)
+	{
+		r->skip_depth = 1;
+		return ok;
+	}
+	if (filtering(r))
+		filter_push(r, bracket == '[');
+
+	if (!ok || !emit_prefix(r) || !emit_char(r, bracket))
+		return 0;
+	++r->depth;
+	r->first = true;
+	return 1;
+}
+
+static int reformat_close(JSAXContextRef ctxt, char bracket)
+{
+	jreformatter_ref r = get_reformatter(ctxt);
+	if (UNLIKELY(r->skip_depth))
+	{
+		--r->skip_depth;
+		return 1;
+	}
+
+	if (filtering(r))
+		filter_pop(r);
+
+	--r->depth;
+	if (!r->first && r->indent && !emit_newline(r, r->depth))
+		return 0;
+	r->first = false;
+	return emit_char(r, bracket) && emit_suffix(r) && end_value(r);
+}
+
+// Write scalar value, which has been serialized already
+static int reformat_scalar(JSAXContextRef ctxt, const char *text, size_t len, bool quote)
+{
+	jreformatter_ref r = get_reformatter(ctxt);
+	if (UNLIKELY(r->skip_depth))
+		return 1;
+
+	bool ok;
+	value_action action = begin_value(r, &ok);
+	if (action == VALUE_DROP || action == VALUE_REPLACE)
+		return ok;
+
+	return ok && emit_prefix(r) &&
+	       (quote ? emit_string(r, text, len) : emit(r, text, len)) &&
+	       emit_suffix(r) && end_value(r);
+}
+
+static int reformat_object_start(JSAXContextRef ctxt)
+{
+	return reformat_open(ctxt, '{');
+}
+
+static int reformat_object_key(JSAXContextRef ctxt, const char *key, size_t keyLen)
+{
+	jreformatter_ref r = get_reformatter(ctxt);
+	if (UNLIKELY(r->skip_depth))
+		return 1;
+
+	if (filtering(r))
+	{
+		filter_enter(r, key, keyLen);
+		// Dropped member goes away together with its key
+		if (r->pending_action == VALUE_DROP)
+			return 1;
+	}
+
+	if (!emit_prefix(r) || !emit_string(r, key, keyLen) || !emit_char(r, ':'))
+		return 0;
+	r->after_key = true;
+	return 1;
+}
+
+static int reformat_object_end(JSAXContextRef ctxt)
+{
+	return reformat_close(ctxt, '}');
+}
+
+static int reformat_array_start(JSAXContextRef ctxt)
+{
+	return reformat_open(ctxt, '[');
+}
+
+static int reformat_array_end(JSAXContextRef ctxt)
+{
+	return reformat_close(ctxt, ']');
+}
+
+static int reformat_string(JSAXContextRef ctxt, const char *string, size_t stringLen)
+{
+	return reformat_scalar(ctxt, string, stringLen, true);
+}
+
+static int reformat_number(JSAXContextRef ctxt, const char *number, size_t numberLen)
+{
+	return reformat_scalar(ctxt, number, numberLen, false);
+}
+
+static int reformat_boolean(JSAXContextRef ctxt, bool value)
+{
+	return value ? reformat_scalar(ctxt, "true", 4, false)
+	             : reformat_scalar(ctxt, "false", 5, false);
+}
+
+static int reformat_null(JSAXContextRef ctxt)
+{
+	return reformat_scalar(ctxt, "null", 4, false);
+}
+
+static PJSAXCallbacks reformat_callbacks = {
+	reformat_object_start,
+	reformat_object_key,
+	reformat_object_end,
+	reformat_array_start,
+	reformat_array_end,
+	reformat_string,
+	reformat_number,
+	reformat_boolean,
+	reformat_null
+};
+
+static bool is_valid_indent(const char *indent)
+{
+	return strspn(indent, " \t\n\v\f\r") == strlen(indent);
+}
+
+static void jreformatter_init(jreformatter_ref r, const jschema_ref schema, const char *indent,
+                              jreformat_write write, void *ctxt)
+{
+	r->write = write;
+	r->write_ctxt = ctxt;
+	r->write_failed = false;
+	r->indent = NULL;
+	r->indent_len = 0;
+	if (indent)
+	{
+		r->indent = strdup(is_valid_indent(indent) ? indent : REFORMAT_DEFAULT_INDENT);
+		r->indent_len = strlen(r->indent);
+	}
+	r->depth = 0;
+	r->first = true;
+	r->after_key = false;
+
+	r->rules = g_ptr_array_new_with_free_func(reformat_rule_free);
+	r->has_keep = false;
+	r->frames = g_array_new(FALSE, FALSE, sizeof(filter_frame));
+	r->alive = g_array_new(FALSE, FALSE, sizeof(guint));
+	r->pending = false;
+	r->pending_action = VALUE_EMIT;
+	r->pending_kept = false;
+	r->pending_rule = NULL;
+	r->skip_depth = 0;
+	memset(&r->hash, 0, sizeof(r->hash));
+
+	r->len = 0;
+
+	jsaxparser_init(&r->saxparser, schema, &reformat_callbacks, r);
+}
+
+static void jreformatter_deinit(jreformatter_ref r)
+{
+	if (r->hash.checksum)
+	{
+		g_checksum_free(r->hash.checksum);
+		r->indent = r->hash.indent;
+	}
+	free(r->indent);
+	g_ptr_array_free(r->rules, TRUE);
+	g_array_free(r->frames, TRUE);
+	g_array_free(r->alive, TRUE);
+	jsaxparser_deinit(&r->saxparser);
+}
+
+jreformatter_ref jreformatter_new(const jschema_ref schema, const char *indent,
+                                  jreformat_write write, void *ctxt)
+{
+	jreformatter_ref r = malloc(sizeof(struct jreformatter));
+	if (r)
+		jreformatter_init(r, schema, indent, write, ctxt);
+	return r;
+}
+
+bool jreformatter_add_rule(jreformatter_ref reformatter, const char *pointer,
+                           jreformat_action action, jvalue_ref replacement)
+{
+	if (action == JREFORMAT_REPLACE && !jis_valid(replacement))
+		return false;
+
+	size_t count;
+	char **segments = parse_pointer(pointer, &count);
+	if (!segments)
+		return false;
+
+	reformat_rule *rule = g_new0(reformat_rule, 1);
+	rule->action = action;
+	rule->segments = segments;
+	rule->segments_count = count;
+	if (action == JREFORMAT_REPLACE)
+		rule->replacement = g_strdup(jvalue_stringify(replacement));
+	g_ptr_array_add(reformatter->rules, rule);
+
+	reformatter->has_keep |= action == JREFORMAT_KEEP;
+	return true;
+}
+
+bool jreformatter_feed(jreformatter_ref reformatter, const char *buf, int buf_len)
+{
+	return jsaxparser_feed(&reformatter->saxparser, buf, buf_len);
+}
+
+bool jreformatter_end(jreformatter_ref reformatter)
+{
+	return jsaxparser_end(&reformatter->saxparser) && flush(reformatter);
+}
+
+void jreformatter_release(jreformatter_ref *reformatter)
+{
+	jreformatter_deinit(*reformatter);
+	free(*reformatter);
+	*reformatter = NULL;
+}
+
+const char *jreformatter_get_error(jreformatter_ref reformatter)
+{
+	if (reformatter->write_failed)
+		return "Output write failed";
+	return jsaxparser_get_error(&reformatter->saxparser);
+}
+
+bool jreformat(raw_buffer input, const jschema_ref schema, const char *indent,
+               jreformat_write write, void *ctxt, jerror **err)
+{
+	struct jreformatter *r = malloc(sizeof(struct jreformatter));
+	if (!r)
+	{
+		jerror_set(err, JERROR_TYPE_INTERNAL, "Out of memory");
+		return false;
+	}
+	jreformatter_init(r, schema, indent, write, ctxt);
+
+	bool res = jreformatter_feed(r, input.m_str, input.m_len) && jreformatter_end(r);
+	if (!res && err && !*err)
+	{
+		if (r->write_failed)
+		{
+			jerror_set(err, JERROR_TYPE_INTERNAL, jreformatter_get_error(r));
+		}
+		else
+		{
+			*err = r->saxparser.internalCtxt.m_error;
+			r->saxparser.internalCtxt.m_error = NULL;
+		}
+	}
+
+	jreformatter_release(&r);
+	return res;
+}
@@ -184,11 +184,11 @@ static bool jschema_resolve_internal(jschema_ref schema, JSchemaResolverRef reso
 	return true;
 }
 
-static jschema_ref jschema_parse_internal(raw_buffer input,
-                                          char const *root_scope,
-                                          JSchemaOptimizationFlags inputOpt,
-                                          JErrorCallbacksRef errorHandler,
-                                          JSchemaResolverRef resolver)
+jschema_ref jschema_parse_internal(raw_buffer input,
+                                   char const *root_scope,
+                                   JSchemaOptimizationFlags inputOpt,
+                                   JErrorCallbacksRef errorHandler,
+                                   JSchemaResolverRef resolver)
 {
 	jschema_ref schema = jschema_new();
 
@@ -0,0 +1,454 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <jschema_generated.h>
+#include <jobject.h>
+
+#include <glib.h>
+
+#include "jobject_internal.h"
+#include "jschema_types_internal.h"
+#include "validation/number.h"
+#include "validation/regex_matcher.h"
+#include "validation/validator.h"
+#include "validation/validation_event.h"
+#include "validation/validation_state.h"
+#include "validation/error_code.h"
+
+// Constants are parsed on the first use and kept for the lifetime of the program
+static Number const *number_constant(jschema_gen_number *constant)
+{
+	Number *c = g_atomic_pointer_get(&constant->parsed);
+	if (c)
+		return c;
+
+	c = g_new(Number, 1);
+	number_init(c);
+	// The generator has checked the constants, as the schema interpreter would
+	if (number_set(c, constant->text))
+	{
+		number_clear(c);
+		g_free(c);
+		return NULL;
+	}
+
+	// Another thread may have been faster
+	if (!g_atomic_pointer_compare_and_exchange(&constant->parsed, NULL, c))
+	{
+		number_clear(c);
+		g_free(c);
+		c = g_atomic_pointer_get(&constant->parsed);
+	}
+	return c;
+}
+
+// Same checks in the same order as the number validator does
+static bool check_number(Number const *n, jschema_gen_number_limits *limits)
+{
+	if (limits->integer && !number_is_integer(n))
+		return false;
+
+	Number const *c;
+	if (limits->minimum.text && (c = number_constant(&limits->minimum)))
+	{
+		int cmp = number_compare(n, c);
+		if (cmp == -1 || (cmp == 0 && limits->exclusive_minimum))
+			return false;
+	}
+	if (limits->maximum.text && (c = number_constant(&limits->maximum)))
+	{
+		int cmp = number_compare(n, c);
+		if (cmp == 1 || (cmp == 0 && limits->exclusive_maximum))
+			return false;
+	}
+	if (limits->multiple_of.text && (c = number_constant(&limits->multiple_of)))
+		return number_is_multiple_of(n, c);
+	return true;
+}
+
+static bool number_in(Number const *n, jschema_gen_number *constants, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		Number const *c = number_constant(&constants[i]);
+		if (c && 0 == number_compare(n, c))
+			return true;
+	}
+	return false;
+}
+
+static bool number_get(jvalue_ref number, Number *n)
+{
+	char buf[24];
+	char const *str;
+	int len = jvalidation_number_text(number, buf, &str);
+	return 0 == number_set_n(n, str, len);
+}
+
+bool jschema_gen_check_number(jvalue_ref number, jschema_gen_number_limits *limits)
+{
+	Number n;
+	number_init(&n);
+	bool res = number_get(number, &n) && check_number(&n, limits);
+	number_clear(&n);
+	return res;
+}
+
+bool jschema_gen_check_number_text(const char *str, size_t len, jschema_gen_number_limits *limits)
+{
+	Number n;
+	number_init(&n);
+	bool res = 0 == number_set_n(&n, str, len) && check_number(&n, limits);
+	number_clear(&n);
+	return res;
+}
+
+bool jschema_gen_number_in(jvalue_ref number, jschema_gen_number *constants, size_t count)
+{
+	Number n;
+	number_init(&n);
+	bool res = number_get(number, &n) && number_in(&n, constants, count);
+	number_clear(&n);
+	return res;
+}
+
+bool jschema_gen_number_in_text(const char *str, size_t len, jschema_gen_number *constants, size_t count)
+{
+	Number n;
+	number_init(&n);
+	bool res = 0 == number_set_n(&n, str, len) && number_in(&n, constants, count);
+	number_clear(&n);
+	return res;
+}
+
+bool jschema_gen_match(jschema_gen_pattern *pattern, const char *str, size_t len)
+{
+	RegexMatcher *matcher = g_atomic_pointer_get(&pattern->matcher);
+	if (!matcher)
+	{
+		// The schema interpreter refuses invalid patterns, so does the generator
+		matcher = regex_matcher_new(pattern->source);
+		if (!matcher)
+			return false;
+
+		// Another thread may have been faster
+		if (!g_atomic_pointer_compare_and_exchange(&pattern->matcher, NULL, matcher))
+		{
+			regex_matcher_unref(matcher);
+			matcher = g_atomic_pointer_get(&pattern->matcher);
+		}
+	}
+
+	return regex_matcher_match(matcher, str, len);
+}
+
+bool jschema_gen_unique_items(jvalue_ref arr)
+{
+	return !jarray_has_duplicates(arr);
+}
+
+// Values of the validators without events are built from the events,
+// and checked with the DOM code once complete
+typedef struct DomBuilder
+{
+	GPtrArray *containers;   // Objects and arrays being built, current on top
+	GPtrArray *keys;         // Keys of the containers in their parent objects
+	jvalue_ref key;          // Key of the next property of the current object
+} DomBuilder;
+
+static void dom_clear(jschema_gen_sax_state *s)
+{
+	DomBuilder *b = s->dom;
+	if (!b)
+		return;
+	for (guint i = 0; i < b->containers->len; ++i)
+	{
+		jvalue_ref val = g_ptr_array_index(b->containers, i);
+		jvalue_ref key = g_ptr_array_index(b->keys, i);
+		j_release(&val);
+		j_release(&key);
+	}
+	g_ptr_array_free(b->containers, TRUE);
+	g_ptr_array_free(b->keys, TRUE);
+	j_release(&b->key);
+	g_slice_free(DomBuilder, b);
+	s->dom = NULL;
+}
+
+static bool dom_check(jschema_gen_sax_state *s, const jschema_gen_event *e)
+{
+	DomBuilder *b = s->dom;
+	if (!b)
+	{
+		if (s->started)
+			return false;
+		s->started = true;
+		b = s->dom = g_slice_new(DomBuilder);
+		b->containers = g_ptr_array_new();
+		b->keys = g_ptr_array_new();
+		b->key = NULL;
+	}
+
+	jvalue_ref val;
+	switch (e->type)
+	{
+	case JSCHEMA_GEN_NULL:
+		val = jnull();
+		break;
+	case JSCHEMA_GEN_BOOLEAN:
+		val = jboolean_create(e->boolean);
+		break;
+	case JSCHEMA_GEN_NUMBER:
+		val = jnumber_create(j_str_to_buffer(e->str, e->len));
+		break;
+	case JSCHEMA_GEN_STRING:
+		val = jstring_create_copy(j_str_to_buffer(e->str, e->len));
+		break;
+	case JSCHEMA_GEN_OBJECT_KEY:
+		b->key = jstring_create_copy(j_str_to_buffer(e->str, e->len));
+		return true;
+	case JSCHEMA_GEN_OBJECT_START:
+		val = jobject_create();
+		break;
+	case JSCHEMA_GEN_ARRAY_START:
+		val = jarray_create(NULL);
+		break;
+	case JSCHEMA_GEN_OBJECT_END:
+	case JSCHEMA_GEN_ARRAY_END:
+		if (!b->containers->len)
+			return false;
+		val = g_ptr_array_remove_index(b->containers, b->containers->len - 1);
+		b->key = g_ptr_array_remove_index(b->keys, b->keys->len - 1);
+		break;
+	default:
+		return false;
+	}
+
+	// Containers are attached to their parents when they're complete
+	if (e->type == JSCHEMA_GEN_OBJECT_START || e->type == JSCHEMA_GEN_ARRAY_START)
+	{
+		g_ptr_array_add(b->containers, val);
+		g_ptr_array_add(b->keys, b->key);
+		b->key = NULL;
+		return true;
+	}
+
+	if (b->containers->len)
+	{
+		jvalue_ref parent = g_ptr_array_index(b->containers, b->containers->len - 1);
+		if (jis_object(parent))
+		{
+			jobject_put(parent, b->key, val);
+			b->key = NULL;
+		}
+		else
+			jarray_append(parent, val);
+		return true;
+	}
+
+	bool res = s->validator->validate(val);
+	j_release(&val);
+	dom_clear(s);
+	return res;
+}
+
+void jschema_gen_sax_init(jschema_gen_sax_state *s, const jschema_gen_validator *validator)
+{
+	s->validator = validator;
+	s->frames = NULL;
+	s->depth = 0;
+	s->capacity = 0;
+	s->started = false;
+	s->dom = NULL;
+}
+
+void jschema_gen_sax_clear(jschema_gen_sax_state *s)
+{
+	g_free(s->frames);
+	s->frames = NULL;
+	s->depth = 0;
+	s->capacity = 0;
+	dom_clear(s);
+}
+
+bool jschema_gen_sax_check(jschema_gen_sax_state *s, const jschema_gen_event *e)
+{
+	if (!s->validator->events)
+		return dom_check(s, e);
+
+	if (s->depth)
+	{
+		jschema_gen_frame *f = &s->frames[s->depth - 1];
+		return f->check(s, f, e);
+	}
+
+	// One value per validation
+	if (s->started)
+		return false;
+	s->started = true;
+	return s->validator->events(s, e);
+}
+
+bool jschema_gen_sax_complete(const jschema_gen_sax_state *s)
+{
+	if (!s->validator->events)
+		return s->started && !s->dom;
+	return s->started && s->depth == 0;
+}
+
+bool jschema_gen_sax_push(jschema_gen_sax_state *s, jschema_gen_frame_func check)
+{
+	if (s->depth == s->capacity)
+	{
+		s->capacity = s->capacity ? s->capacity * 2 : 16;
+		s->frames = g_renew(jschema_gen_frame, s->frames, s->capacity);
+	}
+	jschema_gen_frame *f = &s->frames[s->depth++];
+	f->check = check;
+	f->value = NULL;
+	f->count = 0;
+	f->seen = 0;
+	return true;
+}
+
+void jschema_gen_sax_pop(jschema_gen_sax_state *s)
+{
+	--s->depth;
+}
+
+// Skips an object or an array, the count is the nesting inside of it
+static bool skip(jschema_gen_sax_state *s, jschema_gen_frame *f, const jschema_gen_event *e)
+{
+	switch (e->type)
+	{
+	case JSCHEMA_GEN_OBJECT_START:
+	case JSCHEMA_GEN_ARRAY_START:
+		++f->count;
+		break;
+	case JSCHEMA_GEN_OBJECT_END:
+	case JSCHEMA_GEN_ARRAY_END:
+		if (f->count-- == 0)
+			jschema_gen_sax_pop(s);
+		break;
+	default:
+		break;
+	}
+	return true;
+}
+
+bool jschema_gen_sax_any(jschema_gen_sax_state *s, const jschema_gen_event *e)
+{
+	if (e->type == JSCHEMA_GEN_OBJECT_START || e->type == JSCHEMA_GEN_ARRAY_START)
+		return jschema_gen_sax_push(s, skip);
+	return true;
+}
+
+// Validator of jschema_gen_create, which feeds the events of the parser to the generated code
+typedef struct GeneratedValidator
+{
+	Validator base;
+	int ref_count;
+	const jschema_gen_validator *gen;
+} GeneratedValidator;
+
+static Validator* ref(Validator *validator)
+{
+	GeneratedValidator *v = (GeneratedValidator *) validator;
+	++v->ref_count;
+	return validator;
+}
+
+static void unref(Validator *validator)
+{
+	GeneratedValidator *v = (GeneratedValidator *) validator;
+	if (--v->ref_count)
+		return;
+	g_free(v);
+}
+
+static bool init_state(Validator *validator, ValidationState *s)
+{
+	GeneratedValidator *v = (GeneratedValidator *) validator;
+	jschema_gen_sax_state *state = g_slice_new(jschema_gen_sax_state);
+	jschema_gen_sax_init(state, v->gen);
+	validation_state_push_context(s, state);
+	return true;
+}
+
+static void cleanup_state(Validator *validator, ValidationState *s)
+{
+	jschema_gen_sax_state *state = validation_state_pop_context(s);
+	jschema_gen_sax_clear(state);
+	g_slice_free(jschema_gen_sax_state, state);
+}
+
+static bool check(Validator *validator, ValidationEvent const *e, ValidationState *s, void *ctxt)
+{
+	static const jschema_gen_event_type types[] =
+	{
+		[EV_NULL] = JSCHEMA_GEN_NULL,
+		[EV_BOOL] = JSCHEMA_GEN_BOOLEAN,
+		[EV_NUM] = JSCHEMA_GEN_NUMBER,
+		[EV_STR] = JSCHEMA_GEN_STRING,
+		[EV_OBJ_START] = JSCHEMA_GEN_OBJECT_START,
+		[EV_OBJ_END] = JSCHEMA_GEN_OBJECT_END,
+		[EV_OBJ_KEY] = JSCHEMA_GEN_OBJECT_KEY,
+		[EV_ARR_START] = JSCHEMA_GEN_ARRAY_START,
+		[EV_ARR_END] = JSCHEMA_GEN_ARRAY_END,
+	};
+
+	jschema_gen_event ge = { .type = types[e->type] };
+	if (e->type == EV_BOOL)
+		ge.boolean = e->value.boolean;
+	else
+	{
+		ge.str = e->value.string.ptr;
+		ge.len = e->value.string.len;
+	}
+
+	jschema_gen_sax_state *state = validation_state_get_context(s);
+	if (!jschema_gen_sax_check(state, &ge))
+	{
+		validation_state_notify_error(s, VEC_UNEXPECTED_VALUE, ctxt);
+		validation_state_pop_validator(s);
+		return false;
+	}
+
+	if (jschema_gen_sax_complete(state))
+		validation_state_pop_validator(s);
+	return true;
+}
+
+static ValidatorVtable generated_vtable =
+{
+	.ref = ref,
+	.unref = unref,
+	.check = check,
+	.init_state = init_state,
+	.cleanup_state = cleanup_state,
+};
+
+jschema_ref jschema_gen_create(const jschema_gen_validator *validator)
+{
+	GeneratedValidator *v = g_new0(GeneratedValidator, 1);
+	v->ref_count = 1;
+	v->gen = validator;
+	validator_init(&v->base, &generated_vtable);
+
+	jschema_ref schema = jschema_new();
+	schema->validator = &v->base;
+	return schema;
+}
@@ -50,19 +50,19 @@ static bool schema_bool(void *ctx, jvalue_ref ref)
 
 static bool schema_str(void *ctx, jvalue_ref ref)
 {
-	raw_buffer raw = jstring_deref(ref)->m_data;
+	raw_buffer raw = jstring_deref_buffer(ref);
 	return jschema_builder_str((jschema_builder *)ctx, raw.m_str, raw.m_len);
 }
 
 static bool schema_key(void *ctx, jvalue_ref ref)
 {
-	raw_buffer raw = jstring_deref(ref)->m_data;
+	raw_buffer raw = jstring_deref_buffer(ref);
 	return jschema_builder_key((jschema_builder *)ctx, raw.m_str, raw.m_len);
 }
 
 static bool schema_number(void *ctx, jvalue_ref ref)
 {
-	raw_buffer raw = jnum_deref(ref)->value.raw;
+	raw_buffer raw = jnum_deref_buffer(ref);
 	return jschema_builder_number((jschema_builder *)ctx, raw.m_str, raw.m_len);
 }
 
@@ -0,0 +1,391 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include <jschema.h>
+#include <jobject.h>
+
+#include "jschema_types_internal.h"
+#include "jerror_internal.h"
+
+#include <glib.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <uriparser/Uri.h>
+
+// Cached source of a schema file
+typedef struct document {
+	char *text;
+	gsize len;
+	struct stat info;  // File attributes at the moment it was read
+} document;
+
+// Compiled schema of the set with the files it has been built from
+typedef struct member {
+	jschema_ref schema;
+	GPtrArray *files;  // Canonical file names, immutable once built
+} member;
+
+struct jschema_set {
+	GMutex update_lock;     // Serializes modifications of the set
+	GMutex publish_lock;    // Guards the replacement of members
+	GHashTable *members;    // file -> member, the published version is never modified
+	GHashTable *documents;  // Canonical file name -> document, used under update_lock
+};
+
+// State of a set modification
+typedef struct update {
+	jschema_set_ref set;
+	GHashTable *staged;     // Documents read during the update, replace cached ones on success
+	GPtrArray *files;       // Files used by the schema being compiled
+	const char *file;       // File being compiled, for error messages
+	jerror **err;
+} update;
+
+static void document_free(gpointer data)
+{
+	document *doc = (document *) data;
+	g_free(doc->text);
+	g_free(doc);
+}
+
+static bool document_changed(const char *file, const document *doc)
+{
+	struct stat info;
+	if (stat(file, &info))
+		return true;
+	return info.st_dev != doc->info.st_dev ||
+	       info.st_ino != doc->info.st_ino ||
+	       info.st_size != doc->info.st_size ||
+	       info.st_mtim.tv_sec != doc->info.st_mtim.tv_sec ||
+	       info.st_mtim.tv_nsec != doc->info.st_mtim.tv_nsec;
+}
+
+static document *document_read(const char *file, jerror **err)
+{
+	document *doc = g_new0(document, 1);
+	// Attributes go first: if the file is modified while being read,
+	// the next refresh reads it again.
+	if (stat(file, &doc->info) || !g_file_get_contents(file, &doc->text, &doc->len, NULL))
+	{
+		jerror_set_formatted(err, JERROR_TYPE_INVALID_PARAMETERS, "Can't read schema file %s", file);
+		document_free(doc);
+		return NULL;
+	}
+	return doc;
+}
+
+static member *member_new(jschema_ref schema, GPtrArray *files)
+{
+	member *m = g_new(member, 1);
+	m->schema = schema;
+	m->files = files;
+	return m;
+}
+
+static member *member_copy(const member *m)
+{
+	return member_new(jschema_copy(m->schema), g_ptr_array_ref(m->files));
+}
+
+static void member_free(gpointer data)
+{
+	member *m = (member *) data;
+	jschema_release(&m->schema);
+	g_ptr_array_unref(m->files);
+	g_free(m);
+}
+
+static GHashTable *version_new(void)
+{
+	return g_hash_table_new_full(g_str_hash, g_str_equal, g_free, member_free);
+}
+
+static const document *update_get_document(update *u, const char *file)
+{
+	document *doc = g_hash_table_lookup(u->staged, file);
+	if (!doc)
+		doc = g_hash_table_lookup(u->set->documents, file);
+	if (!doc)
+	{
+		doc = document_read(file, u->err);
+		if (!doc)
+			return NULL;
+		g_hash_table_insert(u->staged, g_strdup(file), doc);
+	}
+	return doc;
+}
+
+static bool cb_parse_error(void *ctxt, JSAXContextRef parseCtxt)
+{
+	update *u = (update *) ctxt;
+	struct __JSAXContext *c = (struct __JSAXContext *) parseCtxt;
+	jerror_set_formatted(u->err, JERROR_TYPE_SCHEMA, "Schema %s: %s (code %d)", u->file,
+	                     c->errorDescription ? c->errorDescription : "unknown error", c->m_error_code);
+	return false;
+}
+
+static jschema_ref update_compile(update *u, const char *file, JSchemaResolverRef resolver);
+
+// Referenced documents are looked up in the set instead of the file system
+static JSchemaResolutionResult resolve_file(JSchemaResolverRef resolver, jschema_ref *resolved)
+{
+	update *u = (update *) resolver->m_userCtxt;
+	const char *uri = resolver->m_resourceToResolve.m_str;
+
+	char file[strlen(uri) + 1];
+	if (URI_SUCCESS != uriUriStringToUnixFilenameA(uri, file))
+		return SCHEMA_NOT_FOUND;
+
+	const char *referrer = u->file;
+	*resolved = update_compile(u, file, resolver);
+	u->file = referrer;
+
+	return *resolved ? SCHEMA_RESOLVED : SCHEMA_INVALID;
+}
+
+static jschema_ref update_compile(update *u, const char *file, JSchemaResolverRef resolver)
+{
+	const document *doc = update_get_document(u, file);
+	if (!doc)
+		return NULL;
+
+	bool known = false;
+	for (guint i = 0; i < u->files->len && !known; ++i)
+		known = !strcmp(g_ptr_array_index(u->files, i), file);
+	if (!known)
+		g_ptr_array_add(u->files, g_strdup(file));
+
+	char uri[3 * strlen(file) + 8];
+	if (URI_SUCCESS != uriUnixFilenameToUriStringA(file, uri))
+		return NULL;
+
+	struct JErrorCallbacks callbacks = {
+		.m_parser = cb_parse_error,
+		.m_schema = cb_parse_error,
+		.m_unknown = cb_parse_error,
+		.m_ctxt = u,
+	};
+
+	u->file = file;
+	return jschema_parse_internal(j_str_to_buffer(doc->text, doc->len), uri,
+	                              DOMOPT_INPUT_OUTLIVES_WITH_NOCHANGE, &callbacks, resolver);
+}
+
+// Compile the schema file with all the documents it references
+static member *update_build(update *u, const char *file)
+{
+	char canonical[PATH_MAX];
+	if (!realpath(file, canonical))
+	{
+		jerror_set_formatted(u->err, JERROR_TYPE_INVALID_PARAMETERS, "Can't read schema file %s", file);
+		return NULL;
+	}
+
+	// Resolution state can't be reused, its recursion counter is never reset
+	struct JSchemaResolver resolver = {
+		.m_resolve = resolve_file,
+		.m_userCtxt = u,
+	};
+
+	u->files = g_ptr_array_new_with_free_func(g_free);
+	jschema_ref schema = update_compile(u, canonical, &resolver);
+	if (!schema)
+	{
+		jerror_set_formatted(u->err, JERROR_TYPE_SCHEMA, "Failed to compile schema %s", file);
+		g_ptr_array_unref(u->files);
+		return NULL;
+	}
+	return member_new(schema, u->files);
+}
+
+static bool member_depends(const member *m, GHashTable *files)
+{
+	for (guint i = 0; i < m->files->len; ++i)
+		if (g_hash_table_contains(files, g_ptr_array_index(m->files, i)))
+			return true;
+	return false;
+}
+
+// Make the update visible. Documents no schema is built from are forgotten.
+static void update_commit(update *u, GHashTable *version)
+{
+	jschema_set_ref set = u->set;
+
+	GHashTableIter it;
+	gpointer key, value;
+	g_hash_table_iter_init(&it, u->staged);
+	while (g_hash_table_iter_next(&it, &key, &value))
+	{
+		g_hash_table_insert(set->documents, key, value);
+		g_hash_table_iter_steal(&it);
+	}
+
+	GHashTable *used = g_hash_table_new(g_str_hash, g_str_equal);
+	g_hash_table_iter_init(&it, version);
+	while (g_hash_table_iter_next(&it, &key, &value))
+	{
+		const member *m = (const member *) value;
+		for (guint i = 0; i < m->files->len; ++i)
+			g_hash_table_add(used, g_ptr_array_index(m->files, i));
+	}
+	g_hash_table_iter_init(&it, set->documents);
+	while (g_hash_table_iter_next(&it, &key, &value))
+		if (!g_hash_table_contains(used, key))
+			g_hash_table_iter_remove(&it);
+	g_hash_table_unref(used);
+
+	g_mutex_lock(&set->publish_lock);
+	GHashTable *old = set->members;
+	set->members = version;
+	g_mutex_unlock(&set->publish_lock);
+
+	// Schemas taken by the users stay alive until they're released
+	g_hash_table_unref(old);
+}
+
+jschema_set_ref jschema_set_new(void)
+{
+	jschema_set_ref set = g_new0(struct jschema_set, 1);
+	g_mutex_init(&set->update_lock);
+	g_mutex_init(&set->publish_lock);
+	set->members = version_new();
+	set->documents = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, document_free);
+	return set;
+}
+
+void jschema_set_release(jschema_set_ref *set)
+{
+	jschema_set_ref s = *set;
+	if (!s)
+		return;
+
+	g_hash_table_unref(s->members);
+	g_hash_table_unref(s->documents);
+	g_mutex_clear(&s->update_lock);
+	g_mutex_clear(&s->publish_lock);
+	g_free(s);
+	*set = NULL;
+}
+
+bool jschema_set_add_file(jschema_set_ref set, const char *file, jerror **err)
+{
+	g_mutex_lock(&set->update_lock);
+
+	update u = {
+		.set = set,
+		.staged = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, document_free),
+		.err = err,
+	};
+
+	member *m = update_build(&u, file);
+	if (m)
+	{
+		GHashTable *version = version_new();
+		GHashTableIter it;
+		gpointer key, value;
+		g_hash_table_iter_init(&it, set->members);
+		while (g_hash_table_iter_next(&it, &key, &value))
+			g_hash_table_insert(version, g_strdup(key), member_copy(value));
+		g_hash_table_replace(version, g_strdup(file), m);
+
+		update_commit(&u, version);
+	}
+
+	g_hash_table_unref(u.staged);
+	g_mutex_unlock(&set->update_lock);
+	return m != NULL;
+}
+
+jschema_ref jschema_set_get(jschema_set_ref set, const char *file)
+{
+	jschema_ref schema = NULL;
+
+	g_mutex_lock(&set->publish_lock);
+	member *m = g_hash_table_lookup(set->members, file);
+	if (m)
+		schema = jschema_copy(m->schema);
+	g_mutex_unlock(&set->publish_lock);
+
+	return schema;
+}
+
+int jschema_set_refresh(jschema_set_ref set, jerror **err)
+{
+	g_mutex_lock(&set->update_lock);
+
+	update u = {
+		.set = set,
+		.staged = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, document_free),
+		.err = err,
+	};
+	GHashTable *version = NULL;
+	int rebuilt = 0;
+
+	// Read modified documents again
+	GHashTableIter it;
+	gpointer key, value;
+	g_hash_table_iter_init(&it, set->documents);
+	while (g_hash_table_iter_next(&it, &key, &value))
+	{
+		if (!document_changed(key, value))
+			continue;
+		document *doc = document_read(key, err);
+		if (!doc)
+		{
+			rebuilt = -1;
+			goto out;
+		}
+		g_hash_table_insert(u.staged, g_strdup(key), doc);
+	}
+
+	if (!g_hash_table_size(u.staged))
+		goto out;
+
+	// Schemas built from the same documents are shared with the previous version
+	GHashTable *changed = g_hash_table_new(g_str_hash, g_str_equal);
+	g_hash_table_iter_init(&it, u.staged);
+	while (g_hash_table_iter_next(&it, &key, &value))
+		g_hash_table_add(changed, key);
+
+	version = version_new();
+	g_hash_table_iter_init(&it, set->members);
+	while (g_hash_table_iter_next(&it, &key, &value))
+	{
+		member *m = member_depends(value, changed) ? update_build(&u, key) : member_copy(value);
+		if (!m)
+		{
+			rebuilt = -1;
+			break;
+		}
+		if (m->schema != ((member *) value)->schema)
+			++rebuilt;
+		g_hash_table_insert(version, g_strdup(key), m);
+	}
+	g_hash_table_unref(changed);
+
+	if (rebuilt < 0)
+		g_hash_table_unref(version);
+	else
+		update_commit(&u, version);
+
+out:
+	g_hash_table_unref(u.staged);
+	g_mutex_unlock(&set->update_lock);
+	return rebuilt;
+}
@@ -20,7 +20,7 @@
 #include "jparse_types.h"
 #include "jgen_types.h"
 #include "jerror_internal.h"
-#include <yajl/yajl_parse.h>
+#include "tokenizer.h"
 
 
 #define URI_SCHEME_RELATIVE "relative:"
@@ -43,16 +43,30 @@ typedef struct jschema {
 struct __JSAXContext
 {
 	void *ctxt;
-	yajl_callbacks *m_handlers;
+	const tokenizer_callbacks *m_handlers;
 	JErrorCallbacksRef m_errors;
 	int m_error_code;
 	char *errorDescription;
 	ValidationState *validation_state;
 	jerror *m_error;
+	jsaxparser_ref m_parser; // NULL out of parsing
 };
 
 jschema_ref jschema_new(void);
+
+/// Text of the number as it's seen by the validators
+PJSON_LOCAL int jvalidation_number_text(jvalue_ref ref, char buf[24], char const **str);
 jschema_ref jschema_copy(jschema_ref schema);
 void jschema_release(jschema_ref *schema);
 
+/**
+ * Parse the schema with the given base URI and resolve external references
+ * with the resolver, if it's given.
+ */
+jschema_ref jschema_parse_internal(raw_buffer input,
+                                   char const *root_scope,
+                                   JSchemaOptimizationFlags inputOpt,
+                                   JErrorCallbacksRef errorHandler,
+                                   JSchemaResolverRef resolver);
+
 #endif /* JSCHEMA_TYPES_INTERNAL_H_ */
@@ -0,0 +1,508 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <jobject.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <glib.h>
+#include <compiler/builtins.h>
+
+#include "jobject_internal.h"
+#include "jerror_internal.h"
+#include "liblog.h"
+
+#define SHARED_MAGIC   0x4a53484d // "JSHM"
+#define SHARED_VERSION 2
+#define SHARED_ALIGN   8
+
+#define SHARED_ALIGN_SIZE(size) (((size) + SHARED_ALIGN - 1) & ~(size_t)(SHARED_ALIGN - 1))
+
+_Static_assert(_Alignof(jstring_inline) <= SHARED_ALIGN, "Shared string should be aligned");
+_Static_assert(_Alignof(jnum_inline) <= SHARED_ALIGN, "Shared number should be aligned");
+_Static_assert(_Alignof(jshared_array) <= SHARED_ALIGN, "Shared array should be aligned");
+_Static_assert(_Alignof(jshared_object) <= SHARED_ALIGN, "Shared object should be aligned");
+
+// The magic is written the last, when the rest of the segment is ready
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t size;
+	jshared_link root;
+} shared_header;
+
+struct jshared {
+	char *base;
+	size_t size;
+	GHashTable *strings;  // Values to the text generated for them by jvalue_stringify
+};
+
+// Heap block of a DOM compacted by jvalue_compact, its values are laid out the same way
+typedef struct {
+	shared_header shared;  // Only the root link is used
+	gint refcnt;           // References to any value of the block
+	GMutex lock;
+	GHashTable *strings;   // Created by the first jvalue_stringify, under the lock
+} compact_header;
+
+// Attached segments, to find the one a value belongs to
+static GSList *attached;
+static GMutex attached_lock;
+
+// Both passes go through the same steps: the first one just counts the size,
+// the second one writes to the segment.
+typedef struct {
+	char *base;           // NULL for the counting pass
+	bool compact;         // Building a compact_header block rather than a segment
+	size_t pos;
+	GHashTable *keys;     // Object keys by their text to the offset of their copy
+	GHashTable *nodes;    // Values referred from several places to the offset of their copy
+} shared_builder;
+
+static size_t shared_put(shared_builder *b, jvalue_ref val);
+
+static size_t shared_alloc(shared_builder *b, size_t size)
+{
+	size_t offset = b->pos;
+	b->pos += SHARED_ALIGN_SIZE(size);
+	return offset;
+}
+
+// Offsets inside of the header stand for the constants, see J_SHARED_LINK_NULL
+static void shared_link_set(shared_builder *b, size_t link, size_t target)
+{
+	if (!b->base)
+		return;
+
+	*(jshared_link *)(b->base + link) = target < sizeof(shared_header)
+		? (jshared_link) target
+		: (jshared_link) target - (jshared_link) link;
+}
+
+static void shared_value_init(shared_builder *b, size_t offset, JValueType type)
+{
+	jvalue *val = (jvalue *)(b->base + offset);
+	val->m_type = type;
+	val->m_refCnt = J_SHARED_REFCNT;
+	if (b->compact)
+		val->m_biased = (int) offset;
+}
+
+static size_t shared_put_string(shared_builder *b, jvalue_ref val)
+{
+	size_t len = jstring_size(val);
+	size_t offset = shared_alloc(b, sizeof(jstring_inline) + len + 1);
+	if (b->base) {
+		jstring_inline *copy = (jstring_inline *)(b->base + offset);
+		shared_value_init(b, offset, JV_STR);
+		copy->m_header.m_data.m_len = len;
+
+		// Chunked strings are copied without flattening them
+		jstring_chunk_iter it;
+		jstring_chunk_iter_init(&it, val);
+		raw_buffer chunk;
+		char *pos = copy->m_buf;
+		while (jstring_chunk_iter_next(&it, &chunk)) {
+			memcpy(pos, chunk.m_str, chunk.m_len);
+			pos += chunk.m_len;
+		}
+		*pos = '\0';
+	}
+	return offset;
+}
+
+static size_t shared_put_number(shared_builder *b, jvalue_ref val)
+{
+	jnum *num = jnum_deref(val);
+
+	if (num->m_type != NUM_RAW) {
+		size_t offset = shared_alloc(b, sizeof(jnum));
+		if (b->base) {
+			jnum *copy = (jnum *)(b->base + offset);
+			shared_value_init(b, offset, JV_NUM);
+			copy->m_type = num->m_type;
+			copy->m_error = num->m_error;
+			copy->value = num->value;
+		}
+		return offset;
+	}
+
+	raw_buffer raw = jnum_deref_buffer(val);
+	size_t offset = shared_alloc(b, sizeof(jnum_inline) + raw.m_len + 1);
+	if (b->base) {
+		jnum_inline *copy = (jnum_inline *)(b->base + offset);
+		shared_value_init(b, offset, JV_NUM);
+		copy->m_header.m_type = NUM_RAW;
+		copy->m_header.m_error = num->m_error;
+		copy->m_header.value.raw.m_len = raw.m_len;
+		memcpy(copy->m_buf, raw.m_str, raw.m_len);
+		copy->m_buf[raw.m_len] = '\0';
+	}
+	return offset;
+}
+
+static size_t shared_put_array(shared_builder *b, jvalue_ref val)
+{
+	ssize_t size = jarray_size(val);
+	size_t offset = shared_alloc(b, sizeof(jshared_array) + size * sizeof(jshared_link));
+	if (b->base) {
+		shared_value_init(b, offset, JV_ARRAY);
+		((jshared_array *)(b->base + offset))->m_size = size;
+	}
+
+	for (ssize_t i = 0; i < size; ++i) {
+		size_t item = shared_put(b, jarray_get(val, i));
+		shared_link_set(b, offset + offsetof(jshared_array, m_items) + i * sizeof(jshared_link), item);
+	}
+	return offset;
+}
+
+static size_t shared_put_key(shared_builder *b, jvalue_ref key)
+{
+	gpointer offset;
+	if (g_hash_table_lookup_extended(b->keys, key, NULL, &offset))
+		return GPOINTER_TO_SIZE(offset);
+
+	size_t result = shared_put_string(b, key);
+	g_hash_table_insert(b->keys, key, GSIZE_TO_POINTER(result));
+	return result;
+}
+
+static int shared_member_compare(const void *a, const void *b)
+{
+	return jshared_key_compare(jstring_get_fast(((const jobject_key_value *)a)->key),
+	                           jstring_get_fast(((const jobject_key_value *)b)->key));
+}
+
+static size_t shared_put_object(shared_builder *b, jvalue_ref val)
+{
+	size_t size = jobject_size(val);
+	size_t offset = shared_alloc(b, sizeof(jshared_object) + size * sizeof(jshared_member));
+	if (b->base) {
+		shared_value_init(b, offset, JV_OBJECT);
+		((jshared_object *)(b->base + offset))->m_size = size;
+	}
+
+	// Lookups in the segment rely on the order of the members
+	jobject_key_value *members = g_new(jobject_key_value, size);
+	jobject_iter it;
+	jobject_iter_init(&it, val);
+	for (size_t i = 0; i < size; ++i)
+		(void) jobject_iter_next(&it, &members[i]);
+	qsort(members, size, sizeof(jobject_key_value), shared_member_compare);
+
+	for (size_t i = 0; i < size; ++i) {
+		size_t member = offset + offsetof(jshared_object, m_members) + i * sizeof(jshared_member);
+		shared_link_set(b, member + offsetof(jshared_member, key), shared_put_key(b, members[i].key));
+		shared_link_set(b, member + offsetof(jshared_member, value), shared_put(b, members[i].value));
+	}
+
+	g_free(members);
+	return offset;
+}
+
+static size_t shared_put(shared_builder *b, jvalue_ref val)
+{
+	switch (jget_type(val)) {
+	case JV_NULL:
+		return J_SHARED_LINK_NULL;
+	case JV_BOOL:
+		return jboolean_deref_to_value(val) ? J_SHARED_LINK_TRUE : J_SHARED_LINK_FALSE;
+	default:
+		break;
+	}
+
+	// Only the values with several owners may be met again
+	bool several = jis_multiref(val);
+	gpointer known;
+	if (several && g_hash_table_lookup_extended(b->nodes, val, NULL, &known))
+		return GPOINTER_TO_SIZE(known);
+
+	size_t offset = 0;
+	switch (jget_type(val)) {
+	case JV_STR:
+		offset = shared_put_string(b, val);
+		break;
+	case JV_NUM:
+		offset = shared_put_number(b, val);
+		break;
+	case JV_ARRAY:
+		offset = shared_put_array(b, val);
+		break;
+	case JV_OBJECT:
+		offset = shared_put_object(b, val);
+		break;
+	default:
+		assert(false);
+	}
+
+	if (several)
+		g_hash_table_insert(b->nodes, val, GSIZE_TO_POINTER(offset));
+	return offset;
+}
+
+static size_t shared_build(shared_builder *b, jvalue_ref dom, char *base)
+{
+	b->base = base;
+	b->pos = 0;
+	g_hash_table_remove_all(b->keys);
+	g_hash_table_remove_all(b->nodes);
+
+	size_t header = shared_alloc(b, b->compact ? sizeof(compact_header) : sizeof(shared_header));
+	shared_link_set(b, header + offsetof(shared_header, root), shared_put(b, dom));
+	return b->pos;
+}
+
+bool jshared_publish(const char *name, jvalue_ref dom, jerror **err)
+{
+	CHECK_CONDITION_RETURN_VALUE(!jis_valid(dom), false, "Attempt to share invalid value");
+
+	shared_builder b = {
+		.keys = g_hash_table_new(ObjKeyHash, ObjKeyEqual),
+		.nodes = g_hash_table_new(g_direct_hash, g_direct_equal),
+	};
+	bool result = false;
+	char *base = MAP_FAILED;
+
+	size_t size = shared_build(&b, dom, NULL);
+
+	int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0644);
+	if (fd == -1) {
+		jerror_set_formatted(err, JERROR_TYPE_INVALID_PARAMETERS,
+		                     "Can't create shared memory %s: %s", name, strerror(errno));
+		goto out;
+	}
+
+	if (ftruncate(fd, size) != 0) {
+		jerror_set_formatted(err, JERROR_TYPE_INVALID_PARAMETERS,
+		                     "Can't resize shared memory %s: %s", name, strerror(errno));
+		goto out;
+	}
+
+	base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (base == MAP_FAILED) {
+		jerror_set_formatted(err, JERROR_TYPE_INVALID_PARAMETERS,
+		                     "Can't map shared memory %s: %s", name, strerror(errno));
+		goto out;
+	}
+
+	// Fresh memory is zeroed, the writing pass fills in the rest
+	size_t written = shared_build(&b, dom, base);
+	assert(written == size);
+	(void) written;
+
+	shared_header *header = (shared_header *) base;
+	header->version = SHARED_VERSION;
+	header->size = size;
+	__atomic_store_n(&header->magic, SHARED_MAGIC, __ATOMIC_RELEASE);
+	result = true;
+
+out:
+	if (base != MAP_FAILED)
+		munmap(base, size);
+	if (fd != -1) {
+		close(fd);
+		if (!result)
+			shm_unlink(name);
+	}
+	g_hash_table_destroy(b.nodes);
+	g_hash_table_destroy(b.keys);
+	return result;
+}
+
+jshared_ref jshared_attach(const char *name, jerror **err)
+{
+	int fd = shm_open(name, O_RDONLY, 0);
+	if (fd == -1) {
+		jerror_set_formatted(err, JERROR_TYPE_INVALID_PARAMETERS,
+		                     "Can't open shared memory %s: %s", name, strerror(errno));
+		return NULL;
+	}
+
+	struct stat info;
+	if (fstat(fd, &info) != 0) {
+		jerror_set_formatted(err, JERROR_TYPE_INVALID_PARAMETERS,
+		                     "Can't read shared memory size %s: %s", name, strerror(errno));
+		close(fd);
+		return NULL;
+	}
+
+	size_t size = info.st_size;
+	if (size < sizeof(shared_header)) {
+		jerror_set_formatted(err, JERROR_TYPE_INVALID_PARAMETERS,
+		                     "Shared memory %s isn't ready", name);
+		close(fd);
+		return NULL;
+	}
+
+	char *base = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (base == MAP_FAILED) {
+		jerror_set_formatted(err, JERROR_TYPE_INVALID_PARAMETERS,
+		                     "Can't map shared memory %s: %s", name, strerror(errno));
+		return NULL;
+	}
+
+	shared_header const *header = (shared_header const *) base;
+	if (__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) != SHARED_MAGIC
+	    || header->version != SHARED_VERSION
+	    || header->size != size) {
+		jerror_set_formatted(err, JERROR_TYPE_INVALID_PARAMETERS,
+		                     "Shared memory %s isn't ready or has incompatible format", name);
+		munmap(base, size);
+		return NULL;
+	}
+
+	jshared_ref shared = g_new0(struct jshared, 1);
+	shared->base = base;
+	shared->size = size;
+	shared->strings = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, free);
+
+	g_mutex_lock(&attached_lock);
+	attached = g_slist_prepend(attached, shared);
+	g_mutex_unlock(&attached_lock);
+
+	return shared;
+}
+
+jvalue_ref jshared_root(jshared_ref shared)
+{
+	return jshared_link_deref(&((shared_header const *) shared->base)->root);
+}
+
+void jshared_detach(jshared_ref shared)
+{
+	if (!shared)
+		return;
+
+	g_mutex_lock(&attached_lock);
+	attached = g_slist_remove(attached, shared);
+	g_mutex_unlock(&attached_lock);
+
+	g_hash_table_destroy(shared->strings);
+	munmap(shared->base, shared->size);
+	g_free(shared);
+}
+
+bool jshared_unlink(const char *name)
+{
+	return shm_unlink(name) == 0;
+}
+
+static compact_header *compact_block(jvalue_ref val)
+{
+	return (compact_header *)((char *) val - val->m_biased);
+}
+
+bool jvalue_compact(jvalue_ref *dom)
+{
+	CHECK_CONDITION_RETURN_VALUE(!jis_valid(*dom), false, "Attempt to compact invalid value");
+
+	JValueType type = jget_type(*dom);
+	if (type == JV_NULL || type == JV_BOOL)
+		return true;
+
+	shared_builder b = {
+		.compact = true,
+		.keys = g_hash_table_new(ObjKeyHash, ObjKeyEqual),
+		.nodes = g_hash_table_new(g_direct_hash, g_direct_equal),
+	};
+	bool result = false;
+
+	// The values find the block by their offset kept in m_biased
+	size_t size = shared_build(&b, *dom, NULL);
+	if (UNLIKELY(size > INT_MAX)) {
+		PJ_LOG_ERR("DOM is too big to compact: %zu bytes", size);
+		goto out;
+	}
+
+	char *base = calloc(1, size);
+	if (UNLIKELY(!base))
+		goto out;
+
+	size_t written = shared_build(&b, *dom, base);
+	assert(written == size);
+	(void) written;
+
+	compact_header *header = (compact_header *) base;
+	header->refcnt = 1;
+	g_mutex_init(&header->lock);
+
+	j_release(dom);
+	*dom = jshared_link_deref(&header->shared.root);
+	result = true;
+
+out:
+	g_hash_table_destroy(b.nodes);
+	g_hash_table_destroy(b.keys);
+	return result;
+}
+
+void jcompact_copy(jvalue_ref val)
+{
+	g_atomic_int_inc(&compact_block(val)->refcnt);
+}
+
+void jcompact_release(jvalue_ref val)
+{
+	compact_header *header = compact_block(val);
+	if (!g_atomic_int_dec_and_test(&header->refcnt))
+		return;
+
+	if (header->strings)
+		g_hash_table_destroy(header->strings);
+	g_mutex_clear(&header->lock);
+	free(header);
+}
+
+const char *jshared_keep_string(jvalue_ref val, char *str)
+{
+	if (jis_compact(val)) {
+		compact_header *header = compact_block(val);
+		g_mutex_lock(&header->lock);
+		if (!header->strings)
+			header->strings = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, free);
+		g_hash_table_replace(header->strings, val, str);
+		g_mutex_unlock(&header->lock);
+		return str;
+	}
+
+	const char *result = NULL;
+	char const *addr = (char const *) val;
+
+	g_mutex_lock(&attached_lock);
+	for (GSList *it = attached; it; it = g_slist_next(it)) {
+		jshared_ref shared = (jshared_ref) it->data;
+		if (addr >= shared->base && addr < shared->base + shared->size) {
+			g_hash_table_replace(shared->strings, val, str);
+			result = str;
+			break;
+		}
+	}
+	g_mutex_unlock(&attached_lock);
+
+	if (UNLIKELY(!result)) {
+		PJ_LOG_ERR("Value %p doesn't belong to any attached segment", val);
+		free(str);
+	}
+	return result;
+}
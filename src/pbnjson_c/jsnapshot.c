@@ -0,0 +1,185 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include <jobject.h>
+
+#include <glib.h>
+#include <sched.h>
+#include <compiler/builtins.h>
+
+// Readers are spread over counters in different cache lines to avoid
+// contention. Should be a power of two.
+#define SNAPSHOT_STRIPES 16
+#define SNAPSHOT_CACHE_LINE 64
+
+typedef struct counter {
+	gint value;
+	char padding[SNAPSHOT_CACHE_LINE - sizeof(gint)];
+} counter;
+
+struct jsnapshot_version {
+	jvalue_ref dom;
+	counter pins[SNAPSHOT_STRIPES];
+};
+
+struct jsnapshot {
+	jsnapshot_version_ref current;
+	// Readers between loading the current version and pinning it,
+	// the parity of the epoch selects the set new readers go to.
+	counter readers[2][SNAPSHOT_STRIPES];
+	gint epoch;
+
+	GMutex publish_lock;  // Serializes writers, guards retired
+	GSList *retired;      // Previous versions waiting for their readers
+};
+
+static guint snapshot_stripe(void)
+{
+	static gint next_stripe;
+	static _Thread_local gint stripe = -1;
+
+	if (UNLIKELY(stripe < 0))
+		stripe = g_atomic_int_add(&next_stripe, 1) & (SNAPSHOT_STRIPES - 1);
+	return stripe;
+}
+
+static gint counter_sum(counter const *counters)
+{
+	gint sum = 0;
+	for (int i = 0; i < SNAPSHOT_STRIPES; ++i)
+		sum += g_atomic_int_get(&counters[i].value);
+	return sum;
+}
+
+static jsnapshot_version_ref version_new(jvalue_ref dom)
+{
+	jsnapshot_version_ref version = g_new0(struct jsnapshot_version, 1);
+	version->dom = dom ? dom : jnull();
+	return version;
+}
+
+static void version_free(jsnapshot_version_ref version)
+{
+	j_release(&version->dom);
+	g_free(version);
+}
+
+// Wait until nobody can pin a version replaced before the call. Readers stay
+// in the window for a few instructions only, so spinning is cheap. Flipping the
+// epoch twice lets the old set of counters drain while new readers go to the other.
+static void snapshot_synchronize(jsnapshot_ref snapshot)
+{
+	for (int flip = 0; flip < 2; ++flip)
+	{
+		guint parity = g_atomic_int_add(&snapshot->epoch, 1) & 1;
+		for (int i = 0; i < SNAPSHOT_STRIPES; ++i)
+		{
+			while (g_atomic_int_get(&snapshot->readers[parity][i].value))
+				sched_yield();
+		}
+	}
+}
+
+// Should be called with publish_lock held
+static size_t snapshot_reclaim_unlocked(jsnapshot_ref snapshot)
+{
+	size_t pending = 0;
+	GSList **link = &snapshot->retired;
+	while (*link)
+	{
+		jsnapshot_version_ref version = (*link)->data;
+		// Retired version can't be pinned anymore, so its pins only go down
+		if (counter_sum(version->pins) == 0)
+		{
+			version_free(version);
+			*link = g_slist_delete_link(*link, *link);
+		}
+		else
+		{
+			++pending;
+			link = &(*link)->next;
+		}
+	}
+	return pending;
+}
+
+jsnapshot_ref jsnapshot_create(jvalue_ref dom)
+{
+	jsnapshot_ref snapshot = g_new0(struct jsnapshot, 1);
+	snapshot->current = version_new(dom);
+	g_mutex_init(&snapshot->publish_lock);
+	return snapshot;
+}
+
+void jsnapshot_free(jsnapshot_ref snapshot)
+{
+	if (!snapshot)
+		return;
+
+	g_slist_free_full(snapshot->retired, (GDestroyNotify) version_free);
+	version_free(snapshot->current);
+	g_mutex_clear(&snapshot->publish_lock);
+	g_free(snapshot);
+}
+
+void jsnapshot_publish(jsnapshot_ref snapshot, jvalue_ref dom)
+{
+	jsnapshot_version_ref version = version_new(dom);
+
+	g_mutex_lock(&snapshot->publish_lock);
+
+	jsnapshot_version_ref previous = snapshot->current;
+	g_atomic_pointer_set(&snapshot->current, version);
+	snapshot_synchronize(snapshot);
+
+	snapshot->retired = g_slist_prepend(snapshot->retired, previous);
+	snapshot_reclaim_unlocked(snapshot);
+
+	g_mutex_unlock(&snapshot->publish_lock);
+}
+
+size_t jsnapshot_reclaim(jsnapshot_ref snapshot)
+{
+	g_mutex_lock(&snapshot->publish_lock);
+	size_t pending = snapshot_reclaim_unlocked(snapshot);
+	g_mutex_unlock(&snapshot->publish_lock);
+	return pending;
+}
+
+jsnapshot_version_ref jsnapshot_pin(jsnapshot_ref snapshot)
+{
+	guint stripe = snapshot_stripe();
+	counter *readers = &snapshot->readers[g_atomic_int_get(&snapshot->epoch) & 1][stripe];
+
+	g_atomic_int_inc(&readers->value);
+	jsnapshot_version_ref version = g_atomic_pointer_get(&snapshot->current);
+	g_atomic_int_inc(&version->pins[stripe].value);
+	g_atomic_int_add(&readers->value, -1);
+
+	return version;
+}
+
+jvalue_ref jsnapshot_version_get(jsnapshot_version_ref version)
+{
+	return version->dom;
+}
+
+void jsnapshot_unpin(jsnapshot_version_ref version)
+{
+	// Any stripe will do, only the sum matters
+	g_atomic_int_add(&version->pins[snapshot_stripe()].value, -1);
+}
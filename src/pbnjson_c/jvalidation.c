@@ -36,18 +36,291 @@
 #include "jerror_internal.h"
 #include "jschema_types_internal.h"
 #include "jparse_stream_internal.h"
-#include "jtraverse.h"
 #include "validation/validation_state.h"
 #include "validation/validation_event.h"
 #include "validation/validation_api.h"
 #include "validation/nothing_validator.h"
+#include "validation/validator.h"
+
+typedef enum {
+	MEMO_NONE,        // Validate every value
+	MEMO_SHARED,      // Remember containers, which are referenced from several places
+	MEMO_STRUCTURAL,  // Remember all containers, recognize structurally identical ones
+} MemoMode;
+
+// Pair of a validator and a container, which is known to be valid against it
+typedef struct {
+	Validator *validator;
+	jvalue_ref value;
+	guint hash;
+} MemoEntry;
+
+typedef struct {
+	MemoMode mode;
+	GHashTable *valid;   // MemoEntry set
+	GHashTable *hashes;  // Structural hashes of the containers
+} ValidationMemo;
 
 typedef struct {
 	JErrorCallbacksRef callbacks;
 	jvalue_ref jvalue;
 	ValidationState *validation_state;
+
+	ValidationMemo memo;
+	jvalue_ref next_value;       // Value, which is about to be validated
+	Validator *value_validator;  // Validator of next_value to remember after success
+	bool skip_value;             // next_value is known to be valid, skip its events
+
+	// Candidates of the multi-schema validation, validation_state isn't used then
+	ValidationState *states;
+	bool *alive;
+	size_t states_count;
+	size_t alive_count;
 } ValidationContext;
 
+int jvalidation_number_text(jvalue_ref ref, char buf[24], char const **str)
+{
+	jnum *num = jnum_deref(ref);
+	switch (num->m_type)
+	{
+	case NUM_RAW:
+	{
+		raw_buffer raw = jnum_deref_buffer(ref);
+		*str = raw.m_str;
+		return raw.m_len;
+	}
+	case NUM_FLOAT:
+		*str = buf;
+		return snprintf(buf, 24, "%.14lg", num->value.floating);
+	default:
+		*str = buf;
+		return snprintf(buf, 24, "%" PRId64, num->value.integer);
+	}
+}
+
+static guint hash_bytes_from(guint h, char const *str, size_t len)
+{
+	for (size_t i = 0; i < len; ++i)
+		h = h * 33 + (unsigned char) str[i];
+	return h;
+}
+
+static guint hash_bytes(char const *str, size_t len)
+{
+	return hash_bytes_from(5381, str, len);
+}
+
+static guint value_hash(ValidationMemo *memo, jvalue_ref ref)
+{
+	switch (ref->m_type)
+	{
+	case JV_NULL:
+		return jis_valid(ref) ? 1 : 2;
+	case JV_BOOL:
+		return jboolean_deref(ref)->value ? 3 : 4;
+	case JV_NUM:
+	{
+		char buf[24];
+		char const *str;
+		int len = jvalidation_number_text(ref, buf, &str);
+		return hash_bytes(str, len);
+	}
+	case JV_STR:
+	{
+		// Chunked strings are hashed chunk by chunk
+		jstring_chunk_iter it;
+		jstring_chunk_iter_init(&it, ref);
+		raw_buffer chunk;
+		guint h = 5381;
+		while (jstring_chunk_iter_next(&it, &chunk))
+			h = hash_bytes_from(h, chunk.m_str, chunk.m_len);
+		return h * 7;
+	}
+	default:
+		break;
+	}
+
+	gpointer cached;
+	if (g_hash_table_lookup_extended(memo->hashes, ref, NULL, &cached))
+		return GPOINTER_TO_UINT(cached);
+
+	guint h;
+	if (ref->m_type == JV_ARRAY)
+	{
+		h = 11;
+		for (ssize_t i = 0; i < jarray_size(ref); ++i)
+			h = h * 31 + value_hash(memo, jarray_get(ref, i));
+	}
+	else
+	{
+		// Key order doesn't matter for the validation
+		h = 13;
+		jobject_iter it;
+		jobject_iter_init(&it, ref);
+		jobject_key_value key_value;
+		while (jobject_iter_next(&it, &key_value))
+			h += value_hash(memo, key_value.key) * 0x9e3779b1u ^ value_hash(memo, key_value.value);
+	}
+
+	g_hash_table_insert(memo->hashes, ref, GUINT_TO_POINTER(h));
+	return h;
+}
+
+// Check if the values produce the same validation events up to the order of object keys
+static bool same_events(jvalue_ref a, jvalue_ref b)
+{
+	if (a == b)
+		return true;
+	if (a->m_type != b->m_type)
+		return false;
+
+	switch (a->m_type)
+	{
+	case JV_NULL:
+		return jis_valid(a) == jis_valid(b);
+	case JV_BOOL:
+		return jboolean_deref(a)->value == jboolean_deref(b)->value;
+	case JV_NUM:
+	{
+		char buf_a[24], buf_b[24];
+		char const *str_a, *str_b;
+		int len_a = jvalidation_number_text(a, buf_a, &str_a);
+		int len_b = jvalidation_number_text(b, buf_b, &str_b);
+		return len_a == len_b && memcmp(str_a, str_b, len_a) == 0;
+	}
+	case JV_STR:
+		return jstring_equal(a, b);
+	case JV_ARRAY:
+	{
+		ssize_t size = jarray_size(a);
+		if (size != jarray_size(b))
+			return false;
+		for (ssize_t i = 0; i < size; ++i)
+			if (!same_events(jarray_get(a, i), jarray_get(b, i)))
+				return false;
+		return true;
+	}
+	case JV_OBJECT:
+	{
+		if (jobject_size(a) != jobject_size(b))
+			return false;
+		jobject_iter it;
+		jobject_iter_init(&it, a);
+		jobject_key_value key_value;
+		while (jobject_iter_next(&it, &key_value))
+		{
+			jvalue_ref other;
+			if (!jobject_get_exists2(b, key_value.key, &other) ||
+			    !same_events(key_value.value, other))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+	}
+	return false;
+}
+
+static guint memo_entry_hash(gconstpointer key)
+{
+	MemoEntry const *e = (MemoEntry const *) key;
+	return g_direct_hash(e->validator) ^ e->hash;
+}
+
+static gboolean memo_entry_same_value(gconstpointer a, gconstpointer b)
+{
+	MemoEntry const *e1 = (MemoEntry const *) a;
+	MemoEntry const *e2 = (MemoEntry const *) b;
+	return e1->validator == e2->validator && e1->value == e2->value;
+}
+
+static gboolean memo_entry_same_events(gconstpointer a, gconstpointer b)
+{
+	MemoEntry const *e1 = (MemoEntry const *) a;
+	MemoEntry const *e2 = (MemoEntry const *) b;
+	return e1->validator == e2->validator && e1->hash == e2->hash &&
+	       same_events(e1->value, e2->value);
+}
+
+static void memo_entry_free(gpointer data)
+{
+	MemoEntry *e = (MemoEntry *) data;
+	validator_unref(e->validator);
+	g_slice_free(MemoEntry, e);
+}
+
+static bool memo_applicable(ValidationMemo *memo, jvalue_ref ref)
+{
+	if (memo->mode == MEMO_NONE || !ref)
+		return false;
+	if (ref->m_type != JV_OBJECT && ref->m_type != JV_ARRAY)
+		return false;
+	// Node identity can repeat only if the node is referenced several times
+	return memo->mode == MEMO_STRUCTURAL || jis_multiref(ref);
+}
+
+static MemoEntry memo_key(ValidationMemo *memo, Validator *v, jvalue_ref ref)
+{
+	if (!memo->valid)
+	{
+		bool structural = memo->mode == MEMO_STRUCTURAL;
+		memo->valid = g_hash_table_new_full(memo_entry_hash,
+		                                    structural ? memo_entry_same_events : memo_entry_same_value,
+		                                    memo_entry_free, NULL);
+		if (structural)
+			memo->hashes = g_hash_table_new(g_direct_hash, g_direct_equal);
+	}
+
+	MemoEntry key = {
+		.validator = v,
+		.value = ref,
+		.hash = memo->hashes ? value_hash(memo, ref) : g_direct_hash(ref),
+	};
+	return key;
+}
+
+static bool memo_lookup(ValidationMemo *memo, Validator *v, jvalue_ref ref)
+{
+	MemoEntry key = memo_key(memo, v, ref);
+	return g_hash_table_contains(memo->valid, &key);
+}
+
+static void memo_add(ValidationMemo *memo, Validator *v, jvalue_ref ref)
+{
+	MemoEntry *e = g_slice_new(MemoEntry);
+	*e = memo_key(memo, v, ref);
+	// The validator is kept alive, so that its address can't be reused during the run
+	validator_ref(v);
+	g_hash_table_add(memo->valid, e);
+}
+
+static void memo_clear(ValidationMemo *memo)
+{
+	if (memo->valid)
+		g_hash_table_destroy(memo->valid);
+	if (memo->hashes)
+		g_hash_table_destroy(memo->hashes);
+}
+
+// Feed the event to the validation. In multi-schema validation, candidates
+// are dropped as soon as they fail, the validation goes on while any remains.
+static bool check_event(ValidationContext *ctxt, ValidationEvent const *e)
+{
+	if (LIKELY(!ctxt->states))
+		return validation_check(e, ctxt->validation_state, ctxt);
+
+	for (size_t i = 0; i < ctxt->states_count; ++i)
+	{
+		if (ctxt->alive[i] && !validation_check(e, &ctxt->states[i], ctxt))
+		{
+			ctxt->alive[i] = false;
+			--ctxt->alive_count;
+		}
+	}
+	return ctxt->alive_count > 0;
+}
+
 static bool check_schema_jnull(void *ctxt, jvalue_ref ref)
 {
 	ValidationContext *context = (ValidationContext*)ctxt;
@@ -59,27 +332,28 @@ static bool check_schema_jnull(void *ctxt, jvalue_ref ref)
 			.errorDescription = "jinvalid() cannot be validated against any schema"
 		};
 
-		context->callbacks->m_parser(context->callbacks->m_ctxt, &fake_sax_ctxt);
+		if (context->callbacks)
+			context->callbacks->m_parser(context->callbacks->m_ctxt, &fake_sax_ctxt);
 		return false;
 	}
 	ValidationEvent e = validation_event_null();
-	return validation_check(&e, context->validation_state, context);
+	return check_event(context, &e);
 }
 
 //Helper function for jobject_to_string_append()
 static bool check_schema_jkeyvalue(void *ctxt, jvalue_ref ref)
 {
 	ValidationContext *context = (ValidationContext*)ctxt;
-	raw_buffer raw = jstring_deref(ref)->m_data;
+	raw_buffer raw = jstring_deref_buffer(ref);
 	ValidationEvent e = validation_event_obj_key(raw.m_str, raw.m_len);
-	return validation_check(&e, context->validation_state, context);
+	return check_event(context, &e);
 }
 
 static bool check_schema_jobject_start(void *ctxt, jvalue_ref ref)
 {
 	ValidationContext *context = (ValidationContext*)ctxt;
 	ValidationEvent e = validation_event_obj_start();
-	return validation_check(&e, context->validation_state, context);
+	return check_event(context, &e);
 }
 
 static bool check_schema_jobject_end(void *ctxt, jvalue_ref ref)
@@ -87,14 +361,14 @@ static bool check_schema_jobject_end(void *ctxt, jvalue_ref ref)
 	ValidationContext *context = (ValidationContext*)ctxt;
 	context->jvalue = ref;
 	ValidationEvent e = validation_event_obj_end();
-	return validation_check(&e, context->validation_state, context);
+	return check_event(context, &e);
 }
 
 static bool check_schema_jarray_start(void *ctxt, jvalue_ref ref)
 {
 	ValidationContext *context = (ValidationContext*)ctxt;
 	ValidationEvent e = validation_event_arr_start();
-	return validation_check(&e, context->validation_state, context);
+	return check_event(context, &e);
 }
 
 static bool check_schema_jarray_end(void *ctxt, jvalue_ref ref)
@@ -102,48 +376,42 @@ static bool check_schema_jarray_end(void *ctxt, jvalue_ref ref)
 	ValidationContext *context = (ValidationContext*)ctxt;
 	context->jvalue = ref;
 	ValidationEvent e = validation_event_arr_end();
-	return validation_check(&e, context->validation_state, context);
+	return check_event(context, &e);
 }
 
-static bool check_schema_jnumber_raw(void *ctxt, jvalue_ref ref)
-{
-	ValidationContext *context = (ValidationContext*)ctxt;
-	raw_buffer raw = jnum_deref(ref)->value.raw;
-	ValidationEvent e = validation_event_number(raw.m_str, raw.m_len);
-	return validation_check(&e, context->validation_state, context);
-}
-
-static bool check_schema_jnumber_double(void *ctxt, jvalue_ref ref)
-{
-	char buf[24];
-	int len = snprintf(buf, sizeof(buf), "%.14lg", jnum_deref(ref)->value.floating);
-	ValidationContext *context = (ValidationContext*)ctxt;
-	ValidationEvent e = validation_event_number(buf, len);
-	return validation_check(&e, context->validation_state, context);
-}
-
-static bool check_schema_jnumber_int(void *ctxt, jvalue_ref ref)
+static bool check_schema_jnumber(void *ctxt, jvalue_ref ref)
 {
 	char buf[24];
-	int len = snprintf(buf, sizeof(buf), "%" PRId64, jnum_deref(ref)->value.integer);
+	char const *str;
+	int len = jvalidation_number_text(ref, buf, &str);
 	ValidationContext *context = (ValidationContext*)ctxt;
-	ValidationEvent e = validation_event_number(buf, len);
-	return validation_check(&e, context->validation_state, context);
+	ValidationEvent e = validation_event_number(str, len);
+	return check_event(context, &e);
 }
 
 static bool check_schema_jstring(void *ctxt, jvalue_ref ref)
 {
 	ValidationContext *context = (ValidationContext*)ctxt;
-	raw_buffer raw = jstring_deref(ref)->m_data;
+	if (UNLIKELY(jstring_is_chunked(ref))) {
+		// Validators need the text in one piece, the copy isn't kept next to the chunks
+		raw_buffer copy = jstring_get(ref);
+		if (UNLIKELY(!copy.m_str))
+			return false;
+		ValidationEvent e = validation_event_string(copy.m_str, copy.m_len);
+		bool result = check_event(context, &e);
+		jstring_free_buffer(copy);
+		return result;
+	}
+	raw_buffer raw = jstring_deref_buffer(ref);
 	ValidationEvent e = validation_event_string(raw.m_str, raw.m_len);
-	return validation_check(&e, context->validation_state, context);
+	return check_event(context, &e);
 }
 
 static bool check_schema_jbool(void *ctxt, jvalue_ref ref)
 {
 	ValidationContext *context = (ValidationContext*)ctxt;
 	ValidationEvent e = validation_event_boolean(jboolean_deref(ref)->value);
-	return validation_check(&e, context->validation_state, context);
+	return check_event(context, &e);
 }
 
 static void error_callback(ValidationState *s, ValidationErrorCode error, void *ctxt)
@@ -167,25 +435,148 @@ static bool has_array_duplicates(ValidationState *s, void *ctxt)
 	return jarray_has_duplicates(((ValidationContext *) ctxt)->jvalue);
 }
 
+static bool skip_known_valid(ValidationState *s, Validator *v, void *_ctxt)
+{
+	ValidationContext *ctxt = (ValidationContext *)_ctxt;
+
+	// Combined validators feed the same events into their own states,
+	// only the main state can let the value go.
+	if (s != ctxt->validation_state || !memo_applicable(&ctxt->memo, ctxt->next_value))
+		return false;
+
+	if (memo_lookup(&ctxt->memo, v, ctxt->next_value))
+	{
+		ctxt->skip_value = true;
+		return true;
+	}
+
+	ctxt->value_validator = v;
+	return false;
+}
+
 static Notification jvalue_check_notification =
 {
 	.error_func = &error_callback,
 	.has_array_duplicates = &has_array_duplicates,
+	.skip_value_func = &skip_known_valid,
 };
 
-static struct TraverseCallbacks traverse = {
-	check_schema_jnull,
-	check_schema_jbool,
-	check_schema_jnumber_int,
-	check_schema_jnumber_double,
-	check_schema_jnumber_raw,
-	check_schema_jstring,
-	check_schema_jobject_start,
-	check_schema_jkeyvalue,
-	check_schema_jobject_end,
-	check_schema_jarray_start,
-	check_schema_jarray_end,
-};
+static bool check_value(ValidationContext *ctxt, jvalue_ref jref);
+
+// Called after the start of a container value. Returns true if the rest of the value
+// should be skipped. Otherwise, return validator, which should be remembered
+// together with the value after successful validation.
+static bool take_skip(ValidationContext *ctxt, Validator **validator)
+{
+	*validator = ctxt->value_validator;
+	ctxt->value_validator = NULL;
+	if (!ctxt->skip_value)
+		return false;
+	ctxt->skip_value = false;
+	return true;
+}
+
+typedef enum {
+	MEMBERS_ALL,
+	MEMBERS_SCALAR,
+	MEMBERS_CONTAINER,
+} MembersFilter;
+
+static inline bool is_container(jvalue_ref jref)
+{
+	return jref->m_type == JV_OBJECT || jref->m_type == JV_ARRAY;
+}
+
+static bool check_members(ValidationContext *ctxt, jvalue_ref jref, MembersFilter filter)
+{
+	jobject_iter it;
+	jobject_iter_init(&it, jref);
+	jobject_key_value key_value;
+	while (jobject_iter_next(&it, &key_value))
+	{
+		if (filter != MEMBERS_ALL && (filter == MEMBERS_CONTAINER) != is_container(key_value.value))
+			continue;
+
+		ctxt->next_value = key_value.value;
+		if (!check_schema_jkeyvalue(ctxt, key_value.key))
+			return false;
+		if (ctxt->skip_value)
+		{
+			ctxt->skip_value = false;
+			continue;
+		}
+		if (!check_value(ctxt, key_value.value))
+			return false;
+	}
+	return true;
+}
+
+static bool check_object(ValidationContext *ctxt, jvalue_ref jref)
+{
+	if (!check_schema_jobject_start(ctxt, jref))
+		return false;
+
+	Validator *validator;
+	if (take_skip(ctxt, &validator))
+		return true;
+
+	if (ctxt->states)
+	{
+		// Validation doesn't depend on the order of the properties. Scalars are
+		// cheap to check and usually discriminate the candidates (like "method": "get"),
+		// so they go first to drop mismatching schemas before descending into subtrees.
+		if (!check_members(ctxt, jref, MEMBERS_SCALAR) || !check_members(ctxt, jref, MEMBERS_CONTAINER))
+			return false;
+	}
+	else if (!check_members(ctxt, jref, MEMBERS_ALL))
+		return false;
+
+	if (!check_schema_jobject_end(ctxt, jref))
+		return false;
+	if (validator)
+		memo_add(&ctxt->memo, validator, jref);
+	return true;
+}
+
+static bool check_array(ValidationContext *ctxt, jvalue_ref jref)
+{
+	if (!check_schema_jarray_start(ctxt, jref))
+		return false;
+
+	Validator *validator;
+	if (take_skip(ctxt, &validator))
+		return true;
+
+	for (ssize_t i = 0; i < jarray_size(jref); i++)
+	{
+		jvalue_ref element = jarray_get(jref, i);
+		ctxt->next_value = element;
+		if (!check_value(ctxt, element))
+			return false;
+	}
+
+	if (!check_schema_jarray_end(ctxt, jref))
+		return false;
+	if (validator)
+		memo_add(&ctxt->memo, validator, jref);
+	return true;
+}
+
+// Same as jvalue_traverse(), but able to skip values known to be valid
+static bool check_value(ValidationContext *ctxt, jvalue_ref jref)
+{
+	switch (jref->m_type)
+	{
+	case JV_NULL   : return check_schema_jnull(ctxt, jref);
+	case JV_OBJECT : return check_object(ctxt, jref);
+	case JV_ARRAY  : return check_array(ctxt, jref);
+	case JV_NUM    : return check_schema_jnumber(ctxt, jref);
+	case JV_STR    : return check_schema_jstring(ctxt, jref);
+	case JV_BOOL   : return check_schema_jbool(ctxt, jref);
+	}
+
+	return false;
+}
 
 static bool on_default_property(ValidationState *s, char const *key, jvalue_ref value, void *_ctxt)
 {
@@ -232,7 +623,7 @@ static bool cb_unknown_error(void *ctxt, JSAXContextRef parseCtxt)
 }
 
 static bool jvalue_schema_work(jvalue_ref jref, const jschema_ref schema, JErrorCallbacksRef cb,
-                               Notification *notifications)
+                               Notification *notifications, MemoMode memo)
 {
 	assert(schema != NULL);
 
@@ -246,10 +637,12 @@ static bool jvalue_schema_work(jvalue_ref jref, const jschema_ref schema, JError
 		.callbacks = cb,
 		.jvalue = jref,
 		.validation_state = &validation_state,
+		.memo = { .mode = memo },
 	};
 
-	bool retVal = jvalue_traverse(jref, &traverse, &ctxt);
+	bool retVal = check_value(&ctxt, jref);
 	validation_state_clear(&validation_state);
+	memo_clear(&ctxt.memo);
 
 	return retVal;
 }
@@ -271,7 +664,8 @@ bool jvalue_check_schema(jvalue_ref jref, const JSchemaInfoRef schema_info)
 		return false;
 	}
 
-	return jvalue_schema_work(jref, schema_info->m_schema, schema_info->m_errHandler, &jvalue_check_notification);
+	return jvalue_schema_work(jref, schema_info->m_schema, schema_info->m_errHandler,
+	                          &jvalue_check_notification, MEMO_SHARED);
 }
 
 bool jvalue_validate(const jvalue_ref val, const jschema_ref schema, jerror **err)
@@ -284,7 +678,60 @@ bool jvalue_validate(const jvalue_ref val, const jschema_ref schema, jerror **er
 		.m_ctxt    = err
 	};
 
-	return jvalue_schema_work(val, schema, &cb, &jvalue_check_notification);
+	return jvalue_schema_work(val, schema, &cb, &jvalue_check_notification, MEMO_SHARED);
+}
+
+bool jvalue_validate_dedup(const jvalue_ref val, const jschema_ref schema, jerror **err)
+{
+	struct JErrorCallbacks cb =
+	{
+		.m_parser  = cb_parser_error,
+		.m_schema  = cb_schema_error,
+		.m_unknown = cb_unknown_error,
+		.m_ctxt    = err
+	};
+
+	return jvalue_schema_work(val, schema, &cb, &jvalue_check_notification, MEMO_STRUCTURAL);
+}
+
+size_t jvalue_validate_many(const jvalue_ref val, const jschema_ref schemas[], size_t count, size_t *matches)
+{
+	if (!count)
+		return 0;
+
+	ValidationContext ctxt = {
+		.jvalue = val,
+		.memo = { .mode = MEMO_NONE },
+		.states = g_new0(ValidationState, count),
+		.alive = g_new(bool, count),
+		.states_count = count,
+		.alive_count = count,
+	};
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		assert(schemas[i] != NULL);
+		validation_state_init(&ctxt.states[i],
+		                      schemas[i]->validator,
+		                      schemas[i]->uri_resolver,
+		                      &jvalue_check_notification);
+		ctxt.alive[i] = true;
+	}
+
+	size_t found = 0;
+	if (check_value(&ctxt, val))
+	{
+		for (size_t i = 0; i < count; ++i)
+			if (ctxt.alive[i])
+				matches[found++] = i;
+	}
+
+	for (size_t i = 0; i < count; ++i)
+		validation_state_clear(&ctxt.states[i]);
+	g_free(ctxt.states);
+	g_free(ctxt.alive);
+
+	return found;
 }
 
 bool jvalue_apply_schema(jvalue_ref val, const JSchemaInfoRef schema)
@@ -305,7 +752,7 @@ bool jvalue_apply_schema(jvalue_ref val, const JSchemaInfoRef schema)
 	}
 
 	return jvalue_schema_work(val, schema->m_schema, schema->m_errHandler,
-	                          &jvalue_apply_notification);
+	                          &jvalue_apply_notification, MEMO_NONE);
 }
 
 bool jvalue_validate_apply(jvalue_ref val, const jschema_ref schema, jerror **err)
@@ -317,5 +764,5 @@ bool jvalue_validate_apply(jvalue_ref val, const jschema_ref schema, jerror **er
 		.m_unknown = cb_unknown_error,
 		.m_ctxt    = err
 	};
-	return jvalue_schema_work(val, schema, &cb, &jvalue_apply_notification);
+	return jvalue_schema_work(val, schema, &cb, &jvalue_apply_notification, MEMO_NONE);
 }
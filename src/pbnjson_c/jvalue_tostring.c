@@ -32,7 +32,7 @@ static bool to_string_append_jnull(void *ctxt, jvalue_ref jref)
 static bool to_string_append_jkeyvalue(void *ctxt, jvalue_ref jref)
 {
 	JStreamRef generating = (JStreamRef)ctxt;
-	raw_buffer raw = jstring_deref(jref)->m_data;
+	raw_buffer raw = jstring_deref_buffer(jref);
 	return generating->o_key(generating, raw) != NULL;
 }
 
@@ -63,7 +63,7 @@ static bool to_string_append_jarray_end(void *ctxt, jvalue_ref jref)
 static bool to_string_append_jnumber_raw(void *ctxt, jvalue_ref jref)
 {
 	JStreamRef generating = (JStreamRef)ctxt;
-	return generating->number(generating, jnum_deref(jref)->value.raw) != NULL;
+	return generating->number(generating, jnum_deref_buffer(jref)) != NULL;
 }
 
 static bool to_string_append_jnumber_double(void *ctxt, jvalue_ref jref)
@@ -81,7 +81,9 @@ static bool to_string_append_jnumber_int(void *ctxt, jvalue_ref jref)
 static inline bool to_string_append_jstring(void *ctxt, jvalue_ref jref)
 {
 	JStreamRef generating = (JStreamRef)ctxt;
-	raw_buffer raw = jstring_deref(jref)->m_data;
+	if (UNLIKELY(jstring_is_chunked(jref)))
+		return jstream_string_chunks(generating, jref) != NULL;
+	raw_buffer raw = jstring_deref_buffer(jref);
 	return generating->string(generating, raw) != NULL;
 }
 
@@ -126,6 +128,10 @@ static const char *jvalue_tostring_internal(jvalue_ref val, JSchemaInfoRef schem
 		return NULL; // We are not expecting that something goes wrong
 	}
 
+	// Shared values are read-only, their text is kept aside
+	if (UNLIKELY(jis_shared(val)))
+		return jshared_keep_string(val, generating->finish(generating, NULL));
+
 	val->m_string = (_jbuffer){
 		j_cstr_to_buffer(generating->finish(generating, NULL)),
 		_jbuffer_free
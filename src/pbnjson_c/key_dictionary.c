@@ -18,6 +18,7 @@
 #include "jobject.h"
 #include "jobject_internal.h"
 #include "liblog.h"
+#include "dom_node_allocator.h"
 
 #include <assert.h>
 #include <glib.h>
@@ -56,7 +57,8 @@ static void keyStringDtor(void *buffer)
 
 static jvalue_ref allocKeyString(raw_buffer str)
 {
-	jstring_inline *new_str = (jstring_inline*) calloc(1, sizeof(jstring_inline) + str.m_len);
+	// Same layout as jstring_create_copy() to be released the same way
+	jstring_inline *new_str = (jstring_inline*) dom_node_alloc0(sizeof(jstring_inline) + str.m_len + 1);
 	SANITY_CHECK_POINTER(new_str);
 	jvalue_init((jvalue_ref)new_str, JV_STR);
 
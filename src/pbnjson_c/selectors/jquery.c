@@ -26,6 +26,10 @@
 #include "jquery_generated_declarations.h"
 #include "jquery_selectors.h"
 
+// Every jquery_init() starts a new run, numbered across the threads
+static volatile gint last_run;
+static _Thread_local guint current_run;
+
 jquery_ptr
 jquery_new(selector_filter_function sfunc,
            void *sfunc_ctxt,
@@ -158,6 +162,11 @@ jvalue_ref jquery_next(jquery_ptr query)
 	return result.value;
 }
 
+guint jquery_current_run(void)
+{
+	return current_run;
+}
+
 void
 jquery_internal_init(jquery_ptr query, jvalue_search_result JSON)
 {
@@ -180,6 +189,8 @@ bool jquery_init(jquery_ptr query, jvalue_ref JSON, jerror **err)
 	CHECK_POINTER_SET_ERROR_RETURN(query, false, err, "'query' parameter must be a non-null pointer");
 	CHECK_POINTER_SET_ERROR_RETURN(JSON, false, err, "'JSON' parameter must be a non-null pointer");
 
+	current_run = (guint) g_atomic_int_add(&last_run, 1) + 1;
+
 	jvalue_search_result val = { JSON, NULL };
 	jquery_internal_init(query, val);
 
@@ -18,11 +18,15 @@
 
 #include <stdio.h>
 
+// Positions only need to be unique within a query run, which doesn't leave its thread
+static _Thread_local gsize last_position;
+
 jquery_generator_ptr jq_generator_new(jvalue_search_result json, int type)
 {
 	jquery_generator_ptr result = g_new0(jquery_generator, 1);
 
 	result->json = json;
+	result->json.position = ++last_position;
 	result->type = type;
 
 	return result;
@@ -33,6 +37,7 @@ void jq_generator_reset(jquery_generator_ptr generator, jvalue_search_result jso
 	if (NULL == generator) return;
 
 	generator->json = json;
+	generator->json.position = ++last_position;
 	generator->array_iterator = 0;
 	generator->self_returned = false;
 }
@@ -34,6 +34,9 @@ struct _jvalue_search_result
 	jvalue_search_result *parent;
 	ssize_t value_index;
 	jvalue_ref value_key;
+	// Identifies the generator position, changes whenever the generator is reset.
+	// Combinators memoize their results per position (see jquery_combinator).
+	gsize position;
 };
 
 typedef jvalue_search_result(*jq_generator_function)(jvalue_search_result *, void *);
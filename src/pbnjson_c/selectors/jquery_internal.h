@@ -77,6 +77,11 @@ jquery_ptr jquery_new(selector_filter_function sfunc,
  */
 void jquery_internal_init(jquery_ptr query, jvalue_search_result json);
 
+/* Number of the query run started by the last jquery_init() in the calling thread.
+ * State memoized by the combinators is valid only during the same run.
+ */
+guint jquery_current_run(void);
+
 static inline void j_release_helper(jvalue_ref val)
 {
     j_release(&val);
@@ -73,7 +73,8 @@ bool selector_has(jvalue_search_result *json, void *ctxt)
 	assert(ctxt);
 	jquery_ptr q = (jquery_ptr) ctxt;
 
-	jquery_init(q, json->value, NULL);
+	// Not jquery_init(), the sub-query belongs to the current run
+	jquery_internal_init(q, (jvalue_search_result){ json->value, NULL });
 	return jis_valid(jquery_next(q));
 }
 
@@ -95,75 +96,152 @@ bool selector_value(jvalue_search_result *json, void *ctxt)
 	return jvalue_equal(value, json->value);
 }
 
-bool selector_parent(jvalue_search_result *json, void *ctxt)
+// Memoized results. Absent entries are NULL, so the values are offset by one.
+#define MEMO_MISMATCH GINT_TO_POINTER(1)
+#define MEMO_MATCH    GINT_TO_POINTER(2)
+
+jquery_combinator_ptr jquery_combinator_new(jquery_ptr query)
 {
-	if (json->parent)
-	{
-		assert(ctxt);
-		jquery_ptr q = (jquery_ptr) ctxt;
+	jquery_combinator_ptr combinator = g_new(struct __query_combinator, 1);
+	combinator->query = query;
+	combinator->memo = g_hash_table_new(g_direct_hash, g_direct_equal);
+	combinator->run = 0;
+	return combinator;
+}
+
+void jquery_combinator_free(jquery_combinator_ptr combinator)
+{
+	jquery_free(combinator->query);
+	g_hash_table_destroy(combinator->memo);
+	g_free(combinator);
+}
 
-		jquery_internal_init(q, *json->parent);
-		return jis_valid(jquery_next(q));
+// Positions are never reused within a run, but the values they point to may be
+// changed between the runs.
+static GHashTable *combinator_memo(jquery_combinator_ptr combinator)
+{
+	guint run = jquery_current_run();
+	if (combinator->run != run)
+	{
+		g_hash_table_remove_all(combinator->memo);
+		combinator->run = run;
 	}
+	return combinator->memo;
+}
 
-	return false;
+static bool combinator_match(jquery_combinator_ptr combinator, jvalue_search_result json)
+{
+	jquery_internal_init(combinator->query, json);
+	return jis_valid(jquery_next(combinator->query));
 }
 
-bool selector_ancestor(jvalue_search_result *json, void *ctxt)
+bool selector_parent(jvalue_search_result *json, void *ctxt)
 {
 	jvalue_search_result *parent = json->parent;
 
 	if (NULL == parent) return false;
 
 	assert(ctxt);
-	jquery_ptr q = (jquery_ptr) ctxt;
+	jquery_combinator_ptr combinator = (jquery_combinator_ptr) ctxt;
+	GHashTable *memo = combinator_memo(combinator);
 
-	do
+	gpointer key = GSIZE_TO_POINTER(parent->position);
+	gpointer result = g_hash_table_lookup(memo, key);
+	if (!result)
 	{
-		jquery_internal_init(q, *parent);
-		if (jis_valid(jquery_next(q))) return true;
+		result = combinator_match(combinator, *parent) ? MEMO_MATCH : MEMO_MISMATCH;
+		g_hash_table_insert(memo, key, result);
 	}
-	while (NULL != (parent = parent->parent));
 
-	return false;
+	return result == MEMO_MATCH;
 }
 
-bool selector_sibling(jvalue_search_result *json, void *ctxt)
+// Check the node and its ancestors. The result is memoized for every node on
+// the way up, so the siblings and descendants of the node don't walk it again.
+static bool ancestor_match(jquery_combinator_ptr combinator, GHashTable *memo, jvalue_search_result *node)
+{
+	gpointer key = GSIZE_TO_POINTER(node->position);
+	gpointer result = g_hash_table_lookup(memo, key);
+	if (!result)
+	{
+		bool matched = combinator_match(combinator, *node)
+		               || (node->parent && ancestor_match(combinator, memo, node->parent));
+		result = matched ? MEMO_MATCH : MEMO_MISMATCH;
+		g_hash_table_insert(memo, key, result);
+	}
+
+	return result == MEMO_MATCH;
+}
+
+bool selector_ancestor(jvalue_search_result *json, void *ctxt)
 {
 	jvalue_search_result *parent = json->parent;
 
 	if (NULL == parent) return false;
 
 	assert(ctxt);
-	jquery_ptr q = (jquery_ptr) ctxt;
+	jquery_combinator_ptr combinator = (jquery_combinator_ptr) ctxt;
+
+	return ancestor_match(combinator, combinator_memo(combinator), parent);
+}
+
+// Count the children of the node matching the left-hand query, up to two
+static gint count_children(jquery_combinator_ptr combinator, jvalue_search_result *parent)
+{
+	gint count = 0;
 
 	if (jis_object(parent->value))
 	{
 		jobject_iter it;
 		jobject_iter_init(&it, parent->value);
 		jobject_key_value kv;
-		while (jobject_iter_next(&it, &kv))
+		while (count < 2 && jobject_iter_next(&it, &kv))
 		{
-			if (kv.key != json->value_key)
-			{
-				jquery_internal_init(q, (jvalue_search_result){ kv.value, parent, -1, kv.key });
-				if (jis_valid(jquery_next(q))) return true;
-			}
+			if (combinator_match(combinator, (jvalue_search_result){ kv.value, parent, -1, kv.key }))
+				++count;
 		}
 	}
 	else if (jis_array(parent->value))
 	{
-		for (ssize_t i = 0; i < jarray_size(parent->value); ++i)
+		for (ssize_t i = 0; count < 2 && i < jarray_size(parent->value); ++i)
 		{
-			if (i != json->value_index)
-			{
-				jquery_internal_init(q, (jvalue_search_result){ jarray_get(parent->value, i), parent, i, NULL });
-				if (jis_valid(jquery_next(q))) return true;
-			}
+			if (combinator_match(combinator, (jvalue_search_result){ jarray_get(parent->value, i), parent, i, NULL }))
+				++count;
 		}
 	}
 
-	return false;
+	return count;
+}
+
+bool selector_sibling(jvalue_search_result *json, void *ctxt)
+{
+	jvalue_search_result *parent = json->parent;
+
+	if (NULL == parent) return false;
+
+	assert(ctxt);
+	jquery_combinator_ptr combinator = (jquery_combinator_ptr) ctxt;
+	GHashTable *memo = combinator_memo(combinator);
+
+	// The children of the parent are tested once, the node has a matching
+	// sibling if there are two matching children, or one which isn't the node.
+	gpointer key = GSIZE_TO_POINTER(parent->position);
+	gint count = GPOINTER_TO_INT(g_hash_table_lookup(memo, key)) - 1;
+	if (count < 0)
+	{
+		count = count_children(combinator, parent);
+		g_hash_table_insert(memo, key, GINT_TO_POINTER(count + 1));
+	}
+
+	switch (count)
+	{
+	case 0:
+		return false;
+	case 1:
+		return !combinator_match(combinator, *json);
+	default:
+		return true;
+	}
 }
 
 bool selector_empty(jvalue_search_result *json, void *ctxt)
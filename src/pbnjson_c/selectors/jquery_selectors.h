@@ -32,6 +32,16 @@ typedef struct __query_pair {
 	jquery_ptr second;
 } *jquery_pair_ptr;
 
+/* Context of the combinators: the left-hand query and its results
+ * memoized per position for the current query run, so that every node
+ * is tested against the left-hand query at most once.
+ */
+typedef struct __query_combinator {
+	jquery_ptr query;
+	GHashTable *memo;
+	guint run;
+} *jquery_combinator_ptr;
+
 /* Filter all subelements.
 jvalue_ref current element
 void * next element (jobject_key_value or jvalue_ref)
@@ -90,23 +100,25 @@ bool selector_value(jvalue_search_result *json, void *ctxt);
 
 /* T > U
  * A node U with a parent T
- * Context is jquery_ptr
+ * Context is jquery_combinator
  */
 bool selector_parent(jvalue_search_result *json, void *ctxt);
 
 /*
  * T U
  * A node U with an ancestor T
- * Context is jquery_ptr
+ * Context is jquery_combinator
  */
 bool selector_ancestor(jvalue_search_result *json, void *ctxt);
 
 /*
  * T ~ U
  * A node U with a sibling T
- * Context is jquery_ptr
+ * Context is jquery_combinator
  */
 bool selector_sibling(jvalue_search_result *json, void *ctxt);
+jquery_combinator_ptr jquery_combinator_new(jquery_ptr query);
+void jquery_combinator_free(jquery_combinator_ptr combinator);
 
 /*
  * :empty
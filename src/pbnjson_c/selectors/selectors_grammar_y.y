@@ -105,13 +105,14 @@ selector(A) ::= simple_selector_sequence(B).
  * will be not able to work with single values, which has itself as an
  * entry point, so generators can't generate the value from ancestor or
  * parent JSON node. Consequently, we work with parent links of *every*
- * incoming JSON value. */
+ * incoming JSON value. The combinators memoize the left-hand results
+ * per node, so each node is tested against them once per query run. */
 // Whitespace
 selector(A) ::= selector(B) COMBINATOR_ANCESTOR simple_selector_sequence(C).
 {
     A = (jquery_pair){ .root_query = C.root_query,
-                       .deepest_query = jquery_new(selector_ancestor, B.deepest_query,
-                                                   (query_context_destructor)jquery_free,
+                       .deepest_query = jquery_new(selector_ancestor, jquery_combinator_new(B.deepest_query),
+                                                   (query_context_destructor)jquery_combinator_free,
                                                    JQG_TYPE_SELF) };
     A.deepest_query->parent_query = C.deepest_query;
 }
@@ -119,8 +120,8 @@ selector(A) ::= selector(B) COMBINATOR_ANCESTOR simple_selector_sequence(C).
 selector(A) ::= selector(B) COMBINATOR_PARENT simple_selector_sequence(C).
 {
     A = (jquery_pair){ .root_query = C.root_query,
-                       .deepest_query = jquery_new(selector_parent, B.deepest_query,
-                                                   (query_context_destructor)jquery_free,
+                       .deepest_query = jquery_new(selector_parent, jquery_combinator_new(B.deepest_query),
+                                                   (query_context_destructor)jquery_combinator_free,
                                                    JQG_TYPE_SELF) };
     A.deepest_query->parent_query = C.deepest_query;
 }
@@ -128,8 +129,8 @@ selector(A) ::= selector(B) COMBINATOR_PARENT simple_selector_sequence(C).
 selector(A) ::= selector(B) COMBINATOR_SIBLINGS simple_selector_sequence(C).
 {
     A = (jquery_pair){ .root_query = C.root_query,
-                       .deepest_query = jquery_new(selector_sibling, B.deepest_query,
-                                                   (query_context_destructor)jquery_free,
+                       .deepest_query = jquery_new(selector_sibling, jquery_combinator_new(B.deepest_query),
+                                                   (query_context_destructor)jquery_combinator_free,
                                                    JQG_TYPE_SELF) };
     A.deepest_query->parent_query = C.deepest_query;
 }
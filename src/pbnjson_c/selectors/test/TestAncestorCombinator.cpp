@@ -145,4 +145,42 @@ TEST(Selectors, TestDeepAncestor)
 	jquery_free(query);
 }
 
+TEST(Selectors, TestSharedAncestor)
+{
+	jerror *err = NULL;
+
+	// The same array under different keys, numbers match through one of them only
+	jvalue_ref shared = jdom_create(j_cstr_to_buffer(R"([1, [2]])"), jschema_all(), &err);
+	jvalue_ref doc = jobject_create_var(jkeyval(J_CSTR_TO_JVAL("a"), shared),
+	                                    jkeyval(J_CSTR_TO_JVAL("b"), jvalue_copy(shared)),
+	                                    J_END_OBJ_DECL);
+
+	jquery_ptr query = jquery_create(".a number", &err);
+	ASSERT_TRUE(query);
+
+	// Memoized results don't leak into the next run
+	for (int run = 0; run < 2; ++run)
+	{
+		ASSERT_TRUE(jquery_init(query, doc, &err));
+		int counter = 0;
+		while (jis_valid(jquery_next(query)))
+			++counter;
+		ASSERT_EQ(2, counter);
+	}
+	jquery_free(query);
+
+	query = jquery_create(".a > array > number", &err);
+	ASSERT_TRUE(query);
+	ASSERT_TRUE(jquery_init(query, doc, &err));
+	jvalue_ref result = jquery_next(query);
+	ASSERT_TRUE(jis_number(result));
+	int32_t num = 0;
+	jnumber_get_i32(result, &num);
+	ASSERT_EQ(2, num);
+	ASSERT_FALSE(jis_valid(jquery_next(query)));
+	jquery_free(query);
+
+	j_release(&doc);
+}
+
 } //namespace
@@ -142,4 +142,39 @@ TEST(Selectors, TestKeySiblings)
 	jquery_free(query);
 }
 
+TEST(Selectors, TestSameValueSiblings)
+{
+	jerror *err = NULL;
+
+	// The same value in two positions, only one of them is the first child
+	jvalue_ref obj = jobject_create();
+	jvalue_ref arr = jarray_create_var(NULL, obj, jvalue_copy(obj), J_END_ARRAY_DECL);
+
+	jquery_ptr query = jquery_create(":first-child ~ object", &err);
+	ASSERT_TRUE(query);
+
+	// Memoized results don't leak into the next run
+	for (int run = 0; run < 2; ++run)
+	{
+		ASSERT_TRUE(jquery_init(query, arr, &err));
+		ASSERT_EQ(obj, jquery_next(query));
+		ASSERT_FALSE(jis_valid(jquery_next(query)));
+	}
+	jquery_free(query);
+
+	query = jquery_create("object ~ object", &err);
+	ASSERT_TRUE(query);
+	ASSERT_TRUE(jquery_init(query, arr, &err));
+	ASSERT_EQ(obj, jquery_next(query));
+	ASSERT_EQ(obj, jquery_next(query));
+	ASSERT_FALSE(jis_valid(jquery_next(query)));
+
+	jarray_set(arr, 0, jnumber_create_i32(1));
+	ASSERT_TRUE(jquery_init(query, arr, &err));
+	ASSERT_FALSE(jis_valid(jquery_next(query)));
+	jquery_free(query);
+
+	j_release(&arr);
+}
+
 } // namespace
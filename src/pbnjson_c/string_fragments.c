@@ -0,0 +1,326 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "string_fragments.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Escaped text is gathered into fragments of this size, longer runs without escapes are passed as they are
+#define FRAGMENT_BUFFER_SIZE (16 * 1024)
+
+enum {
+	ESCAPE_NONE = 0,
+	ESCAPE_BACKSLASH,
+	ESCAPE_HEX,              // Digits of \u
+	ESCAPE_PAIR,             // After a high surrogate, which may be followed by its pair
+	ESCAPE_PAIR_BACKSLASH,   // Backslash after a high surrogate
+};
+
+const char *string_fragments_scan(string_fragments *f, const char *p, const char *end)
+{
+	if (f->escaped && p < end)
+	{
+		f->escaped = false;
+		++p;
+	}
+	while (p < end)
+	{
+		if (*p == '"')
+			return p;
+		if (*p == '\\' && ++p == end)
+		{
+			f->escaped = true;
+			return NULL;
+		}
+		++p;
+	}
+	return NULL;
+}
+
+bool string_fragments_hold(string_fragments *f, const char *p, size_t len)
+{
+	if (f->held_capacity < f->held_len + len)
+	{
+		size_t capacity = f->held_capacity ? f->held_capacity : 256;
+		while (capacity < f->held_len + len)
+			capacity *= 2;
+		char *held = realloc(f->held, capacity);
+		if (!held)
+			return false;
+		f->held = held;
+		f->held_capacity = capacity;
+	}
+	memcpy(f->held + f->held_len, p, len);
+	f->held_len += len;
+	return true;
+}
+
+bool string_fragments_begin(string_fragments *f)
+{
+	if (!f->out)
+	{
+		f->out = malloc(FRAGMENT_BUFFER_SIZE);
+		if (!f->out)
+			return false;
+	}
+	f->out_len = 0;
+	f->escape = ESCAPE_NONE;
+	f->high = 0;
+	f->seq_len = 0;
+	return true;
+}
+
+// Add the text to the fragment
+static bool pass(string_fragments *f, const char *text, size_t len, string_fragments_emit emit, void *ctxt)
+{
+	if (f->out_len + len > FRAGMENT_BUFFER_SIZE)
+	{
+		if (f->out_len && !emit(ctxt, f->out, f->out_len, false))
+			return false;
+		f->out_len = 0;
+		if (len >= FRAGMENT_BUFFER_SIZE)
+			return emit(ctxt, text, len, false);
+	}
+	memcpy(f->out + f->out_len, text, len);
+	f->out_len += len;
+	return true;
+}
+
+static char simple_escape(char c)
+{
+	switch (c)
+	{
+	case '"': return '"';
+	case '\\': return '\\';
+	case '/': return '/';
+	case 'b': return '\b';
+	case 'f': return '\f';
+	case 'n': return '\n';
+	case 'r': return '\r';
+	case 't': return '\t';
+	default: return 0;
+	}
+}
+
+static int hex_digit(char c)
+{
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	return -1;
+}
+
+// The same encoding as the tokenizer's
+static size_t utf8_encode(unsigned code, char *buf)
+{
+	if (code < 0x80)
+	{
+		buf[0] = (char) code;
+		return 1;
+	}
+	if (code < 0x800)
+	{
+		buf[0] = (char) (0xC0 | code >> 6);
+		buf[1] = (char) (0x80 | (code & 0x3F));
+		return 2;
+	}
+	if (code < 0x10000)
+	{
+		buf[0] = (char) (0xE0 | code >> 12);
+		buf[1] = (char) (0x80 | (code >> 6 & 0x3F));
+		buf[2] = (char) (0x80 | (code & 0x3F));
+		return 3;
+	}
+	if (code < 0x200000)
+	{
+		buf[0] = (char) (0xF0 | code >> 18);
+		buf[1] = (char) (0x80 | (code >> 12 & 0x3F));
+		buf[2] = (char) (0x80 | (code >> 6 & 0x3F));
+		buf[3] = (char) (0x80 | (code & 0x3F));
+		return 4;
+	}
+	buf[0] = '?';
+	return 1;
+}
+
+string_fragments_result string_fragments_unescape(string_fragments *f, const char **input, const char *end,
+                                                  string_fragments_emit emit, void *ctxt)
+{
+	const char *p = *input;
+	string_fragments_result result = FRAGMENTS_MORE;
+
+	while (p < end && result == FRAGMENTS_MORE)
+	{
+		switch (f->escape)
+		{
+		case ESCAPE_NONE:
+		{
+			const char *run = p;
+			while (p < end && *p != '"' && *p != '\\' && (unsigned char) *p >= 0x20)
+				++p;
+
+			if (p < end && *p == '"' && f->out_len == 0)
+			{
+				// The string ends with the run, which is the last fragment as it is
+				result = emit(ctxt, run, p - run, true) ? FRAGMENTS_CLOSED : FRAGMENTS_CANCELED;
+				++p;
+				break;
+			}
+			if (p > run && !pass(f, run, p - run, emit, ctxt))
+			{
+				result = FRAGMENTS_CANCELED;
+				break;
+			}
+			if (p == end)
+				break;
+
+			if (*p == '"')
+			{
+				result = emit(ctxt, f->out, f->out_len, true) ? FRAGMENTS_CLOSED : FRAGMENTS_CANCELED;
+				f->out_len = 0;
+				++p;
+			}
+			else if (*p == '\\')
+			{
+				f->seq[0] = '\\';
+				f->seq_len = 1;
+				f->escape = ESCAPE_BACKSLASH;
+				++p;
+			}
+			else
+			{
+				// Control characters are to be escaped
+				f->seq[0] = *p;
+				f->seq_len = 1;
+				result = FRAGMENTS_INVALID;
+			}
+			break;
+		}
+		case ESCAPE_BACKSLASH:
+		{
+			f->seq[f->seq_len++] = *p;
+			if (*p == 'u')
+			{
+				f->escape = ESCAPE_HEX;
+				f->code = 0;
+				f->digits = 0;
+				++p;
+				break;
+			}
+
+			char c = simple_escape(*p);
+			if (!c)
+			{
+				result = FRAGMENTS_INVALID;
+				break;
+			}
+			f->escape = ESCAPE_NONE;
+			++p;
+			if (!pass(f, &c, 1, emit, ctxt))
+				result = FRAGMENTS_CANCELED;
+			break;
+		}
+		case ESCAPE_HEX:
+		{
+			int digit = hex_digit(*p);
+			f->seq[f->seq_len++] = *p;
+			if (digit < 0)
+			{
+				result = FRAGMENTS_INVALID;
+				break;
+			}
+			++p;
+			f->code = f->code << 4 | digit;
+			if (++f->digits < 4)
+				break;
+
+			unsigned code = f->code;
+			if (f->high)
+			{
+				// The pair is combined as the tokenizer does it
+				code = ((f->high & 0x3F) << 10) | ((((f->high >> 6) & 0xF) + 1) << 16) | (code & 0x3FF);
+				f->high = 0;
+			}
+			else if ((code & 0xFC00) == 0xD800)
+			{
+				f->high = code;
+				f->escape = ESCAPE_PAIR;
+				break;
+			}
+
+			char buf[4];
+			f->escape = ESCAPE_NONE;
+			if (!pass(f, buf, utf8_encode(code, buf), emit, ctxt))
+				result = FRAGMENTS_CANCELED;
+			break;
+		}
+		case ESCAPE_PAIR:
+			if (*p == '\\')
+			{
+				f->seq[0] = '\\';
+				f->seq_len = 1;
+				f->escape = ESCAPE_PAIR_BACKSLASH;
+				++p;
+				break;
+			}
+			// Unpaired surrogate
+			f->high = 0;
+			f->escape = ESCAPE_NONE;
+			if (!pass(f, "?", 1, emit, ctxt))
+				result = FRAGMENTS_CANCELED;
+			break;
+		case ESCAPE_PAIR_BACKSLASH:
+			if (*p == 'u')
+			{
+				f->seq[f->seq_len++] = 'u';
+				f->escape = ESCAPE_HEX;
+				f->code = 0;
+				f->digits = 0;
+				++p;
+				break;
+			}
+			// Unpaired surrogate, the backslash starts another escape
+			f->high = 0;
+			f->escape = ESCAPE_BACKSLASH;
+			if (!pass(f, "?", 1, emit, ctxt))
+				result = FRAGMENTS_CANCELED;
+			break;
+		}
+	}
+
+	*input = p;
+	return result;
+}
+
+size_t string_fragments_invalid(const string_fragments *f, char *text)
+{
+	text[0] = '"';
+	memcpy(text + 1, f->seq, f->seq_len);
+	return f->seq_len + 1;
+}
+
+void string_fragments_clear(string_fragments *f)
+{
+	free(f->held);
+	free(f->out);
+	f->held = NULL;
+	f->out = NULL;
+	f->held_len = f->held_capacity = 0;
+}
@@ -0,0 +1,115 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief Splitter of long string values into fragments
+ *
+ * The tokenizer keeps a string spanning chunks of the stream in its buffer, and
+ * unescapes it into one more buffer before the callback gets it. Long string values
+ * are taken out of the text instead: their content is unescaped here as it comes,
+ * and passed on in fragments, while the tokenizer gets an empty string in place.
+ *
+ * The splitter knows only the lexical structure of the text, the parser tells
+ * which strings are values. The state is kept between chunks of the stream.
+ */
+typedef enum {
+	FRAGMENTS_TOKEN = 0,   // Outside of strings
+	FRAGMENTS_STRING,      // Inside a string passed to the tokenizer
+	FRAGMENTS_HELD,        // Inside a string held till it turns out long or short
+	FRAGMENTS_VALUE,       // Inside a long string value, which is unescaped here
+} string_fragments_state;
+
+typedef enum {
+	FRAGMENTS_MORE,        // The text is consumed, the string goes on
+	FRAGMENTS_CLOSED,      // The string is closed, the text goes on after the quote
+	FRAGMENTS_INVALID,     // The string has an invalid byte, see string_fragments_invalid
+	FRAGMENTS_CANCELED,    // The callback has refused a fragment
+} string_fragments_result;
+
+typedef int (*string_fragments_emit)(void *ctxt, const char *fragment, size_t len, bool last);
+
+typedef struct {
+	string_fragments_state state;
+	size_t threshold;      // Raw length of the shortest string to split
+	bool escaped;          // The last byte scanned is a backslash
+	char *held;            // The opening quote and the beginning of the held string
+	size_t held_len;
+	size_t held_capacity;
+	int escape;            // Unescaping state
+	unsigned code;         // Code unit of the \u escape being read
+	int digits;
+	unsigned high;         // High surrogate waiting for its pair
+	char seq[8];           // Raw bytes of the escape being read
+	size_t seq_len;
+	char *out;             // Unescaped text not passed on yet
+	size_t out_len;
+} string_fragments;
+
+/**
+ * @brief Find the closing quote of the string
+ *
+ * @param f Splitter, its escaped flag tells if the text starts escaped.
+ * @param p Text inside the string.
+ * @param end End of the text.
+ * @return The closing quote, or NULL if the string goes on after the text.
+ */
+const char *string_fragments_scan(string_fragments *f, const char *p, const char *end);
+
+/**
+ * @brief Keep the beginning of the string till its length is known
+ *
+ * @return false if out of memory
+ */
+bool string_fragments_hold(string_fragments *f, const char *p, size_t len);
+
+/**
+ * @brief Start unescaping the string value after its opening quote
+ *
+ * @return false if out of memory
+ */
+bool string_fragments_begin(string_fragments *f);
+
+/**
+ * @brief Unescape the text of the string value, and pass it on in fragments
+ *
+ * The fragments are the text itself where it has no escapes, otherwise the text
+ * is unescaped into a buffer first. The last fragment comes at the closing quote.
+ *
+ * @param f Splitter.
+ * @param p Text of the string value, advanced past the consumed bytes. On
+ *          FRAGMENTS_INVALID it points to the invalid byte.
+ * @param end End of the text.
+ * @param emit Callback getting the fragments.
+ * @param ctxt Context of the callback.
+ */
+string_fragments_result string_fragments_unescape(string_fragments *f, const char **p, const char *end,
+                                                  string_fragments_emit emit, void *ctxt);
+
+/**
+ * @brief Text of the invalid string, for the tokenizer to report it
+ *
+ * @param f Splitter, which has returned FRAGMENTS_INVALID.
+ * @param text Buffer for the text, at least sizeof(f->seq) + 1 bytes.
+ * @return Length of the text: the opening quote, the escape read so far and the invalid byte.
+ */
+size_t string_fragments_invalid(const string_fragments *f, char *text);
+
+void string_fragments_clear(string_fragments *f);
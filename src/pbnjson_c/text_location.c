@@ -0,0 +1,108 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "text_location.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define BYTES(b) (UINT64_C(0x0101010101010101) * (uint8_t)(b))
+
+// Marks the high bit of every newline byte
+static inline uint64_t newlines(const char *p)
+{
+	uint64_t w;
+	memcpy(&w, p, sizeof(w));
+	w ^= BYTES('\n');
+	return ~(((w & BYTES(0x7f)) + BYTES(0x7f)) | w) & BYTES(0x80);
+}
+#endif
+
+// Count newlines from the cursor up to `to` bytes of the chunk
+static void count(text_location *l, size_t to)
+{
+	const char *p = l->text + l->counted;
+	const char *end = l->text + to;
+	const char *last = NULL;  // Last newline seen
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	for (; end - p >= 8; p += 8)
+	{
+		uint64_t mask = newlines(p);
+		if (mask)
+		{
+			l->line += __builtin_popcountll(mask);
+			last = p + ((63 - __builtin_clzll(mask)) >> 3);
+		}
+	}
+#endif
+	for (; p < end; ++p)
+	{
+		if (*p == '\n')
+		{
+			++l->line;
+			last = p;
+		}
+	}
+
+	if (last)
+		l->line_offset = l->offset + (last + 1 - l->text);
+	l->counted = to;
+}
+
+void text_location_begin(text_location *l, const char *text, size_t len)
+{
+	text_location_skip(l);
+	l->text = text;
+	l->text_len = len;
+	l->start_line = l->line;
+	l->start_line_offset = l->line_offset;
+}
+
+void text_location_skip(text_location *l)
+{
+	if (!l->text)
+		return;
+
+	count(l, l->text_len);
+	l->offset += l->text_len;
+	l->counted = 0;
+	l->text = NULL;
+	l->text_len = 0;
+}
+
+void text_location_get(text_location *l, size_t offset, jlocation *location)
+{
+	size_t to = offset - l->offset;
+	if (to > l->text_len)
+		to = l->text_len;
+
+	if (to < l->counted)
+	{
+		// Count the chunk again for an earlier offset
+		l->counted = 0;
+		l->line = l->start_line;
+		l->line_offset = l->start_line_offset;
+	}
+
+	if (l->text)
+		count(l, to);
+
+	location->offset = offset;
+	location->line = l->line + 1;
+	location->column = offset - l->line_offset + 1;
+}
@@ -0,0 +1,59 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <jerror.h>
+
+/**
+ * @brief Line accounting for the offsets in a parsed stream
+ *
+ * Lines aren't counted while parsing. The text of the current chunk is kept
+ * by reference, and newlines are counted only when a location in it is asked
+ * for, or before the chunk is let go. Locations asked for in the order of the
+ * text count every byte once.
+ */
+typedef struct {
+	const char *text;    // Current chunk, NULL if there is none
+	size_t text_len;
+	size_t offset;       // Stream offset of the chunk
+	size_t counted;      // Bytes of the chunk with newlines counted
+	size_t line;         // Newlines before the counted bytes
+	size_t line_offset;  // Stream offset of the line with the counted bytes end
+	size_t start_line;   // Line accounting at the beginning of the chunk
+	size_t start_line_offset;
+} text_location;
+
+/**
+ * @brief Start the next chunk of the stream
+ *
+ * The previous chunk is accounted for, if it wasn't yet.
+ */
+void text_location_begin(text_location *l, const char *text, size_t len);
+
+/**
+ * @brief Count the lines of the current chunk before the chunk is let go
+ */
+void text_location_skip(text_location *l);
+
+/**
+ * @brief Location of the stream offset
+ *
+ * @param offset Stream offset within the current chunk or right after it.
+ */
+void text_location_get(text_location *l, size_t offset, jlocation *location);
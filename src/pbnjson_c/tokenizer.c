@@ -0,0 +1,51 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "tokenizer.h"
+
+#include <glib.h>
+#include <string.h>
+
+static const tokenizer_backend *backends[] = {
+	&tokenizer_yajl,
+};
+
+static const tokenizer_backend *current_backend = &tokenizer_yajl;
+
+const tokenizer_backend *tokenizer_backend_current(void)
+{
+	return g_atomic_pointer_get(&current_backend);
+}
+
+const tokenizer_backend *tokenizer_backend_find(const char *name)
+{
+	for (size_t i = 0; i < G_N_ELEMENTS(backends); ++i)
+	{
+		if (strcmp(backends[i]->name, name) == 0)
+			return backends[i];
+	}
+	return NULL;
+}
+
+const tokenizer_backend *tokenizer_backend_at(size_t index)
+{
+	return index < G_N_ELEMENTS(backends) ? backends[index] : NULL;
+}
+
+void tokenizer_backend_select(const tokenizer_backend *backend)
+{
+	g_atomic_pointer_set(&current_backend, (gpointer)backend);
+}
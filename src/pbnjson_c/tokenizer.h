@@ -0,0 +1,124 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "parser_memory_pool.h"
+
+/**
+ * @brief Events of the tokenizer
+ *
+ * Every callback returns nonzero to continue parsing, or zero to stop it.
+ * The field names follow PJSAXCallbacks, which are cast to these.
+ */
+typedef int (*tokenizer_null)(void *ctxt);
+typedef int (*tokenizer_boolean)(void *ctxt, int value);
+typedef int (*tokenizer_number)(void *ctxt, const char *number, size_t len);
+typedef int (*tokenizer_string)(void *ctxt, const unsigned char *string, size_t len);
+typedef int (*tokenizer_context)(void *ctxt);
+
+typedef struct tokenizer_callbacks {
+	tokenizer_null m_null;
+	tokenizer_boolean m_boolean;
+	tokenizer_number m_number;
+	tokenizer_string m_string;
+	tokenizer_context m_objStart;
+	tokenizer_string m_objKey;
+	tokenizer_context m_objEnd;
+	tokenizer_context m_arrStart;
+	tokenizer_context m_arrEnd;
+} tokenizer_callbacks;
+
+typedef enum {
+	TOKENIZER_OK = 0,
+	TOKENIZER_CANCELED,      ///< A callback has stopped parsing
+	TOKENIZER_INCOMPLETE,    ///< The text has ended in the middle of the document
+	TOKENIZER_ERROR,         ///< The text isn't valid JSON
+} tokenizer_status;
+
+typedef struct tokenizer tokenizer;
+
+/**
+ * @brief Tokenizer implementation turning JSON text into the events
+ *
+ * The parser passes the text without runs of whitespace and comments, see
+ * trivia_filter. Comments are still to be accepted, as the filter leaves a
+ * slash which doesn't start a comment to the tokenizer.
+ */
+typedef struct tokenizer_backend {
+	const char *name;
+
+	/**
+	 * @brief Create the tokenizer
+	 *
+	 * @param callbacks Events to call, stay valid while the tokenizer lives.
+	 * @param ctxt Context to pass to the callbacks.
+	 * @param pool Memory pool of the parser, which may be used for the tokenizer.
+	 */
+	tokenizer *(*create)(const tokenizer_callbacks *callbacks, void *ctxt, mem_pool_t *pool);
+	void (*destroy)(tokenizer *t);
+
+	/**
+	 * @brief Parse the next chunk of the text
+	 *
+	 * Tokens may span chunks. TOKENIZER_INCOMPLETE isn't returned from here.
+	 */
+	tokenizer_status (*parse)(tokenizer *t, const char *text, size_t len);
+
+	/**
+	 * @brief Complete the text
+	 */
+	tokenizer_status (*finish)(tokenizer *t);
+
+	/**
+	 * @brief Bytes of the last chunk consumed
+	 *
+	 * Within the callbacks, the position right after the token of the event.
+	 * After an error, the position where parsing has stopped.
+	 */
+	size_t (*bytes_consumed)(tokenizer *t);
+
+	/**
+	 * @brief Error description, released with free_error
+	 *
+	 * @param text The last chunk passed to parse, to quote its context.
+	 */
+	char *(*get_error)(tokenizer *t, const char *text, size_t len);
+	void (*free_error)(tokenizer *t, char *error);
+} tokenizer_backend;
+
+/// Backend of the new parsers
+const tokenizer_backend *tokenizer_backend_current(void);
+
+/**
+ * @brief Find the backend by name
+ *
+ * @return NULL if there is no such backend
+ */
+const tokenizer_backend *tokenizer_backend_find(const char *name);
+
+/**
+ * @brief Backend by index, for enumeration
+ *
+ * @return NULL past the last backend
+ */
+const tokenizer_backend *tokenizer_backend_at(size_t index);
+
+void tokenizer_backend_select(const tokenizer_backend *backend);
+
+extern const tokenizer_backend tokenizer_yajl;
@@ -0,0 +1,215 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "tokenizer.h"
+
+#include <glib.h>
+#include <yajl/yajl_parse.h>
+#include "yajl_compat.h"
+
+struct tokenizer {
+	yajl_handle handle;
+	yajl_callbacks events;  // yajl keeps the pointer to them
+	mem_pool_t *pool;
+#if YAJL_VERSION < 20000
+	// yajl 1 passes lengths as unsigned int, its events are bounced
+	const tokenizer_callbacks *callbacks;
+	void *ctxt;
+#endif
+};
+
+#if YAJL_VERSION < 20000
+static inline struct tokenizer *events_of(void *ctxt)
+{
+	return (struct tokenizer *) ctxt;
+}
+
+static int on_null(void *ctxt)
+{
+	return events_of(ctxt)->callbacks->m_null(events_of(ctxt)->ctxt);
+}
+
+static int on_boolean(void *ctxt, int value)
+{
+	return events_of(ctxt)->callbacks->m_boolean(events_of(ctxt)->ctxt, value);
+}
+
+static int on_number(void *ctxt, const char *number, yajl_size_t len)
+{
+	return events_of(ctxt)->callbacks->m_number(events_of(ctxt)->ctxt, number, len);
+}
+
+static int on_string(void *ctxt, const unsigned char *string, yajl_size_t len)
+{
+	return events_of(ctxt)->callbacks->m_string(events_of(ctxt)->ctxt, string, len);
+}
+
+static int on_start_map(void *ctxt)
+{
+	return events_of(ctxt)->callbacks->m_objStart(events_of(ctxt)->ctxt);
+}
+
+static int on_map_key(void *ctxt, const unsigned char *key, yajl_size_t len)
+{
+	return events_of(ctxt)->callbacks->m_objKey(events_of(ctxt)->ctxt, key, len);
+}
+
+static int on_end_map(void *ctxt)
+{
+	return events_of(ctxt)->callbacks->m_objEnd(events_of(ctxt)->ctxt);
+}
+
+static int on_start_array(void *ctxt)
+{
+	return events_of(ctxt)->callbacks->m_arrStart(events_of(ctxt)->ctxt);
+}
+
+static int on_end_array(void *ctxt)
+{
+	return events_of(ctxt)->callbacks->m_arrEnd(events_of(ctxt)->ctxt);
+}
+
+static const yajl_callbacks bounce =
+{
+	.yajl_null        = on_null,
+	.yajl_boolean     = on_boolean,
+	.yajl_number      = on_number,
+	.yajl_string      = on_string,
+	.yajl_start_map   = on_start_map,
+	.yajl_map_key     = on_map_key,
+	.yajl_end_map     = on_end_map,
+	.yajl_start_array = on_start_array,
+	.yajl_end_array   = on_end_array,
+};
+#endif // YAJL_VERSION
+
+static tokenizer *yajl_create(const tokenizer_callbacks *callbacks, void *ctxt, mem_pool_t *pool)
+{
+	yajl_alloc_funcs allocFuncs = {
+		mempool_malloc,
+		mempool_realloc,
+		mempool_free,
+		pool
+	};
+	const bool allow_comments = true;
+
+	struct tokenizer *t = mempool_malloc(pool, sizeof(struct tokenizer));
+	t->pool = pool;
+
+#if YAJL_VERSION < 20000
+	yajl_parser_config yajl_opts =
+	{
+		allow_comments,
+		0, // currently only UTF-8 will be supported for input.
+	};
+
+	t->events = bounce;
+	t->callbacks = callbacks;
+	t->ctxt = ctxt;
+	t->handle = yajl_alloc(&t->events, &yajl_opts, &allocFuncs, t);
+#else
+	// The events have the same signatures as in yajl 2
+	yajl_callbacks events =
+	{
+		.yajl_null        = callbacks->m_null,
+		.yajl_boolean     = callbacks->m_boolean,
+		.yajl_number      = callbacks->m_number,
+		.yajl_string      = callbacks->m_string,
+		.yajl_start_map   = callbacks->m_objStart,
+		.yajl_map_key     = callbacks->m_objKey,
+		.yajl_end_map     = callbacks->m_objEnd,
+		.yajl_start_array = callbacks->m_arrStart,
+		.yajl_end_array   = callbacks->m_arrEnd,
+	};
+
+	t->events = events;
+	t->handle = yajl_alloc(&t->events, &allocFuncs, ctxt);
+	yajl_config(t->handle, yajl_allow_comments, allow_comments ? 1 : 0);
+
+	// currently only UTF-8 will be supported for input.
+	yajl_config(t->handle, yajl_dont_validate_strings, 1);
+#endif // YAJL_VERSION
+
+	return t;
+}
+
+static void yajl_destroy(tokenizer *t)
+{
+	yajl_free(t->handle);
+	mempool_free(t->pool, t);
+}
+
+static tokenizer_status status_of(yajl_status status)
+{
+	switch (status)
+	{
+	case yajl_status_ok:
+		return TOKENIZER_OK;
+	case yajl_status_client_canceled:
+		return TOKENIZER_CANCELED;
+#if YAJL_VERSION < 20000
+	case yajl_status_insufficient_data:
+		return TOKENIZER_INCOMPLETE;
+#endif
+	case yajl_status_error:
+	default:
+		return TOKENIZER_ERROR;
+	}
+}
+
+static tokenizer_status yajl_tokenizer_parse(tokenizer *t, const char *text, size_t len)
+{
+	tokenizer_status status = status_of(yajl_parse(t->handle, (const unsigned char *) text, len));
+
+	// yajl 1 reports a chunk ending inside the document, which isn't an error till the end
+	return status == TOKENIZER_INCOMPLETE ? TOKENIZER_OK : status;
+}
+
+static tokenizer_status yajl_tokenizer_finish(tokenizer *t)
+{
+#if YAJL_VERSION < 20000
+	return status_of(yajl_parse_complete(t->handle));
+#else
+	return status_of(yajl_complete_parse(t->handle));
+#endif
+}
+
+static size_t yajl_tokenizer_bytes_consumed(tokenizer *t)
+{
+	return yajl_get_bytes_consumed(t->handle);
+}
+
+static char *yajl_tokenizer_get_error(tokenizer *t, const char *text, size_t len)
+{
+	return (char *) yajl_get_error(t->handle, 1, (const unsigned char *) text, len);
+}
+
+static void yajl_tokenizer_free_error(tokenizer *t, char *error)
+{
+	yajl_free_error(t->handle, (unsigned char *) error);
+}
+
+const tokenizer_backend tokenizer_yajl =
+{
+	.name = "yajl",
+	.create = yajl_create,
+	.destroy = yajl_destroy,
+	.parse = yajl_tokenizer_parse,
+	.finish = yajl_tokenizer_finish,
+	.bytes_consumed = yajl_tokenizer_bytes_consumed,
+	.get_error = yajl_tokenizer_get_error,
+	.free_error = yajl_tokenizer_free_error,
+};
@@ -0,0 +1,362 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "trivia_filter.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Bigger inputs are filtered piece by piece, to bound the scratch buffer
+#define TRIVIA_PIECE_SIZE (64 * 1024)
+
+enum {
+	TRIVIA_TOKEN = 0,      // Outside of strings and runs
+	TRIVIA_STRING,
+	TRIVIA_STRING_ESCAPE,
+	TRIVIA_RUN,            // Inside a run, its separator is already passed
+	TRIVIA_SLASH,          // '/' after a token, which may open a comment
+	TRIVIA_RUN_SLASH,      // '/' inside a run
+	TRIVIA_LINE_COMMENT,
+	TRIVIA_BLOCK_COMMENT,
+	TRIVIA_BLOCK_STAR,     // '*' which may close a block comment
+};
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+// Scan eight bytes at a time, the lowest matching byte is the first in memory
+#define TRIVIA_SWAR 1
+
+#define BYTES(b) (UINT64_C(0x0101010101010101) * (uint8_t)(b))
+
+static inline uint64_t load_word(const char *p)
+{
+	uint64_t w;
+	memcpy(&w, p, sizeof(w));
+	return w;
+}
+
+// Marks the high bit of bytes less than n (n <= 0x80). Only the lowest mark is
+// exact, the borrow may spoil the marks above it.
+static inline uint64_t bytes_less(uint64_t w, uint8_t n)
+{
+	return (w - BYTES(n)) & ~w & BYTES(0x80);
+}
+
+static inline uint64_t bytes_equal(uint64_t w, uint8_t c)
+{
+	return bytes_less(w ^ BYTES(c), 1);
+}
+
+static inline const char *first_marked(const char *p, uint64_t mask)
+{
+	return p + (__builtin_ctzll(mask) >> 3);
+}
+#endif
+
+static inline bool is_space(char c)
+{
+	return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+// Next byte which may open a string, a run or a comment
+static const char *find_token_end(const char *p, const char *end)
+{
+#ifdef TRIVIA_SWAR
+	for (; end - p >= 8; p += 8)
+	{
+		uint64_t w = load_word(p);
+		uint64_t mask = bytes_less(w, 0x21) | bytes_equal(w, '"') | bytes_equal(w, '/');
+		if (mask)
+			return first_marked(p, mask);
+	}
+#endif
+	while (p < end && (unsigned char) *p > 0x20 && *p != '"' && *p != '/')
+		++p;
+	return p;
+}
+
+static const char *find_string_end(const char *p, const char *end)
+{
+#ifdef TRIVIA_SWAR
+	for (; end - p >= 8; p += 8)
+	{
+		uint64_t w = load_word(p);
+		uint64_t mask = bytes_equal(w, '"') | bytes_equal(w, '\\');
+		if (mask)
+			return first_marked(p, mask);
+	}
+#endif
+	while (p < end && *p != '"' && *p != '\\')
+		++p;
+	return p;
+}
+
+static const char *skip_space(const char *p, const char *end)
+{
+	for (;;)
+	{
+#ifdef TRIVIA_SWAR
+		// Indentation is mostly spaces
+		while (end - p >= 8 && load_word(p) == BYTES(' '))
+			p += 8;
+#endif
+		if (p == end || !is_space(*p))
+			return p;
+		++p;
+	}
+}
+
+typedef struct {
+	trivia_filter *f;
+	const char *begin;  // Beginning of the piece
+	const char *kept;   // Input not copied to the scratch yet
+	size_t len;         // Length of the text in the scratch
+	size_t capacity;    // Scratch size the piece may need
+	bool copying;
+	uint32_t *map;      // Input offsets of the output bytes, if asked for
+} output;
+
+// Leave out the input from p to `to`
+static void drop(output *o, const char *p, const char *to)
+{
+	if (!o->copying)
+	{
+		trivia_filter *f = o->f;
+		if (f->capacity < o->capacity)
+		{
+			free(f->scratch);
+			f->scratch = malloc(o->capacity);
+			f->capacity = o->capacity;
+		}
+		o->copying = true;
+	}
+	memcpy(o->f->scratch + o->len, o->kept, p - o->kept);
+	if (o->map)
+	{
+		for (size_t i = 0; i < (size_t) (p - o->kept); ++i)
+			o->map[o->len + i] = o->kept - o->begin + i;
+	}
+	o->len += p - o->kept;
+	o->kept = to;
+}
+
+// Insert the character before p
+static void put(output *o, const char *p, char c)
+{
+	drop(o, p, p);
+	// The character stands for the slash before p
+	if (o->map)
+		o->map[o->len] = p > o->begin ? p - 1 - o->begin : 0;
+	o->f->scratch[o->len++] = c;
+}
+
+static const char *filter(trivia_filter *f, const char **input, const char *end, size_t *len, uint32_t *map)
+{
+	const char *p = *input;
+	if (end - p > TRIVIA_PIECE_SIZE)
+		end = p + TRIVIA_PIECE_SIZE;
+
+	// A pending slash may add a byte to the input
+	output o = { f, p, p, 0, end - p + 1, false, map };
+	while (p < end)
+	{
+		switch (f->state)
+		{
+		case TRIVIA_TOKEN:
+			p = find_token_end(p, end);
+			if (p == end)
+				break;
+			if (*p == '"')
+			{
+				f->state = TRIVIA_STRING;
+				++p;
+			}
+			else if (is_space(*p))
+			{
+				f->state = TRIVIA_RUN;  // The byte is the separator
+				++p;
+				break;
+			}
+			else if (*p == '/')
+			{
+				drop(&o, p, p + 1);
+				f->state = TRIVIA_SLASH;
+				++p;
+				break;
+			}
+			else
+			{
+				++p;
+				break;
+			}
+			// Fall through, minified text is mostly strings
+
+		case TRIVIA_STRING:
+			for (;;)
+			{
+				p = find_string_end(p, end);
+				if (p == end)
+					break;
+				if (*p == '"')
+				{
+					f->state = TRIVIA_TOKEN;
+					++p;
+					break;
+				}
+				if (end - p < 2)
+				{
+					f->state = TRIVIA_STRING_ESCAPE;
+					++p;
+					break;
+				}
+				p += 2;
+			}
+			break;
+
+		case TRIVIA_STRING_ESCAPE:
+			f->state = TRIVIA_STRING;
+			++p;
+			break;
+
+		case TRIVIA_RUN:
+		{
+			const char *q = skip_space(p, end);
+			if (q != p)
+			{
+				drop(&o, p, q);
+				p = q;
+			}
+			if (p == end)
+				break;
+			if (*p == '/')
+			{
+				drop(&o, p, p + 1);
+				f->state = TRIVIA_RUN_SLASH;
+				++p;
+			}
+			else
+				f->state = TRIVIA_TOKEN;
+			break;
+		}
+
+		case TRIVIA_SLASH:
+		case TRIVIA_RUN_SLASH:
+			if (*p == '/' || *p == '*')
+			{
+				if (f->state == TRIVIA_SLASH)
+					put(&o, p, ' ');
+				drop(&o, p, p + 1);
+				f->state = *p == '/' ? TRIVIA_LINE_COMMENT : TRIVIA_BLOCK_COMMENT;
+				++p;
+			}
+			else
+			{
+				// Not a comment, leave the slash to the tokenizer
+				put(&o, p, '/');
+				f->state = TRIVIA_TOKEN;
+			}
+			break;
+
+		case TRIVIA_LINE_COMMENT:
+		{
+			const char *nl = memchr(p, '\n', end - p);
+			const char *q = nl ? nl + 1 : end;
+			drop(&o, p, q);
+			p = q;
+			if (nl)
+				f->state = TRIVIA_RUN;
+			break;
+		}
+
+		case TRIVIA_BLOCK_COMMENT:
+		{
+			const char *star = memchr(p, '*', end - p);
+			const char *q = star ? star + 1 : end;
+			drop(&o, p, q);
+			p = q;
+			if (star)
+				f->state = TRIVIA_BLOCK_STAR;
+			break;
+		}
+
+		case TRIVIA_BLOCK_STAR:
+			if (*p == '/')
+				f->state = TRIVIA_RUN;
+			else if (*p != '*')
+			{
+				f->state = TRIVIA_BLOCK_COMMENT;
+				break;
+			}
+			drop(&o, p, p + 1);
+			++p;
+			break;
+		}
+	}
+
+	*input = p;
+	if (!o.copying)
+	{
+		*len = p - o.begin;
+		if (map)
+		{
+			for (size_t i = 0; i < *len; ++i)
+				map[i] = i;
+		}
+		return o.begin;
+	}
+
+	drop(&o, p, p);
+	*len = o.len;
+	return f->scratch;
+}
+
+const char *trivia_filter_next(trivia_filter *f, const char **input, const char *end, size_t *len)
+{
+	return filter(f, input, end, len, NULL);
+}
+
+size_t trivia_filter_map(int state, const char *input, size_t len, uint32_t *map)
+{
+	trivia_filter f = { state, NULL, 0 };
+	size_t filtered_len;
+	filter(&f, &input, input + len, &filtered_len, map);
+	trivia_filter_clear(&f);
+	return filtered_len;
+}
+
+const char *trivia_filter_finish(trivia_filter *f)
+{
+	switch (f->state)
+	{
+	case TRIVIA_SLASH:
+	case TRIVIA_RUN_SLASH:
+		return "/";
+	case TRIVIA_LINE_COMMENT:
+		return "//";
+	case TRIVIA_BLOCK_COMMENT:
+	case TRIVIA_BLOCK_STAR:
+		return "/*";
+	default:
+		return "";
+	}
+}
+
+void trivia_filter_clear(trivia_filter *f)
+{
+	free(f->scratch);
+	f->scratch = NULL;
+	f->capacity = 0;
+}
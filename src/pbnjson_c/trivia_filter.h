@@ -0,0 +1,76 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Filter collapsing runs of whitespace and comments for the tokenizer
+ *
+ * Indentation and comments are consumed by the tokenizer one byte at a time.
+ * The filter skips them word by word instead, and passes every run between
+ * tokens as a single whitespace byte, which separates the tokens the same way.
+ * Input without such runs is passed through without copying.
+ *
+ * The filter state is kept between chunks, so a run or a string may span
+ * chunks of the stream.
+ */
+typedef struct {
+	int state;
+	char *scratch;
+	size_t capacity;
+} trivia_filter;
+
+/**
+ * @brief Filter the next piece of the input
+ *
+ * @param f Filter state. Zero-filled state starts at the beginning of a document.
+ * @param input Input to filter, advanced past the consumed bytes.
+ * @param end End of the input.
+ * @param len Length of the filtered piece.
+ * @return Filtered piece, which is either a part of the input or the text in the
+ *         filter scratch buffer valid till the next call.
+ */
+const char *trivia_filter_next(trivia_filter *f, const char **input, const char *end, size_t *len);
+
+/**
+ * @brief Map a filtered piece back to the input
+ *
+ * Filters the piece again, and records the input offset of every byte of the
+ * filtered text. The separator of a run maps to the beginning of the run.
+ *
+ * @param state Filter state before the piece.
+ * @param input Input of the piece, as consumed by trivia_filter_next.
+ * @param len Length of the input of the piece.
+ * @param map Offsets of the filtered bytes, room for len + 1 of them.
+ * @return Length of the filtered piece.
+ */
+size_t trivia_filter_map(int state, const char *input, size_t len, uint32_t *map);
+
+/**
+ * @brief Text to complete the document with
+ *
+ * A comment or a slash unterminated at the end of the input is passed as its
+ * opening, so that the tokenizer can report it.
+ *
+ * @return Text to feed the tokenizer, which may be empty.
+ */
+const char *trivia_filter_finish(trivia_filter *f);
+
+void trivia_filter_clear(trivia_filter *f);
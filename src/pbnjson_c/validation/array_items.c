@@ -30,7 +30,8 @@ static void _release(Feature *f)
 	ArrayItems *a = (ArrayItems *) f;
 	if (a->generic_validator)
 		validator_unref(a->generic_validator);
-	g_list_free_full(a->validators, _validator_release);
+	if (a->validators)
+		g_ptr_array_free(a->validators, TRUE);
 	g_free(a);
 }
 
@@ -66,8 +67,7 @@ void array_items_unref(ArrayItems *a)
 void array_items_set_generic_item(ArrayItems *a, Validator *v)
 {
 	// clean up old items before setting general one
-	g_list_free_full(a->validators, _validator_release);
-	a->validators = NULL;
+	array_items_set_zero_items(a);
 	if (a->generic_validator)
 		validator_unref(a->generic_validator);
 
@@ -79,13 +79,15 @@ void array_items_add_item(ArrayItems *a, Validator *v)
 	if (a->generic_validator)
 		validator_unref(a->generic_validator), a->generic_validator = NULL;
 
-	a->validators = g_list_append(a->validators, v);
+	if (!a->validators)
+		a->validators = g_ptr_array_new_with_free_func(_validator_release);
+	g_ptr_array_add(a->validators, v);
 	++a->validator_count;
 }
 
 size_t array_items_items_length(ArrayItems *a)
 {
-	assert(a->validator_count == g_list_length(a->validators));
+	assert(a->validator_count == (a->validators ? a->validators->len : 0));
 	return a->validator_count;
 }
 
@@ -94,7 +96,8 @@ void array_items_set_zero_items(ArrayItems *a)
 	if (a->generic_validator)
 		validator_unref(a->generic_validator), a->generic_validator = NULL;
 
-	g_list_free_full(a->validators, _validator_release);
+	if (a->validators)
+		g_ptr_array_free(a->validators, TRUE);
 	a->validators = NULL;
 	a->validator_count = 0;
 }
@@ -116,10 +119,9 @@ void array_items_visit(ArrayItems *a,
 		}
 	}
 
-	GList *it = a->validators;
-	while (it)
+	for (size_t i = 0; i < a->validator_count; ++i)
 	{
-		Validator *v = (Validator *) it->data;
+		Validator *v = array_items_get_item(a, i);
 		enter_func(NULL, v, ctxt);
 		validator_visit(v, enter_func, exit_func, ctxt);
 		Validator *new_v = NULL;
@@ -127,26 +129,19 @@ void array_items_visit(ArrayItems *a,
 		if (new_v)
 		{
 			validator_unref(v);
-			it->data = new_v;
+			g_ptr_array_index(a->validators, i) = new_v;
 		}
-		it = g_list_next(it);
 	}
 }
 
-static bool validator_lists_equals(GList *vals, GList *vals2)
+static bool validator_items_equals(ArrayItems *a, ArrayItems *other)
 {
-	if (vals == vals2)
-		return true;
-
-	while (vals && vals2)
+	for (size_t i = 0; i < a->validator_count; ++i)
 	{
-		if (!validator_equals(vals->data, vals2->data))
+		if (!validator_equals(array_items_get_item(a, i), array_items_get_item(other, i)))
 			return false;
-		vals = g_list_next(vals);
-		vals2 = g_list_next(vals2);
 	}
-
-	return !vals && !vals2;
+	return true;
 }
 
 bool array_items_equals(ArrayItems *a, ArrayItems *other)
@@ -158,7 +153,7 @@ bool array_items_equals(ArrayItems *a, ArrayItems *other)
 
 	if (a->validator_count == other->validator_count &&
 	    validator_equals(a->generic_validator, other->generic_validator) &&
-	    validator_lists_equals(a->validators, other->validators))
+	    validator_items_equals(a, other))
 		return true;
 
 	return false;
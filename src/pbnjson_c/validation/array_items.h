@@ -33,7 +33,7 @@ typedef struct _ArrayItems
 {
 	Feature base;                  /**< @brief Base class */
 	Validator *generic_validator;  /**< @brief Validator for {"items": {...}} */
-	GList *validators;             /**< @brief Validators for specified elements {"items": [...]} */
+	GPtrArray *validators;         /**< @brief Validators for specified elements {"items": [...]}, indexed by position */
 	size_t validator_count;        /**< @brief Count of specified array elements */
 } ArrayItems;
 
@@ -59,6 +59,12 @@ void array_items_add_item(ArrayItems *a, Validator *v);
 /** @brief Access the count of specified items. */
 size_t array_items_items_length(ArrayItems *a);
 
+/** @brief Get the validator for the specified item, NULL if there's no such item. */
+static inline Validator *array_items_get_item(ArrayItems const *a, size_t index)
+{
+	return index < a->validator_count ? (Validator *) g_ptr_array_index(a->validators, index) : NULL;
+}
+
 /** @brief Visit contained validators. */
 void array_items_visit(ArrayItems *a,
                        VisitorEnterFunc enter_func, VisitorExitFunc exit_func,
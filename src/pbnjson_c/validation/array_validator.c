@@ -30,7 +30,6 @@ typedef struct _MyContext
 {
 	bool has_started;     // Has an array been opened with "["?
 	size_t items_count;
-	GList *cur_validator; // pointer to current validator
 } MyContext;
 
 static Validator* _get_current_validator(ArrayValidator *varr, MyContext *ctxt)
@@ -42,14 +41,11 @@ static Validator* _get_current_validator(ArrayValidator *varr, MyContext *ctxt)
 	if (items->generic_validator)
 		return items->generic_validator;
 
-	GList *cur = ctxt->cur_validator;
-	if (!cur)
+	// items_count is already incremented for the current item
+	if (ctxt->items_count > items->validator_count)
 		return varr->additional_items;
 
-	Validator *v = cur->data;
-	ctxt->cur_validator = g_list_next(cur);
-
-	return v;
+	return array_items_get_item(items, ctxt->items_count - 1);
 }
 
 static bool check(Validator *v, ValidationEvent const *e, ValidationState *s, void *c)
@@ -65,7 +61,6 @@ static bool check(Validator *v, ValidationEvent const *e, ValidationState *s, vo
 			return false;
 		}
 		my_ctxt->has_started = true;
-		my_ctxt->cur_validator = varr->items ? varr->items->validators : NULL;
 		return true;
 	}
 
@@ -99,7 +94,9 @@ static bool check(Validator *v, ValidationEvent const *e, ValidationState *s, vo
 	Validator* vcur = _get_current_validator(varr, my_ctxt);
 	if (vcur)
 	{
-		validation_state_push_validator(s, vcur);
+		// The item may be already known to be valid, then its events are skipped
+		if (!validation_state_push_value_validator(s, vcur, c))
+			return true;
 		bool valid = validation_check(e, s, c);
 		if (!valid)
 			validation_state_pop_validator(s);
@@ -315,6 +312,49 @@ static bool equals(Validator *v, Validator *other)
 	return false;
 }
 
+static ValidatorVtable generic_array_vtable;
+ValidatorVtable array_vtable;
+
+static int merge_max_count(int max1, int max2)
+{
+	if (max1 == EMPTY_LENGTH)
+		return max2;
+	if (max2 == EMPTY_LENGTH)
+		return max1;
+	return MIN(max1, max2);
+}
+
+static Validator* merge(Validator *v, Validator *other)
+{
+	if (other->vtable != &array_vtable &&
+	    other->vtable != &generic_array_vtable)
+	{
+		return NULL;
+	}
+
+	ArrayValidator *a1 = v->vtable == &array_vtable ? (ArrayValidator *) v : NULL;
+	ArrayValidator *a2 = other->vtable == &array_vtable ? (ArrayValidator *) other : NULL;
+
+	if (!a1 || !a2)
+		return validator_ref(a1 ? v : other);
+
+	// Items of both arrays would have to be intersected one by one
+	if (a1->items && a2->items)
+		return NULL;
+
+	ArrayValidator *a = array_validator_new();
+	ArrayValidator *with_items = a1->items ? a1 : a2;
+	if (with_items->items)
+	{
+		set_items(&a->base, with_items->items);
+		set_additional_items(&a->base, with_items->additional_items);
+	}
+	a->min_items = MAX(a1->min_items, a2->min_items);
+	a->max_items = merge_max_count(a1->max_items, a2->max_items);
+	a->unique_items = a1->unique_items || a2->unique_items;
+	return &a->base;
+}
+
 static ValidatorVtable generic_array_vtable =
 {
 	.check = check_generic,
@@ -326,6 +366,7 @@ static ValidatorVtable generic_array_vtable =
 	.set_array_min_items = set_min_items_generic,
 	.set_array_unique_items = set_unique_items_generic,
 	.set_default = set_default_generic,
+	.merge = merge,
 	.dump_enter = dump_enter,
 	.dump_exit = dump_exit,
 };
@@ -346,6 +387,7 @@ ValidatorVtable array_vtable =
 	.set_array_unique_items = set_unique_items,
 	.set_default = set_default,
 	.get_default = get_default,
+	.merge = merge,
 	.dump_enter = dump_enter,
 	.dump_exit = dump_exit,
 };
@@ -281,6 +281,14 @@ static bool init_state_suppress_errors(Validator *v, ValidationState *s)
 	return true;
 }
 
+static bool init_state(Validator *v, ValidationState *s)
+{
+	CombinedValidator *vcomb = (CombinedValidator *) v;
+	if (vcomb->collect_errors)
+		return init_state_collect_errors(v, s);
+	return init_state_suppress_errors(v, s);
+}
+
 static void cleanup_state(Validator *v, ValidationState *s)
 {
 	MyContext *c = validation_state_pop_context(s);
@@ -358,7 +366,7 @@ static void _dump_exit(char const *key, Validator *v, void *ctxt, Validator **ne
 ValidatorVtable combined_vtable =
 {
 	.check = _check,
-	.init_state = init_state_suppress_errors,
+	.init_state = init_state,
 	.cleanup_state = cleanup_state,
 	.ref = ref,
 	.unref = unref,
@@ -453,12 +461,30 @@ void combined_validator_convert_to_enum(CombinedValidator *v)
 
 void combined_validator_collect_errors(CombinedValidator *v)
 {
-	v->base.vtable->init_state = init_state_collect_errors;
+	v->collect_errors = true;
 }
 
 void combined_validator_suppress_errors(CombinedValidator *v)
 {
-	v->base.vtable->init_state = init_state_suppress_errors;
+	v->collect_errors = false;
+}
+
+bool combined_validator_is_all_of(Validator *v)
+{
+	return v->vtable == &combined_vtable &&
+	       ((CombinedValidator *) v)->check_all == _all_of_check;
+}
+
+bool combined_validator_is_any_of(Validator *v)
+{
+	return v->vtable == &combined_vtable &&
+	       ((CombinedValidator *) v)->check_all == any_of_check;
+}
+
+bool combined_validator_is_not(Validator *v)
+{
+	return v->vtable == &combined_vtable &&
+	       ((CombinedValidator *) v)->check_all == not_check;
 }
 
 
@@ -44,6 +44,9 @@ typedef struct _CombinedValidator
 	 */
 	bool (*check_all)(ValidationEvent const *e, ValidationState *s, void *ctxt, bool *all_finished);
 
+	/** @brief Should inner errors be notified instead of the error of the combinator? */
+	bool collect_errors;
+
 } CombinedValidator;
 
 //_Static_assert(offsetof(ArrayValidator, base) == 0, "");
@@ -107,6 +110,15 @@ void combined_validator_collect_errors(CombinedValidator *v);
  */
 void combined_validator_suppress_errors(CombinedValidator *v);
 
+/** @brief Check if the validator is {"allOf": [...]} */
+bool combined_validator_is_all_of(Validator *v);
+
+/** @brief Check if the validator is {"anyOf": [...]} */
+bool combined_validator_is_any_of(Validator *v);
+
+/** @brief Check if the validator is {"not": ...} */
+bool combined_validator_is_not(Validator *v);
+
 #ifdef __cplusplus
 }
 #endif
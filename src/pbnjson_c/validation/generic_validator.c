@@ -126,6 +126,12 @@ static void dump_enter(char const *key, Validator *v, void *ctxt)
 	fprintf((FILE *) ctxt, "(*)");
 }
 
+// Generic validator accepts everything, the intersection is the other one.
+static Validator* merge(Validator *v, Validator *other)
+{
+	return validator_ref(other);
+}
+
 static ValidatorVtable generic_vtable =
 {
 	.ref = ref,
@@ -135,6 +141,7 @@ static ValidatorVtable generic_vtable =
 	.cleanup_state = cleanup_state,
 	.set_default = set_default,
 	.get_default = get_default,
+	.merge = merge,
 	.dump_enter = dump_enter,
 };
 
@@ -144,6 +151,7 @@ static ValidatorVtable generic_static_vtable =
 	.init_state = init_state,
 	.cleanup_state = cleanup_state,
 	.set_default = set_default_generic,
+	.merge = merge,
 	.dump_enter = dump_enter,
 };
 
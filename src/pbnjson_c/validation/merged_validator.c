@@ -0,0 +1,182 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "merged_validator.h"
+#include "validation_state.h"
+#include "validation_api.h"
+#include <jobject.h>
+#include <glib.h>
+#include <stdio.h>
+
+// Notification, which substitutes inner errors with the error of the combinator
+typedef struct _MyContext
+{
+	Notification notify;
+	Notification *parent;
+	ValidationErrorCode error;
+	bool reported;
+} MyContext;
+
+static void _on_error(ValidationState *s, ValidationErrorCode error, void *ctxt)
+{
+	MyContext *my_ctxt = (MyContext *) s->notify;
+
+	// The combinator reports its error once
+	if (my_ctxt->reported)
+		return;
+	my_ctxt->reported = true;
+
+	// Let outer merged validators find their context too
+	s->notify = my_ctxt->parent;
+	validation_state_notify_error(s, my_ctxt->error, ctxt);
+	s->notify = &my_ctxt->notify;
+}
+
+static bool _init_state(Validator *v, ValidationState *s)
+{
+	MergedValidator *m = (MergedValidator *) v;
+
+	MyContext *my_ctxt = NULL;
+	if (m->error != VEC_OK && s->notify)
+	{
+		my_ctxt = g_slice_new0(MyContext);
+		my_ctxt->notify.error_func = _on_error;
+		my_ctxt->notify.default_property_func = s->notify->default_property_func;
+		my_ctxt->notify.has_array_duplicates = s->notify->has_array_duplicates;
+		my_ctxt->notify.skip_value_func = s->notify->skip_value_func;
+		my_ctxt->parent = s->notify;
+		my_ctxt->error = m->error;
+		s->notify = &my_ctxt->notify;
+	}
+	validation_state_push_context(s, my_ctxt);
+
+	validation_state_push_validator(s, m->validator);
+	return true;
+}
+
+static void _cleanup_state(Validator *v, ValidationState *s)
+{
+	MyContext *my_ctxt = validation_state_pop_context(s);
+	if (my_ctxt)
+	{
+		s->notify = my_ctxt->parent;
+		g_slice_free(MyContext, my_ctxt);
+	}
+}
+
+static void _reactivate(Validator *v, ValidationState *s)
+{
+	// The merged validator has finished
+	validation_state_pop_validator(s);
+}
+
+static bool _check(Validator *v, ValidationEvent const *e, ValidationState *s, void *ctxt)
+{
+	// Containers may call the validator directly after pushing it,
+	// pass the event to the merged validator at the head of the stack.
+	if (validation_state_get_validator(s) == v)
+		return false;
+	return validation_check(e, s, ctxt);
+}
+
+static Validator* ref(Validator *validator)
+{
+	MergedValidator *m = (MergedValidator *) validator;
+	++m->ref_count;
+	return validator;
+}
+
+static void unref(Validator *validator)
+{
+	MergedValidator *m = (MergedValidator *) validator;
+	if (--m->ref_count)
+		return;
+	validator_unref(m->validator);
+	j_release(&m->def_value);
+	g_free(m);
+}
+
+static Validator* set_default(Validator *validator, jvalue_ref def_value)
+{
+	MergedValidator *m = (MergedValidator *) validator;
+	j_release(&m->def_value);
+	m->def_value = jvalue_copy(def_value);
+	return validator;
+}
+
+static jvalue_ref get_default(Validator *validator, ValidationState *s)
+{
+	MergedValidator *m = (MergedValidator *) validator;
+	return m->def_value;
+}
+
+static void _visit(Validator *v,
+                   VisitorEnterFunc enter_func, VisitorExitFunc exit_func,
+                   void *ctxt)
+{
+	MergedValidator *m = (MergedValidator *) v;
+	enter_func(NULL, m->validator, ctxt);
+	validator_visit(m->validator, enter_func, exit_func, ctxt);
+	Validator *new_v = NULL;
+	exit_func(NULL, m->validator, ctxt, &new_v);
+	if (new_v)
+	{
+		validator_unref(m->validator);
+		m->validator = new_v;
+	}
+}
+
+static void _dump_enter(char const *key, Validator *v, void *ctxt)
+{
+	if (key)
+		fprintf((FILE *) ctxt, "%s:", key);
+	fprintf((FILE *) ctxt, "<=");
+}
+
+static void _dump_exit(char const *key, Validator *v, void *ctxt, Validator **new_v)
+{
+	fprintf((FILE *) ctxt, ">");
+}
+
+static ValidatorVtable merged_vtable =
+{
+	.check = _check,
+	.init_state = _init_state,
+	.cleanup_state = _cleanup_state,
+	.reactivate = _reactivate,
+	.ref = ref,
+	.unref = unref,
+	.visit = _visit,
+	.set_default = set_default,
+	.get_default = get_default,
+	.dump_enter = _dump_enter,
+	.dump_exit = _dump_exit,
+};
+
+MergedValidator* merged_validator_new(Validator *v, ValidationErrorCode error)
+{
+	MergedValidator *self = g_new0(MergedValidator, 1);
+	self->ref_count = 1;
+	self->validator = v;
+	self->error = error;
+	validator_init(&self->base, &merged_vtable);
+	return self;
+}
+
+bool merged_validator_is_instance(Validator *v)
+{
+	return v->vtable == &merged_vtable;
+}
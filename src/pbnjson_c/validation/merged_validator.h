@@ -0,0 +1,57 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include "validator.h"
+#include "error_code.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Result of compile-time flattening of {"allOf": [...]}
+ *
+ * When branches of "allOf" (or "extends") are merged into a single validator,
+ * this one takes place of the combinator. It runs the merged validator in the
+ * same validation state, and keeps the observable behaviour of the replaced
+ * combinator: its default value and the error code it would report.
+ */
+typedef struct _MergedValidator
+{
+	Validator base;            /**< @brief Base class */
+	unsigned ref_count;        /**< @brief Reference count */
+	jvalue_ref def_value;      /**< @brief Default value attached to this validator */
+
+	Validator *validator;      /**< @brief Merged validator, which does the actual work */
+
+	/** @brief Error reported instead of inner errors, VEC_OK to report them as is */
+	ValidationErrorCode error;
+} MergedValidator;
+
+/** @brief Constructor.
+ *
+ * @param[in] v Merged validator (moved)
+ * @param[in] error Error code to report instead of errors of the merged validator
+ */
+MergedValidator* merged_validator_new(Validator *v, ValidationErrorCode error);
+
+/** @brief Check if the validator is MergedValidator */
+bool merged_validator_is_instance(Validator *v);
+
+#ifdef __cplusplus
+}
+#endif
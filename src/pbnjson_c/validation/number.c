@@ -15,63 +15,303 @@
 // SPDX-License-Identifier: Apache-2.0
 
 #include "number.h"
+#include <inttypes.h>
+#include <limits.h>
 #include <stdio.h>
 
+// Significant digits held by the mantissa exactly
+#define MANTISSA_DIGITS 19
+// Bigger exponents are left to GMP
+#define EXPONENT_LIMIT 100000000
+
 void number_init(Number *number)
 {
-	mpf_init(number->f);
+	number->mantissa = 0;
+	number->exponent = 0;
+	number->negative = false;
+	number->big = false;
 }
 
 void number_clear(Number *number)
 {
-	mpf_clear(number->f);
+	if (number->big)
+		mpf_clear(number->f);
+	number->big = false;
+}
+
+// Accumulate next digit of the number, false if it doesn't fit the mantissa
+static bool add_digit(Number *n, int *digits, int64_t *exponent, int digit, bool fraction)
+{
+	if (*digits < MANTISSA_DIGITS)
+	{
+		if (n->mantissa || digit)
+		{
+			n->mantissa = n->mantissa * 10 + digit;
+			++*digits;
+		}
+		if (fraction)
+			--*exponent;
+		return true;
+	}
+
+	// Zeros beyond the mantissa change only the exponent
+	if (digit)
+		return false;
+	if (!fraction)
+		++*exponent;
+	return true;
+}
+
+static bool parse_decimal(Number *n, char const *str, size_t len)
+{
+	char const *p = str, *end = str + len;
+	int digits = 0;
+	int64_t exponent = 0;
+
+	n->mantissa = 0;
+	n->negative = p < end && *p == '-';
+	if (n->negative)
+		++p;
+
+	char const *start = p;
+	for (; p < end && *p >= '0' && *p <= '9'; ++p)
+		if (!add_digit(n, &digits, &exponent, *p - '0', false))
+			return false;
+	if (p == start)
+		return false;
+
+	if (p < end && *p == '.')
+	{
+		start = ++p;
+		for (; p < end && *p >= '0' && *p <= '9'; ++p)
+			if (!add_digit(n, &digits, &exponent, *p - '0', true))
+				return false;
+		if (p == start)
+			return false;
+	}
+
+	if (p < end && (*p == 'e' || *p == 'E'))
+	{
+		++p;
+		bool negative = p < end && *p == '-';
+		if (p < end && (*p == '-' || *p == '+'))
+			++p;
+
+		int64_t e = 0;
+		start = p;
+		for (; p < end && *p >= '0' && *p <= '9'; ++p)
+		{
+			e = e * 10 + (*p - '0');
+			if (e > EXPONENT_LIMIT)
+				return false;
+		}
+		if (p == start)
+			return false;
+		exponent += negative ? -e : e;
+	}
+
+	if (p != end)
+		return false;
+
+	if (!n->mantissa)
+	{
+		n->negative = false;
+		exponent = 0;
+	}
+	for (; n->mantissa && n->mantissa % 10 == 0; n->mantissa /= 10)
+		++exponent;
+	if (exponent > EXPONENT_LIMIT || exponent < -EXPONENT_LIMIT)
+		return false;
+
+	n->exponent = exponent;
+	return true;
 }
 
 int number_set(Number *number, char const *str)
 {
-	return mpf_set_str(number->f, str, 10);
+	return number_set_n(number, str, strlen(str));
 }
 
 int number_set_n(Number *number, char const *str, size_t len)
 {
+	number_clear(number);
+	if (parse_decimal(number, str, len))
+		return 0;
+
+	number_init(number);
 	char buffer[len + 1];
 	strncpy(buffer, str, len);
 	buffer[len] = 0;
 
-	return number_set(number, buffer);
+	mpf_init(number->f);
+	number->big = true;
+	return mpf_set_str(number->f, buffer, 10);
 }
 
 void number_copy(Number *dest, Number *src)
 {
+	if (!src->big)
+	{
+		number_clear(dest);
+		*dest = *src;
+		return;
+	}
+
+	if (!dest->big)
+		mpf_init(dest->f);
 	mpf_set(dest->f, src->f);
+	dest->big = true;
+}
+
+// GMP counterpart of a number, for the operations on big numbers
+static void number_to_mpf(Number const *n, mpf_t f)
+{
+	if (n->big)
+	{
+		mpf_init_set(f, n->f);
+		return;
+	}
+
+	char buffer[32];
+	snprintf(buffer, sizeof(buffer), "%s%" PRIu64 "e%" PRId32,
+	         n->negative ? "-" : "", n->mantissa, n->exponent);
+	mpf_init(f);
+	mpf_set_str(f, buffer, 10);
 }
 
 bool number_is_integer(Number const *n)
 {
-	return mpf_integer_p(n->f) != 0;
+	if (n->big)
+		return mpf_integer_p(n->f) != 0;
+	return n->exponent >= 0;
 }
 
 bool number_is_positive(Number const *n)
 {
-	return mpf_sgn(n->f) == 1;
+	if (n->big)
+		return mpf_sgn(n->f) == 1;
+	return !n->negative && n->mantissa;
+}
+
+static int count_digits(uint64_t m)
+{
+	int digits = 1;
+	for (; m >= 10; m /= 10)
+		++digits;
+	return digits;
+}
+
+static int compare_magnitude(Number const *a, Number const *b)
+{
+	if (!a->mantissa || !b->mantissa)
+		return (a->mantissa != 0) - (b->mantissa != 0);
+
+	// Position of the leading digit decides, unless it's the same
+	int a_digits = count_digits(a->mantissa);
+	int b_digits = count_digits(b->mantissa);
+	int64_t a_order = (int64_t) a->exponent + a_digits;
+	int64_t b_order = (int64_t) b->exponent + b_digits;
+	if (a_order != b_order)
+		return a_order < b_order ? -1 : 1;
+
+	uint64_t a_mantissa = a->mantissa, b_mantissa = b->mantissa;
+	for (; a_digits < b_digits; ++a_digits)
+		a_mantissa *= 10;
+	for (; b_digits < a_digits; ++b_digits)
+		b_mantissa *= 10;
+	return (a_mantissa > b_mantissa) - (a_mantissa < b_mantissa);
 }
 
 int number_compare(Number const *a, Number const *b)
 {
-	return mpf_cmp(a->f, b->f);
+	if (a->big || b->big)
+	{
+		mpf_t fa, fb;
+		number_to_mpf(a, fa);
+		number_to_mpf(b, fb);
+		int cmp = mpf_cmp(fa, fb);
+		mpf_clear(fa);
+		mpf_clear(fb);
+		return (cmp > 0) - (cmp < 0);
+	}
+
+	if (a->negative != b->negative)
+		return a->negative ? -1 : 1;
+	int cmp = compare_magnitude(a, b);
+	return a->negative ? -cmp : cmp;
+}
+
+// Absolute value of the number truncated to integer, false if it overflows
+static bool truncate_magnitude(Number const *n, uint64_t *magnitude)
+{
+	uint64_t m = n->mantissa;
+	for (int32_t i = n->exponent; i < 0 && m; ++i)
+		m /= 10;
+	for (int32_t i = 0; i < n->exponent && m; ++i)
+	{
+		if (m > UINT64_MAX / 10)
+			return false;
+		m *= 10;
+	}
+	*magnitude = m;
+	return true;
 }
 
 bool number_fits_long(Number const *n)
 {
-	return mpf_fits_slong_p(n->f);
+	if (n->big)
+		return mpf_fits_slong_p(n->f);
+
+	uint64_t m;
+	if (!truncate_magnitude(n, &m))
+		return false;
+	return m <= (uint64_t) LONG_MAX + n->negative;
 }
 
 long number_get_long(Number const *n)
 {
-	return mpf_get_si(n->f);
+	if (n->big)
+		return mpf_get_si(n->f);
+
+	uint64_t m;
+	if (!truncate_magnitude(n, &m) || !m)
+		return 0;
+	return n->negative ? -(long) (m - 1) - 1 : (long) m;
+}
+
+// Count and remove the factors f of m
+static int64_t strip_factor(uint64_t *m, unsigned f)
+{
+	int64_t count = 0;
+	for (; *m % f == 0; *m /= f)
+		++count;
+	return count;
 }
 
-void number_div(Number const *a, Number const *b, Number *res)
+bool number_is_multiple_of(Number const *a, Number const *b)
 {
-	mpf_div(res->f, a->f, b->f);
+	if (a->big || b->big)
+	{
+		mpf_t fa, fb;
+		number_to_mpf(a, fa);
+		number_to_mpf(b, fb);
+		mpf_div(fa, fa, fb);
+		bool res = mpf_integer_p(fa) != 0;
+		mpf_clear(fa);
+		mpf_clear(fb);
+		return res;
+	}
+
+	if (!b->mantissa)
+		return false;
+	if (!a->mantissa)
+		return true;
+
+	// a / b = 2^(a2 - b2 + e) * 5^(a5 - b5 + e) * a' / b', where e is the difference
+	// of exponents, and a', b' are the mantissas without factors 2 and 5
+	uint64_t a_rest = a->mantissa, b_rest = b->mantissa;
+	int64_t e = (int64_t) a->exponent - b->exponent;
+	int64_t a2 = strip_factor(&a_rest, 2), a5 = strip_factor(&a_rest, 5);
+	int64_t b2 = strip_factor(&b_rest, 2), b5 = strip_factor(&b_rest, 5);
+	return a_rest % b_rest == 0 && a2 + e >= b2 && a5 + e >= b5;
 }
@@ -17,6 +17,7 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
 #include <gmp.h>
 
@@ -24,10 +25,18 @@
 extern "C" {
 #endif
 
-/** @brief Arbitrary precision number */
+/** @brief Arbitrary precision number
+ *
+ * Numbers of up to 19 significant digits are held exactly as a decimal mantissa
+ * and exponent, which needs no allocation. Longer numbers fall back to GMP.
+ */
 typedef struct _Number
 {
-	mpf_t f;  /**< GMP is used in current implementation. */
+	uint64_t mantissa;  /**< Decimal digits without trailing zeros */
+	int32_t exponent;   /**< The value is mantissa * 10^exponent */
+	bool negative;
+	bool big;           /**< The value doesn't fit the mantissa, and is held by f */
+	mpf_t f;            /**< Initialized only for big values */
 } Number;
 
 
@@ -75,8 +84,8 @@ bool number_fits_long(Number const *n);
 /** @brief Get long from a number */
 long number_get_long(Number const *n);
 
-/** @brief Calculates division of two numbers (res = a / b) */
-void number_div(Number const *a, Number const *b, Number *res);
+/** @brief Check if a is a multiple of b (a / b is integer) */
+bool number_is_multiple_of(Number const *a, Number const *b);
 
 
 #ifdef __cplusplus
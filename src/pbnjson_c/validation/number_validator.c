@@ -62,12 +62,7 @@ static bool _check_conditions(NumberValidator *v, Number const *n,
 
 	if (v->multiple_of_set)
 	{
-		Number div;
-		number_init(&div);
-		number_div(n, &v->multiple_of, &div);
-		bool res = number_is_integer(&div);
-		number_clear(&div);
-		if (!res)
+		if (!number_is_multiple_of(n, &v->multiple_of))
 		{
 			validation_state_notify_error(s, VEC_NUMBER_NOT_MULTIPLE_OF, ctxt);
 			return false;
@@ -300,6 +295,85 @@ static bool equals(Validator *v, Validator *other)
 	return false;
 }
 
+static ValidatorVtable generic_number_vtable;
+static ValidatorVtable generic_integer_vtable;
+static ValidatorVtable number_vtable;
+
+static void merge_constraints(NumberValidator *n, NumberValidator *src)
+{
+	if (!src)
+		return;
+
+	n->integer |= src->integer;
+
+	if (src->min_set)
+	{
+		int cmp = n->min_set ? number_compare(&src->min, &n->min) : 1;
+		if (cmp > 0)
+		{
+			if (!n->min_set)
+				set_minimum(&n->base, &src->min);
+			else
+				number_copy(&n->min, &src->min);
+			n->min_exclusive = src->min_exclusive;
+		}
+		else if (cmp == 0)
+			n->min_exclusive |= src->min_exclusive;
+	}
+
+	if (src->max_set)
+	{
+		int cmp = n->max_set ? number_compare(&src->max, &n->max) : -1;
+		if (cmp < 0)
+		{
+			if (!n->max_set)
+				set_maximum(&n->base, &src->max);
+			else
+				number_copy(&n->max, &src->max);
+			n->max_exclusive = src->max_exclusive;
+		}
+		else if (cmp == 0)
+			n->max_exclusive |= src->max_exclusive;
+	}
+
+	if (src->multiple_of_set && !n->multiple_of_set)
+		set_multiple_of(&n->base, &src->multiple_of);
+}
+
+static Validator* merge(Validator *v, Validator *other)
+{
+	if (other->vtable != &number_vtable &&
+	    other->vtable != &generic_number_vtable &&
+	    other->vtable != &generic_integer_vtable)
+	{
+		return NULL;
+	}
+
+	NumberValidator *n1 = v->vtable == &number_vtable ? (NumberValidator *) v : NULL;
+	NumberValidator *n2 = other->vtable == &number_vtable ? (NumberValidator *) other : NULL;
+	bool integer = v->vtable == &generic_integer_vtable ||
+	               other->vtable == &generic_integer_vtable;
+
+	if (!n1 && !n2)
+		return integer ? integer_validator_instance() : number_validator_instance();
+
+	// Exact values come from enums, which aren't subject of merging.
+	// Different multipleOf can't be expressed by a single validator.
+	if ((n1 && n1->expected_set) || (n2 && n2->expected_set))
+		return NULL;
+	if (n1 && n2 && n1->multiple_of_set && n2->multiple_of_set &&
+	    number_compare(&n1->multiple_of, &n2->multiple_of) != 0)
+	{
+		return NULL;
+	}
+
+	NumberValidator *n = number_validator_new();
+	n->integer = integer;
+	merge_constraints(n, n1);
+	merge_constraints(n, n2);
+	return &n->base;
+}
+
 static ValidatorVtable generic_number_vtable =
 {
 	.check = check_generic,
@@ -309,6 +383,7 @@ static ValidatorVtable generic_number_vtable =
 	.set_number_minimum_exclusive = set_minimum_exclusive_generic,
 	.set_number_multiple_of = set_multiple_of_generic,
 	.set_default = set_default_generic,
+	.merge = merge,
 };
 
 static ValidatorVtable generic_integer_vtable =
@@ -320,6 +395,7 @@ static ValidatorVtable generic_integer_vtable =
 	.set_number_minimum_exclusive = set_minimum_exclusive_integer_generic,
 	.set_number_multiple_of = set_multiple_of_integer_generic,
 	.set_default = set_default_integer_generic,
+	.merge = merge,
 };
 
 static ValidatorVtable number_vtable =
@@ -335,6 +411,7 @@ static ValidatorVtable number_vtable =
 	.set_number_multiple_of = set_multiple_of,
 	.set_default = set_default,
 	.get_default = get_default,
+	.merge = merge,
 };
 
 NumberValidator* number_validator_new(void)
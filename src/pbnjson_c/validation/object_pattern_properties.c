@@ -20,17 +20,18 @@
 
 #include "validator.h"
 #include "combined_validator.h"
+#include "regex_matcher.h"
 
 
 typedef struct _Entry
 {
-	GRegex *regex;          // Regex of property name
+	RegexMatcher *regex;    // Regex of property name
 	Validator *validator;   // Validator on the property value
 } Entry;
 
 static void entry_free(Entry *entry)
 {
-	g_regex_unref(entry->regex);
+	regex_matcher_unref(entry->regex);
 	validator_unref(entry->validator);
 	g_free(entry);
 }
@@ -80,7 +81,7 @@ bool object_pattern_properties_add(ObjectPatternProperties *o, const char *patte
 
 	Entry *entry = g_new0(Entry, 1);
 	entry->validator = v;
-	entry->regex = g_regex_new(buffer, G_REGEX_JAVASCRIPT_COMPAT, 0, NULL);
+	entry->regex = regex_matcher_new(buffer);
 	if (!entry->regex)
 	{
 		validator_unref(v);
@@ -102,7 +103,7 @@ Validator* object_pattern_properties_find(ObjectPatternProperties *o, const char
 	for (GSList *s = o->patterns; s != NULL; s = g_slist_next(s))
 	{
 		Entry *entry = (Entry *) s->data;
-		if (g_regex_match(entry->regex, key, 0, NULL))
+		if (regex_matcher_match(entry->regex, key, strlen(key)))
 			validators = g_slist_prepend(validators, entry->validator);
 	}
 
@@ -142,13 +142,13 @@ static bool _check(Validator *v, ValidationEvent const *e, ValidationState *s, v
 
 	if (child)
 	{
-		validation_state_push_validator(s, child);
+		validation_state_push_value_validator(s, child, ctxt);
 		return true;
 	}
 
 	if (vobj->additional_properties)
 	{
-		validation_state_push_validator(s, vobj->additional_properties);
+		validation_state_push_value_validator(s, vobj->additional_properties, ctxt);
 		return true;
 	}
 
@@ -160,7 +160,7 @@ static bool _check(Validator *v, ValidationEvent const *e, ValidationState *s, v
 	{
 		validator_unref(my_ctxt->pattern_properties_validator);
 		my_ctxt->pattern_properties_validator = child;
-		validation_state_push_validator(s, child);
+		validation_state_push_value_validator(s, child, ctxt);
 		return true;
 	}
 
@@ -395,6 +395,114 @@ static bool equals(Validator *v, Validator *other)
 	return false;
 }
 
+static ValidatorVtable generic_object_vtable;
+ValidatorVtable object_vtable;
+
+// Does the validator constrain the keys or the values of the properties?
+static bool has_key_constraints(ObjectValidator *o)
+{
+	return (o->properties && object_properties_length(o->properties)) ||
+	       o->additional_properties != GENERIC_VALIDATOR ||
+	       o->pattern_properties;
+}
+
+static void merge_required(ObjectRequired *dst, ObjectRequired *src)
+{
+	if (!src)
+		return;
+
+	GHashTableIter it;
+	g_hash_table_iter_init(&it, src->keys);
+	char const *key = NULL;
+	while (g_hash_table_iter_next(&it, (gpointer *) &key, NULL))
+		object_required_add_key(dst, key);
+}
+
+static bool merge_properties(ObjectProperties *dst, ObjectProperties *src)
+{
+	if (!src)
+		return true;
+
+	GHashTableIter it;
+	g_hash_table_iter_init(&it, src->keys);
+	char const *key = NULL;
+	Validator *value = NULL;
+	while (g_hash_table_iter_next(&it, (gpointer *) &key, (gpointer *) &value))
+	{
+		// Both validators would have to be run for the same key
+		if (object_properties_lookup(dst, key))
+			return false;
+		object_properties_add_key(dst, key, validator_ref(value));
+	}
+	return true;
+}
+
+static Validator* merge(Validator *v, Validator *other)
+{
+	if (other->vtable != &object_vtable &&
+	    other->vtable != &generic_object_vtable)
+	{
+		return NULL;
+	}
+
+	ObjectValidator *o1 = v->vtable == &object_vtable ? (ObjectValidator *) v : NULL;
+	ObjectValidator *o2 = other->vtable == &object_vtable ? (ObjectValidator *) other : NULL;
+
+	if (!o1 || !o2)
+		return validator_ref(o1 ? v : other);
+
+	ObjectValidator *o = object_validator_new();
+
+	bool keys1 = has_key_constraints(o1);
+	bool keys2 = has_key_constraints(o2);
+	if (keys1 && keys2)
+	{
+		// Only disjoint "properties" of open objects may be joined:
+		// every key is then checked by exactly one of the validators.
+		if (o1->additional_properties != GENERIC_VALIDATOR ||
+		    o2->additional_properties != GENERIC_VALIDATOR ||
+		    o1->pattern_properties || o2->pattern_properties)
+		{
+			object_validator_release(o);
+			return NULL;
+		}
+
+		ObjectProperties *p = object_properties_new();
+		if (!merge_properties(p, o1->properties) ||
+		    !merge_properties(p, o2->properties))
+		{
+			object_properties_unref(p);
+			object_validator_release(o);
+			return NULL;
+		}
+		o->properties = p;
+	}
+	else if (keys1 || keys2)
+	{
+		ObjectValidator *src = keys1 ? o1 : o2;
+		if (src->properties)
+			set_properties(&o->base, src->properties);
+		set_additional_properties(&o->base, src->additional_properties);
+		if (src->pattern_properties)
+			set_pattern_properties(&o->base, src->pattern_properties);
+	}
+
+	if (o1->required || o2->required)
+	{
+		o->required = object_required_new();
+		merge_required(o->required, o1->required);
+		merge_required(o->required, o2->required);
+	}
+
+	o->min_properties = MAX(o1->min_properties, o2->min_properties);
+	if (o1->max_properties == -1 || o2->max_properties == -1)
+		o->max_properties = MAX(o1->max_properties, o2->max_properties);
+	else
+		o->max_properties = MIN(o1->max_properties, o2->max_properties);
+
+	return &o->base;
+}
+
 static ValidatorVtable generic_object_vtable =
 {
 	.check = check_generic,
@@ -407,6 +515,7 @@ static ValidatorVtable generic_object_vtable =
 	.set_object_max_properties = set_max_properties_generic,
 	.set_object_min_properties = set_min_properties_generic,
 	.set_default = set_default_generic,
+	.merge = merge,
 	.dump_enter = dump_enter,
 	.dump_exit = dump_exit,
 };
@@ -427,6 +536,7 @@ ValidatorVtable object_vtable =
 	.set_object_min_properties = set_min_properties,
 	.set_default = set_default,
 	.get_default = get_default,
+	.merge = merge,
 	.visit = _visit,
 	.dump_enter = dump_enter,
 	.dump_exit = dump_exit,
@@ -22,7 +22,7 @@ static void release(Feature *f)
 {
 	Pattern *p = (Pattern *) f;
 	if (p->regex)
-		g_regex_unref(p->regex);
+		regex_matcher_unref(p->regex);
 	g_free(p);
 }
 
@@ -48,8 +48,8 @@ Pattern* pattern_new(void)
 bool pattern_set_regex(Pattern *p, char const *str)
 {
 	if (p->regex)
-		g_regex_unref(p->regex);
-	p->regex = g_regex_new(str, G_REGEX_JAVASCRIPT_COMPAT, 0, NULL);
+		regex_matcher_unref(p->regex);
+	p->regex = regex_matcher_new(str);
 	return p->regex;
 }
 
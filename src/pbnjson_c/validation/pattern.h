@@ -17,6 +17,7 @@
 #pragma once
 
 #include "feature.h"
+#include "regex_matcher.h"
 #include <glib.h>
 #include <stdbool.h>
 
@@ -30,7 +31,7 @@ extern "C" {
 typedef struct _Pattern
 {
 	Feature base;    /**< @brief Base class */
-	GRegex *regex;   /**< @brief Regular expression handler */
+	RegexMatcher *regex;   /**< @brief Regular expression handler */
 } Pattern;
 
 /** @brief Constructor */
@@ -101,9 +101,7 @@ static void _collect_uri_enter(char const *key, Validator *v, void *ctxt)
 	// Push target to resolve it in the current context.
 	uri_scope_push_uri(uri_scope, r->target);
 
-	int chars_required = uri_scope_get_document_length(uri_scope);
-	char buffer[chars_required];
-	char const *document = uri_scope_get_document(uri_scope, buffer, chars_required);
+	char const *document = uri_scope_peek_document(uri_scope);
 
 	assert(!r->document && !r->fragment && "Reference URI should be collected only once");
 	r->document = g_strdup(uri_resolver_add_document(uri_scope->uri_resolver, document));
@@ -122,9 +120,7 @@ static void _collect_schemas(Validator *v, void *ctxt)
 	// infinite loop we should keep it as indirect instead of trying resolving
 	// target.
 
-	int chars_required = uri_scope_get_document_length(uri_scope);
-	char buffer[chars_required];
-	char const *document = uri_scope_get_document(uri_scope, buffer, chars_required);
+	char const *document = uri_scope_peek_document(uri_scope);
 	char const *fragment = uri_scope_get_fragment(uri_scope);
 
 	uri_resolver_add_validator(uri_scope->uri_resolver, document, fragment, v);
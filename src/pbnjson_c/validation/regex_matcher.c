@@ -0,0 +1,956 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "regex_matcher.h"
+#include <glib.h>
+#include <stdint.h>
+#include <string.h>
+
+// Limits beyond which the pattern is left to the backtracking matcher
+#define MAX_REPEAT      1000
+#define MAX_NESTING     128
+#define MAX_PROGRAM     20000
+
+// Backtracking steps PCRE may take in one match of the fallback path
+#define FALLBACK_MATCH_LIMIT 100000
+
+// Size of the thread lists which are allocated on the stack
+#define SMALL_PROGRAM   256
+
+#define NONE            (-1)
+
+/** @name Syntax tree of the pattern
+ *  @{
+ */
+
+typedef enum
+{
+	NODE_EMPTY,
+	NODE_CHAR,
+	NODE_ANY,
+	NODE_CLASS,
+	NODE_ASSERT,
+	NODE_CAT,
+	NODE_ALT,
+	NODE_REPEAT,
+} NodeType;
+
+typedef enum
+{
+	ASSERT_BEGIN,
+	ASSERT_END,
+	ASSERT_WORD_BOUNDARY,
+	ASSERT_NOT_WORD_BOUNDARY,
+} AssertKind;
+
+typedef struct _Node
+{
+	NodeType type;
+	uint32_t value;    // Character, class index or assertion kind
+	int left;          // Operands of CAT and ALT, repeated node
+	int right;
+	int min;           // Bounds of REPEAT, max is NONE for unlimited
+	int max;
+} Node;
+
+typedef struct _Range
+{
+	uint32_t lo;
+	uint32_t hi;
+} Range;
+
+typedef struct _CharClass
+{
+	GArray *ranges;
+	bool negate;
+} CharClass;
+
+/** @} */
+
+/** @name Compiled program
+ *  @{
+ */
+
+typedef enum
+{
+	OP_CHAR,
+	OP_ANY,
+	OP_CLASS,
+	OP_ASSERT,
+	OP_SPLIT,
+	OP_JMP,
+	OP_MATCH,
+} OpCode;
+
+typedef struct _Inst
+{
+	OpCode op;
+	uint32_t arg;      // Character, class index, assertion kind or jump target
+	uint32_t arg2;     // Second target of SPLIT
+} Inst;
+
+typedef struct _Program
+{
+	GArray *insts;
+	GArray *classes;
+	bool anchored;     // Can match only from the beginning of the input
+} Program;
+
+/** @} */
+
+struct _RegexMatcher
+{
+	unsigned ref_count;
+	char *pattern;
+	Program *program;  // Linear engine, NULL if the pattern isn't supported
+	GRegex *regex;     // Backtracking fallback
+};
+
+typedef struct _Parser
+{
+	unsigned char const *pos;
+	unsigned char const *end;
+	GArray *nodes;
+	GArray *classes;
+	int depth;
+	bool failed;
+} Parser;
+
+static size_t decode_utf8(unsigned char const *s, size_t len, uint32_t *c)
+{
+	unsigned char b = s[0];
+	size_t n = 0;
+	uint32_t res = 0;
+
+	if (b < 0x80)
+	{
+		*c = b;
+		return 1;
+	}
+	else if ((b & 0xe0) == 0xc0)
+		n = 2, res = b & 0x1f;
+	else if ((b & 0xf0) == 0xe0)
+		n = 3, res = b & 0x0f;
+	else if ((b & 0xf8) == 0xf0)
+		n = 4, res = b & 0x07;
+
+	if (!n || n > len)
+	{
+		// Invalid sequence, take the byte as is
+		*c = b;
+		return 1;
+	}
+
+	for (size_t i = 1; i < n; ++i)
+	{
+		if ((s[i] & 0xc0) != 0x80)
+		{
+			*c = b;
+			return 1;
+		}
+		res = (res << 6) | (s[i] & 0x3f);
+	}
+	*c = res;
+	return n;
+}
+
+static bool is_word_char(int c)
+{
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+	       (c >= '0' && c <= '9') || c == '_';
+}
+
+static int hex_value(unsigned char c)
+{
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	return NONE;
+}
+
+static int add_node(Parser *p, NodeType type, uint32_t value, int left, int right)
+{
+	Node n = { type, value, left, right, 0, 0 };
+	g_array_append_val(p->nodes, n);
+	return p->nodes->len - 1;
+}
+
+static Node* get_node(Parser *p, int i)
+{
+	return &g_array_index(p->nodes, Node, i);
+}
+
+static int fail(Parser *p)
+{
+	p->failed = true;
+	return NONE;
+}
+
+static void class_add_range(CharClass *c, uint32_t lo, uint32_t hi)
+{
+	Range r = { lo, hi };
+	g_array_append_val(c->ranges, r);
+}
+
+// Ranges of "\d", "\w", "\s" as PCRE sees them without Unicode properties
+static bool class_add_escape(CharClass *c, unsigned char e)
+{
+	switch (e)
+	{
+	case 'd':
+		class_add_range(c, '0', '9');
+		return true;
+	case 'w':
+		class_add_range(c, '0', '9');
+		class_add_range(c, 'A', 'Z');
+		class_add_range(c, 'a', 'z');
+		class_add_range(c, '_', '_');
+		return true;
+	case 's':
+		class_add_range(c, '\t', '\r');
+		class_add_range(c, ' ', ' ');
+		return true;
+	default:
+		return false;
+	}
+}
+
+static int add_class(Parser *p, CharClass *c)
+{
+	g_array_append_val(p->classes, *c);
+	return add_node(p, NODE_CLASS, p->classes->len - 1, NONE, NONE);
+}
+
+static void class_free(CharClass *c)
+{
+	g_array_free(c->ranges, TRUE);
+}
+
+static CharClass class_new(bool negate)
+{
+	CharClass c = { g_array_new(FALSE, FALSE, sizeof(Range)), negate };
+	return c;
+}
+
+// Parse escaped character (after '\'), which denotes a single character.
+// Returns NONE if the escape isn't supported.
+static int parse_char_escape(Parser *p, bool in_class)
+{
+	if (p->pos == p->end)
+		return NONE;
+
+	unsigned char e = *p->pos++;
+	switch (e)
+	{
+	case 'n': return '\n';
+	case 'r': return '\r';
+	case 't': return '\t';
+	case 'f': return '\f';
+	case 'v': return '\v';
+	case 'b': return in_class ? '\b' : NONE;
+	case '0':
+		if (p->pos != p->end && *p->pos >= '0' && *p->pos <= '9')
+			return NONE;
+		return 0;
+	case 'x':
+	case 'u':
+	{
+		int digits = e == 'x' ? 2 : 4;
+		if (p->end - p->pos < digits)
+			return NONE;
+		int res = 0;
+		for (int i = 0; i < digits; ++i)
+		{
+			int h = hex_value(*p->pos++);
+			if (h == NONE)
+				return NONE;
+			res = res * 16 + h;
+		}
+		return res;
+	}
+	default:
+		// Escaped punctuation means the character itself,
+		// letters and digits have special meanings we don't handle.
+		if (e >= 0x80 || g_ascii_isalnum(e))
+			return NONE;
+		return e;
+	}
+}
+
+static int parse_class(Parser *p)
+{
+	// After '['
+	bool negate = false;
+	if (p->pos != p->end && *p->pos == '^')
+	{
+		negate = true;
+		++p->pos;
+	}
+
+	// Empty class differs between JavaScript and PCRE
+	if (p->pos == p->end || *p->pos == ']')
+		return fail(p);
+
+	CharClass c = class_new(negate);
+	while (p->pos != p->end && *p->pos != ']')
+	{
+		uint32_t lo;
+		if (*p->pos == '\\')
+		{
+			++p->pos;
+			if (p->pos != p->end && class_add_escape(&c, *p->pos))
+			{
+				++p->pos;
+				// Ranges like [\d-z] aren't supported
+				if (p->pos != p->end && *p->pos == '-' &&
+				    p->pos + 1 != p->end && p->pos[1] != ']')
+				{
+					break;
+				}
+				continue;
+			}
+			int e = parse_char_escape(p, true);
+			if (e == NONE)
+				break;
+			lo = e;
+		}
+		else if (*p->pos == '[' && p->pos + 1 != p->end &&
+		         (p->pos[1] == ':' || p->pos[1] == '.' || p->pos[1] == '='))
+		{
+			// POSIX classes like [[:alpha:]] are PCRE syntax, not ours
+			break;
+		}
+		else
+			p->pos += decode_utf8(p->pos, p->end - p->pos, &lo);
+
+		uint32_t hi = lo;
+		if (p->end - p->pos >= 2 && *p->pos == '-' && p->pos[1] != ']')
+		{
+			++p->pos;
+			if (*p->pos == '\\')
+			{
+				++p->pos;
+				int e = parse_char_escape(p, true);
+				if (e == NONE)
+					break;
+				hi = e;
+			}
+			else
+				p->pos += decode_utf8(p->pos, p->end - p->pos, &hi);
+			if (hi < lo)
+				break;
+		}
+		class_add_range(&c, lo, hi);
+	}
+
+	if (p->pos == p->end || *p->pos != ']')
+	{
+		class_free(&c);
+		return fail(p);
+	}
+	++p->pos;
+	return add_class(p, &c);
+}
+
+static int parse_alternative(Parser *p);
+
+static int parse_atom(Parser *p)
+{
+	unsigned char c = *p->pos;
+	switch (c)
+	{
+	case '(':
+	{
+		++p->pos;
+		if (p->pos != p->end && *p->pos == '?')
+		{
+			// Only non-capturing groups, no lookarounds
+			if (p->end - p->pos < 2 || p->pos[1] != ':')
+				return fail(p);
+			p->pos += 2;
+		}
+		if (++p->depth > MAX_NESTING)
+			return fail(p);
+		int res = parse_alternative(p);
+		--p->depth;
+		if (p->failed || p->pos == p->end || *p->pos != ')')
+			return fail(p);
+		++p->pos;
+		return res;
+	}
+	case '[':
+		++p->pos;
+		return parse_class(p);
+	case '.':
+	{
+		++p->pos;
+		return add_node(p, NODE_ANY, 0, NONE, NONE);
+	}
+	case '^':
+		++p->pos;
+		return add_node(p, NODE_ASSERT, ASSERT_BEGIN, NONE, NONE);
+	case '$':
+		++p->pos;
+		return add_node(p, NODE_ASSERT, ASSERT_END, NONE, NONE);
+	case '\\':
+	{
+		++p->pos;
+		if (p->pos == p->end)
+			return fail(p);
+		unsigned char e = *p->pos;
+		if (e == 'b' || e == 'B')
+		{
+			++p->pos;
+			return add_node(p, NODE_ASSERT,
+			                e == 'b' ? ASSERT_WORD_BOUNDARY : ASSERT_NOT_WORD_BOUNDARY,
+			                NONE, NONE);
+		}
+		CharClass cls = class_new(g_ascii_isupper(e));
+		if (class_add_escape(&cls, g_ascii_tolower(e)))
+		{
+			++p->pos;
+			return add_class(p, &cls);
+		}
+		class_free(&cls);
+		int ch = parse_char_escape(p, false);
+		if (ch == NONE)
+			return fail(p);
+		return add_node(p, NODE_CHAR, ch, NONE, NONE);
+	}
+	case '*':
+	case '+':
+	case '?':
+	case '{':
+	case ')':
+	case '|':
+		// '{' is a literal if it doesn't start a quantifier,
+		// leave such patterns to PCRE.
+		return fail(p);
+	default:
+	{
+		uint32_t ch;
+		p->pos += decode_utf8(p->pos, p->end - p->pos, &ch);
+		return add_node(p, NODE_CHAR, ch, NONE, NONE);
+	}
+	}
+}
+
+static bool parse_number(Parser *p, int *n)
+{
+	if (p->pos == p->end || !g_ascii_isdigit(*p->pos))
+		return false;
+	int res = 0;
+	while (p->pos != p->end && g_ascii_isdigit(*p->pos))
+	{
+		res = res * 10 + (*p->pos++ - '0');
+		if (res > MAX_REPEAT)
+			return false;
+	}
+	*n = res;
+	return true;
+}
+
+static int parse_repeat(Parser *p)
+{
+	int atom = parse_atom(p);
+	if (p->failed || p->pos == p->end)
+		return atom;
+
+	int min, max;
+	switch (*p->pos)
+	{
+	case '*':
+		min = 0, max = NONE;
+		++p->pos;
+		break;
+	case '+':
+		min = 1, max = NONE;
+		++p->pos;
+		break;
+	case '?':
+		min = 0, max = 1;
+		++p->pos;
+		break;
+	case '{':
+		++p->pos;
+		if (!parse_number(p, &min))
+			return fail(p);
+		max = min;
+		if (p->pos != p->end && *p->pos == ',')
+		{
+			++p->pos;
+			max = NONE;
+			if (p->pos != p->end && *p->pos != '}' && !parse_number(p, &max))
+				return fail(p);
+		}
+		if (p->pos == p->end || *p->pos != '}' || (max != NONE && max < min))
+			return fail(p);
+		++p->pos;
+		break;
+	default:
+		return atom;
+	}
+
+	// Lazy quantifier gives the same answer whether the pattern matches
+	if (p->pos != p->end && *p->pos == '?')
+		++p->pos;
+
+	// Quantified assertions and double quantifiers are left for PCRE
+	if (get_node(p, atom)->type == NODE_ASSERT ||
+	    (p->pos != p->end && strchr("*+?{", *p->pos)))
+	{
+		return fail(p);
+	}
+
+	int res = add_node(p, NODE_REPEAT, 0, atom, NONE);
+	get_node(p, res)->min = min;
+	get_node(p, res)->max = max;
+	return res;
+}
+
+static int parse_concatenation(Parser *p)
+{
+	int res = add_node(p, NODE_EMPTY, 0, NONE, NONE);
+	while (!p->failed && p->pos != p->end && *p->pos != '|' && *p->pos != ')')
+	{
+		int next = parse_repeat(p);
+		if (p->failed)
+			break;
+		res = add_node(p, NODE_CAT, 0, res, next);
+	}
+	return res;
+}
+
+static int parse_alternative(Parser *p)
+{
+	int res = parse_concatenation(p);
+	while (!p->failed && p->pos != p->end && *p->pos == '|')
+	{
+		++p->pos;
+		int next = parse_concatenation(p);
+		res = add_node(p, NODE_ALT, 0, res, next);
+	}
+	return res;
+}
+
+static bool node_is_anchored(Parser *p, int i)
+{
+	Node *n = get_node(p, i);
+	switch (n->type)
+	{
+	case NODE_ASSERT:
+		return n->value == ASSERT_BEGIN;
+	case NODE_CAT:
+		// Leftmost non-empty element decides
+		if (get_node(p, n->left)->type == NODE_EMPTY)
+			return node_is_anchored(p, n->right);
+		return node_is_anchored(p, n->left);
+	case NODE_ALT:
+		return node_is_anchored(p, n->left) && node_is_anchored(p, n->right);
+	case NODE_REPEAT:
+		return n->min > 0 && node_is_anchored(p, n->left);
+	default:
+		return false;
+	}
+}
+
+static unsigned emit(Program *prog, OpCode op, uint32_t arg, uint32_t arg2)
+{
+	Inst i = { op, arg, arg2 };
+	g_array_append_val(prog->insts, i);
+	return prog->insts->len - 1;
+}
+
+static Inst* get_inst(Program *prog, unsigned pc)
+{
+	return &g_array_index(prog->insts, Inst, pc);
+}
+
+static bool compile_node(Parser *p, Program *prog, int i)
+{
+	if (prog->insts->len > MAX_PROGRAM)
+		return false;
+
+	Node n = *get_node(p, i);
+	switch (n.type)
+	{
+	case NODE_EMPTY:
+		return true;
+	case NODE_CHAR:
+		emit(prog, OP_CHAR, n.value, 0);
+		return true;
+	case NODE_ANY:
+		emit(prog, OP_ANY, 0, 0);
+		return true;
+	case NODE_CLASS:
+		emit(prog, OP_CLASS, n.value, 0);
+		return true;
+	case NODE_ASSERT:
+		emit(prog, OP_ASSERT, n.value, 0);
+		return true;
+	case NODE_CAT:
+		return compile_node(p, prog, n.left) && compile_node(p, prog, n.right);
+	case NODE_ALT:
+	{
+		unsigned split = emit(prog, OP_SPLIT, prog->insts->len + 1, 0);
+		if (!compile_node(p, prog, n.left))
+			return false;
+		unsigned jmp = emit(prog, OP_JMP, 0, 0);
+		get_inst(prog, split)->arg2 = prog->insts->len;
+		if (!compile_node(p, prog, n.right))
+			return false;
+		get_inst(prog, jmp)->arg = prog->insts->len;
+		return true;
+	}
+	case NODE_REPEAT:
+	{
+		for (int k = 0; k < n.min; ++k)
+			if (!compile_node(p, prog, n.left))
+				return false;
+
+		if (n.max == NONE)
+		{
+			unsigned split = emit(prog, OP_SPLIT, prog->insts->len + 1, 0);
+			if (!compile_node(p, prog, n.left))
+				return false;
+			emit(prog, OP_JMP, split, 0);
+			get_inst(prog, split)->arg2 = prog->insts->len;
+			return true;
+		}
+
+		// Optional copies, each of them may skip the rest
+		GArray *splits = g_array_new(FALSE, FALSE, sizeof(unsigned));
+		bool res = true;
+		for (int k = n.min; k < n.max && res; ++k)
+		{
+			unsigned split = emit(prog, OP_SPLIT, prog->insts->len + 1, 0);
+			g_array_append_val(splits, split);
+			res = compile_node(p, prog, n.left);
+		}
+		for (unsigned k = 0; k < splits->len; ++k)
+			get_inst(prog, g_array_index(splits, unsigned, k))->arg2 = prog->insts->len;
+		g_array_free(splits, TRUE);
+		return res;
+	}
+	}
+	return false;
+}
+
+static void program_free(Program *prog)
+{
+	if (!prog)
+		return;
+	g_array_free(prog->insts, TRUE);
+	for (unsigned i = 0; i < prog->classes->len; ++i)
+		class_free(&g_array_index(prog->classes, CharClass, i));
+	g_array_free(prog->classes, TRUE);
+	g_free(prog);
+}
+
+static Program* program_compile(char const *pattern)
+{
+	Parser p = {
+		.pos = (unsigned char const *) pattern,
+		.end = (unsigned char const *) pattern + strlen(pattern),
+		.nodes = g_array_new(FALSE, FALSE, sizeof(Node)),
+		.classes = g_array_new(FALSE, FALSE, sizeof(CharClass)),
+	};
+
+	int root = parse_alternative(&p);
+	if (p.pos != p.end)
+		p.failed = true;
+
+	Program *prog = g_new0(Program, 1);
+	prog->insts = g_array_new(FALSE, FALSE, sizeof(Inst));
+	prog->classes = p.classes;
+
+	if (!p.failed)
+	{
+		prog->anchored = node_is_anchored(&p, root);
+		if (compile_node(&p, prog, root) && prog->insts->len < MAX_PROGRAM)
+			emit(prog, OP_MATCH, 0, 0);
+		else
+			p.failed = true;
+	}
+
+	g_array_free(p.nodes, TRUE);
+	if (p.failed)
+	{
+		program_free(prog);
+		return NULL;
+	}
+	return prog;
+}
+
+/** @name NFA simulation
+ *  @{
+ */
+
+// Sparse set of instructions
+typedef struct _ThreadList
+{
+	unsigned *dense;
+	unsigned *sparse;
+	unsigned count;
+} ThreadList;
+
+// Position in the input for zero-width assertions
+typedef struct _Position
+{
+	size_t pos;
+	int prev;          // Character before the position or NONE
+	int cur;           // Character at the position or NONE
+	bool before_last_newline;
+} Position;
+
+static inline bool thread_list_contains(ThreadList *l, unsigned pc)
+{
+	unsigned i = l->sparse[pc];
+	return i < l->count && l->dense[i] == pc;
+}
+
+static inline void thread_list_insert(ThreadList *l, unsigned pc)
+{
+	l->sparse[pc] = l->count;
+	l->dense[l->count++] = pc;
+}
+
+static bool check_assertion(AssertKind kind, Position const *at)
+{
+	switch (kind)
+	{
+	case ASSERT_BEGIN:
+		return at->pos == 0;
+	case ASSERT_END:
+		// PCRE allows "$" before the final newline
+		return at->cur == NONE || at->before_last_newline;
+	case ASSERT_WORD_BOUNDARY:
+		return is_word_char(at->prev) != is_word_char(at->cur);
+	case ASSERT_NOT_WORD_BOUNDARY:
+		return is_word_char(at->prev) == is_word_char(at->cur);
+	}
+	return false;
+}
+
+static bool class_matches(CharClass const *c, uint32_t ch)
+{
+	bool found = false;
+	for (unsigned i = 0; i < c->ranges->len && !found; ++i)
+	{
+		Range const *r = &g_array_index(c->ranges, Range, i);
+		found = ch >= r->lo && ch <= r->hi;
+	}
+	return found != c->negate;
+}
+
+// Follow the instructions, which don't consume input, from pc
+static void add_thread(Program const *prog, ThreadList *l, unsigned *stack,
+                       unsigned pc, Position const *at)
+{
+	Inst const *insts = (Inst const *) prog->insts->data;
+	unsigned top = 0;
+	stack[top++] = pc;
+	while (top)
+	{
+		pc = stack[--top];
+		if (thread_list_contains(l, pc))
+			continue;
+		thread_list_insert(l, pc);
+
+		Inst const *i = &insts[pc];
+		switch (i->op)
+		{
+		case OP_JMP:
+			stack[top++] = i->arg;
+			break;
+		case OP_SPLIT:
+			stack[top++] = i->arg2;
+			stack[top++] = i->arg;
+			break;
+		case OP_ASSERT:
+			if (check_assertion(i->arg, at))
+				stack[top++] = pc + 1;
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+static void read_position(Position *at, unsigned char const *s, size_t len,
+                          size_t pos, int prev, size_t *char_len)
+{
+	at->pos = pos;
+	at->prev = prev;
+	at->cur = NONE;
+	at->before_last_newline = pos + 1 == len && s[pos] == '\n';
+	*char_len = 0;
+	if (pos < len)
+	{
+		uint32_t c;
+		*char_len = decode_utf8(s + pos, len - pos, &c);
+		at->cur = c;
+	}
+}
+
+static bool program_match(Program const *prog, char const *str, size_t len)
+{
+	unsigned char const *s = (unsigned char const *) str;
+	Inst const *insts = (Inst const *) prog->insts->data;
+	unsigned n = prog->insts->len;
+
+	// Two thread lists and the stack for add_thread()
+	unsigned small[SMALL_PROGRAM * 7];
+	unsigned *buf = n <= SMALL_PROGRAM ? small : g_new(unsigned, n * 7);
+	ThreadList lists[2] = {
+		{ buf, buf + n, 0 },
+		{ buf + 2 * n, buf + 3 * n, 0 },
+	};
+	unsigned *stack = buf + 4 * n;
+	// Sparse arrays may be left uninitialized, but memory checkers dislike it
+	memset(buf, 0, sizeof(unsigned) * 4 * n);
+	ThreadList *clist = &lists[0];
+	ThreadList *nlist = &lists[1];
+
+	bool matched = false;
+	size_t cur_len, next_len;
+	Position at, next;
+	read_position(&at, s, len, 0, NONE, &cur_len);
+
+	for (;;)
+	{
+		if (!prog->anchored || at.pos == 0)
+			add_thread(prog, clist, stack, 0, &at);
+		if (!clist->count)
+			break;
+
+		if (at.cur != NONE)
+			read_position(&next, s, len, at.pos + cur_len, at.cur, &next_len);
+
+		nlist->count = 0;
+		for (unsigned k = 0; k < clist->count && !matched; ++k)
+		{
+			unsigned pc = clist->dense[k];
+			Inst const *i = &insts[pc];
+			bool step = false;
+			switch (i->op)
+			{
+			case OP_MATCH:
+				matched = true;
+				break;
+			case OP_CHAR:
+				step = at.cur != NONE && (uint32_t) at.cur == i->arg;
+				break;
+			case OP_ANY:
+				step = at.cur != NONE && at.cur != '\n';
+				break;
+			case OP_CLASS:
+				step = at.cur != NONE &&
+				       class_matches(&g_array_index(prog->classes, CharClass, i->arg), at.cur);
+				break;
+			default:
+				break;
+			}
+			if (step)
+				add_thread(prog, nlist, stack, pc + 1, &next);
+		}
+
+		if (matched || at.cur == NONE)
+			break;
+
+		ThreadList *tmp = clist;
+		clist = nlist;
+		nlist = tmp;
+		at = next;
+		cur_len = next_len;
+	}
+
+	if (buf != small)
+		g_free(buf);
+	return matched;
+}
+
+/** @} */
+
+RegexMatcher* regex_matcher_new(char const *pattern)
+{
+	Program *prog = program_compile(pattern);
+	GRegex *regex = NULL;
+	if (!prog)
+	{
+		// The verb bounds every match, GRegex has no API for the limit
+		char *limited = g_strdup_printf("(*LIMIT_MATCH=%d)%s", FALLBACK_MATCH_LIMIT, pattern);
+		regex = g_regex_new(limited, G_REGEX_JAVASCRIPT_COMPAT, 0, NULL);
+		g_free(limited);
+		if (!regex)
+			return NULL;
+	}
+
+	RegexMatcher *m = g_new0(RegexMatcher, 1);
+	m->ref_count = 1;
+	m->pattern = g_strdup(pattern);
+	m->program = prog;
+	m->regex = regex;
+	return m;
+}
+
+RegexMatcher* regex_matcher_ref(RegexMatcher *m)
+{
+	if (m)
+		++m->ref_count;
+	return m;
+}
+
+void regex_matcher_unref(RegexMatcher *m)
+{
+	if (!m || --m->ref_count)
+		return;
+	program_free(m->program);
+	if (m->regex)
+		g_regex_unref(m->regex);
+	g_free(m->pattern);
+	g_free(m);
+}
+
+bool regex_matcher_match(RegexMatcher *m, char const *str, size_t len)
+{
+	if (m->program)
+		return program_match(m->program, str, len);
+
+	// Errors of the backtracking matcher, including exceeded
+	// match limit of PCRE, count as mismatch.
+	GError *error = NULL;
+	bool matched = g_regex_match_full(m->regex, str, len, 0, 0, NULL, &error);
+	if (error)
+	{
+		g_error_free(error);
+		return false;
+	}
+	return matched;
+}
+
+char const* regex_matcher_get_pattern(RegexMatcher *m)
+{
+	return m->pattern;
+}
+
+bool regex_matcher_is_linear(RegexMatcher *m)
+{
+	return m->program != NULL;
+}
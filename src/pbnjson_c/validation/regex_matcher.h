@@ -0,0 +1,61 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Compiled regular expression for "pattern" and "patternProperties"
+ *
+ * Patterns in the subset of ECMA-262 syntax commonly used in schemas
+ * (literals, ".", character classes, "\d\w\s" and their negations, groups,
+ * alternation, greedy and lazy quantifiers, "^", "$", "\b", "\B") are compiled
+ * into a Thompson NFA, which is matched in time linear to the length of the input.
+ * Other patterns (backreferences, lookarounds and alike) fall back
+ * to backtracking PCRE matcher of GRegex. Its matches are bounded with
+ * the PCRE match limit, a match which exceeds it counts as mismatch.
+ */
+typedef struct _RegexMatcher RegexMatcher;
+
+/** @brief Compile NULL-terminated ECMA-262 regular expression
+ *
+ * @return New matcher or NULL if the pattern is invalid
+ */
+RegexMatcher* regex_matcher_new(char const *pattern);
+
+/** @brief Increment reference counter. */
+RegexMatcher* regex_matcher_ref(RegexMatcher *m);
+
+/** @brief Decrement reference counter. Once it drops to zero, the matcher is destroyed. */
+void regex_matcher_unref(RegexMatcher *m);
+
+/** @brief Check if the pattern matches somewhere in the given UTF-8 string */
+bool regex_matcher_match(RegexMatcher *m, char const *str, size_t len);
+
+/** @brief Source text of the pattern */
+char const* regex_matcher_get_pattern(RegexMatcher *m);
+
+/** @brief Check if the pattern is matched by the linear time engine */
+bool regex_matcher_is_linear(RegexMatcher *m);
+
+#ifdef __cplusplus
+}
+#endif
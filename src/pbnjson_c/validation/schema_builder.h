@@ -21,6 +21,7 @@
 #ifndef NDEBUG
 #include <stdio.h>
 #endif
+#include <jobject.h>
 
 #include "parser_api.h"
 #include "parser_context.h"
@@ -49,6 +50,7 @@ typedef struct
 {
 	void *parser;
 	ParserContext parser_ctxt;
+	jarena_ref arena;
 } jschema_builder;
 
 /* schema builder manipulation functions interface */
@@ -61,6 +63,8 @@ static inline void jschema_builder_init(jschema_builder *builder)
 			.validator = NULL,
 			.error = SEC_OK,
 		},
+		// Schemas outlive the scopes of arenas, keep their values on the heap
+		.arena = jarena_set_current(NULL),
 	};
 }
 
@@ -70,6 +74,8 @@ static inline void jschema_builder_destroy(jschema_builder *builder)
 	validator_unref(builder->parser_ctxt.validator);
 
 	JsonSchemaParserFree(builder->parser, free);
+
+	jarena_set_current(builder->arena);
 }
 
 static inline bool jschema_builder_is_ok(jschema_builder *builder)
@@ -19,6 +19,7 @@
 #include "parser_context.h"
 #include "combined_types_validator.h"
 #include "combined_validator.h"
+#include "merged_validator.h"
 #include "generic_validator.h"
 #include "feature.h"
 #include "uri_resolver.h"
@@ -113,6 +114,225 @@ static void _visit(Validator *v,
 	}
 }
 
+static ValidatorVtable schema_parsing_vtable;
+
+// Validator of the subschema if its node isn't needed anymore.
+// Nodes with "id" or "definitions" are kept to collect URIs later.
+static Validator* unwrap(Validator *v)
+{
+	if (v->vtable != &schema_parsing_vtable)
+		return v;
+
+	SchemaParsing *s = (SchemaParsing *) v;
+	if (s->id || s->definitions)
+		return v;
+	return s->type_validator;
+}
+
+// Gather branches of "allOf". If the combinator hides inner errors,
+// nested "allOf" and merged validators can be dissolved into it.
+static bool collect_all_of_branches(CombinedValidator *c, bool dissolve, GSList **branches)
+{
+	bool changed = false;
+
+	GSList *it = c->validators;
+	for (; it; it = g_slist_next(it))
+	{
+		Validator *v = unwrap(it->data);
+		changed |= v != it->data;
+
+		if (dissolve && combined_validator_is_all_of(v))
+		{
+			collect_all_of_branches((CombinedValidator *) v, dissolve, branches);
+			changed = true;
+			continue;
+		}
+
+		if (dissolve && merged_validator_is_instance(v))
+		{
+			v = ((MergedValidator *) v)->validator;
+			changed = true;
+		}
+
+		*branches = g_slist_prepend(*branches, v);
+	}
+
+	return changed;
+}
+
+// Merge every branch into the first one it's compatible with
+static GSList* merge_branches(GSList *branches, bool *changed)
+{
+	GSList *res = NULL;
+
+	GSList *it = branches;
+	for (; it; it = g_slist_next(it))
+	{
+		GSList *r = res;
+		for (; r; r = g_slist_next(r))
+		{
+			Validator *merged = validator_merge(r->data, it->data);
+			if (merged)
+			{
+				validator_unref(r->data);
+				r->data = merged;
+				*changed = true;
+				break;
+			}
+		}
+		if (!r)
+			res = g_slist_append(res, validator_ref(it->data));
+	}
+
+	return res;
+}
+
+static Validator* flatten_all_of(CombinedValidator *c)
+{
+	bool suppress = !c->collect_errors;
+
+	GSList *branches = NULL;
+	bool changed = collect_all_of_branches(c, suppress, &branches);
+	GSList *merged = merge_branches(branches, &changed);
+
+	Validator *res = NULL;
+	if (!changed)
+	{
+		g_slist_free_full(merged, _release_validator);
+		res = validator_ref(&c->base);
+	}
+	else if (!merged->next)
+	{
+		// Single validator remains. It still has to report the error and
+		// the default value of the combinator, unless it's a new one,
+		// which hasn't got a default value, and errors are passed through.
+		Validator *v = merged->data;
+		if (suppress || c->def_value || g_slist_find(branches, v))
+		{
+			MergedValidator *m = merged_validator_new(v, suppress ? VEC_NOT_EVERY_ALL_OF : VEC_OK);
+			res = validator_set_default(&m->base, c->def_value);
+		}
+		else
+			res = v;
+		g_slist_free(merged);
+	}
+	else
+	{
+		CombinedValidator *vcomb = all_of_validator_new();
+		vcomb->collect_errors = c->collect_errors;
+		vcomb->validators = merged;
+		res = validator_set_default(&vcomb->base, c->def_value);
+	}
+
+	g_slist_free(branches);
+	return res;
+}
+
+// Dissolve "anyOf" branches into the outer "anyOf"
+static Validator* flatten_any_of(CombinedValidator *c)
+{
+	if (c->collect_errors)
+		return validator_ref(&c->base);
+
+	bool changed = false;
+	GSList *branches = NULL;
+
+	GSList *it = c->validators;
+	for (; it; it = g_slist_next(it))
+	{
+		Validator *v = unwrap(it->data);
+		if (combined_validator_is_any_of(v) &&
+		    !((CombinedValidator *) v)->collect_errors)
+		{
+			GSList *inner = ((CombinedValidator *) v)->validators;
+			for (; inner; inner = g_slist_next(inner))
+				branches = g_slist_prepend(branches, validator_ref(inner->data));
+			changed = true;
+		}
+		else
+			branches = g_slist_prepend(branches, validator_ref(it->data));
+	}
+
+	if (!changed)
+	{
+		g_slist_free_full(branches, _release_validator);
+		return validator_ref(&c->base);
+	}
+
+	CombinedValidator *vcomb = any_of_validator_new();
+	vcomb->validators = g_slist_reverse(branches);
+	return validator_set_default(&vcomb->base, c->def_value);
+}
+
+// The only subschema of "not"
+static Validator* not_subschema(CombinedValidator *c)
+{
+	Validator *res = NULL;
+
+	GSList *it = c->validators;
+	for (; it; it = g_slist_next(it))
+	{
+		if (it->data == inverse_generic_validator_instance())
+			continue;
+		if (res)
+			return NULL;
+		res = it->data;
+	}
+
+	return res;
+}
+
+// {"not": {"not": X}} is X, which fails with the error of the outer "not"
+static Validator* flatten_not(CombinedValidator *c)
+{
+	if (c->collect_errors)
+		return validator_ref(&c->base);
+
+	Validator *inner = not_subschema(c);
+	inner = inner ? unwrap(inner) : NULL;
+	if (!inner ||
+	    !combined_validator_is_not(inner) ||
+	    ((CombinedValidator *) inner)->collect_errors)
+	{
+		return validator_ref(&c->base);
+	}
+
+	Validator *v = not_subschema((CombinedValidator *) inner);
+	if (!v)
+		return validator_ref(&c->base);
+
+	MergedValidator *m = merged_validator_new(validator_ref(v), VEC_SOME_OF_NOT);
+	return validator_set_default(&m->base, c->def_value);
+}
+
+static gint flattening_enabled = 1;
+
+void schema_parsing_set_flattening(bool enable)
+{
+	g_atomic_int_set(&flattening_enabled, enable);
+}
+
+// Simplify the combinator at compile time. The function consumes the validator
+// and returns either the same one or its replacement.
+static Validator* flatten(Validator *v)
+{
+	if (!g_atomic_int_get(&flattening_enabled))
+		return v;
+
+	Validator *res = NULL;
+	if (combined_validator_is_all_of(v))
+		res = flatten_all_of((CombinedValidator *) v);
+	else if (combined_validator_is_any_of(v))
+		res = flatten_any_of((CombinedValidator *) v);
+	else if (combined_validator_is_not(v))
+		res = flatten_not((CombinedValidator *) v);
+	else
+		return v;
+
+	validator_unref(v);
+	return res;
+}
+
 static void _combine(char const *key, Validator *v, void *ctxt, Validator **new_v)
 {
 	SchemaParsing *s = (SchemaParsing *) v;
@@ -127,6 +347,10 @@ static void _combine(char const *key, Validator *v, void *ctxt, Validator **new_
 	}
 
 	GSList *it = s->validator_combinators;
+	for (; it; it = g_slist_next(it))
+		it->data = flatten(it->data);
+
+	it = s->validator_combinators;
 	while (it)
 	{
 		// If there was no type validator, consider the first element as one.
@@ -154,6 +378,9 @@ static void _combine(char const *key, Validator *v, void *ctxt, Validator **new_
 	}
 	s->validator_combinators = NULL;
 
+	if (vcomb)
+		s->type_validator = flatten(s->type_validator);
+
 	if (s->extends)
 	{
 		vcomb = all_of_validator_new();
@@ -161,7 +388,7 @@ static void _combine(char const *key, Validator *v, void *ctxt, Validator **new_
 		s->extends = NULL;
 		if (s->type_validator)
 			combined_validator_add_value(vcomb, s->type_validator);
-		s->type_validator = &vcomb->base;
+		s->type_validator = flatten(&vcomb->base);
 	}
 }
 
@@ -209,9 +436,7 @@ static void _collect_schemas(Validator *v, void *ctxt)
 	UriScope *uri_scope = (UriScope *) ctxt;
 
 	// collect root schema
-	int chars_required = uri_scope_get_document_length(uri_scope);
-	char buffer[chars_required];
-	char const *document = uri_scope_get_document(uri_scope, buffer, chars_required);
+	char const *document = uri_scope_peek_document(uri_scope);
 	char const *fragment = uri_scope_get_fragment(uri_scope);
 
 	if (!uri_resolver_add_validator(uri_scope->uri_resolver, document, fragment, s->type_validator))
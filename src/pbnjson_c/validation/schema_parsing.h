@@ -117,6 +117,13 @@ void schema_parsing_add_combinator(SchemaParsing *s, Validator *v);
 
 void schema_parsing_set_extends(SchemaParsing *s, Validator *extends);
 
+/** @brief Turn compile time flattening of "allOf", "anyOf", "not" and "extends" on or off.
+ *
+ * It's on by default. The setting affects schemas parsed afterwards, it's meant
+ * for the tests comparing both ways.
+ */
+void schema_parsing_set_flattening(bool enable);
+
 #ifdef __cplusplus
 }
 #endif
@@ -57,12 +57,7 @@ static bool _check_conditions(StringValidator *v, ValidationEvent const *e,
 
 	if (v->pattern)
 	{
-		size_t len = e->value.string.len;
-		char buf[len + 1];
-		memcpy(buf, e->value.string.ptr, len);
-		buf[len] = 0;
-		bool res = g_regex_match(v->pattern, buf, 0, NULL);
-		if (!res)
+		if (!regex_matcher_match(v->pattern, e->value.string.ptr, e->value.string.len))
 		{
 			validation_state_notify_error(s, VEC_STRING_NOT_PATTERN, c);
 			return false;
@@ -181,6 +176,52 @@ static bool equals(Validator *v, Validator *other)
 	return false;
 }
 
+static ValidatorVtable generic_string_vtable;
+static ValidatorVtable string_vtable;
+
+static void merge_constraints(StringValidator *s, StringValidator *src)
+{
+	if (!src)
+		return;
+
+	if (src->min_length >= 0 && src->min_length > s->min_length)
+		s->min_length = src->min_length;
+	if (src->max_length >= 0 && (s->max_length < 0 || src->max_length < s->max_length))
+		s->max_length = src->max_length;
+	if (src->pattern && !s->pattern)
+		string_validator_set_pattern(s, src->pattern);
+}
+
+static Validator* merge(Validator *v, Validator *other)
+{
+	if (other->vtable != &string_vtable &&
+	    other->vtable != &generic_string_vtable)
+	{
+		return NULL;
+	}
+
+	StringValidator *s1 = v->vtable == &string_vtable ? (StringValidator *) v : NULL;
+	StringValidator *s2 = other->vtable == &string_vtable ? (StringValidator *) other : NULL;
+
+	if (!s1 || !s2)
+		return validator_ref(s1 ? v : other);
+
+	// Exact values come from enums, and two regular expressions can't be
+	// joined into one without changing their syntax.
+	if (s1->expected_value || s2->expected_value)
+		return NULL;
+	if (s1->pattern && s2->pattern &&
+	    g_strcmp0(regex_matcher_get_pattern(s1->pattern), regex_matcher_get_pattern(s2->pattern)) != 0)
+	{
+		return NULL;
+	}
+
+	StringValidator *s = string_validator_new();
+	merge_constraints(s, s1);
+	merge_constraints(s, s2);
+	return &s->base;
+}
+
 static ValidatorVtable generic_string_vtable =
 {
 	.check = check_generic,
@@ -188,6 +229,7 @@ static ValidatorVtable generic_string_vtable =
 	.set_string_min_length = set_min_length_generic,
 	.set_string_pattern = set_pattern_generic,
 	.set_default = set_default_generic,
+	.merge = merge,
 	.dump_enter = dump_enter,
 };
 
@@ -202,6 +244,7 @@ static ValidatorVtable string_vtable =
 	.set_string_pattern = set_pattern,
 	.set_default = set_default,
 	.get_default = get_default,
+	.merge = merge,
 	.dump_enter = dump_enter,
 };
 
@@ -219,8 +262,7 @@ void string_validator_release(StringValidator *v)
 {
 	g_free(v->expected_value);
 	j_release(&v->def_value);
-	if (v->pattern)
-		g_regex_unref(v->pattern);
+	regex_matcher_unref(v->pattern);
 	g_free(v);
 }
 
@@ -234,11 +276,10 @@ void string_validator_add_max_length_constraint(StringValidator *v, size_t max_l
 	v->max_length = max_length;
 }
 
-void string_validator_set_pattern(StringValidator *v, GRegex *pattern)
+void string_validator_set_pattern(StringValidator *v, RegexMatcher *pattern)
 {
-	if (v->pattern)
-		g_regex_unref(v->pattern);
-	v->pattern = g_regex_ref(pattern);
+	regex_matcher_unref(v->pattern);
+	v->pattern = regex_matcher_ref(pattern);
 }
 
 void string_validator_add_expected_value(StringValidator *v, StringSpan *span)
@@ -17,6 +17,7 @@
 #pragma once
 
 #include "validator.h"
+#include "regex_matcher.h"
 #include <glib.h>
 #include <stddef.h>
 
@@ -37,7 +38,7 @@ typedef struct _StringValidator
 	int min_length;        /**< @brief Minimal string length from {"minLength": ...} */
 	int max_length;        /**< @brief Maximal string length from {"maxLength": ...} */
 
-	GRegex *pattern;       /**< @brief Regex pattern to match string against from {"pattern": ...} */
+	RegexMatcher *pattern; /**< @brief Regex pattern to match string against from {"pattern": ...} */
 } StringValidator;
 
 //_Static_assert(offsetof(StringValidator, base) == 0, "Addresses of StringValidator and StringValidator.base should be equal");
@@ -58,7 +59,7 @@ void string_validator_add_min_length_constraint(StringValidator *v, size_t min_l
 void string_validator_add_max_length_constraint(StringValidator *v, size_t max_length);
 
 /** @brief Remember string validation pattern */
-void string_validator_set_pattern(StringValidator *v, GRegex *pattern);
+void string_validator_set_pattern(StringValidator *v, RegexMatcher *pattern);
 
 /** @brief Remember expected value (for enums) */
 void string_validator_add_expected_value(StringValidator *v, StringSpan *span);
@@ -0,0 +1,265 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "../parser_api.h"
+#include "../uri_resolver.h"
+#include "../validation_api.h"
+#include "../combined_validator.h"
+#include "../merged_validator.h"
+#include "../object_validator.h"
+#include "../object_required.h"
+#include <gtest/gtest.h>
+
+using namespace std;
+
+class TestFlattening : public ::testing::Test
+{
+protected:
+	Validator *v;
+	ValidationError error;
+
+	virtual void SetUp()
+	{
+		v = NULL;
+	}
+
+	virtual void TearDown()
+	{
+		validator_unref(v), v = NULL;
+	}
+
+	Validator *merged()
+	{
+		if (!merged_validator_is_instance(v))
+			return NULL;
+		return ((MergedValidator *) v)->validator;
+	}
+};
+
+TEST_F(TestFlattening, Objects)
+{
+	v = parse_schema_bare(R"schema({"allOf": [
+		{"type": "object", "properties": {"a": {"type": "integer"}}, "required": ["a"]},
+		{"type": "object", "properties": {"b": {"type": "string"}}, "maxProperties": 3},
+		{"type": "object", "minProperties": 2, "required": ["b"]}
+	]})schema");
+	ASSERT_TRUE(v != NULL);
+
+	ObjectValidator *o = (ObjectValidator *) merged();
+	ASSERT_TRUE(o != NULL);
+	EXPECT_EQ(2, o->min_properties);
+	EXPECT_EQ(3, o->max_properties);
+	EXPECT_EQ(2U, object_required_size(o->required));
+
+	EXPECT_TRUE(validate_json_plain(R"({"a": 1, "b": "x"})", v));
+	EXPECT_TRUE(validate_json_plain(R"({"a": 1, "b": "x", "c": null})", v));
+	EXPECT_FALSE(validate_json(R"({"a": 1, "b": "x", "c": null, "d": 0})", v, NULL, &error));
+	EXPECT_EQ(VEC_NOT_EVERY_ALL_OF, error.error);
+	EXPECT_FALSE(validate_json(R"({"a": 1})", v, NULL, &error));
+	EXPECT_EQ(VEC_NOT_EVERY_ALL_OF, error.error);
+	EXPECT_FALSE(validate_json(R"({"a": "x", "b": "x"})", v, NULL, &error));
+	EXPECT_EQ(VEC_NOT_EVERY_ALL_OF, error.error);
+	EXPECT_FALSE(validate_json(R"({"a": 1, "b": 2})", v, NULL, &error));
+	EXPECT_EQ(VEC_NOT_EVERY_ALL_OF, error.error);
+	EXPECT_FALSE(validate_json("[]", v, NULL, &error));
+	EXPECT_EQ(VEC_NOT_EVERY_ALL_OF, error.error);
+}
+
+TEST_F(TestFlattening, OverlappingProperties)
+{
+	v = parse_schema_bare(R"schema({"allOf": [
+		{"type": "object", "properties": {"a": {"type": "integer"}}},
+		{"type": "object", "properties": {"a": {"minimum": 2}}}
+	]})schema");
+	ASSERT_TRUE(v != NULL);
+	EXPECT_TRUE(combined_validator_is_all_of(v));
+
+	EXPECT_TRUE(validate_json_plain(R"({"a": 2})", v));
+	EXPECT_FALSE(validate_json_plain(R"({"a": 1})", v));
+	EXPECT_FALSE(validate_json_plain(R"({"a": 2.5})", v));
+}
+
+TEST_F(TestFlattening, Numbers)
+{
+	v = parse_schema_bare(R"schema({"allOf": [
+		{"type": "number", "minimum": 1, "maximum": 10},
+		{"type": "integer", "maximum": 10, "exclusiveMaximum": true},
+		{"type": "number", "minimum": 3, "multipleOf": 3}
+	]})schema");
+	ASSERT_TRUE(v != NULL);
+	EXPECT_TRUE(merged() != NULL);
+
+	EXPECT_TRUE(validate_json_plain("3", v));
+	EXPECT_TRUE(validate_json_plain("9", v));
+	EXPECT_FALSE(validate_json_plain("0", v));
+	EXPECT_FALSE(validate_json_plain("4", v));
+	EXPECT_FALSE(validate_json_plain("4.5", v));
+	EXPECT_FALSE(validate_json_plain("12", v));
+	EXPECT_FALSE(validate_json(R"("3")", v, NULL, &error));
+	EXPECT_EQ(VEC_NOT_EVERY_ALL_OF, error.error);
+}
+
+TEST_F(TestFlattening, Strings)
+{
+	v = parse_schema_bare(R"schema({"allOf": [
+		{"type": "string", "minLength": 2},
+		{"type": "string", "maxLength": 4, "pattern": "^a"},
+		{}
+	]})schema");
+	ASSERT_TRUE(v != NULL);
+	EXPECT_TRUE(merged() != NULL);
+
+	EXPECT_TRUE(validate_json_plain(R"("ab")", v));
+	EXPECT_TRUE(validate_json_plain(R"("abcd")", v));
+	EXPECT_FALSE(validate_json_plain(R"("a")", v));
+	EXPECT_FALSE(validate_json_plain(R"("abcde")", v));
+	EXPECT_FALSE(validate_json_plain(R"("bcd")", v));
+	EXPECT_FALSE(validate_json_plain("null", v));
+}
+
+TEST_F(TestFlattening, Arrays)
+{
+	v = parse_schema_bare(R"schema({"allOf": [
+		{"type": "array", "items": {"type": "integer"}, "minItems": 1},
+		{"type": "array", "maxItems": 2}
+	]})schema");
+	ASSERT_TRUE(v != NULL);
+	EXPECT_TRUE(merged() != NULL);
+
+	EXPECT_TRUE(validate_json_plain("[1]", v));
+	EXPECT_TRUE(validate_json_plain("[1, 2]", v));
+	EXPECT_FALSE(validate_json_plain("[]", v));
+	EXPECT_FALSE(validate_json_plain("[1, 2, 3]", v));
+	EXPECT_FALSE(validate_json_plain(R"(["1"])", v));
+}
+
+TEST_F(TestFlattening, Extends)
+{
+	v = parse_schema_bare(R"schema({
+		"type": "string", "maxLength": 3,
+		"extends": {"type": "string", "minLength": 2}
+	})schema");
+	ASSERT_TRUE(v != NULL);
+	EXPECT_TRUE(merged() != NULL);
+
+	EXPECT_TRUE(validate_json_plain(R"("abc")", v));
+	EXPECT_FALSE(validate_json(R"("abcd")", v, NULL, &error));
+	EXPECT_EQ(VEC_NOT_EVERY_ALL_OF, error.error);
+	EXPECT_FALSE(validate_json(R"("a")", v, NULL, &error));
+	EXPECT_EQ(VEC_NOT_EVERY_ALL_OF, error.error);
+}
+
+TEST_F(TestFlattening, PartialMerge)
+{
+	v = parse_schema_bare(R"schema({"allOf": [
+		{"type": "object", "minProperties": 1},
+		{"type": ["object", "null"]},
+		{"type": "object", "maxProperties": 1}
+	]})schema");
+	ASSERT_TRUE(v != NULL);
+	ASSERT_TRUE(combined_validator_is_all_of(v));
+	EXPECT_EQ(2U, g_slist_length(((CombinedValidator *) v)->validators));
+
+	EXPECT_TRUE(validate_json_plain(R"({"a": 1})", v));
+	EXPECT_FALSE(validate_json_plain("{}", v));
+	EXPECT_FALSE(validate_json_plain("null", v));
+	EXPECT_FALSE(validate_json(R"({"a": 1, "b": 2})", v, NULL, &error));
+	EXPECT_EQ(VEC_NOT_EVERY_ALL_OF, error.error);
+}
+
+TEST_F(TestFlattening, NestedAllOf)
+{
+	v = parse_schema_bare(R"schema({"allOf": [
+		{"allOf": [{"type": "integer"}, {"minimum": 0}]},
+		{"allOf": [{"type": "number", "maximum": 5}, {"type": "number", "minimum": 1}]}
+	]})schema");
+	ASSERT_TRUE(v != NULL);
+
+	EXPECT_TRUE(validate_json_plain("1", v));
+	EXPECT_TRUE(validate_json_plain("5", v));
+	EXPECT_FALSE(validate_json_plain("0", v));
+	EXPECT_FALSE(validate_json_plain("2.5", v));
+	EXPECT_FALSE(validate_json(R"(6)", v, NULL, &error));
+	EXPECT_EQ(VEC_NOT_EVERY_ALL_OF, error.error);
+}
+
+TEST_F(TestFlattening, References)
+{
+	UriResolver *u = uri_resolver_new();
+	v = parse_schema(R"schema({
+		"definitions": {"base": {"type": "object", "required": ["a"]}},
+		"allOf": [
+			{"$ref": "#/definitions/base"},
+			{"type": "object", "properties": {"a": {"type": "boolean"}}},
+			{"type": "object", "maxProperties": 1}
+		]
+	})schema", u, "file://test.json", NULL, NULL);
+	ASSERT_TRUE(v != NULL);
+	ASSERT_TRUE(combined_validator_is_all_of(v));
+	EXPECT_EQ(2U, g_slist_length(((CombinedValidator *) v)->validators));
+
+	EXPECT_TRUE(validate_json(R"({"a": true})", v, u, NULL));
+	EXPECT_FALSE(validate_json(R"({})", v, u, NULL));
+	EXPECT_FALSE(validate_json(R"({"a": 1})", v, u, NULL));
+	EXPECT_FALSE(validate_json(R"({"a": true, "b": 1})", v, u, NULL));
+
+	uri_resolver_free(u);
+}
+
+TEST_F(TestFlattening, NestedAnyOf)
+{
+	v = parse_schema_bare(R"schema({"anyOf": [
+		{"anyOf": [{"type": "null"}, {"type": "boolean"}]},
+		{"type": "string"}
+	]})schema");
+	ASSERT_TRUE(v != NULL);
+	ASSERT_TRUE(combined_validator_is_any_of(v));
+	EXPECT_EQ(3U, g_slist_length(((CombinedValidator *) v)->validators));
+
+	EXPECT_TRUE(validate_json_plain("null", v));
+	EXPECT_TRUE(validate_json_plain("true", v));
+	EXPECT_TRUE(validate_json_plain(R"("s")", v));
+	EXPECT_FALSE(validate_json(R"(1)", v, NULL, &error));
+	EXPECT_EQ(VEC_NEITHER_OF_ANY, error.error);
+}
+
+TEST_F(TestFlattening, DoubleNot)
+{
+	v = parse_schema_bare(R"schema({"not": {"not": {"type": "object", "required": ["a"]}}})schema");
+	ASSERT_TRUE(v != NULL);
+	EXPECT_TRUE(merged() != NULL);
+
+	EXPECT_TRUE(validate_json_plain(R"({"a": {"b": [1]}})", v));
+	EXPECT_FALSE(validate_json(R"({"b": 1})", v, NULL, &error));
+	EXPECT_EQ(VEC_SOME_OF_NOT, error.error);
+	EXPECT_FALSE(validate_json(R"([])", v, NULL, &error));
+	EXPECT_EQ(VEC_SOME_OF_NOT, error.error);
+}
+
+TEST_F(TestFlattening, ImplicitAllOfKeepsErrors)
+{
+	v = parse_schema_bare(R"schema({
+		"type": "integer", "maximum": 10,
+		"allOf": [{"type": "number", "minimum": 0}]
+	})schema");
+	ASSERT_TRUE(v != NULL);
+
+	EXPECT_TRUE(validate_json_plain("5", v));
+	EXPECT_FALSE(validate_json(R"(11)", v, NULL, &error));
+	EXPECT_EQ(VEC_NUMBER_TOO_BIG, error.error);
+	EXPECT_FALSE(validate_json(R"(1.5)", v, NULL, &error));
+	EXPECT_EQ(VEC_NOT_INTEGER_NUMBER, error.error);
+}
@@ -321,8 +321,9 @@ TEST_F(TestArrayValidator, SpecificValidatorsLessThanNeeded)
 	ASSERT_EQ(2U, array_items_items_length(v->items));
 	EXPECT_EQ(2U, ((NumberValidator *)vnum.get())->ref_count);
 	EXPECT_EQ(2U, ((StringValidator *)vstr.get())->ref_count);
-	EXPECT_EQ(vnum.get(), v->items->validators->data);
-	EXPECT_EQ(vstr.get(), g_list_last(v->items->validators)->data);
+	EXPECT_EQ(vnum.get(), array_items_get_item(v->items, 0));
+	EXPECT_EQ(vstr.get(), array_items_get_item(v->items, 1));
+	EXPECT_EQ(NULL, array_items_get_item(v->items, 2));
 
 	EXPECT_TRUE(validation_check(&(e = validation_event_arr_start()), s, NULL));
 	EXPECT_EQ(1U, g_slist_length(s->validator_stack));
@@ -429,6 +430,28 @@ TEST_F(TestArrayValidator, AdditionalItemsNegative)
 	EXPECT_EQ(0U, g_slist_length(s->validator_stack));
 }
 
+TEST_F(TestArrayValidator, LongTuple)
+{
+	auto vstr = mk_ptr((Validator *)string_validator_new(), validator_unref);
+	auto vnum = mk_ptr((Validator *)number_validator_new(), validator_unref);
+	for (int i = 0; i < 300; ++i)
+		array_items_add_item(items, validator_ref(i % 2 ? vnum.get() : vstr.get()));
+	validator_set_array_additional_items(&v->base, NULL);
+	ASSERT_EQ(300U, array_items_items_length(items));
+
+	EXPECT_TRUE(validation_check(&(e = validation_event_arr_start()), s, NULL));
+	for (int i = 0; i < 300; ++i)
+	{
+		if (i % 2)
+			ASSERT_TRUE(validation_check(&(e = validation_event_number("1", 1)), s, NULL));
+		else
+			ASSERT_TRUE(validation_check(&(e = validation_event_string("a", 1)), s, NULL));
+	}
+	EXPECT_FALSE(validation_check(&(e = validation_event_string("a", 1)), s, this));
+	EXPECT_EQ(VEC_ARRAY_TOO_LONG, error);
+	EXPECT_EQ(0U, g_slist_length(s->validator_stack));
+}
+
 TEST_F(TestArrayValidator, OnlyEmptyArrayAllowedPositive)
 {
 	array_items_set_zero_items(items);
@@ -0,0 +1,130 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "../parser_api.h"
+#include "../schema_parsing.h"
+#include "../validation_api.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+const int LAYERS = 8;
+const int RECORDS = 100;
+const int REPEATS = 200;
+const int SAMPLES = 5;
+
+// Every layer extends the previous one and adds an allOf of its own:
+// {"type": "object", "properties": {"f<i>": ...}, "required": ["f<i>"],
+//  "extends": <layer i - 1>, "allOf": [{"properties": {"s<i>": ...}}, {"minProperties": ...}]}
+string LayeredSchema(int layers)
+{
+	string layer;
+	for (int i = 0; i < layers; ++i)
+	{
+		string n = to_string(i);
+		string next = R"({"type": "object", "properties": {"f)" + n +
+			R"(": {"type": "integer", "minimum": 0, "maximum": 1000}}, "required": ["f)" + n + R"("], )";
+		if (!layer.empty())
+			next += R"("extends": )" + layer + ", ";
+		next += R"("allOf": [{"type": "object", "properties": {"s)" + n +
+			R"(": {"type": "string", "maxLength": 32}}}, {"type": "object", "minProperties": )" +
+			to_string(2 * i + 1) + "}]}";
+		layer = next;
+	}
+	return R"({"type": "array", "items": )" + layer + "}";
+}
+
+string Records(int layers, int records, bool valid)
+{
+	string doc = "[";
+	for (int r = 0; r < records; ++r)
+	{
+		doc += r ? ", {" : "{";
+		// The last record of the invalid document lacks the first required property
+		bool skip = !valid && r == records - 1;
+		for (int i = skip ? 1 : 0; i < layers; ++i)
+		{
+			string n = to_string(i);
+			doc += (i > (skip ? 1 : 0) ? ", \"f" : "\"f") + n + "\": " + to_string(r % 1000) +
+				", \"s" + n + "\": \"record " + to_string(r) + "\"";
+		}
+		doc += "}";
+	}
+	return doc + "]";
+}
+
+Validator *ParseLayered(bool flattening)
+{
+	schema_parsing_set_flattening(flattening);
+	Validator *v = parse_schema_bare(LayeredSchema(LAYERS).c_str());
+	schema_parsing_set_flattening(true);
+	return v;
+}
+
+// The best of several samples, microseconds per validated document
+double Measure(Validator *v, const string &doc)
+{
+	double best = 0;
+	for (int s = 0; s < SAMPLES; ++s)
+	{
+		auto start = chrono::steady_clock::now();
+		for (int i = 0; i < REPEATS; ++i)
+			validate_json_n(doc.data(), doc.size(), v, NULL, NULL);
+		chrono::duration<double, micro> took = chrono::steady_clock::now() - start;
+		double sample = took.count() / REPEATS;
+		best = s ? min(best, sample) : sample;
+	}
+	return best;
+}
+
+} // namespace
+
+TEST(FlatteningPerformance, LayeredAllOfExtends)
+{
+	Validator *flat = ParseLayered(true);
+	Validator *nested = ParseLayered(false);
+	ASSERT_TRUE(flat != NULL);
+	ASSERT_TRUE(nested != NULL);
+
+	const string valid = Records(LAYERS, RECORDS, true);
+	const string invalid = Records(LAYERS, RECORDS, false);
+
+	// Both ways have to agree before their timing is worth comparing
+	EXPECT_TRUE(validate_json_plain(valid.c_str(), flat));
+	EXPECT_TRUE(validate_json_plain(valid.c_str(), nested));
+	EXPECT_FALSE(validate_json_plain(invalid.c_str(), flat));
+	EXPECT_FALSE(validate_json_plain(invalid.c_str(), nested));
+
+	double flat_us = Measure(flat, valid);
+	double nested_us = Measure(nested, valid);
+
+	cout << "Validation of " << RECORDS << " records against " << LAYERS
+	     << " layers of allOf/extends, microseconds per document, smaller is better:" << endl;
+	cout << fixed << setprecision(1)
+	     << "  flattening on:  " << flat_us << endl
+	     << "  flattening off: " << nested_us << endl
+	     << "  speedup:        " << setprecision(2) << nested_us / flat_us << "x" << endl;
+
+	validator_unref(nested);
+	validator_unref(flat);
+}
@@ -16,6 +16,8 @@
 
 #include "../number.h"
 #include <gtest/gtest.h>
+#include <climits>
+#include <cstdlib>
 
 
 TEST(Number, IsInteger)
@@ -30,3 +32,112 @@ TEST(Number, IsInteger)
 	EXPECT_FALSE(number_is_integer(&n));
 	number_clear(&n);
 }
+
+namespace {
+
+struct TestNumber
+{
+	TestNumber(char const *str) { number_init(&n); EXPECT_EQ(0, number_set(&n, str)) << str; }
+	~TestNumber() { number_clear(&n); }
+	Number n;
+};
+
+int compare(char const *a, char const *b)
+{
+	TestNumber na(a), nb(b);
+	return number_compare(&na.n, &nb.n);
+}
+
+bool multiple(char const *a, char const *b)
+{
+	TestNumber na(a), nb(b);
+	return number_is_multiple_of(&na.n, &nb.n);
+}
+
+size_t allocations = 0;
+
+void *count_alloc(size_t size) { ++allocations; return malloc(size); }
+void *count_realloc(void *ptr, size_t, size_t size) { ++allocations; return realloc(ptr, size); }
+void count_free(void *ptr, size_t) { free(ptr); }
+
+} // namespace
+
+TEST(Number, Compare)
+{
+	EXPECT_EQ(0, compare("1", "1.0"));
+	EXPECT_EQ(0, compare("100", "1e2"));
+	EXPECT_EQ(0, compare("0.001", "1E-3"));
+	EXPECT_EQ(0, compare("-0", "0"));
+	EXPECT_EQ(-1, compare("-1", "0"));
+	EXPECT_EQ(1, compare("0", "-0.5"));
+	EXPECT_EQ(-1, compare("-2", "-1"));
+	EXPECT_EQ(-1, compare("0.1", "0.10000000000000001"));
+	EXPECT_EQ(1, compare("123.456", "123.45599"));
+	EXPECT_EQ(-1, compare("99", "1e2"));
+	EXPECT_EQ(1, compare("9223372036854775808", "9223372036854775807"));
+
+	// More digits than the mantissa holds
+	EXPECT_EQ(-1, compare("1234567890123456789012345", "1234567890123456789012346"));
+	EXPECT_EQ(1, compare("1234567890123456789012345", "1e24"));
+	EXPECT_EQ(0, compare("12345678901234567890000", "1234567890123456789e4"));
+}
+
+TEST(Number, MultipleOf)
+{
+	EXPECT_TRUE(multiple("0.3", "0.1"));
+	EXPECT_TRUE(multiple("4.35", "0.05"));
+	EXPECT_TRUE(multiple("10", "2.5"));
+	EXPECT_TRUE(multiple("0", "7"));
+	EXPECT_TRUE(multiple("-21", "7"));
+	EXPECT_TRUE(multiple("1e10", "1024"));
+	EXPECT_FALSE(multiple("1e9", "1024"));
+	EXPECT_FALSE(multiple("0.35", "0.1"));
+	EXPECT_FALSE(multiple("1", "3"));
+	EXPECT_FALSE(multiple("0.1", "0.3"));
+	EXPECT_TRUE(multiple("19.99", "0.01"));
+}
+
+TEST(Number, Long)
+{
+	TestNumber max("9223372036854775807"), min("-9223372036854775808"), over("9223372036854775808");
+	EXPECT_TRUE(number_fits_long(&max.n));
+	EXPECT_EQ(LONG_MAX, number_get_long(&max.n));
+	EXPECT_TRUE(number_fits_long(&min.n));
+	EXPECT_EQ(LONG_MIN, number_get_long(&min.n));
+	EXPECT_FALSE(number_fits_long(&over.n));
+
+	TestNumber fraction("-12.75"), exponent("42e3");
+	EXPECT_TRUE(number_fits_long(&fraction.n));
+	EXPECT_EQ(-12, number_get_long(&fraction.n));
+	EXPECT_EQ(42000, number_get_long(&exponent.n));
+}
+
+TEST(Number, Invalid)
+{
+	Number n;
+	number_init(&n);
+	EXPECT_NE(0, number_set(&n, "abc"));
+	EXPECT_NE(0, number_set_n(&n, "1.5x", 4));
+	EXPECT_EQ(0, number_set_n(&n, "1.5x", 3));
+	number_clear(&n);
+}
+
+TEST(Number, NoAllocation)
+{
+	void *(*alloc)(size_t);
+	void *(*realloc)(void *, size_t, size_t);
+	void (*free)(void *, size_t);
+	mp_get_memory_functions(&alloc, &realloc, &free);
+	mp_set_memory_functions(count_alloc, count_realloc, count_free);
+
+	allocations = 0;
+	{
+		TestNumber value("12.30"), min("-1e3"), step("0.1");
+		number_compare(&value.n, &min.n);
+		number_is_multiple_of(&value.n, &step.n);
+		number_is_integer(&value.n);
+	}
+	EXPECT_EQ(0u, allocations);
+
+	mp_set_memory_functions(alloc, realloc, free);
+}
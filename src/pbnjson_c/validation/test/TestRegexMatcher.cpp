@@ -0,0 +1,175 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include "../regex_matcher.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <memory>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+typedef unique_ptr<RegexMatcher, void(*)(RegexMatcher *)> MatcherPtr;
+
+MatcherPtr mk_matcher(char const *pattern)
+{
+	return MatcherPtr(regex_matcher_new(pattern), regex_matcher_unref);
+}
+
+bool matches(char const *pattern, string const &str)
+{
+	auto m = mk_matcher(pattern);
+	EXPECT_TRUE(m.get() != nullptr) << pattern;
+	if (!m)
+		return false;
+	return regex_matcher_match(m.get(), str.data(), str.size());
+}
+
+bool is_linear(char const *pattern)
+{
+	auto m = mk_matcher(pattern);
+	return m && regex_matcher_is_linear(m.get());
+}
+
+} // namespace
+
+TEST(TestRegexMatcher, Invalid)
+{
+	EXPECT_TRUE(regex_matcher_new("(") == nullptr);
+	EXPECT_TRUE(regex_matcher_new("[a") == nullptr);
+	EXPECT_TRUE(regex_matcher_new("a{3,1}") == nullptr);
+}
+
+TEST(TestRegexMatcher, Linear)
+{
+	EXPECT_TRUE(is_linear(""));
+	EXPECT_TRUE(is_linear("^a[bcd]?$"));
+	EXPECT_TRUE(is_linear("^\\d+$"));
+	EXPECT_TRUE(is_linear("^[-+]?[0-9]*\\.?[0-9]+([eE][-+]?[0-9]+)?$"));
+	EXPECT_TRUE(is_linear("^(?:[a-z0-9_]+\\.)*[a-z0-9_]+$"));
+	EXPECT_TRUE(is_linear("^(a+)+$"));
+	EXPECT_TRUE(is_linear("\\bfoo\\B|x{2,5}?"));
+
+	// Back references and lookarounds are left to PCRE
+	EXPECT_FALSE(is_linear("(a)\\1"));
+	EXPECT_FALSE(is_linear("a(?=b)"));
+	EXPECT_FALSE(is_linear("a(?!b)"));
+
+	// So are POSIX classes inside brackets
+	EXPECT_FALSE(is_linear("^[[:alpha:]]+$"));
+	EXPECT_FALSE(is_linear("^[_[:digit:]]$"));
+}
+
+TEST(TestRegexMatcher, Search)
+{
+	EXPECT_TRUE(matches("", ""));
+	EXPECT_TRUE(matches("", "abc"));
+	EXPECT_TRUE(matches("b", "abc"));
+	EXPECT_FALSE(matches("d", "abc"));
+	EXPECT_TRUE(matches("^ab", "abc"));
+	EXPECT_FALSE(matches("^bc", "abc"));
+	EXPECT_TRUE(matches("bc$", "abc"));
+	EXPECT_TRUE(matches("bc$", "abc\n"));
+	EXPECT_FALSE(matches("ab$", "abc"));
+	EXPECT_TRUE(matches("^$", ""));
+	EXPECT_FALSE(matches("^$", "a"));
+	EXPECT_TRUE(matches("x|^b|c", "abc"));
+	EXPECT_FALSE(matches("x|^b", "abc"));
+}
+
+TEST(TestRegexMatcher, Syntax)
+{
+	EXPECT_TRUE(matches("^a[bcd]?$", "a"));
+	EXPECT_TRUE(matches("^a[bcd]?$", "ac"));
+	EXPECT_FALSE(matches("^a[bcd]?$", "ae"));
+	EXPECT_FALSE(matches("^a[bcd]?$", "acd"));
+
+	EXPECT_TRUE(matches("^[^a-c]+$", "xyz"));
+	EXPECT_FALSE(matches("^[^a-c]+$", "xbz"));
+	EXPECT_TRUE(matches("^[\\d_]+$", "1_2"));
+	EXPECT_FALSE(matches("^[\\d_]+$", "1-2"));
+	EXPECT_TRUE(matches("^\\w\\W\\s\\S\\D$", "a- x_"));
+	EXPECT_TRUE(matches("^a.c$", "abc"));
+	EXPECT_FALSE(matches("^a.c$", "a\nc"));
+	EXPECT_TRUE(matches("^\\x41\\u0042\\.\\t$", "AB.\t"));
+
+	EXPECT_TRUE(matches("^(ab|cd){2}$", "abcd"));
+	EXPECT_FALSE(matches("^(ab|cd){2}$", "ab"));
+	EXPECT_TRUE(matches("^a{2,3}$", "aaa"));
+	EXPECT_FALSE(matches("^a{2,3}$", "aaaa"));
+	EXPECT_FALSE(matches("^a{2,3}$", "a"));
+	EXPECT_TRUE(matches("^a{2,}$", "aaaaa"));
+	EXPECT_FALSE(matches("^a{2,}$", "a"));
+	EXPECT_TRUE(matches("^(?:a|b)*?c$", "ababc"));
+
+	EXPECT_TRUE(matches("\\bfoo\\b", "a foo b"));
+	EXPECT_FALSE(matches("\\bfoo\\b", "afoo"));
+	EXPECT_TRUE(matches("\\Boo", "foo"));
+	EXPECT_FALSE(matches("\\Bfoo", "foo"));
+}
+
+TEST(TestRegexMatcher, Utf8)
+{
+	EXPECT_TRUE(matches("^.$", "\xd0\xaf"));
+	EXPECT_TRUE(matches("^[\xd0\x90-\xd0\xaf]+$", "\xd0\x9f\xd0\xaf"));
+	EXPECT_FALSE(matches("^[\xd0\x90-\xd0\xaf]+$", "\xd0\x9fz"));
+	EXPECT_TRUE(matches("^\\u042f$", "\xd0\xaf"));
+}
+
+TEST(TestRegexMatcher, Fallback)
+{
+	EXPECT_TRUE(matches("^(a+)b\\1$", "aabaa"));
+	EXPECT_FALSE(matches("^(a+)b\\1$", "aaba"));
+	EXPECT_TRUE(matches("^a(?=b)", "ab"));
+	EXPECT_FALSE(matches("^a(?=b)", "ac"));
+	EXPECT_TRUE(matches("^[[:alpha:]]+$", "abC"));
+	EXPECT_FALSE(matches("^[[:alpha:]]+$", "ab1"));
+	EXPECT_TRUE(matches("^[_[:digit:]]+$", "1_2"));
+	EXPECT_FALSE(matches("^[_[:digit:]]+$", "1-2"));
+}
+
+TEST(TestRegexMatcher, NoBacktracking)
+{
+	// Exponential for a backtracking matcher
+	string str(100000, 'a');
+	str += 'b';
+	EXPECT_FALSE(matches("^(a+)+$", str));
+	EXPECT_FALSE(matches("^(a|aa)*$", str));
+	EXPECT_TRUE(matches("^(a|aa)*b$", str));
+}
+
+TEST(TestRegexMatcher, FallbackMatchLimit)
+{
+	// Back reference keeps the pattern on PCRE, where the match limit
+	// stops the exponential search
+	string str(5000, 'a');
+	str += 'b';
+	auto start = chrono::steady_clock::now();
+	EXPECT_FALSE(matches("^(a+)+\\1$", str));
+	EXPECT_LT(chrono::steady_clock::now() - start, chrono::seconds(1));
+
+	EXPECT_TRUE(matches("^(a+)+\\1$", "aaaa"));
+}
+
+TEST(TestRegexMatcher, Embedded)
+{
+	string str("ab\0cd", 5);
+	EXPECT_TRUE(matches("d$", str));
+	EXPECT_TRUE(matches("^ab\\0cd$", str));
+}
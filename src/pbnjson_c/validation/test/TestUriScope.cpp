@@ -80,6 +80,57 @@ TEST(TestUriScope, EmptyBase)
 	uri_scope_free(u);
 }
 
+TEST(TestUriScope, SharedDocuments)
+{
+	UriScope *u = uri_scope_new();
+	ASSERT_TRUE(u != NULL);
+
+	ASSERT_TRUE(uri_scope_push_uri(u, "http://a.b.c/dir/test.json"));
+	char const *root = uri_scope_peek_document(u);
+	EXPECT_STREQ("http://a.b.c/dir/test.json", root);
+	EXPECT_STREQ("#", uri_scope_get_fragment(u));
+
+	// Fragments stay in the same document
+	ASSERT_TRUE(uri_scope_push_uri(u, "#/definitions/a"));
+	EXPECT_EQ(root, uri_scope_peek_document(u));
+	EXPECT_STREQ("#/definitions/a", uri_scope_get_fragment(u));
+	uri_scope_pop_uri(u);
+
+	// Resolved references are reused
+	ASSERT_TRUE(uri_scope_push_uri(u, "../other.json#/x"));
+	char const *other = uri_scope_peek_document(u);
+	EXPECT_STREQ("http://a.b.c/other.json", other);
+	EXPECT_STREQ("#/x", uri_scope_get_fragment(u));
+	uri_scope_pop_uri(u);
+
+	ASSERT_TRUE(uri_scope_push_uri(u, "../other.json#/y"));
+	EXPECT_EQ(other, uri_scope_peek_document(u));
+	EXPECT_STREQ("#/y", uri_scope_get_fragment(u));
+
+	// The same document reached in a different way
+	ASSERT_TRUE(uri_scope_push_uri(u, "/other.json"));
+	EXPECT_EQ(other, uri_scope_peek_document(u));
+	EXPECT_STREQ("#", uri_scope_get_fragment(u));
+	uri_scope_pop_uri(u);
+	uri_scope_pop_uri(u);
+
+	EXPECT_EQ(root, uri_scope_peek_document(u));
+	EXPECT_FALSE(uri_scope_push_uri(u, "a b"));
+	EXPECT_EQ(root, uri_scope_peek_document(u));
+
+	// Fragments are checked as well, even if the document is known
+	EXPECT_FALSE(uri_scope_push_uri(u, "#a b"));
+	EXPECT_FALSE(uri_scope_push_uri(u, "../other.json#a b"));
+	EXPECT_FALSE(uri_scope_push_uri(u, "#a#b"));
+	EXPECT_FALSE(uri_scope_push_uri(u, "#%zz"));
+	EXPECT_EQ(root, uri_scope_peek_document(u));
+	ASSERT_TRUE(uri_scope_push_uri(u, "#/a%20b"));
+	EXPECT_STREQ("#/a%20b", uri_scope_get_fragment(u));
+	uri_scope_pop_uri(u);
+
+	uri_scope_free(u);
+}
+
 TEST(TestUriScope, EscapeJsonPointer)
 {
 	char buffer[64];
@@ -22,78 +22,177 @@
 char const *const ROOT_FRAGMENT = "#";
 char const *const ROOT_DEFINITIONS = "#/definitions";
 
-UriScope *uri_scope_new(void)
+/** @brief Document without fragment, shared by all the URIs referring to it */
+typedef struct _UriDocument
 {
-	UriScope *u = g_new0(UriScope, 1);
-	return u;
+	char *name;             /**< @brief Serialized URI of the document */
+	UriUriA uri;            /**< @brief Parsed name */
+	bool parsed;
+	GHashTable *resolved;   /**< @brief Reference (without fragment) -> UriDocument resolved against this one */
+} UriDocument;
+
+typedef struct _UriScopeEntry
+{
+	UriDocument *document;
+	char const *fragment;   /**< @brief Points into the pushed URI or to ROOT_FRAGMENT */
+} UriScopeEntry;
+
+static void _document_free(gpointer d)
+{
+	UriDocument *document = (UriDocument *) d;
+	if (document->parsed)
+		uriFreeUriMembersA(&document->uri);
+	g_hash_table_destroy(document->resolved);
+	g_free(document->name);
+	g_free(document);
 }
 
-static void _free_uri(gpointer d)
+UriScope *uri_scope_new(void)
 {
-	uriFreeUriMembersA((UriUriA *) d);
-	g_free(d);
+	UriScope *u = g_new0(UriScope, 1);
+	u->documents = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, _document_free);
+	return u;
 }
 
 void uri_scope_free(UriScope *u)
 {
 	if (!u)
 		return;
-	g_slist_free_full(u->uri_stack, _free_uri);
+	g_slist_free_full(u->uri_stack, g_free);
+	g_hash_table_destroy(u->documents);
 	g_free(u);
 }
 
-static UriUriA *uri_scope_get_uri_unsafe(UriScope const *u)
+static UriScopeEntry *uri_scope_get_entry_unsafe(UriScope const *u)
 {
 	assert(u->uri_stack);
-	return (UriUriA *) u->uri_stack->data;
+	return (UriScopeEntry *) u->uri_stack->data;
 }
 
-static UriUriA *uri_scope_get_uri(UriScope const *u)
+static UriScopeEntry *uri_scope_get_entry(UriScope const *u)
 {
 	if (!u->uri_stack)
 		return NULL;
-	return uri_scope_get_uri_unsafe(u);
+	return uri_scope_get_entry_unsafe(u);
 }
 
 char const *uri_scope_get_fragment(UriScope const *u)
 {
-	UriUriA *uri = uri_scope_get_uri_unsafe(u);
-	return uri->fragment.first ? uri->fragment.first - 1 : ROOT_FRAGMENT;
+	return uri_scope_get_entry_unsafe(u)->fragment;
+}
+
+char const *uri_scope_peek_document(UriScope const *u)
+{
+	return uri_scope_get_entry_unsafe(u)->document->name;
 }
 
 int uri_scope_get_document_length(UriScope const *u)
 {
-	UriUriA *uri = uri_scope_get_uri_unsafe(u);
-	int result = 0;
+	return strlen(uri_scope_peek_document(u)) + 1;
+}
 
+char const *uri_scope_get_document(UriScope const *u, char *buffer, int chars_required)
+{
+	char const *document = uri_scope_peek_document(u);
+	size_t length = strlen(document) + 1;
+	if (chars_required < 0 || (size_t) chars_required < length)
+		return NULL;
+	return memcpy(buffer, document, length);
+}
+
+// Serialize URI without fragment
+static char *_uri_to_document_name(UriUriA *uri)
+{
 	UriTextRangeA fragment = uri->fragment;
 	uri->fragment = (UriTextRangeA){};
 
-	if (URI_SUCCESS != uriToStringCharsRequiredA(uri, &result))
+	char *result = NULL;
+	int chars_required = 0;
+	if (URI_SUCCESS == uriToStringCharsRequiredA(uri, &chars_required))
 	{
-		uri->fragment = fragment;
-		return -1;
+		result = g_malloc(chars_required + 1);
+		if (URI_SUCCESS != uriToStringA(result, uri, chars_required + 1, NULL))
+		{
+			g_free(result);
+			result = NULL;
+		}
 	}
+
 	uri->fragment = fragment;
-	return result + 1;
+	return result;
 }
 
-char const *uri_scope_get_document(UriScope const *u, char *buffer, int chars_required)
+// Find the document by name or remember the new one. Takes ownership of the name.
+static UriDocument *_document_intern(UriScope *u, char *name)
 {
-	UriUriA *uri = uri_scope_get_uri_unsafe(u);
+	UriDocument *document = g_hash_table_lookup(u->documents, name);
+	if (document)
+	{
+		g_free(name);
+		return document;
+	}
 
-	// we need to re-construct uri without fragment
-	// to do that we temporary nullify its pointers
-	UriTextRangeA fragment = uri->fragment;
-	uri->fragment = (UriTextRangeA){};
+	document = g_new0(UriDocument, 1);
+	document->name = name;
+	document->resolved = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+
+	// Text ranges of the parsed URI point into the name owned by the document
+	UriParserStateA state;
+	state.uri = &document->uri;
+	document->parsed = URI_SUCCESS == uriParseUriA(&state, name);
+	if (!document->parsed)
+		uriFreeUriMembersA(&document->uri);
+
+	g_hash_table_insert(u->documents, name, document);
+	return document;
+}
+
+// Resolve reference [first, after_last) without fragment against the base document
+static UriDocument *_resolve_document(UriScope *u, UriDocument *base, char const *first, char const *after_last)
+{
+	size_t length = after_last - first;
+	char reference[length + 1];
+	memcpy(reference, first, length);
+	reference[length] = '\0';
+
+	if (base)
+	{
+		UriDocument *document = g_hash_table_lookup(base->resolved, reference);
+		if (document)
+			return document;
+	}
+
+	UriParserStateA state;
+	UriUriA a;
 
-	if (URI_SUCCESS != uriToStringA(buffer, uri, chars_required, NULL))
+	state.uri = &a;
+	if (URI_SUCCESS != uriParseUriExA(&state, reference, reference + length))
 	{
-		uri->fragment = fragment;
+		uriFreeUriMembersA(&a);
 		return NULL;
 	}
-	uri->fragment = fragment; // restore fragment
-	return buffer;
+
+	char *name = NULL;
+	UriUriA result;
+	if (base && base->parsed && URI_SUCCESS == uriAddBaseUriA(&result, &a, &base->uri))
+	{
+		name = _uri_to_document_name(&result);
+		uriFreeUriMembersA(&result);
+	}
+	else
+	{
+		//TODO check that URI is absolute
+		name = _uri_to_document_name(&a);
+	}
+	uriFreeUriMembersA(&a);
+
+	if (!name)
+		return NULL;
+
+	UriDocument *document = _document_intern(u, name);
+	if (base)
+		g_hash_table_insert(base->resolved, g_strdup(reference), document);
+	return document;
 }
 
 char const *escape_json_pointer(char const *fragment, size_t fragment_len, char *buffer)
@@ -168,39 +267,41 @@ char const *unescape_json_pointer(char const *fragment, char *buffer)
 	}
 }
 
-bool uri_scope_push_uri(UriScope *u, char const *uri)
+// Check syntax of the fragment, which the document cache doesn't look at
+static bool _is_valid_fragment(char const *fragment)
 {
 	UriParserStateA state;
 	UriUriA a;
 
 	state.uri = &a;
-	if (URI_SUCCESS != uriParseUriA(&state, uri))
-	{
-		uriFreeUriMembersA(&a);
-		return false;
-	}
+	bool valid = URI_SUCCESS == uriParseUriA(&state, fragment);
+	uriFreeUriMembersA(&a);
+	return valid;
+}
 
-	UriUriA *result = g_new0(UriUriA, 1);
-	UriUriA *base = uri_scope_get_uri(u);
-	if (!base)
-	{
-		//TODO check that URI is absolute
-		memcpy(result, &a, sizeof(a));
+bool uri_scope_push_uri(UriScope *u, char const *uri)
+{
+	// Fragment of the resolved URI is always the fragment of the reference
+	char const *fragment = strchr(uri, '#');
+	char const *reference_end = fragment ? fragment : uri + strlen(uri);
+	UriScopeEntry *top = uri_scope_get_entry(u);
 
-		u->uri_stack = g_slist_prepend(u->uri_stack, result);
-		return true;
-	}
+	if (fragment && !_is_valid_fragment(fragment))
+		return false;
 
-	if (URI_SUCCESS != uriAddBaseUriA(result, &a, base))
-	{
-		memcpy(result, &a, sizeof(a));
+	UriDocument *document = NULL;
+	if (top && reference_end == uri)
+		document = top->document; // same document, like in "#/definitions/a"
+	else
+		document = _resolve_document(u, top ? top->document : NULL, uri, reference_end);
 
-		u->uri_stack = g_slist_prepend(u->uri_stack, result);
-		return true;
-	}
+	if (!document)
+		return false;
 
-	u->uri_stack = g_slist_prepend(u->uri_stack, result);
-	uriFreeUriMembersA(&a);
+	UriScopeEntry *entry = g_new(UriScopeEntry, 1);
+	entry->document = document;
+	entry->fragment = fragment ? fragment : ROOT_FRAGMENT;
+	u->uri_stack = g_slist_prepend(u->uri_stack, entry);
 	return true;
 }
 
@@ -209,7 +310,7 @@ void uri_scope_pop_uri(UriScope *u)
 	if (!u->uri_stack)
 		return;
 	GSList *head = u->uri_stack;
-	_free_uri(head->data);
+	g_free(head->data);
 	u->uri_stack = g_slist_next(u->uri_stack);
 	g_slist_free_1(head);
 }
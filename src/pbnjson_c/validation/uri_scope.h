@@ -30,8 +30,15 @@ typedef struct _UriScope
 {
 	UriResolver *uri_resolver;  /**< @brief UriResolver for convenience */
 
-	/** @brief Stack contains pointers to document URI. */
+	/** @brief Stack of (document, fragment) entries. */
 	GSList *uri_stack;
+
+	/** @brief Parsed documents seen by the scope: name -> document.
+	 *
+	 * Every document remembers references resolved against it, so each
+	 * base URI is parsed and each reference is resolved only once.
+	 */
+	GHashTable *documents;
 } UriScope;
 
 /** @brief Constructor */
@@ -52,6 +59,12 @@ int uri_scope_get_document_length(UriScope const *u);
  */
 char const *uri_scope_get_document(UriScope const *u, char *buffer, int chars_required);
 
+/** @brief Get the top document without copying.
+ *
+ * The document is interned in the scope, the pointer is valid until the scope is freed.
+ */
+char const *uri_scope_peek_document(UriScope const *u);
+
 /** @brief Get current fragment from the top of the stack. */
 char const *uri_scope_get_fragment(UriScope const *u);
 
@@ -125,3 +125,14 @@ bool validation_state_issue_default_property(ValidationState *s,
 {
 	return s->notify->default_property_func(s, key, value, ctxt);
 }
+
+bool validation_state_push_value_validator(ValidationState *s, Validator *v, void *ctxt)
+{
+	if (s->notify && s->notify->skip_value_func &&
+	    s->notify->skip_value_func(s, v, ctxt))
+	{
+		return false;
+	}
+	validation_state_push_validator(s, v);
+	return true;
+}
@@ -60,6 +60,20 @@ typedef struct _Notification
 	 * @return true if array contains duplicate items, false otherwise
 	 */
 	bool (*has_array_duplicates)(ValidationState *s, void *ctxt);
+
+	/** @brief Query if the next value is already known to be valid against the validator
+	 *
+	 * Called by the container validators before they push a validator for
+	 * a property value or an array item. If the function returns true, the validator
+	 * isn't pushed, and the caller is responsible to skip the rest of the value's events.
+	 * If this function is NULL, every value is validated.
+	 * @param[in] s Validation state
+	 * @param[in] v Validator, which is going to check the value
+	 * @param[in] ctxt User-supplied pointer (see validation_check()). This pointer must somehow
+	 *                 track the value being validated.
+	 * @return true if the value may be skipped, false otherwise
+	 */
+	bool (*skip_value_func)(ValidationState *s, Validator *v, void *ctxt);
 } Notification;
 
 
@@ -186,6 +200,15 @@ bool validation_state_issue_default_property(ValidationState *s,
                                              char const *key, jvalue_ref value,
                                              void *ctxt);
 
+/** @brief Push validator for the next value unless the value is known to be valid.
+ *
+ * @param[in] s This object
+ * @param[in] v Validator to check the value
+ * @param[in] ctxt User-supplied context pointer.
+ * @return true if the validator has been pushed, false if the value is skipped.
+ */
+bool validation_state_push_value_validator(ValidationState *s, Validator *v, void *ctxt);
+
 #ifdef __cplusplus
 }
 #endif
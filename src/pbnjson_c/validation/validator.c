@@ -253,6 +253,17 @@ Validator* validator_finalize_parse(Validator *v)
 	return new_v ? new_v : validator_ref(v);
 }
 
+Validator* validator_merge(Validator *v, Validator *other)
+{
+	assert(v && v->vtable && other && other->vtable);
+	Validator *res = NULL;
+	if (v->vtable->merge)
+		res = v->vtable->merge(v, other);
+	if (!res && other->vtable->merge)
+		res = other->vtable->merge(other, v);
+	return res;
+}
+
 void _validator_collect_uri_enter(char const *key, Validator *v, void *ctxt)
 {
 	assert(v && v->vtable);
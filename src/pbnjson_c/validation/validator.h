@@ -127,6 +127,15 @@ typedef struct _ValidatorVtable
 	 */
 	void (*finalize_parse)(char const *key, Validator *v, void *ctxt, Validator **new_v);
 
+	/** @brief Merge two validators into one, which accepts their intersection.
+	 *
+	 * Used to flatten "allOf" at schema compile time. The function should return
+	 * a new reference to the validator, which accepts exactly what both of them
+	 * accept, or NULL if the validators can't be merged. Default values of the
+	 * source validators aren't carried over.
+	 */
+	Validator* (*merge)(Validator *v, Validator *other);
+
 	/** @brief Track URI scope when traversing the tree.
 	 *
 	 * Track URI scope change induced by "id": remember validators under #/definitions.
@@ -252,6 +261,12 @@ void validator_combine(Validator *v);
 void _validator_finalize_parse(char const *key, Validator *v, void *ctxt, Validator **new_v);
 Validator* validator_finalize_parse(Validator *v);
 
+/** @brief Merge two validators into one, which accepts what both of them accept.
+ *
+ * @return New reference to the merged validator, or NULL if it's impossible.
+ */
+Validator* validator_merge(Validator *v, Validator *other);
+
 void _validator_collect_uri_enter(char const *key, Validator *v, void *ctxt);
 void _validator_collect_schemas(Validator *v, void *ctxt);
 void _validator_collect_uri_exit(char const *key, Validator *v, void *ctxt, Validator **new_v);
@@ -0,0 +1,1357 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <cctype>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <cstring>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <pbnjson.hpp>
+#include <boost/program_options.hpp>
+
+using namespace std;
+using namespace pbnjson;
+
+namespace {
+
+const char *Basename(const char *path)
+{
+	const char *res = strrchr(path, '/');
+	return res ? res + 1 : path;
+}
+
+int DetectTerminalWidth()
+{
+	struct winsize w;
+	ioctl(0, TIOCGWINSZ, &w);
+	return w.ws_col;
+}
+
+string Dirname(const string &path)
+{
+	size_t slash = path.rfind('/');
+	return slash == string::npos ? string() : path.substr(0, slash + 1);
+}
+
+bool FileExists(const string &path)
+{
+	return access(path.c_str(), R_OK) == 0;
+}
+
+// Identifier for the generated functions from the name of the schema file
+string Identifier(const string &name)
+{
+	string id;
+	for (char c : name)
+	{
+		if (c == '.')
+			break;
+		id += isalnum((unsigned char) c) ? c : '_';
+	}
+	if (id.empty() || isdigit((unsigned char) id[0]))
+		id = "_" + id;
+	return id;
+}
+
+// C string literal, octal escapes don't swallow the following characters like hex ones do
+string Literal(const string &str)
+{
+	ostringstream out;
+	out << '"';
+	for (unsigned char c : str)
+	{
+		if (c == '"' || c == '\\')
+			out << '\\' << c;
+		else if (c < 0x20 || c >= 0x7f || c == '?')
+			out << '\\' << oct << (c >> 6) << ((c >> 3) & 7) << (c & 7) << dec;
+		else
+			out << c;
+	}
+	out << '"';
+	return out.str();
+}
+
+// Schema location for the comments of the generated code
+string Comment(const string &str)
+{
+	string res;
+	for (size_t i = 0; i < str.size(); ++i)
+	{
+		res += str[i];
+		if (str[i] == '*' && i + 1 < str.size() && str[i + 1] == '/')
+			res += '\\';
+	}
+	return res;
+}
+
+string EscapePointer(const string &key)
+{
+	string res;
+	for (char c : key)
+	{
+		if (c == '~')
+			res += "~0";
+		else if (c == '/')
+			res += "~1";
+		else
+			res += c;
+	}
+	return res;
+}
+
+string UnescapePointer(const string &token)
+{
+	string res;
+	for (size_t i = 0; i < token.size(); ++i)
+	{
+		if (token[i] == '~' && i + 1 < token.size() && (token[i + 1] == '0' || token[i + 1] == '1'))
+			res += token[++i] == '0' ? '~' : '/';
+		else
+			res += token[i];
+	}
+	return res;
+}
+
+enum Type
+{
+	T_OBJECT  = 1 << 0,
+	T_ARRAY   = 1 << 1,
+	T_STRING  = 1 << 2,
+	T_NUMBER  = 1 << 3,
+	T_INTEGER = 1 << 4,
+	T_BOOLEAN = 1 << 5,
+	T_NULL    = 1 << 6,
+	T_ANY     = (1 << 7) - 1,
+};
+
+Type TypeFromName(const string &name)
+{
+	static const map<string, Type> types = {
+		{ "object", T_OBJECT }, { "array", T_ARRAY }, { "string", T_STRING },
+		{ "number", T_NUMBER }, { "integer", T_INTEGER }, { "boolean", T_BOOLEAN },
+		{ "null", T_NULL },
+	};
+	auto it = types.find(name);
+	return it == types.end() ? Type(0) : it->second;
+}
+
+/**
+ * Finds the order of "type" and "enum" in the schemas of a document.
+ *
+ * The interpreter keeps only the one of them, which comes last in the text,
+ * so the order matters, and the DOM doesn't keep it.
+ */
+class KeywordOrder : public JParser
+{
+public:
+	// Pointers of the schemas, where "enum" comes after "type"
+	set<string> enum_last;
+
+protected:
+	bool jsonObjectOpen() override
+	{
+		enter();
+		frames.push_back({ true });
+		return true;
+	}
+
+	bool jsonObjectKey(const string &key) override
+	{
+		Frame &f = frames.back();
+		f.key = EscapePointer(key);
+		if (key == "type")
+			f.type_seen = true, f.enum_last = false;
+		else if (key == "enum")
+			f.enum_last = f.type_seen;
+		return true;
+	}
+
+	bool jsonObjectClose() override
+	{
+		if (frames.back().enum_last)
+			enum_last.insert(pointer());
+		frames.pop_back();
+		leave();
+		return true;
+	}
+
+	bool jsonArrayOpen() override
+	{
+		enter();
+		frames.push_back({ false });
+		return true;
+	}
+
+	bool jsonArrayClose() override
+	{
+		frames.pop_back();
+		leave();
+		return true;
+	}
+
+	bool jsonString(const string &) override { return scalar(); }
+	bool jsonNumber(const string &) override { return scalar(); }
+	bool jsonBoolean(bool) override { return scalar(); }
+	bool jsonNull() override { return scalar(); }
+
+	NumberType conversionToUse() const override { return JNUM_CONV_RAW; }
+
+private:
+	struct Frame
+	{
+		bool object;
+		string key;
+		long index = 0;
+		bool type_seen = false;
+		bool enum_last = false;
+
+		Frame(bool object) : object(object) {}
+	};
+
+	vector<Frame> frames;
+	vector<string> path;
+
+	void enter()
+	{
+		if (frames.empty())
+			return;
+		Frame &f = frames.back();
+		path.push_back(f.object ? f.key : to_string(f.index++));
+	}
+
+	void leave()
+	{
+		if (!frames.empty())
+			path.pop_back();
+	}
+
+	bool scalar()
+	{
+		enter();
+		leave();
+		return true;
+	}
+
+	string pointer() const
+	{
+		string res;
+		for (const string &token : path)
+			res += "/" + token;
+		return res;
+	}
+};
+
+/**
+ * Translates JSON schema into C functions.
+ *
+ * Every subschema becomes a function, which checks a DOM value and returns
+ * true if it's valid. Subschemas are identified by the file and the JSON
+ * pointer, so the references to the same schema share the function.
+ *
+ * Unless the schema needs to see a whole value, as the combinators do, every
+ * subschema also gets a function checking the first event of a value. Objects
+ * and arrays push a frame with the function checking the events inside of them.
+ */
+class Generator
+{
+public:
+	explicit Generator(const string &prefix)
+		: prefix(prefix)
+	{}
+
+	void generate(const string &file)
+	{
+		string root = function(file, "");
+		while (!queue.empty())
+		{
+			int id = queue.front();
+			queue.erase(queue.begin());
+			node(id);
+		}
+		entry = root;
+	}
+
+	string eventsEntry() const
+	{
+		return streamable ? prefix + "_v" + entry.substr(prefix.size() + 2) : "NULL";
+	}
+
+	void write(ostream &out, const string &source, const string &header) const
+	{
+		out << "/* Validator of " << Comment(source) << ", generated by pbnjson_schemac. Do not edit. */\n\n";
+		if (!header.empty())
+			out << "#include " << Literal(header) << "\n";
+		out << "#include <string.h>\n"
+		    << "#include <pbnjson.h>\n\n";
+		out << declarations.str() << "\n";
+		if (streamable)
+			out << eventDeclarations.str() << "\n";
+		out << definitions.str();
+		if (streamable)
+			out << eventDefinitions.str();
+		out << "bool " << prefix << "_validate(jvalue_ref value)\n"
+		    << "{\n"
+		    << "\treturn " << entry << "(value);\n"
+		    << "}\n\n";
+		out << "const jschema_gen_validator " << prefix << "_validator = { "
+		    << eventsEntry() << ", " << prefix << "_validate };\n";
+	}
+
+	void writeHeader(ostream &out, const string &source) const
+	{
+		string guard = Identifier(prefix) + "_GENERATED_H_";
+		for (char &c : guard)
+			c = toupper((unsigned char) c);
+
+		out << "/* Validator of " << Comment(source) << ", generated by pbnjson_schemac. Do not edit. */\n\n"
+		    << "#ifndef " << guard << "\n"
+		    << "#define " << guard << "\n\n"
+		    << "#include <stdbool.h>\n"
+		    << "#include <pbnjson.h>\n\n"
+		    << "#ifdef __cplusplus\n"
+		    << "extern \"C\" {\n"
+		    << "#endif\n\n"
+		    << "/**\n"
+		    << " * Check the value against the schema, same as jvalue_validate() does\n"
+		    << " */\n"
+		    << "bool " << prefix << "_validate(jvalue_ref value);\n\n"
+		    << "/**\n"
+		    << " * Validator for jschema_gen_create() and jschema_gen_sax_init()\n"
+		    << " */\n"
+		    << "extern const jschema_gen_validator " << prefix << "_validator;\n\n"
+		    << "#ifdef __cplusplus\n"
+		    << "}\n"
+		    << "#endif\n\n"
+		    << "#endif\n";
+	}
+
+private:
+	struct Node
+	{
+		string file;
+		string pointer;
+		JValue schema;
+	};
+
+	string prefix;
+	string entry;
+	map<string, JValue> documents;
+	map<string, set<string>> enum_last;
+	map<pair<string, string>, int> ids;
+	vector<Node> nodes;
+	vector<int> queue;
+	ostringstream declarations;
+	ostringstream definitions;
+	ostringstream eventDeclarations;
+	ostringstream eventDefinitions;
+	bool streamable = true;
+	int constants = 0;
+
+	// Code checking a type of values, for a DOM value and for the event starting the value
+	struct Checks
+	{
+		string code;
+		string events;
+	};
+
+	runtime_error error(const Node &n, const string &what) const
+	{
+		return runtime_error(n.file + "#" + n.pointer + ": " + what);
+	}
+
+	JValue document(const string &file)
+	{
+		auto it = documents.find(file);
+		if (it != documents.end())
+			return it->second;
+
+		JValue doc = JDomParser::fromFile(file.c_str());
+		if (!doc.isValid())
+			throw runtime_error("Failed to parse JSON schema " + file);
+
+		// The code is generated only for the schemas the interpreter accepts
+		jerror *err = NULL;
+		jschema_ref schema = jschema_fcreate(file.c_str(), &err);
+		if (!schema)
+		{
+			string message = "Invalid JSON schema " + file;
+			if (err)
+			{
+				vector<char> text(jerror_to_string(err, NULL, 0) + 1);
+				jerror_to_string(err, text.data(), text.size());
+				message += string(": ") + text.data();
+				jerror_free(err);
+			}
+			throw runtime_error(message);
+		}
+		jschema_release(&schema);
+
+		ifstream in(file);
+		string text((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+		KeywordOrder order;
+		if (!order.parse(JInput(text), JSchema::AllSchema()))
+			throw runtime_error("Failed to parse JSON schema " + file);
+		enum_last[file] = order.enum_last;
+
+		checkIds(file, "", doc);
+		documents[file] = doc;
+		return doc;
+	}
+
+	// Scope changes would move the references to other targets, only the
+	// name of the document itself is allowed at its root
+	void checkIds(const string &file, const string &pointer, const JValue &schema)
+	{
+		if (!schema.isObject())
+			return;
+
+		if (schema.hasKey("id"))
+		{
+			string id = schema["id"].isString() ? schema["id"].asString() : string();
+			if (!pointer.empty() || id.find_first_of("/:#") != string::npos ||
+			    (id != Basename(file.c_str()) && id + ".schema" != Basename(file.c_str())))
+				throw runtime_error(file + "#" + pointer + ": \"id\" is supported only as the name of the schema file");
+		}
+
+		for (const char *key : { "items", "additionalItems", "additionalProperties", "not",
+		                         "allOf", "anyOf", "oneOf", "extends" })
+		{
+			if (!schema.hasKey(key))
+				continue;
+			JValue sub = schema[key];
+			if (sub.isArray())
+				for (ssize_t i = 0; i < sub.arraySize(); ++i)
+					checkIds(file, pointer + "/" + key + "/" + to_string(i), sub[i]);
+			else
+				checkIds(file, pointer + "/" + key, sub);
+		}
+
+		for (const char *key : { "properties", "patternProperties", "definitions" })
+		{
+			if (!schema.hasKey(key) || !schema[key].isObject())
+				continue;
+			for (const JValue::KeyValue &kv : schema[key].children())
+				checkIds(file, pointer + "/" + key + "/" + EscapePointer(kv.first.asString()), kv.second);
+		}
+	}
+
+	// Name of the function for the subschema, which is generated later
+	string function(const string &file, const string &pointer)
+	{
+		auto key = make_pair(file, pointer);
+		auto it = ids.find(key);
+		int id;
+		if (it != ids.end())
+			id = it->second;
+		else
+		{
+			JValue schema = document(file);
+			istringstream tokens(pointer);
+			string token;
+			getline(tokens, token, '/');  // Before the leading slash
+			while (getline(tokens, token, '/'))
+			{
+				token = UnescapePointer(token);
+				if (schema.isArray())
+				{
+					char *end = nullptr;
+					long index = strtol(token.c_str(), &end, 10);
+					if (token.empty() || *end || index < 0 || index >= schema.arraySize())
+						throw runtime_error(file + "#" + pointer + ": unresolved pointer");
+					schema = schema[(int) index];
+				}
+				else if (schema.isObject() && schema.hasKey(token))
+					schema = schema[token];
+				else
+					throw runtime_error(file + "#" + pointer + ": unresolved pointer");
+			}
+			if (!schema.isObject())
+				throw runtime_error(file + "#" + pointer + ": schema should be an object");
+
+			id = nodes.size();
+			ids[key] = id;
+			nodes.push_back({ file, pointer, schema });
+			queue.push_back(id);
+			declarations << "static bool " << prefix << "_s" << id << "(jvalue_ref v);\n";
+			eventDeclarations << "static bool " << prefix << "_v" << id
+			                  << "(jschema_gen_sax_state *s, const jschema_gen_event *e);\n";
+		}
+		return prefix + "_s" + to_string(id);
+	}
+
+	// Event function of the subschema with the DOM function
+	string events(const string &function) const
+	{
+		return prefix + "_v" + function.substr(prefix.size() + 2);
+	}
+
+	// Declares the function checking the events inside of an object or an array
+	string frame(char kind, int id)
+	{
+		string name = prefix + "_" + kind + to_string(id);
+		eventDeclarations << "static bool " << name
+		                  << "(jschema_gen_sax_state *s, jschema_gen_frame *f, const jschema_gen_event *e);\n";
+		return name;
+	}
+
+	string child(const Node &n, const string &path)
+	{
+		return function(n.file, n.pointer + "/" + path);
+	}
+
+	string reference(const Node &n, const string &ref)
+	{
+		size_t hash = ref.find('#');
+		string file = ref.substr(0, hash);
+		string fragment = hash == string::npos ? string() : ref.substr(hash + 1);
+		if (!fragment.empty() && fragment[0] != '/')
+			throw error(n, "only JSON pointer fragments are supported in \"$ref\"");
+
+		if (file.empty())
+			file = n.file;
+		else
+		{
+			// Relative to the referencing document, optionally without extension
+			if (file[0] != '/')
+				file = Dirname(n.file) + file;
+			if (!FileExists(file) && FileExists(file + ".schema"))
+				file += ".schema";
+		}
+		return function(file, fragment);
+	}
+
+	static string number(const Node &n, const JValue &schema, const char *key)
+	{
+		if (!schema.hasKey(key))
+			return string();
+		string text;
+		if (!schema[key].isNumber() || schema[key].asNumber<string>(text) != CONV_OK)
+			throw runtime_error(n.file + "#" + n.pointer + ": \"" + key + "\" should be a number");
+		return text;
+	}
+
+	static long count(const Node &n, const JValue &schema, const char *key)
+	{
+		if (!schema.hasKey(key))
+			return -1;
+		int64_t value = -1;
+		if (!schema[key].isNumber() || schema[key].asNumber(value) != CONV_OK || value < 0)
+			throw runtime_error(n.file + "#" + n.pointer + ": \"" + key + "\" should be a non-negative integer");
+		return value;
+	}
+
+	static bool flag(const JValue &schema, const char *key)
+	{
+		bool value = false;
+		return schema.hasKey(key) && schema[key].isBoolean() && schema[key].asBool(value) == CONV_OK && value;
+	}
+
+	int types(const Node &n)
+	{
+		if (!n.schema.hasKey("type"))
+			return T_ANY;
+
+		JValue type = n.schema["type"];
+		vector<string> names;
+		if (type.isString())
+			names.push_back(type.asString());
+		else if (type.isArray())
+			for (ssize_t i = 0; i < type.arraySize(); ++i)
+			{
+				if (!type[i].isString())
+					throw error(n, "only type names are supported in \"type\"");
+				names.push_back(type[i].asString());
+			}
+		else
+			throw error(n, "\"type\" should be a string or an array");
+
+		int mask = 0;
+		for (const string &name : names)
+		{
+			Type t = TypeFromName(name);
+			if (!t)
+				throw error(n, "unknown type \"" + name + "\"");
+			mask |= t;
+		}
+		// Any number is fine if "number" is listed along with "integer"
+		if (mask & T_NUMBER)
+			mask &= ~T_INTEGER;
+		return mask;
+	}
+
+	vector<string> schemas(const Node &n, const char *key)
+	{
+		vector<string> res;
+		JValue list = n.schema[key];
+		if (list.isObject())
+			res.push_back(child(n, key));
+		else if (list.isArray())
+			for (ssize_t i = 0; i < list.arraySize(); ++i)
+				res.push_back(child(n, string(key) + "/" + to_string(i)));
+		else
+			throw error(n, string("\"") + key + "\" should be a schema or an array of schemas");
+		return res;
+	}
+
+	// Checks of an object, empty if none
+	Checks objectChecks(const Node &n, int id)
+	{
+		ostringstream out;
+		const JValue &s = n.schema;
+
+		long min = count(n, s, "minProperties");
+		long max = count(n, s, "maxProperties");
+		if (min > 0 || max >= 0)
+			out << "\t\tsize_t size = jobject_size(v);\n";
+		if (min > 0)
+			out << "\t\tif (size < " << min << ") return false;\n";
+		if (max >= 0)
+			out << "\t\tif (size > " << max << ") return false;\n";
+
+		// Known keys grouped by length for the switch
+		struct Key { string validator; int required = -1; };
+		map<size_t, map<string, Key>> keys;
+		bool properties = false;
+		if (s.hasKey("properties"))
+		{
+			if (!s["properties"].isObject())
+				throw error(n, "\"properties\" should be an object");
+			for (const JValue::KeyValue &kv : s["properties"].children())
+			{
+				string key = kv.first.asString();
+				keys[key.size()][key].validator = child(n, "properties/" + EscapePointer(key));
+				properties = true;
+			}
+		}
+		int required = 0;
+		if (s.hasKey("required"))
+		{
+			JValue list = s["required"];
+			if (!list.isArray())
+				throw error(n, "\"required\" should be an array");
+			for (ssize_t i = 0; i < list.arraySize(); ++i)
+			{
+				string key = list[i].asString();
+				Key &k = keys[key.size()][key];
+				if (k.required < 0)
+					k.required = required++;
+			}
+		}
+
+		vector<pair<string, string>> patterns;
+		if (s.hasKey("patternProperties"))
+		{
+			if (!s["patternProperties"].isObject())
+				throw error(n, "\"patternProperties\" should be an object");
+			for (const JValue::KeyValue &kv : s["patternProperties"].children())
+			{
+				string pattern = kv.first.asString();
+				patterns.push_back({ constantPattern(pattern),
+				                     child(n, "patternProperties/" + EscapePointer(pattern)) });
+			}
+		}
+
+		// Absent additionalProperties allow anything
+		string additional;
+		bool additional_allowed = true;
+		if (s.hasKey("additionalProperties"))
+		{
+			JValue a = s["additionalProperties"];
+			if (a.isBoolean())
+				additional_allowed = a.asBool();
+			else if (a.isObject())
+				additional = child(n, "additionalProperties");
+			else
+				throw error(n, "\"additionalProperties\" should be a boolean or a schema");
+		}
+		bool track_matches = !additional_allowed || !additional.empty();
+
+		if (keys.empty() && patterns.empty() && !track_matches && min <= 0 && max < 0)
+			return {};
+
+		// The value of a key can be checked by one schema at a time only
+		if (required > 64 || patterns.size() > 1 || (!patterns.empty() && properties))
+			streamable = false;
+
+		if (!keys.empty() || !patterns.empty() || track_matches)
+		{
+			if (required)
+				out << "\t\tbool seen[" << required << "] = { false };\n";
+			out << "\t\tjobject_iter it;\n"
+			    << "\t\tjobject_key_value kv;\n"
+			    << "\t\tjobject_iter_init(&it, v);\n"
+			    << "\t\twhile (jobject_iter_next(&it, &kv))\n"
+			    << "\t\t{\n"
+			    << "\t\t\traw_buffer key = jstring_get_fast(kv.key);\n";
+			if (track_matches)
+				out << "\t\t\tbool matched = false;\n";
+
+			if (!keys.empty())
+			{
+				out << "\t\t\tswitch (key.m_len)\n"
+				    << "\t\t\t{\n";
+				for (const auto &group : keys)
+				{
+					out << "\t\t\tcase " << group.first << ":\n";
+					for (const auto &kv : group.second)
+					{
+						out << "\t\t\t\tif (!memcmp(key.m_str, " << Literal(kv.first) << ", " << group.first << "))\n"
+						    << "\t\t\t\t{\n";
+						if (!kv.second.validator.empty())
+							out << "\t\t\t\t\tif (!" << kv.second.validator << "(kv.value)) return false;\n";
+						if (kv.second.required >= 0)
+							out << "\t\t\t\t\tseen[" << kv.second.required << "] = true;\n";
+						// Required only keys aren't properties, additionalProperties apply to them
+						if (track_matches && !kv.second.validator.empty())
+							out << "\t\t\t\t\tmatched = true;\n";
+						out << "\t\t\t\t\tbreak;\n"
+						    << "\t\t\t\t}\n";
+					}
+					out << "\t\t\t\tbreak;\n";
+				}
+				out << "\t\t\t}\n";
+			}
+
+			for (const auto &p : patterns)
+			{
+				out << "\t\t\tif (jschema_gen_match(&" << p.first << ", key.m_str, key.m_len))\n"
+				    << "\t\t\t{\n"
+				    << "\t\t\t\tif (!" << p.second << "(kv.value)) return false;\n";
+				if (track_matches)
+					out << "\t\t\t\tmatched = true;\n";
+				out << "\t\t\t}\n";
+			}
+
+			if (!additional_allowed)
+				out << "\t\t\tif (!matched) return false;\n";
+			else if (!additional.empty())
+				out << "\t\t\tif (!matched && !" << additional << "(kv.value)) return false;\n";
+			out << "\t\t}\n";
+
+			for (int i = 0; i < required; ++i)
+				out << "\t\tif (!seen[" << i << "]) return false;\n";
+		}
+
+		if (!streamable)
+			return { out.str(), string() };
+
+		// Events inside of the object: the keys choose the function for the next value
+		string name = frame('o', id);
+		ostringstream ev;
+		ev << "static bool " << name << "(jschema_gen_sax_state *s, jschema_gen_frame *f, const jschema_gen_event *e)\n"
+		   << "{\n"
+		   << "\tif (e->type == JSCHEMA_GEN_OBJECT_END)\n"
+		   << "\t{\n";
+		if (min > 0)
+			ev << "\t\tif (f->count < " << min << ") return false;\n";
+		if (required)
+		{
+			uint64_t mask = required == 64 ? ~UINT64_C(0) : (UINT64_C(1) << required) - 1;
+			ev << "\t\tif ((f->seen & UINT64_C(0x" << hex << mask << ")) != UINT64_C(0x" << mask << dec
+			   << ")) return false;\n";
+		}
+		ev << "\t\tjschema_gen_sax_pop(s);\n"
+		   << "\t\treturn true;\n"
+		   << "\t}\n"
+		   << "\tif (e->type != JSCHEMA_GEN_OBJECT_KEY)\n"
+		   << "\t\treturn f->value(s, e);\n\n";
+		if (max >= 0)
+			ev << "\tif (++f->count > " << max << ") return false;\n";
+		else
+			ev << "\t++f->count;\n";
+		ev << "\tf->value = jschema_gen_sax_any;\n";
+		if (track_matches)
+			ev << "\tbool matched = false;\n";
+		if (!keys.empty())
+		{
+			ev << "\tswitch (e->len)\n"
+			   << "\t{\n";
+			for (const auto &group : keys)
+			{
+				ev << "\tcase " << group.first << ":\n";
+				for (const auto &kv : group.second)
+				{
+					ev << "\t\tif (!memcmp(e->str, " << Literal(kv.first) << ", " << group.first << "))\n"
+					   << "\t\t{\n";
+					if (!kv.second.validator.empty())
+						ev << "\t\t\tf->value = " << events(kv.second.validator) << ";\n";
+					if (kv.second.required >= 0)
+						ev << "\t\t\tf->seen |= UINT64_C(1) << " << kv.second.required << ";\n";
+					if (track_matches && !kv.second.validator.empty())
+						ev << "\t\t\tmatched = true;\n";
+					ev << "\t\t\tbreak;\n"
+					   << "\t\t}\n";
+				}
+				ev << "\t\tbreak;\n";
+			}
+			ev << "\t}\n";
+		}
+		for (const auto &p : patterns)
+		{
+			ev << "\tif (jschema_gen_match(&" << p.first << ", e->str, e->len))\n"
+			   << "\t{\n"
+			   << "\t\tf->value = " << events(p.second) << ";\n";
+			if (track_matches)
+				ev << "\t\tmatched = true;\n";
+			ev << "\t}\n";
+		}
+		if (!additional_allowed)
+			ev << "\tif (!matched) return false;\n";
+		else if (!additional.empty())
+			ev << "\tif (!matched) f->value = " << events(additional) << ";\n";
+		ev << "\treturn true;\n"
+		   << "}\n\n";
+		eventDefinitions << ev.str();
+
+		return { out.str(), "\t\treturn jschema_gen_sax_push(s, " + name + ");\n" };
+	}
+
+	Checks arrayChecks(const Node &n, int id)
+	{
+		ostringstream out;
+		const JValue &s = n.schema;
+
+		long min = count(n, s, "minItems");
+		long max = count(n, s, "maxItems");
+
+		vector<string> tuple;
+		string items;
+		if (s.hasKey("items"))
+		{
+			if (s["items"].isObject())
+				items = child(n, "items");
+			else if (s["items"].isArray())
+				tuple = schemas(n, "items");
+			else
+				throw error(n, "\"items\" should be a schema or an array of schemas");
+		}
+
+		// additionalItems make sense only after the tuple
+		string additional;
+		bool additional_allowed = true;
+		if (s.hasKey("items") && s["items"].isArray() && s.hasKey("additionalItems"))
+		{
+			JValue a = s["additionalItems"];
+			if (a.isBoolean())
+				additional_allowed = a.asBool();
+			else if (a.isObject())
+				additional = child(n, "additionalItems");
+			else
+				throw error(n, "\"additionalItems\" should be a boolean or a schema");
+		}
+		bool unique = flag(s, "uniqueItems");
+
+		bool need_size = min > 0 || max >= 0 || !items.empty() || !tuple.empty() ||
+		                 !additional_allowed || !additional.empty();
+		if (need_size)
+			out << "\t\tssize_t size = jarray_size(v);\n";
+		if (min > 0)
+			out << "\t\tif (size < " << min << ") return false;\n";
+		if (max >= 0)
+			out << "\t\tif (size > " << max << ") return false;\n";
+		if (!additional_allowed)
+			out << "\t\tif (size > " << tuple.size() << ") return false;\n";
+		if (!items.empty())
+			out << "\t\tfor (ssize_t i = 0; i < size; ++i)\n"
+			    << "\t\t\tif (!" << items << "(jarray_get(v, i))) return false;\n";
+		for (size_t i = 0; i < tuple.size(); ++i)
+			out << "\t\tif (size > " << i << " && !" << tuple[i] << "(jarray_get(v, " << i << "))) return false;\n";
+		if (!additional.empty())
+			out << "\t\tfor (ssize_t i = " << tuple.size() << "; i < size; ++i)\n"
+			    << "\t\t\tif (!" << additional << "(jarray_get(v, i))) return false;\n";
+		if (unique)
+			out << "\t\tif (!jschema_gen_unique_items(v)) return false;\n";
+
+		if (out.str().empty())
+			return {};
+
+		// The items are compared with each other only when all of them are known
+		if (unique)
+			streamable = false;
+		if (!streamable)
+			return { out.str(), string() };
+
+		// Events inside of the array: the index chooses the function for the item
+		string name = frame('a', id);
+		ostringstream ev;
+		ev << "static bool " << name << "(jschema_gen_sax_state *s, jschema_gen_frame *f, const jschema_gen_event *e)\n"
+		   << "{\n"
+		   << "\tif (e->type == JSCHEMA_GEN_ARRAY_END)\n"
+		   << "\t{\n";
+		if (min > 0)
+			ev << "\t\tif (f->count < " << min << ") return false;\n";
+		ev << "\t\tjschema_gen_sax_pop(s);\n"
+		   << "\t\treturn true;\n"
+		   << "\t}\n\n"
+		   << "\tsize_t i = f->count++;\n";
+		if (max >= 0)
+			ev << "\tif (i >= " << max << ") return false;\n";
+		if (!additional_allowed)
+			ev << "\tif (i >= " << tuple.size() << ") return false;\n";
+		if (!items.empty())
+			ev << "\treturn " << events(items) << "(s, e);\n";
+		else
+		{
+			if (!tuple.empty())
+			{
+				ev << "\tswitch (i)\n"
+				   << "\t{\n";
+				for (size_t i = 0; i < tuple.size(); ++i)
+					ev << "\tcase " << i << ": return " << events(tuple[i]) << "(s, e);\n";
+				ev << "\t}\n";
+			}
+			ev << "\treturn " << (additional.empty() ? string("jschema_gen_sax_any") : events(additional))
+			   << "(s, e);\n";
+		}
+		ev << "}\n\n";
+		eventDefinitions << ev.str();
+
+		return { out.str(), "\t\treturn jschema_gen_sax_push(s, " + name + ");\n" };
+	}
+
+	Checks stringChecks(const Node &n)
+	{
+		ostringstream out, ev;
+		const JValue &s = n.schema;
+
+		long min = count(n, s, "minLength");
+		long max = count(n, s, "maxLength");
+		bool pattern = s.hasKey("pattern");
+		if (pattern && !s["pattern"].isString())
+			throw error(n, "\"pattern\" should be a string");
+
+		if (min <= 0 && max < 0 && !pattern)
+			return {};
+
+		out << "\t\traw_buffer str = jstring_get_fast(v);\n";
+		if (min > 0)
+		{
+			out << "\t\tif (str.m_len < " << min << ") return false;\n";
+			ev << "\t\tif (e->len < " << min << ") return false;\n";
+		}
+		if (max >= 0)
+		{
+			out << "\t\tif (str.m_len > " << max << ") return false;\n";
+			ev << "\t\tif (e->len > " << max << ") return false;\n";
+		}
+		if (pattern)
+		{
+			string name = constantPattern(s["pattern"].asString());
+			out << "\t\tif (!jschema_gen_match(&" << name << ", str.m_str, str.m_len)) return false;\n";
+			ev << "\t\tif (!jschema_gen_match(&" << name << ", e->str, e->len)) return false;\n";
+		}
+		ev << "\t\treturn true;\n";
+		return { out.str(), ev.str() };
+	}
+
+	Checks numberChecks(const Node &n, bool integer)
+	{
+		const JValue &s = n.schema;
+		string minimum = number(n, s, "minimum");
+		string maximum = number(n, s, "maximum");
+		string multiple_of = number(n, s, "multipleOf");
+		if (!integer && minimum.empty() && maximum.empty() && multiple_of.empty())
+			return {};
+
+		// Not const, the constants are parsed on the first use
+		string name = prefix + "_limits" + to_string(constants++);
+		auto text = [](const string &t) { return "{ " + (t.empty() ? string("NULL") : Literal(t)) + ", NULL }"; };
+		declarations << "static jschema_gen_number_limits " << name << " = { "
+		             << text(minimum) << ", " << text(maximum) << ", " << text(multiple_of) << ", "
+		             << (flag(s, "exclusiveMinimum") ? "true" : "false") << ", "
+		             << (flag(s, "exclusiveMaximum") ? "true" : "false") << ", "
+		             << (integer ? "true" : "false") << " };\n";
+		return { "\t\tif (!jschema_gen_check_number(v, &" + name + ")) return false;\n",
+		         "\t\treturn jschema_gen_check_number_text(e->str, e->len, &" + name + ");\n" };
+	}
+
+	string constantPattern(const string &pattern)
+	{
+		string name = prefix + "_pattern" + to_string(constants++);
+		declarations << "static jschema_gen_pattern " << name << " = { " << Literal(pattern) << ", NULL };\n";
+		return name;
+	}
+
+	// Functions checking "enum", all the members are scalars. Returns the code for both.
+	Checks enumeration(const Node &n, int id)
+	{
+		JValue list = n.schema["enum"];
+		if (!list.isArray() || list.arraySize() == 0)
+			throw error(n, "\"enum\" should be a non-empty array");
+
+		map<size_t, vector<string>> strings;
+		vector<string> numbers;
+		bool has_true = false, has_false = false, has_null = false;
+		for (ssize_t i = 0; i < list.arraySize(); ++i)
+		{
+			JValue e = list[i];
+			if (e.isString())
+			{
+				string str = e.asString();
+				strings[str.size()].push_back(str);
+			}
+			else if (e.isNumber())
+			{
+				string text;
+				e.asNumber<string>(text);
+				numbers.push_back(text);
+			}
+			else if (e.isBoolean())
+				(e.asBool() ? has_true : has_false) = true;
+			else if (e.isNull())
+				has_null = true;
+			else
+				throw error(n, "only scalar values are supported in \"enum\"");
+		}
+
+		// Not const, the constants are parsed on the first use
+		string constant;
+		if (!numbers.empty())
+		{
+			constant = prefix + "_numbers" + to_string(constants++);
+			declarations << "static jschema_gen_number " << constant << "[] = {";
+			for (size_t i = 0; i < numbers.size(); ++i)
+				declarations << (i ? ", " : " ") << "{ " << Literal(numbers[i]) << ", NULL }";
+			declarations << " };\n";
+		}
+
+		string name = prefix + "_s" + to_string(id) + "_enum";
+		ostringstream out;
+		out << "static bool " << name << "(jvalue_ref v)\n"
+		    << "{\n";
+		if (!strings.empty())
+		{
+			out << "\tif (jis_string(v))\n"
+			    << "\t{\n"
+			    << "\t\traw_buffer str = jstring_get_fast(v);\n"
+			    << "\t\tswitch (str.m_len)\n"
+			    << "\t\t{\n";
+			for (const auto &group : strings)
+			{
+				out << "\t\tcase " << group.first << ":\n"
+				    << "\t\t\treturn ";
+				for (size_t i = 0; i < group.second.size(); ++i)
+					out << (i ? "\n\t\t\t    || " : "") << "!memcmp(str.m_str, " << Literal(group.second[i])
+					    << ", " << group.first << ")";
+				out << ";\n";
+			}
+			out << "\t\t}\n"
+			    << "\t\treturn false;\n"
+			    << "\t}\n";
+		}
+		if (!numbers.empty())
+			out << "\tif (jis_number(v))\n"
+			    << "\t\treturn jschema_gen_number_in(v, " << constant << ", " << numbers.size() << ");\n";
+		if (has_true || has_false)
+		{
+			out << "\tif (jis_boolean(v))\n";
+			if (has_true && has_false)
+				out << "\t\treturn true;\n";
+			else
+				out << "\t{\n"
+				    << "\t\tbool b = false;\n"
+				    << "\t\tjboolean_get(v, &b);\n"
+				    << "\t\treturn " << (has_true ? "b" : "!b") << ";\n"
+				    << "\t}\n";
+		}
+		out << "\treturn " << (has_null ? "jis_null(v)" : "false") << ";\n"
+		    << "}\n\n";
+
+		declarations << "static bool " << name << "(jvalue_ref v);\n";
+		definitions << out.str();
+
+		ostringstream ev;
+		ev << "\tswitch (e->type)\n"
+		   << "\t{\n";
+		if (!strings.empty())
+		{
+			ev << "\tcase JSCHEMA_GEN_STRING:\n"
+			   << "\t\tswitch (e->len)\n"
+			   << "\t\t{\n";
+			for (const auto &group : strings)
+			{
+				ev << "\t\tcase " << group.first << ":\n"
+				   << "\t\t\treturn ";
+				for (size_t i = 0; i < group.second.size(); ++i)
+					ev << (i ? "\n\t\t\t    || " : "") << "!memcmp(e->str, " << Literal(group.second[i])
+					   << ", " << group.first << ")";
+				ev << ";\n";
+			}
+			ev << "\t\t}\n"
+			   << "\t\treturn false;\n";
+		}
+		if (!numbers.empty())
+			ev << "\tcase JSCHEMA_GEN_NUMBER:\n"
+			   << "\t\treturn jschema_gen_number_in_text(e->str, e->len, " << constant << ", "
+			   << numbers.size() << ");\n";
+		if (has_true || has_false)
+			ev << "\tcase JSCHEMA_GEN_BOOLEAN:\n"
+			   << "\t\treturn " << (has_true && has_false ? "true" : has_true ? "e->boolean" : "!e->boolean")
+			   << ";\n";
+		if (has_null)
+			ev << "\tcase JSCHEMA_GEN_NULL:\n"
+			   << "\t\treturn true;\n";
+		ev << "\tdefault:\n"
+		   << "\t\treturn false;\n"
+		   << "\t}\n";
+
+		return { name, ev.str() };
+	}
+
+	void node(int id)
+	{
+		// Copy, generation of the children appends to the vector
+		const Node n = nodes[id];
+		const JValue &s = n.schema;
+
+		ostringstream body, ev;
+		if (s.hasKey("$ref"))
+		{
+			// The rest of the keywords is ignored, as the interpreter does
+			if (!s["$ref"].isString())
+				throw error(n, "\"$ref\" should be a string");
+			string target = reference(n, s["$ref"].asString());
+			body << "\treturn " << target << "(v);\n";
+			ev << "\treturn " << events(target) << "(s, e);\n";
+		}
+		else
+		{
+			// The interpreter keeps only the last of "type" and "enum", and the
+			// keywords of the types apply to nothing along with "enum"
+			bool use_enum = s.hasKey("enum") &&
+			                (!s.hasKey("type") || enum_last[n.file].count(n.pointer));
+			int mask = use_enum ? 0 : types(n);
+
+			struct Branch { const char *check; const char *events; int types; Checks checks; };
+			vector<Branch> branches = {
+				{ "jis_object(v)",  "JSCHEMA_GEN_OBJECT_START", T_OBJECT,
+				  (mask & T_OBJECT) ? objectChecks(n, id) : Checks() },
+				{ "jis_array(v)",   "JSCHEMA_GEN_ARRAY_START",  T_ARRAY,
+				  (mask & T_ARRAY) ? arrayChecks(n, id) : Checks() },
+				{ "jis_string(v)",  "JSCHEMA_GEN_STRING",       T_STRING,
+				  (mask & T_STRING) ? stringChecks(n) : Checks() },
+				{ "jis_number(v)",  "JSCHEMA_GEN_NUMBER",       T_NUMBER | T_INTEGER,
+				  (mask & (T_NUMBER | T_INTEGER)) ? numberChecks(n, !(mask & T_NUMBER)) : Checks() },
+				{ "jis_boolean(v)", "JSCHEMA_GEN_BOOLEAN",      T_BOOLEAN, Checks() },
+				{ "jis_null(v)",    "JSCHEMA_GEN_NULL",         T_NULL,    Checks() },
+			};
+
+			bool first = true;
+			for (const Branch &b : branches)
+			{
+				if (use_enum)
+					break;
+				bool allowed = mask & b.types;
+				if (allowed && b.checks.code.empty())
+					continue;
+				body << (first ? "\tif (" : "\telse if (") << b.check << ")\n"
+				     << "\t{\n"
+				     << (allowed ? b.checks.code : "\t\treturn false;\n")
+				     << "\t}\n";
+				first = false;
+			}
+
+			if (use_enum)
+			{
+				Checks e = enumeration(n, id);
+				body << "\tif (!" << e.code << "(v)) return false;\n";
+				ev << e.events;
+			}
+			else
+			{
+				// Values without checks are accepted as a whole, the rest is refused
+				ev << "\tswitch (e->type)\n"
+				   << "\t{\n";
+				for (const Branch &b : branches)
+					if ((mask & b.types) && !b.checks.code.empty())
+						ev << "\tcase " << b.events << ":\n"
+						   << b.checks.events;
+				bool any = false;
+				for (const Branch &b : branches)
+					if ((mask & b.types) && b.checks.code.empty() && (b.types & (T_OBJECT | T_ARRAY)))
+						ev << "\tcase " << b.events << ":\n", any = true;
+				if (any)
+					ev << "\t\treturn jschema_gen_sax_any(s, e);\n";
+				any = false;
+				for (const Branch &b : branches)
+					if ((mask & b.types) && b.checks.code.empty() && !(b.types & (T_OBJECT | T_ARRAY)))
+						ev << "\tcase " << b.events << ":\n", any = true;
+				if (any)
+					ev << "\t\treturn true;\n";
+				ev << "\tdefault:\n"
+				   << "\t\treturn false;\n"
+				   << "\t}\n";
+			}
+
+			// Combinators need the whole value, such schemas are checked as DOM
+			for (const char *key : { "allOf", "extends" })
+				if (s.hasKey(key))
+				{
+					for (const string &f : schemas(n, key))
+						body << "\tif (!" << f << "(v)) return false;\n";
+					streamable = false;
+				}
+
+			if (s.hasKey("anyOf"))
+			{
+				vector<string> list = schemas(n, "anyOf");
+				body << "\tif (!(";
+				for (size_t i = 0; i < list.size(); ++i)
+					body << (i ? " || " : "") << list[i] << "(v)";
+				body << ")) return false;\n";
+				streamable = false;
+			}
+
+			if (s.hasKey("oneOf"))
+			{
+				vector<string> list = schemas(n, "oneOf");
+				body << "\tif (";
+				for (size_t i = 0; i < list.size(); ++i)
+					body << (i ? " + " : "") << list[i] << "(v)";
+				body << " != 1) return false;\n";
+				streamable = false;
+			}
+
+			if (s.hasKey("not"))
+			{
+				if (!s["not"].isObject())
+					throw error(n, "\"not\" should be a schema");
+				body << "\tif (" << child(n, "not") << "(v)) return false;\n";
+				streamable = false;
+			}
+
+			body << "\treturn true;\n";
+		}
+
+		string location = "/* " + Comment(Basename(n.file.c_str())) + "#" + Comment(n.pointer) + " */\n";
+		definitions << location
+		            << "static bool " << prefix << "_s" << id << "(jvalue_ref v)\n"
+		            << "{\n"
+		            << body.str()
+		            << "}\n\n";
+		eventDefinitions << location
+		                 << "static bool " << prefix << "_v" << id
+		                 << "(jschema_gen_sax_state *s, const jschema_gen_event *e)\n"
+		                 << "{\n"
+		                 << ev.str()
+		                 << "}\n\n";
+	}
+};
+
+} //namespace;
+
+int main(int argc, char *argv[])
+{
+	const char *program_name = Basename(argv[0]);
+	int line_length = DetectTerminalWidth();
+
+	string schema_file;
+	string output_file;
+	string header_file;
+	string name;
+
+	try
+	{
+		using namespace boost::program_options;
+		options_description desc("Options", line_length, line_length / 2);
+		desc.add_options()
+			("version,V", "Print program version")
+			("help,h", "Print usage summary")
+			("schema,s", value<string>(&schema_file)->default_value(schema_file),
+			 "File with JSON schema")
+			("output,o", value<string>(&output_file)->default_value(output_file),
+			 "C file to generate (skip for stdout)")
+			("header,H", value<string>(&header_file)->default_value(header_file),
+			 "C header to generate along with the source")
+			("name,n", value<string>(&name)->default_value(name),
+			 "Prefix of the generated functions (by default from the schema file name)")
+			;
+
+		positional_options_description p;
+		p.add("schema", 1);
+
+		variables_map vm;
+		store(command_line_parser(argc, argv)
+		      .options(desc)
+		      .positional(p)
+		      .run(),
+		      vm);
+		notify(vm);
+
+		if (vm.count("help") || schema_file.empty())
+		{
+			cout << program_name << " -- generate C validator from JSON schema\n\n";
+			cout << "Usage: " << program_name << " [OPTION] <file.schema>\n\n";
+			cout << "Generated function <name>_validate(jvalue_ref) gives the same result as\n"
+			        "jvalue_validate() with the schema, and links with pbnjson_c. Validator\n"
+			        "<name>_validator checks the parser events with jschema_gen_create(), without\n"
+			        "building a DOM unless the schema has combinators.\n";
+			cout << desc << endl;
+			return vm.count("help") ? 0 : 1;
+		}
+
+		if (vm.count("version"))
+		{
+			cout << program_name << " " << WEBOS_COMPONENT_VERSION << endl;
+			return 0;
+		}
+
+		if (name.empty())
+			name = Identifier(Basename(schema_file.c_str()));
+
+		Generator generator(name);
+		generator.generate(schema_file);
+
+		if (!header_file.empty())
+		{
+			ofstream header(header_file);
+			generator.writeHeader(header, Basename(schema_file.c_str()));
+			if (!header)
+			{
+				cerr << "Failed to write " << header_file << endl;
+				return 1;
+			}
+		}
+
+		string include = header_file.empty() ? string() : Basename(header_file.c_str());
+		if (output_file.empty())
+			generator.write(cout, Basename(schema_file.c_str()), include);
+		else
+		{
+			ofstream output(output_file);
+			generator.write(output, Basename(schema_file.c_str()), include);
+			if (!output)
+			{
+				cerr << "Failed to write " << output_file << endl;
+				return 1;
+			}
+		}
+	}
+	catch (const std::exception &e)
+	{
+		cerr << e.what() << endl;
+		return 1;
+	}
+	return 0;
+}
@@ -16,6 +16,7 @@
 
 #define PBNJSON_USE_DEPRECATED_API
 #include <iostream>
+#include <vector>
 #include <sys/ioctl.h>
 #include <pbnjson.hpp>
 #include <boost/program_options.hpp>
@@ -88,7 +89,7 @@ int main(int argc, char *argv[])
 			("version,V", "Print program version")
 			("help,h", "Print usage summary")
 			("file,f", value<string>(&file_name)->default_value(file_name),
-			 "JSON file to validate (skip for stdin)")
+			 "JSON file to validate, may be gzip or zstd compressed (skip for stdin)")
 			("schema,s", value<string>(&schema_file)->default_value(schema_file),
 			 "File with JSON schema")
 			;
@@ -134,41 +135,23 @@ int main(int argc, char *argv[])
 			}
 		}
 
-		// Try to parse the file to validate
-		JDomParser parser;
-		if (file_name.empty())
+		// Try to parse the file to validate, errors point to the place in it
+		jerror *error = NULL;
+		jvalue_ref json = jdom_fcreate_compressed(file_name.empty() ? "/dev/stdin" : file_name.c_str(),
+		                                          schema->peek(), &error);
+		if (!jis_valid(json))
 		{
-			if (!parser.begin(*schema.get(), &error_handler))
+			if (error)
 			{
-				cerr << "Failed to parse JSON stdin" << endl;
-				return 1;
-			}
-
-			string buf;
-			while (getline(cin, buf))
-			{
-				if (!parser.feed(buf))
-				{
-					cerr << "Failed to parse JSON stdin" << endl;
-					return 1;
-				}
-			}
-
-			if (!parser.end())
-			{
-				cerr << "Failed to finalyze parse" << endl;
-				return 1;
-			}
-		}
-		else
-		{
-			// Try to parse the file
-			if (!parser.parseFile(file_name, *schema.get(), JFileOptNoOpt, &error_handler))
-			{
-				cerr << "Failed to parse JSON file " << file_name << endl;
-				return 1;
+				vector<char> message(jerror_to_string(error, NULL, 0) + 1);
+				jerror_to_string(error, message.data(), message.size());
+				cerr << message.data() << endl;
+				jerror_free(error);
 			}
+			cerr << "Failed to parse JSON " << (file_name.empty() ? "stdin" : file_name) << endl;
+			return 1;
 		}
+		j_release(&json);
 	}
 	catch (const std::exception &e)
 	{
@@ -25,7 +25,8 @@ if(NOT HAVE_FLAG_SANITIZE_ADDRESS_ALONE)
 	unset(CMAKE_REQUIRED_LIBRARIES)
 endif()
 
-if(HAVE_FLAG_SANITIZE_ADDRESS_ALONE OR HAVE_FLAG_SANITIZE_ADDRESS_LIBS)
+# The address sanitizer can't be combined with the thread one
+if((HAVE_FLAG_SANITIZE_ADDRESS_ALONE OR HAVE_FLAG_SANITIZE_ADDRESS_LIBS) AND NOT PBNJSON_SANITIZE_THREAD)
 	webos_add_compiler_flags(DEBUG -fsanitize=address)
 	webos_add_linker_options(DEBUG ${ASAN_LIBRARIES})
 endif()
@@ -0,0 +1,119 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include <gtest/gtest.h>
+#include <pbnjson.h>
+
+#include <string>
+
+namespace {
+
+class Arena : public ::testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		arena = jarena_create();
+		ASSERT_NE(nullptr, arena);
+		ASSERT_EQ(nullptr, jarena_set_current(arena));
+	}
+
+	void TearDown() override
+	{
+		jarena_set_current(NULL);
+		jarena_free(arena);
+	}
+
+	jarena_ref arena;
+};
+
+} // namespace
+
+TEST_F(Arena, Allocation)
+{
+	EXPECT_EQ(0u, jarena_size(arena));
+
+	jvalue_ref records = jarray_create(NULL);
+	for (int i = 0; i < 1000; ++i)
+	{
+		jvalue_ref record = jobject_create_var(
+			jkeyval(J_CSTR_TO_JVAL("id"), jnumber_create_i32(i)),
+			jkeyval(J_CSTR_TO_JVAL("name"), jstring_create(("record" + std::to_string(i)).c_str())),
+			J_END_OBJ_DECL);
+		ASSERT_TRUE(jarray_append(records, record));
+	}
+	EXPECT_GT(jarena_size(arena), 1000u * 3 * sizeof(void *));
+
+	// Reference counting doesn't touch arena values
+	jvalue_ref copy = jvalue_copy(records);
+	EXPECT_EQ(records, copy);
+	j_release(&copy);
+	j_release(&records);
+
+	int32_t id = -1;
+	EXPECT_EQ(CONV_OK, jnumber_get_i32(jobject_get(jarray_get(records, 999), J_CSTR_TO_BUF("id")), &id));
+	EXPECT_EQ(999, id);
+}
+
+TEST_F(Arena, Parse)
+{
+	const size_t before = jarena_size(arena);
+	jvalue_ref dom = jdom_create(J_CSTR_TO_BUF("{\"list\": [1, \"two\", {\"three\": 3.0}]}"), jschema_all(), NULL);
+	ASSERT_TRUE(jis_object(dom));
+	EXPECT_LT(before, jarena_size(arena));
+	EXPECT_STREQ("{\"list\":[1,\"two\",{\"three\":3.0}]}", jvalue_stringify(dom));
+	j_release(&dom);
+}
+
+TEST_F(Arena, Outside)
+{
+	jarena_set_current(NULL);
+	jvalue_ref outside = jstring_create("outside");
+	jarena_set_current(arena);
+
+	// Heap values put into arena values are released with the arena
+	jvalue_ref obj = jobject_create();
+	EXPECT_TRUE(jobject_set(obj, J_CSTR_TO_BUF("outside"), outside));
+	EXPECT_TRUE(jarray_append(jarray_create_var(NULL, J_END_ARRAY_DECL), jvalue_copy(outside)));
+	j_release(&outside);
+
+	// Deep copy made out of the arena outlives it
+	jarena_set_current(NULL);
+	jvalue_ref kept = jvalue_duplicate(obj);
+	jarena_free(arena);
+	arena = NULL;
+
+	EXPECT_TRUE(jstring_equal2(jobject_get(kept, J_CSTR_TO_BUF("outside")), J_CSTR_TO_BUF("outside")));
+	j_release(&kept);
+}
+
+TEST_F(Arena, Schema)
+{
+	jschema_ref schema = jschema_create(J_CSTR_TO_BUF("{\"type\": \"object\", \"default\": {\"a\": [1, 2]}}"), NULL);
+	ASSERT_NE(nullptr, schema);
+	EXPECT_EQ(arena, jarena_set_current(arena));
+
+	// Schemas are parsed out of the arena and survive it
+	jarena_set_current(NULL);
+	jarena_free(arena);
+	arena = jarena_create();
+	jarena_set_current(arena);
+
+	jvalue_ref dom = jdom_create(J_CSTR_TO_BUF("{}"), schema, NULL);
+	EXPECT_TRUE(jis_object(dom));
+	jschema_release(&schema);
+}
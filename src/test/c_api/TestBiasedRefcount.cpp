@@ -0,0 +1,218 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+// The values are freed exactly once whichever thread releases them last.
+// Run under the thread sanitizer (PBNJSON_SANITIZE_THREAD) to check the races,
+// under the address sanitizer to check the leaks.
+
+#include <gtest/gtest.h>
+#include <pbnjson.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+jvalue_ref makeDom(int size)
+{
+	jvalue_ref records = jarray_create(NULL);
+	for (int i = 0; i < size; ++i)
+		jarray_append(records, jobject_create_var(
+			jkeyval(J_CSTR_TO_JVAL("id"), jnumber_create_i32(i)),
+			jkeyval(J_CSTR_TO_JVAL("name"), jstring_create("record")),
+			J_END_OBJ_DECL));
+	return records;
+}
+
+void touch(jvalue_ref dom, int rounds)
+{
+	for (int round = 0; round < rounds; ++round)
+	{
+		for (ssize_t i = 0; i < jarray_size(dom); ++i)
+		{
+			jvalue_ref record = jvalue_copy(jarray_get(dom, i));
+			jvalue_ref id = jvalue_copy(jobject_get(record, J_CSTR_TO_BUF("id")));
+			int32_t value = -1;
+			jnumber_get_i32(id, &value);
+			EXPECT_EQ(i, value);
+			j_release(&id);
+			j_release(&record);
+		}
+	}
+}
+
+} // namespace
+
+TEST(BiasedRefcount, SharedWithOwner)
+{
+	jvalue_ref dom = makeDom(100);
+
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; ++t)
+		threads.emplace_back([dom]() { touch(dom, 100); });
+	touch(dom, 100);
+	for (auto &thread : threads)
+		thread.join();
+
+	j_release(&dom);
+}
+
+TEST(BiasedRefcount, ReleasedByConsumer)
+{
+	const int count = 50;
+
+	std::mutex lock;
+	std::condition_variable cond;
+	jvalue_ref box = NULL;
+
+	// The consumer releases the last references while the producer is alive
+	std::thread consumer([&]() {
+		for (int i = 0; i < count; ++i)
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			cond.wait(guard, [&]() { return box != NULL; });
+			jvalue_ref dom = box;
+			box = NULL;
+			guard.unlock();
+			cond.notify_all();
+
+			touch(dom, 2);
+			j_release(&dom);
+		}
+	});
+
+	for (int i = 0; i < count; ++i)
+	{
+		jvalue_ref dom = makeDom(50);
+		std::unique_lock<std::mutex> guard(lock);
+		cond.wait(guard, [&]() { return box == NULL; });
+		box = dom;
+		guard.unlock();
+		cond.notify_all();
+	}
+	consumer.join();
+}
+
+TEST(BiasedRefcount, IdleOwner)
+{
+	std::mutex lock;
+	std::condition_variable cond;
+	jvalue_ref box = NULL;
+	bool done = false;
+
+	std::thread producer([&]() {
+		// The worker releases the last reference, the producer has to complete it
+		jvalue_ref dom = makeDom(100);
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			box = jvalue_copy(dom);
+		}
+		j_release(&dom);
+		cond.notify_all();
+
+		// Creates nothing while waiting
+		std::unique_lock<std::mutex> guard(lock);
+		cond.wait(guard, [&]() { return done; });
+		guard.unlock();
+
+		// The array, 100 records and their members
+		EXPECT_LE(300u, j_release_pending());
+		EXPECT_EQ(0u, j_release_pending());
+	});
+
+	std::thread worker([&]() {
+		std::unique_lock<std::mutex> guard(lock);
+		cond.wait(guard, [&]() { return box != NULL; });
+		jvalue_ref dom = box;
+		box = NULL;
+		guard.unlock();
+
+		touch(dom, 2);
+		j_release(&dom);
+
+		guard.lock();
+		done = true;
+		guard.unlock();
+		cond.notify_all();
+	});
+
+	worker.join();
+	producer.join();
+}
+
+TEST(BiasedRefcount, OwnerExited)
+{
+	std::vector<jvalue_ref> doms(20);
+	for (auto &dom : doms)
+	{
+		std::thread producer([&dom]() {
+			dom = makeDom(30);
+			jvalue_ref copy = jvalue_copy(dom);
+			j_release(&copy);
+		});
+		producer.join();
+	}
+
+	std::vector<std::thread> threads;
+	for (size_t t = 0; t < 4; ++t)
+		threads.emplace_back([&doms, t]() {
+			for (size_t i = t; i < doms.size(); i += 4)
+			{
+				touch(doms[i], 3);
+				j_release(&doms[i]);
+			}
+		});
+	for (auto &thread : threads)
+		thread.join();
+}
+
+TEST(BiasedRefcount, OwnerReleasedFirst)
+{
+	jvalue_ref dom = makeDom(10);
+
+	jvalue_ref copy = NULL;
+	std::thread([&]() { copy = jvalue_copy(dom); }).join();
+
+	// The owner drops its references, the copy of the other thread keeps the value
+	j_release(&dom);
+
+	std::thread([&]() {
+		touch(copy, 3);
+		j_release(&copy);
+	}).join();
+}
+
+TEST(BiasedRefcount, ManyThreads)
+{
+	for (int round = 0; round < 10; ++round)
+	{
+		std::vector<jvalue_ref> kept(16);
+		std::vector<std::thread> threads;
+		for (size_t t = 0; t < kept.size(); ++t)
+			threads.emplace_back([&kept, t]() {
+				jvalue_ref dom = makeDom(5);
+				kept[t] = jvalue_copy(jarray_get(dom, 0));
+				j_release(&dom);
+			});
+		for (auto &thread : threads)
+			thread.join();
+
+		for (auto &value : kept)
+			j_release(&value);
+	}
+}
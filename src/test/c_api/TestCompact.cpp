@@ -0,0 +1,193 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include <gtest/gtest.h>
+#include <pbnjson.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+jvalue_ref makeRecord(int n)
+{
+	return jobject_create_var(
+		jkeyval(J_CSTR_TO_JVAL("id"), jnumber_create_i32(n)),
+		jkeyval(J_CSTR_TO_JVAL("name"), jstring_create(("record" + std::to_string(n)).c_str())),
+		jkeyval(J_CSTR_TO_JVAL("active"), jboolean_create(n % 2)),
+		J_END_OBJ_DECL);
+}
+
+// Built up by edits, like a long-lived config
+jvalue_ref makeDom()
+{
+	jvalue_ref records = jarray_create(NULL);
+	for (int i = 0; i < 100; ++i)
+		jarray_append(records, makeRecord(i));
+	for (int i = 0; i < 100; i += 3)
+		jobject_set(jarray_get(records, i), J_CSTR_TO_BUF("name"), jstring_create("renamed"));
+
+	jvalue_ref dom = jobject_create();
+	jobject_set(dom, J_CSTR_TO_BUF("records"), records);
+	jobject_set(dom, J_CSTR_TO_BUF("list"), jarray_create_var(NULL,
+		jnull(), jboolean_true(), jboolean_false(), jstring_empty(),
+		jnumber_create_f64(0.5), jnumber_create_i64(-1234567890123LL),
+		jnumber_create(J_CSTR_TO_BUF("1234.25")),
+		J_END_ARRAY_DECL));
+	jobject_set(dom, J_CSTR_TO_BUF("empty"), jobject_create());
+	jobject_set(dom, J_CSTR_TO_BUF("nested"), jobject_create_var(
+		jkeyval(J_CSTR_TO_JVAL("array"), jarray_create(NULL)),
+		J_END_OBJ_DECL));
+	jobject_remove(dom, J_CSTR_TO_BUF("empty"));
+	jobject_set(dom, J_CSTR_TO_BUF("empty"), jobject_create());
+	return dom;
+}
+
+} // namespace
+
+TEST(Compact, SameContent)
+{
+	jvalue_ref dom = makeDom();
+	jvalue_ref original = jvalue_duplicate(dom);
+	jvalue_ref before = dom;
+
+	ASSERT_TRUE(jvalue_compact(&dom));
+	EXPECT_NE(before, dom);
+	EXPECT_TRUE(jvalue_equal(original, dom));
+
+	jvalue_ref records = jobject_get(dom, J_CSTR_TO_BUF("records"));
+	ASSERT_EQ(100, jarray_size(records));
+	int32_t id = -1;
+	EXPECT_EQ(CONV_OK, jnumber_get_i32(jobject_get(jarray_get(records, 42), J_CSTR_TO_BUF("id")), &id));
+	EXPECT_EQ(42, id);
+	EXPECT_EQ("renamed", std::string(jstring_get_fast(jobject_get(jarray_get(records, 3), J_CSTR_TO_BUF("name"))).m_str));
+	EXPECT_EQ("record4", std::string(jstring_get_fast(jobject_get(jarray_get(records, 4), J_CSTR_TO_BUF("name"))).m_str));
+	EXPECT_FALSE(jobject_containskey(dom, J_CSTR_TO_BUF("missing")));
+
+	EXPECT_EQ(std::string(jvalue_stringify(original)), std::string(jvalue_stringify(dom)));
+
+	j_release(&original);
+	j_release(&dom);
+}
+
+TEST(Compact, DepthFirstLayout)
+{
+	jvalue_ref dom = makeDom();
+	ASSERT_TRUE(jvalue_compact(&dom));
+
+	// Every record with its members lies between the record and the next one
+	jvalue_ref records = jobject_get(dom, J_CSTR_TO_BUF("records"));
+	for (ssize_t i = 0; i + 1 < jarray_size(records); ++i)
+	{
+		jvalue_ref record = jarray_get(records, i);
+		jvalue_ref next = jarray_get(records, i + 1);
+		jvalue_ref name = jobject_get(record, J_CSTR_TO_BUF("name"));
+		EXPECT_LT((void *) record, (void *) name);
+		EXPECT_LT((void *) name, (void *) next);
+		EXPECT_LT((void *) jstring_get_fast(name).m_str, (void *) next);
+	}
+
+	j_release(&dom);
+}
+
+TEST(Compact, ReadOnly)
+{
+	jvalue_ref dom = makeDom();
+	ASSERT_TRUE(jvalue_compact(&dom));
+
+	EXPECT_FALSE(jobject_set(dom, J_CSTR_TO_BUF("new"), jnumber_create_i32(1)));
+	EXPECT_FALSE(jarray_append(jobject_get(dom, J_CSTR_TO_BUF("records")), jnull()));
+
+	jvalue_ref copy = jvalue_duplicate(dom);
+	EXPECT_TRUE(jvalue_equal(copy, dom));
+	EXPECT_TRUE(jobject_set(copy, J_CSTR_TO_BUF("new"), jnumber_create_i32(1)));
+	EXPECT_FALSE(jvalue_equal(copy, dom));
+
+	// Compacting again takes the edits
+	ASSERT_TRUE(jvalue_compact(&copy));
+	EXPECT_TRUE(jobject_containskey(copy, J_CSTR_TO_BUF("new")));
+
+	j_release(&copy);
+	j_release(&dom);
+}
+
+TEST(Compact, ReferencesKeepBlock)
+{
+	jvalue_ref dom = makeDom();
+	ASSERT_TRUE(jvalue_compact(&dom));
+
+	jvalue_ref record = jvalue_copy(jarray_get(jobject_get(dom, J_CSTR_TO_BUF("records")), 7));
+	jvalue_ref holder = jarray_create(NULL);
+	jarray_append(holder, jvalue_copy(jobject_get(dom, J_CSTR_TO_BUF("list"))));
+	j_release(&dom);
+
+	int32_t id = -1;
+	EXPECT_EQ(CONV_OK, jnumber_get_i32(jobject_get(record, J_CSTR_TO_BUF("id")), &id));
+	EXPECT_EQ(7, id);
+	EXPECT_EQ(7, jarray_size(jarray_get(holder, 0)));
+
+	j_release(&record);
+	j_release(&holder);
+}
+
+TEST(Compact, Threads)
+{
+	jvalue_ref dom = makeDom();
+	ASSERT_TRUE(jvalue_compact(&dom));
+
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; ++t)
+		threads.emplace_back([dom]() {
+			jvalue_ref records = jobject_get(dom, J_CSTR_TO_BUF("records"));
+			for (int round = 0; round < 100; ++round)
+			{
+				for (ssize_t i = 0; i < jarray_size(records); ++i)
+				{
+					jvalue_ref record = jvalue_copy(jarray_get(records, i));
+					int32_t id = -1;
+					jnumber_get_i32(jobject_get(record, J_CSTR_TO_BUF("id")), &id);
+					EXPECT_EQ(i, id);
+					j_release(&record);
+				}
+			}
+		});
+	for (auto &thread : threads)
+		thread.join();
+
+	j_release(&dom);
+}
+
+TEST(Compact, Scalars)
+{
+	jvalue_ref null = jnull();
+	EXPECT_TRUE(jvalue_compact(&null));
+	EXPECT_TRUE(jis_null(null));
+
+	jvalue_ref boolean = jboolean_true();
+	EXPECT_TRUE(jvalue_compact(&boolean));
+	EXPECT_EQ(jboolean_true(), boolean);
+
+	jvalue_ref str = jstring_create("text");
+	ASSERT_TRUE(jvalue_compact(&str));
+	EXPECT_EQ("text", std::string(jstring_get_fast(str).m_str));
+	j_release(&str);
+
+	jvalue_ref invalid = jinvalid();
+	EXPECT_FALSE(jvalue_compact(&invalid));
+	EXPECT_EQ(jinvalid(), invalid);
+}
@@ -0,0 +1,113 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include <gtest/gtest.h>
+#include <pbnjson.h>
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const int RECORDS = 20000;
+const int FIELDS = 8;
+const int ROUNDS = 20;
+
+string field(int n)
+{
+	return "field" + to_string(n);
+}
+
+// Records are filled in random order among other allocations and edited afterwards,
+// so their nodes and strings end up spread over the heap
+jvalue_ref makeConfig()
+{
+	mt19937 random(42);
+	vector<jvalue_ref> garbage;
+
+	jvalue_ref config = jarray_create(NULL);
+	for (int i = 0; i < RECORDS; ++i)
+		jarray_append(config, jobject_create());
+
+	for (int round = 0; round < 3; ++round)
+	{
+		for (int n = 0; n < RECORDS * FIELDS; ++n)
+		{
+			jvalue_ref record = jarray_get(config, random() % RECORDS);
+			string key = field(random() % FIELDS);
+			string text = "value " + to_string(random());
+			jobject_set(record, j_str_to_buffer(key.c_str(), key.size()), jstring_create(text.c_str()));
+			garbage.push_back(jstring_create(text.c_str()));
+		}
+		for (auto &value : garbage)
+			j_release(&value);
+		garbage.clear();
+	}
+	return config;
+}
+
+size_t traverse(jvalue_ref config)
+{
+	size_t sum = 0;
+	for (int round = 0; round < ROUNDS; ++round)
+	{
+		for (ssize_t i = 0; i < jarray_size(config); ++i)
+		{
+			jvalue_ref record = jarray_get(config, i);
+			jobject_iter it;
+			jobject_key_value member;
+			jobject_iter_init(&it, record);
+			while (jobject_iter_next(&it, &member))
+				sum += jstring_get_fast(member.key).m_len + jstring_get_fast(member.value).m_len;
+		}
+	}
+	return sum;
+}
+
+double measure(jvalue_ref config, size_t &sum)
+{
+	auto start = chrono::steady_clock::now();
+	sum = traverse(config);
+	chrono::duration<double, milli> ms = chrono::steady_clock::now() - start;
+	return ms.count();
+}
+
+} // namespace
+
+TEST(CompactPerformance, Traversal)
+{
+	jvalue_ref config = makeConfig();
+
+	size_t scattered_sum = 0, compact_sum = 0;
+	double scattered = measure(config, scattered_sum);
+	ASSERT_TRUE(jvalue_compact(&config));
+	double compact = measure(config, compact_sum);
+
+	EXPECT_EQ(scattered_sum, compact_sum);
+
+	cout << "Traversal of " << RECORDS << " edited records " << ROUNDS << " times, smaller is better." << endl;
+	cout << left << setw(10) << "scattered" << " ms: " << fixed << setprecision(1) << scattered << endl;
+	cout << left << setw(10) << "compact" << " ms: " << fixed << setprecision(1) << compact << endl;
+
+	j_release(&config);
+}
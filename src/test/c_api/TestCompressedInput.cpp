@@ -0,0 +1,248 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include <gtest/gtest.h>
+#include <pbnjson.h>
+#include <zlib.h>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+// Big enough to span many decompressed chunks
+std::string makeJson()
+{
+	std::string json = "[";
+	for (int i = 0; i < 20000; ++i)
+	{
+		if (i) json += ",";
+		json += "{\"id\":" + std::to_string(i) + ",\"name\":\"record" + std::to_string(i) + "\",\"tags\":[true,false,null]}";
+	}
+	return json + "]";
+}
+
+class CompressedInput : public ::testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		json = makeJson();
+		prefix = "compressed-input-" + std::to_string(getpid());
+	}
+
+	void TearDown() override
+	{
+		for (const auto &file : files)
+			std::remove(file.c_str());
+	}
+
+	std::string writePlain(const std::string &content)
+	{
+		std::string file = prefix + "-" + std::to_string(files.size());
+		std::ofstream(file, std::ios::binary) << content;
+		files.push_back(file);
+		return file;
+	}
+
+	// Every part is written as a separate gzip member
+	std::string writeGzip(const std::vector<std::string> &parts)
+	{
+		std::string file = prefix + "-" + std::to_string(files.size()) + ".gz";
+		files.push_back(file);
+		for (const auto &part : parts)
+		{
+			gzFile gz = gzopen(file.c_str(), "ab");
+			gzwrite(gz, part.data(), part.size());
+			gzclose(gz);
+		}
+		return file;
+	}
+
+#ifdef HAVE_ZSTD
+	// Every part is written as a separate zstd frame
+	std::string writeZstd(const std::vector<std::string> &parts)
+	{
+		std::string content;
+		for (const auto &part : parts)
+		{
+			std::string frame(ZSTD_compressBound(part.size()), '\0');
+			size_t len = ZSTD_compress(&frame[0], frame.size(), part.data(), part.size(), 3);
+			EXPECT_FALSE(ZSTD_isError(len));
+			content += frame.substr(0, len);
+		}
+		return writePlain(content);
+	}
+#endif
+
+	std::string readFile(const std::string &file)
+	{
+		std::ifstream in(file, std::ios::binary);
+		return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+	}
+
+	std::string json;
+	std::string prefix;
+	std::vector<std::string> files;
+};
+
+} // namespace
+
+TEST_F(CompressedInput, Gzip)
+{
+	jvalue_ref expected = jdom_create(j_cstr_to_buffer(json.c_str()), jschema_all(), NULL);
+	ASSERT_TRUE(jis_array(expected));
+
+	jerror *err = NULL;
+	jvalue_ref parsed = jdom_fcreate_compressed(writeGzip({json}).c_str(), jschema_all(), &err);
+	EXPECT_EQ(nullptr, err);
+	EXPECT_TRUE(jvalue_equal(expected, parsed));
+	j_release(&parsed);
+
+	// Concatenated members make a single document
+	parsed = jdom_fcreate_compressed(writeGzip({json.substr(0, 1000), json.substr(1000)}).c_str(),
+	                                 jschema_all(), NULL);
+	EXPECT_TRUE(jvalue_equal(expected, parsed));
+	j_release(&parsed);
+
+	j_release(&expected);
+}
+
+#ifdef HAVE_ZSTD
+TEST_F(CompressedInput, Zstd)
+{
+	jvalue_ref expected = jdom_create(j_cstr_to_buffer(json.c_str()), jschema_all(), NULL);
+	ASSERT_TRUE(jis_array(expected));
+
+	jerror *err = NULL;
+	jvalue_ref parsed = jdom_fcreate_compressed(writeZstd({json}).c_str(), jschema_all(), &err);
+	EXPECT_EQ(nullptr, err);
+	EXPECT_TRUE(jvalue_equal(expected, parsed));
+	j_release(&parsed);
+
+	// Concatenated frames make a single document
+	parsed = jdom_fcreate_compressed(writeZstd({json.substr(0, 1000), json.substr(1000)}).c_str(),
+	                                 jschema_all(), NULL);
+	EXPECT_TRUE(jvalue_equal(expected, parsed));
+	j_release(&parsed);
+
+	j_release(&expected);
+}
+
+// The decoded content fills the last chunk of 64 KiB exactly
+TEST_F(CompressedInput, ZstdWholeChunks)
+{
+	const size_t chunk = 64 * 1024;
+	for (size_t size : { chunk, 4 * chunk })
+	{
+		std::string padded = json.substr(0, json.find("},{", size / 2) + 1) + "]";
+		ASSERT_LT(padded.size(), size);
+		padded.insert(padded.size() - 1, size - padded.size(), ' ');
+		ASSERT_EQ(size, padded.size());
+
+		jvalue_ref expected = jdom_create(j_cstr_to_buffer(padded.c_str()), jschema_all(), NULL);
+		ASSERT_TRUE(jis_array(expected));
+
+		for (const auto &parts : { std::vector<std::string>{padded},
+		                           std::vector<std::string>{padded.substr(0, chunk), padded.substr(chunk)} })
+		{
+			jerror *err = NULL;
+			jvalue_ref parsed = jdom_fcreate_compressed(writeZstd(parts).c_str(), jschema_all(), &err);
+			EXPECT_EQ(nullptr, err) << size;
+			EXPECT_TRUE(jvalue_equal(expected, parsed)) << size;
+			jerror_free(err);
+			j_release(&parsed);
+		}
+
+		j_release(&expected);
+	}
+}
+#endif
+
+TEST_F(CompressedInput, Plain)
+{
+	jvalue_ref expected = jdom_create(j_cstr_to_buffer(json.c_str()), jschema_all(), NULL);
+
+	jvalue_ref parsed = jdom_fcreate_compressed(writePlain(json).c_str(), jschema_all(), NULL);
+	EXPECT_TRUE(jvalue_equal(expected, parsed));
+	j_release(&parsed);
+
+	j_release(&expected);
+}
+
+TEST_F(CompressedInput, Sax)
+{
+	int keys = 0;
+	PJSAXCallbacks callbacks = { 0 };
+	callbacks.m_objKey = [](JSAXContextRef ctxt, const char *, size_t) -> int
+	{
+		++*static_cast<int *>(jsax_getContext(ctxt));
+		return 1;
+	};
+
+	jsaxparser_ref parser = jsaxparser_new(jschema_all(), &callbacks, &keys);
+	ASSERT_NE(nullptr, parser);
+	EXPECT_TRUE(jsaxparser_feed_compressed(parser, writeGzip({json}).c_str(), NULL));
+	EXPECT_TRUE(jsaxparser_end(parser));
+	jsaxparser_release(&parser);
+
+	EXPECT_EQ(3 * 20000, keys);
+}
+
+TEST_F(CompressedInput, Errors)
+{
+	jerror *err = NULL;
+	EXPECT_FALSE(jis_valid(jdom_fcreate_compressed("compressed-input-missing", jschema_all(), &err)));
+	EXPECT_NE(nullptr, err);
+	jerror_free(err);
+
+	// Truncated stream
+	std::string gz = readFile(writeGzip({json}));
+	err = NULL;
+	EXPECT_FALSE(jis_valid(jdom_fcreate_compressed(writePlain(gz.substr(0, gz.size() / 2)).c_str(),
+	                                               jschema_all(), &err)));
+	EXPECT_NE(nullptr, err);
+	jerror_free(err);
+
+#ifdef HAVE_ZSTD
+	std::string zst = readFile(writeZstd({json}));
+	err = NULL;
+	EXPECT_FALSE(jis_valid(jdom_fcreate_compressed(writePlain(zst.substr(0, zst.size() / 2)).c_str(),
+	                                               jschema_all(), &err)));
+	EXPECT_NE(nullptr, err);
+	jerror_free(err);
+
+	// A frame cut at its very end
+	err = NULL;
+	EXPECT_FALSE(jis_valid(jdom_fcreate_compressed(writePlain(zst.substr(0, zst.size() - 1)).c_str(),
+	                                               jschema_all(), &err)));
+	EXPECT_NE(nullptr, err);
+	jerror_free(err);
+#endif
+
+	// Invalid JSON inside
+	err = NULL;
+	EXPECT_FALSE(jis_valid(jdom_fcreate_compressed(writeGzip({"{\"a\":"}).c_str(), jschema_all(), &err)));
+	EXPECT_NE(nullptr, err);
+	jerror_free(err);
+}
@@ -111,3 +111,169 @@ TEST(JobjRemove2, GetNested)
 
 	j_release(&root);
 }
+
+namespace {
+
+jvalue_ref numbers(int from, int to)
+{
+	jvalue_ref arr = jarray_create(NULL);
+	for (int i = from; i < to; ++i)
+		jarray_append(arr, jnumber_create_i32(i));
+	return arr;
+}
+
+int32_t at(jvalue_ref arr, ssize_t i)
+{
+	int32_t n = -1;
+	jnumber_get_i32(jarray_get(arr, i), &n);
+	return n;
+}
+
+string dump(jvalue_ref arr)
+{
+	return jvalue_stringify(arr);
+}
+
+} // namespace
+
+TEST(JarraySplice, ReplaceRange)
+{
+	jvalue_ref a = numbers(0, 40);
+	jvalue_ref b = numbers(100, 105);
+
+	// Fewer elements than removed
+	ASSERT_TRUE(jarray_splice(a, 2, 30, b, 1, 3, SPLICE_COPY));
+	EXPECT_EQ("[0,1,101,102,32,33,34,35,36,37,38,39]", dump(a));
+	EXPECT_EQ(5, jarray_size(b));
+
+	// More elements than removed, the array grows past the small bucket
+	jvalue_ref c = numbers(200, 230);
+	ASSERT_TRUE(jarray_splice(a, 1, 1, c, 0, 30, SPLICE_COPY));
+	EXPECT_EQ(41, jarray_size(a));
+	EXPECT_EQ(200, at(a, 1));
+	EXPECT_EQ(229, at(a, 30));
+	EXPECT_EQ(101, at(a, 31));
+	EXPECT_EQ(39, at(a, 40));
+	EXPECT_FALSE(jis_valid(jarray_get(a, 41)));
+
+	j_release(&c);
+
+	j_release(&a);
+	j_release(&b);
+}
+
+TEST(JarraySplice, Transfer)
+{
+	jvalue_ref a = numbers(0, 3);
+	jvalue_ref b = numbers(10, 50);
+
+	ASSERT_TRUE(jarray_splice(a, 1, 0, b, 5, 35, SPLICE_TRANSFER));
+	EXPECT_EQ(33, jarray_size(a));
+	EXPECT_EQ(0, at(a, 0));
+	EXPECT_EQ(15, at(a, 1));
+	EXPECT_EQ(44, at(a, 30));
+	EXPECT_EQ(1, at(a, 31));
+
+	// The transferred range is cut out of the source
+	EXPECT_EQ("[10,11,12,13,14,45,46,47,48,49]", dump(b));
+
+	EXPECT_FALSE(jarray_splice(a, 0, 0, a, 0, 1, SPLICE_TRANSFER));
+
+	j_release(&a);
+	j_release(&b);
+}
+
+TEST(JarraySplice, AppendAndInject)
+{
+	jvalue_ref a = numbers(0, 3);
+	jvalue_ref b = numbers(3, 6);
+
+	ASSERT_TRUE(jarray_splice_append(a, b, SPLICE_COPY));
+	EXPECT_EQ("[0,1,2,3,4,5]", dump(a));
+
+	ASSERT_TRUE(jarray_splice_inject(a, 100, b, SPLICE_COPY));
+	EXPECT_EQ("[0,1,2,3,4,5,3,4,5]", dump(a));
+
+	ASSERT_TRUE(jarray_splice_inject(a, 0, b, SPLICE_TRANSFER));
+	EXPECT_EQ("[3,4,5,0,1,2,3,4,5,3,4,5]", dump(a));
+	EXPECT_EQ(0, jarray_size(b));
+
+	j_release(&a);
+	j_release(&b);
+}
+
+TEST(JarraySplice, SameArray)
+{
+	jvalue_ref a = numbers(0, 20);
+
+	ASSERT_TRUE(jarray_splice(a, 0, 2, a, 18, 20, SPLICE_COPY));
+	EXPECT_EQ(18, at(a, 0));
+	EXPECT_EQ(19, at(a, 1));
+	EXPECT_EQ(2, at(a, 2));
+	EXPECT_EQ(20, jarray_size(a));
+
+	j_release(&a);
+}
+
+TEST(JarraySplice, Cycle)
+{
+	jvalue_ref a = numbers(0, 2);
+	jvalue_ref b = jarray_create(NULL);
+	jvalue_ref nested = jobject_create();
+	jobject_put(nested, J_CSTR_TO_JVAL("a"), jvalue_copy(a));
+	jarray_append(b, jnumber_create_i32(1));
+	jarray_append(b, nested);
+
+	// Only the inserted range matters
+	EXPECT_TRUE(jarray_splice(a, 0, 0, b, 0, 1, SPLICE_COPY));
+	EXPECT_FALSE(jarray_splice(a, 0, 0, b, 1, 2, SPLICE_COPY));
+	EXPECT_EQ("[1,0,1]", dump(a));
+
+	j_release(&a);
+	j_release(&b);
+}
+
+TEST(JobjFromArrays, Create)
+{
+	jvalue_ref keys[] = { J_CSTR_TO_JVAL("a"), J_CSTR_TO_JVAL("b"), J_CSTR_TO_JVAL("c") };
+
+	jvalue_ref values[] = { jnumber_create_i32(1), jstring_create("two"), jarray_create(NULL) };
+	jvalue_ref obj = jobject_create_from_arrays(keys, values, 3);
+	ASSERT_TRUE(jis_object(obj));
+	EXPECT_EQ(3, jobject_size(obj));
+	EXPECT_EQ(values[0], jobject_get(obj, J_CSTR_TO_BUF("a")));
+	EXPECT_EQ(values[1], jobject_get(obj, J_CSTR_TO_BUF("b")));
+	EXPECT_EQ(values[2], jobject_get(obj, J_CSTR_TO_BUF("c")));
+	j_release(&obj);
+
+	// Keys are borrowed, values may be missing
+	jvalue_ref key = jstring_create("key");
+	jvalue_ref value = NULL;
+	obj = jobject_create_from_arrays(&key, &value, 1);
+	ASSERT_TRUE(jis_object(obj));
+	EXPECT_TRUE(jis_null(jobject_get(obj, J_CSTR_TO_BUF("key"))));
+	j_release(&key);
+	EXPECT_TRUE(jobject_containskey(obj, J_CSTR_TO_BUF("key")));
+	j_release(&obj);
+
+	obj = jobject_create_from_arrays(NULL, NULL, 0);
+	EXPECT_TRUE(jis_object(obj));
+	EXPECT_EQ(0, jobject_size(obj));
+	j_release(&obj);
+}
+
+TEST(JobjFromArrays, Invalid)
+{
+	jvalue_ref duplicate[] = { J_CSTR_TO_JVAL("a"), J_CSTR_TO_JVAL("b"), J_CSTR_TO_JVAL("a"), J_CSTR_TO_JVAL("c") };
+	jvalue_ref values[] = { jnumber_create_i32(1), jnumber_create_i32(2), jnumber_create_i32(3), jnumber_create_i32(4) };
+	EXPECT_FALSE(jis_valid(jobject_create_from_arrays(duplicate, values, 4)));
+
+	jvalue_ref empty[] = { J_CSTR_TO_JVAL("a"), J_CSTR_TO_JVAL("") };
+	jvalue_ref values2[] = { jnumber_create_i32(1), jnumber_create_i32(2) };
+	EXPECT_FALSE(jis_valid(jobject_create_from_arrays(empty, values2, 2)));
+
+	jvalue_ref number[] = { jnumber_create_i32(1) };
+	jvalue_ref values3[] = { jnumber_create_i32(1) };
+	EXPECT_FALSE(jis_valid(jobject_create_from_arrays(number, values3, 1)));
+	j_release(&number[0]);
+}
@@ -23,6 +23,8 @@
 #include <algorithm>
 #include <fstream>
 #include <functional>
+#include <cstring>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -656,3 +658,136 @@ TEST(TestParse, ElementParser)
 	ASSERT_FAIL("null", R"({"type":"number"})");
 	ASSERT_FAIL("null", R"({"type":"string"})");
 }
+
+namespace {
+
+// Parse with the stream parser fed by pieces of the given size
+jvalue_ref parseByPieces(const std::string &json, size_t piece)
+{
+	jdomparser_ref parser = jdomparser_new(jschema_all());
+	bool ok = true;
+	for (size_t i = 0; ok && i < json.size(); i += piece)
+		ok = jdomparser_feed(parser, json.data() + i, std::min(piece, json.size() - i));
+	jvalue_ref result = ok && jdomparser_end(parser) ? jdomparser_get_result(parser) : jinvalid();
+	jdomparser_release(&parser);
+	return result;
+}
+
+} // namespace
+
+TEST(TestParse, WhitespaceAndComments)
+{
+	const std::string pretty =
+		"// config\n"
+		"{\n"
+		"    /* block\n"
+		"     * comment **/\n"
+		"    \"key  //\" :    \"value /* */  \\\"  \" , // line\n"
+		"\t\t\"list\":[  1 ,/**/2,\r\n  3  ]   ,\n"
+		"    \"empty\" : { }\n"
+		"}   // trailing\n";
+	jptr_value expected{ jdom_create(j_cstr_to_buffer(
+		R"({"key  //":"value /* */  \"  ","list":[1,2,3],"empty":{}})"), jschema_all(), NULL) };
+	ASSERT_TRUE(jis_object(expected));
+
+	for (size_t piece : {1, 2, 3, 7, 1000})
+	{
+		jptr_value parsed{ parseByPieces(pretty, piece) };
+		EXPECT_TRUE(jvalue_equal(expected, parsed)) << "piece " << piece;
+	}
+
+	// Comments separate tokens, and a slash out of them is still an error
+	for (const char *invalid : {"[1/**/2]", "[1 // x\n2]", "{}/", "{} /", "[1 /x]"})
+	{
+		for (size_t piece : {1, 1000})
+			EXPECT_FALSE(jis_valid(parseByPieces(invalid, piece))) << invalid << " piece " << piece;
+	}
+}
+
+namespace {
+
+int recordLocation(JSAXContextRef ctxt, const char *, size_t)
+{
+	auto locations = static_cast<std::vector<jlocation> *>(jsax_getContext(ctxt));
+	jlocation location;
+	EXPECT_TRUE(jsax_get_location(ctxt, &location));
+	locations->push_back(location);
+	return 1;
+}
+
+} // namespace
+
+TEST(TestParse, EventLocation)
+{
+	std::vector<jlocation> locations;
+	PJSAXCallbacks callbacks = {};
+	callbacks.m_number = recordLocation;
+
+	ASSERT_TRUE(jsax_parse_with_callbacks(j_cstr_to_buffer("[1,\n /* */ 22,\n   333]"), jschema_all(),
+	                                      &callbacks, &locations, NULL));
+	ASSERT_EQ(3u, locations.size());
+
+	// Events point right after their values
+	EXPECT_EQ(2u, locations[0].offset);
+	EXPECT_EQ(1u, locations[0].line);
+	EXPECT_EQ(3u, locations[0].column);
+	EXPECT_EQ(13u, locations[1].offset);
+	EXPECT_EQ(2u, locations[1].line);
+	EXPECT_EQ(10u, locations[1].column);
+	EXPECT_EQ(21u, locations[2].offset);
+	EXPECT_EQ(3u, locations[2].line);
+	EXPECT_EQ(7u, locations[2].column);
+}
+
+TEST(TestParse, ErrorLocation)
+{
+	jptr_schema schema{ jschema_create(j_cstr_to_buffer(
+		R"({"type":"object","properties":{"b":{"type":"string"}}})"), NULL) };
+	ASSERT_TRUE(schema.get());
+
+	const std::string json = "{\n  \"a\": 1, // one\n  \"b\": 2\n}";
+	const size_t offset = json.find('2') + 1;
+
+	jerror *error = NULL;
+	EXPECT_FALSE(jis_valid(jdom_create(j_str_to_buffer(json.data(), json.size()), schema, &error)));
+	jlocation location;
+	ASSERT_TRUE(jerror_get_location(error, &location));
+	EXPECT_EQ(offset, location.offset);
+	EXPECT_EQ(3u, location.line);
+	EXPECT_EQ(9u, location.column);
+
+	char str[256];
+	jerror_to_string(error, str, sizeof(str));
+	EXPECT_NE(nullptr, strstr(str, "(line 3, column 9, offset 27)")) << str;
+	jerror_free(error);
+
+	// The stream parser doesn't keep the chunks, but finds the same place
+	for (size_t piece : {1, 5, 1000})
+	{
+		jdomparser_ref parser = jdomparser_new(schema);
+		bool ok = true;
+		for (size_t i = 0; ok && i < json.size(); i += piece)
+			ok = jdomparser_feed(parser, json.data() + i, std::min(piece, json.size() - i));
+		EXPECT_FALSE(ok && jdomparser_end(parser));
+		ASSERT_TRUE(jdomparser_get_location(parser, &location));
+		EXPECT_EQ(offset, location.offset) << "piece " << piece;
+		EXPECT_EQ(3u, location.line) << "piece " << piece;
+		jdomparser_release(&parser);
+	}
+
+	// Syntax errors point where the text can't be parsed further
+	error = NULL;
+	EXPECT_FALSE(jis_valid(jdom_create(j_cstr_to_buffer("[\n  1,\n  ]"), jschema_all(), &error)));
+	ASSERT_TRUE(jerror_get_location(error, &location));
+	EXPECT_EQ(3u, location.line);
+	EXPECT_LE(3u, location.column);
+	jerror_free(error);
+
+	error = NULL;
+	EXPECT_FALSE(jis_valid(jdom_create(j_cstr_to_buffer("{\"a\":\n[1, 2"), jschema_all(), &error)));
+	ASSERT_TRUE(jerror_get_location(error, &location));
+	EXPECT_EQ(11u, location.offset);
+	EXPECT_EQ(2u, location.line);
+	EXPECT_EQ(6u, location.column);
+	jerror_free(error);
+}
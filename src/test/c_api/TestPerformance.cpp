@@ -100,6 +100,26 @@ void ParseSax(raw_buffer const &input, jschema_ref schema)
 	ASSERT_TRUE(jsax_parse(NULL, input, &schemaInfo));
 }
 
+bool CountOutput(void *ctxt, const char *buf, size_t len)
+{
+	*static_cast<size_t *>(ctxt) += len;
+	return true;
+}
+
+void Reformat(raw_buffer const &input, const char *indent)
+{
+	size_t written = 0;
+	ASSERT_TRUE(jreformat(input, jschema_all(), indent, CountOutput, &written, NULL));
+	ASSERT_LT(0u, written);
+}
+
+void ReformatDom(raw_buffer const &input, const char *indent)
+{
+	auto jv = mk_ptr(jdom_create(input, jschema_all(), NULL));
+	ASSERT_TRUE(jis_valid(jv.get()));
+	ASSERT_TRUE(indent ? jvalue_prettify(jv.get(), indent) : jvalue_stringify(jv.get()));
+}
+
 void ParsePpSax(raw_buffer const &input, jschema_ref schema)
 {
 	struct NoopParser final : pbnjson::JParser
@@ -300,6 +320,31 @@ const raw_buffer big_input = J_CSTR_TO_BUF(
 	"\"b1\" : true"
 	"}");
 const size_t big_input_size = big_input.m_len;
+
+// The same records minified, or indented and commented like config files
+std::string MakeRecords(bool pretty)
+{
+	std::string nl = pretty ? "\n" : "";
+	std::string indent = pretty ? "        " : "";
+	std::string json = "[" + nl;
+	for (int i = 0; i < 200; ++i)
+	{
+		if (i)
+			json += "," + nl;
+		if (pretty)
+			json += "    /* record " + std::to_string(i) + " */\n";
+		json += (pretty ? "    {\n" : "{")
+		     + indent + "\"id\":" + (pretty ? " " : "") + std::to_string(i) + "," + nl
+		     + indent + "\"name\":" + (pretty ? " " : "") + "\"record " + std::to_string(i) + "\"," + nl
+		     + (pretty ? indent + "// flags of the record\n" : "")
+		     + indent + "\"flags\":" + (pretty ? " " : "") + "[true, false, null]" + nl
+		     + (pretty ? "    }" : "}");
+	}
+	return json + nl + "]";
+}
+
+const std::string pretty_records = MakeRecords(true);
+const std::string minified_records = MakeRecords(false);
 } //namespace;
 
 TEST(Performance, ParseSmallInput)
@@ -526,6 +571,85 @@ TEST(Performance, ParseBigPbnjsonDomIter)
 		});
 }
 
+TEST(Performance, ParsePrettyPbnjsonSax)
+{
+	BenchmarkMBps("pbnjson-sax pretty:", pretty_records.size(), [&](size_t n)
+		{
+			for (; n > 0; --n)
+				ParseSax(j_str_to_buffer(pretty_records.data(), pretty_records.size()), jschema_all());
+		});
+}
+
+TEST(Performance, ParseMinifiedPbnjsonSax)
+{
+	BenchmarkMBps("pbnjson-sax minified:", minified_records.size(), [&](size_t n)
+		{
+			for (; n > 0; --n)
+				ParseSax(j_str_to_buffer(minified_records.data(), minified_records.size()), jschema_all());
+		});
+}
+
+TEST(Performance, ReformatMinified)
+{
+	raw_buffer input = j_str_to_buffer(minified_records.data(), minified_records.size());
+	BenchmarkMBps("pbnjson-reformat minify:", input.m_len, [&](size_t n)
+		{
+			for (; n > 0; --n)
+				Reformat(input, NULL);
+		});
+	BenchmarkMBps("pbnjson-reformat prettify:", input.m_len, [&](size_t n)
+		{
+			for (; n > 0; --n)
+				Reformat(input, "  ");
+		});
+	BenchmarkMBps("pbnjson-dom minify:", input.m_len, [&](size_t n)
+		{
+			for (; n > 0; --n)
+				ReformatDom(input, NULL);
+		});
+	BenchmarkMBps("pbnjson-dom prettify:", input.m_len, [&](size_t n)
+		{
+			for (; n > 0; --n)
+				ReformatDom(input, "  ");
+		});
+}
+
+TEST(Performance, ParseTokenizers)
+{
+	const std::string default_tokenizer = jparse_get_tokenizer();
+
+	for (size_t i = 0; const char *name = jparse_tokenizer_name(i); ++i)
+	{
+		ASSERT_TRUE(jparse_set_tokenizer(name));
+		const std::string prefix = std::string("pbnjson[") + name + "]";
+
+		BenchmarkMBps(prefix + "-sax big:", big_input_size, [&](size_t n)
+			{
+				for (; n > 0; --n)
+					ParseSax(big_input, jschema_all());
+			});
+		BenchmarkMBps(prefix + " (+opts) big:", big_input_size, [&](size_t n)
+			{
+				for (; n > 0; --n)
+					ParsePbnjson(big_input, OPT_ALL, jschema_all());
+			});
+		BenchmarkMBps(prefix + "-sax pretty:", pretty_records.size(), [&](size_t n)
+			{
+				for (; n > 0; --n)
+					ParseSax(j_str_to_buffer(pretty_records.data(), pretty_records.size()), jschema_all());
+			});
+		BenchmarkMBps(prefix + "-sax minified:", minified_records.size(), [&](size_t n)
+			{
+				for (; n > 0; --n)
+					ParseSax(j_str_to_buffer(minified_records.data(), minified_records.size()), jschema_all());
+			});
+	}
+
+	EXPECT_TRUE(jparse_set_tokenizer(default_tokenizer.c_str()));
+	EXPECT_FALSE(jparse_set_tokenizer("no such tokenizer"));
+	EXPECT_EQ(default_tokenizer, jparse_get_tokenizer());
+}
+
 TEST(Performance, AccessBigPbnjsonDom)
 {
 	auto root = mk_ptr(jdom_create(big_input, jschema_all(), nullptr));
@@ -0,0 +1,257 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+
+#include <gtest/gtest.h>
+#include <pbnjson.h>
+
+#include <cstring>
+#include <string>
+#include <tuple>
+
+using namespace std;
+
+namespace {
+
+bool append(void *ctxt, const char *buf, size_t len)
+{
+	static_cast<string *>(ctxt)->append(buf, len);
+	return true;
+}
+
+bool fail_write(void *ctxt, const char *buf, size_t len)
+{
+	return false;
+}
+
+string reformat(const string &input, const char *indent, jschema_ref schema = jschema_all())
+{
+	string out;
+	jerror *err = NULL;
+	EXPECT_TRUE(jreformat(j_str_to_buffer(input.c_str(), input.size()), schema, indent, append, &out, &err));
+	EXPECT_EQ(nullptr, err);
+	jerror_free(err);
+	return out;
+}
+
+} // namespace
+
+TEST(Reformat, Minify)
+{
+	EXPECT_EQ(R"({"a":[1,2.50,{}],"b":{"c":null,"d":[]},"e":true,"f":false})",
+	          reformat(" { \"a\" : [ 1 , 2.50 , { } ] ,\n \"b\" : { \"c\" : null, \"d\": [ ] },"
+	                   " \"e\" : true, \"f\" : false } ", NULL));
+	EXPECT_EQ("\"str\"", reformat(" \"str\" ", NULL));
+	EXPECT_EQ("-1e10", reformat("-1e10", NULL));
+}
+
+TEST(Reformat, Prettify)
+{
+	EXPECT_EQ("{\n  \"a\": [\n    1,\n    {}\n  ],\n  \"b\": {\n    \"c\": null\n  }\n}\n",
+	          reformat(R"({"a":[1,{}],"b":{"c":null}})", "  "));
+	EXPECT_EQ("[\n\t[]\n]\n", reformat("[[]]", "\t"));
+	EXPECT_EQ("42\n", reformat("42", "  "));
+}
+
+TEST(Reformat, MatchesPrettify)
+{
+	const char *input = R"({"people":[{"name":"Alisha"},{"age":27},["x",true,null]]})";
+	jvalue_ref jv = jdom_create(j_cstr_to_buffer(input), jschema_all(), NULL);
+	ASSERT_TRUE(jis_valid(jv));
+
+	EXPECT_EQ(jvalue_prettify(jv, "  "), reformat(input, "  "));
+	// Invalid indentation falls back to the default one
+	EXPECT_EQ(jvalue_prettify(jv, "  "), reformat(input, "x"));
+	EXPECT_EQ(jvalue_stringify(jv), reformat(input, NULL));
+
+	j_release(&jv);
+}
+
+TEST(Reformat, Escapes)
+{
+	// Escapes of the input are kept
+	const char *escaped = R"(["q\"b\\s\/\b\f\n\r\t\u0001\u001f","\u00e9\\",{"\u006b\"":"\\\""}])";
+	EXPECT_EQ(escaped, reformat(escaped, NULL));
+	EXPECT_EQ("{\"k\\n\":\"\xc3\xa9\"}", reformat(R"({"k\n":"é"})", NULL));
+
+	// Strings split between the chunks are escaped again
+	string out;
+	jreformatter_ref r = jreformatter_new(jschema_all(), NULL, append, &out);
+	ASSERT_TRUE(r != NULL);
+	for (const char *p = escaped; *p; ++p)
+		ASSERT_TRUE(jreformatter_feed(r, p, 1));
+	ASSERT_TRUE(jreformatter_end(r));
+	jreformatter_release(&r);
+	EXPECT_EQ(R"(["q\"b\\s/\b\f\n\r\t\u0001\u001F",")" "\xc3\xa9" R"(\\",{"k\"":"\\\""}])", out);
+}
+
+TEST(Reformat, Chunked)
+{
+	string input = "[";
+	for (int i = 0; i < 2000; ++i)
+		input += (i ? ", " : "") + string("{\"key\": \"value ") + to_string(i) + "\"}";
+	input += "]";
+
+	string expected = reformat(input, "  ");
+	EXPECT_GT(expected.size(), 8192u);
+
+	string out;
+	jreformatter_ref r = jreformatter_new(jschema_all(), "  ", append, &out);
+	ASSERT_TRUE(r != NULL);
+	for (size_t i = 0; i < input.size(); i += 7)
+		ASSERT_TRUE(jreformatter_feed(r, input.data() + i, min<size_t>(7, input.size() - i)));
+	ASSERT_TRUE(jreformatter_end(r));
+	jreformatter_release(&r);
+	EXPECT_EQ(nullptr, r);
+
+	EXPECT_EQ(expected, out);
+}
+
+TEST(Reformat, Errors)
+{
+	jschema_ref schema = jschema_create(j_cstr_to_buffer(R"({"type": "array", "items": {"type": "integer"}})"), NULL);
+	ASSERT_TRUE(schema != NULL);
+
+	string out;
+	jerror *err = NULL;
+	EXPECT_TRUE(jreformat(j_cstr_to_buffer("[1, 2]"), schema, NULL, append, &out, &err));
+	EXPECT_EQ("[1,2]", out);
+
+	EXPECT_FALSE(jreformat(j_cstr_to_buffer("[1, \"2\"]"), schema, NULL, append, &out, &err));
+	ASSERT_TRUE(err != NULL);
+	jerror_free(err);
+	err = NULL;
+
+	EXPECT_FALSE(jreformat(j_cstr_to_buffer("[1, "), jschema_all(), NULL, append, &out, &err));
+	ASSERT_TRUE(err != NULL);
+	jerror_free(err);
+	err = NULL;
+
+	EXPECT_FALSE(jreformat(j_cstr_to_buffer("[1, 2]"), jschema_all(), NULL, fail_write, NULL, &err));
+	ASSERT_TRUE(err != NULL);
+	jerror_free(err);
+
+	jreformatter_ref r = jreformatter_new(schema, NULL, append, &out);
+	EXPECT_FALSE(jreformatter_feed(r, "[true]", 6));
+	EXPECT_TRUE(jreformatter_get_error(r) != NULL);
+	jreformatter_release(&r);
+
+	r = jreformatter_new(jschema_all(), NULL, fail_write, NULL);
+	EXPECT_TRUE(jreformatter_feed(r, "[1]", 3));
+	EXPECT_FALSE(jreformatter_end(r));
+	EXPECT_STREQ("Output write failed", jreformatter_get_error(r));
+	jreformatter_release(&r);
+
+	jschema_release(&schema);
+}
+
+namespace {
+
+const char *account = R"({"user": {"name": "bob", "password": "secret",
+	"cards": [{"num": "1234", "exp": "12/20"}, {"num": "5678"}]}, "id": 5, "tags": ["a", "b", "c"]})";
+
+string filter(const char *input, const char *indent,
+              std::initializer_list<std::tuple<const char *, jreformat_action, jvalue_ref>> rules)
+{
+	string out;
+	jreformatter_ref r = jreformatter_new(jschema_all(), indent, append, &out);
+	for (const auto &rule : rules)
+	{
+		jvalue_ref replacement = get<2>(rule);
+		EXPECT_TRUE(jreformatter_add_rule(r, get<0>(rule), get<1>(rule), replacement));
+		j_release(&replacement);
+	}
+	EXPECT_TRUE(jreformatter_feed(r, input, strlen(input)));
+	EXPECT_TRUE(jreformatter_end(r));
+	jreformatter_release(&r);
+	return out;
+}
+
+} // namespace
+
+TEST(Reformat, FilterDropReplace)
+{
+	EXPECT_EQ(R"({"user":{"name":"bob","cards":[{"exp":"12/20"},{}]},"id":"<id>","tags":["a","c"]})",
+	          filter(account, NULL, {
+	              make_tuple("/user/password", JREFORMAT_DROP, nullptr),
+	              make_tuple("/user/cards/*/num", JREFORMAT_DROP, nullptr),
+	              make_tuple("/id", JREFORMAT_REPLACE, J_CSTR_TO_JVAL("<id>")),
+	              make_tuple("/tags/1", JREFORMAT_DROP, nullptr),
+	          }));
+
+	EXPECT_EQ(R"({"user":{"name":"bob","password":null,"cards":{"n":[1]}},"id":5,"tags":["a","b","c"]})",
+	          filter(account, NULL, {
+	              make_tuple("/user/password", JREFORMAT_REPLACE, jnull()),
+	              make_tuple("/user/cards", JREFORMAT_REPLACE,
+	                         jobject_create_var(jkeyval(J_CSTR_TO_JVAL("n"),
+	                                            jarray_create_var(NULL, jnumber_create_i32(1), J_END_ARRAY_DECL)),
+	                                            J_END_OBJ_DECL)),
+	          }));
+
+	// The first added rule wins
+	EXPECT_EQ(R"({"id":5})", filter(R"({"id": 5, "x": 1})", NULL, {
+	              make_tuple("/x", JREFORMAT_DROP, nullptr),
+	              make_tuple("/x", JREFORMAT_REPLACE, jnull()),
+	          }));
+
+	EXPECT_EQ("", filter(account, NULL, { make_tuple("", JREFORMAT_DROP, nullptr) }));
+	EXPECT_EQ(R"({"a/b":1})", filter(R"({"a/b": 1, "a~b": 2})", NULL, {
+	              make_tuple("/a~0b", JREFORMAT_DROP, nullptr),
+	          }));
+}
+
+TEST(Reformat, FilterKeep)
+{
+	EXPECT_EQ("{\n  \"user\": {\n    \"name\": \"bob\"\n  },\n  \"tags\": [\n    \"c\"\n  ]\n}\n",
+	          filter(account, "  ", {
+	              make_tuple("/user/name", JREFORMAT_KEEP, nullptr),
+	              make_tuple("/tags/2", JREFORMAT_KEEP, nullptr),
+	          }));
+
+	EXPECT_EQ(R"({"user":{"name":"bob","password":"secret","cards":[{"num":"5678"}]}})",
+	          filter(account, NULL, {
+	              make_tuple("/user", JREFORMAT_KEEP, nullptr),
+	              make_tuple("/user/cards/0", JREFORMAT_DROP, nullptr),
+	          }));
+
+	EXPECT_EQ("{}", filter(account, NULL, { make_tuple("/missing", JREFORMAT_KEEP, nullptr) }));
+}
+
+TEST(Reformat, FilterHash)
+{
+	// SHA-256 of "1234" with the quotes
+	const string digest = "\"637a76f73d638b7143381abaae0b5e05109276ff2bb30bf313113b52f7bcfec1\"";
+	EXPECT_EQ(R"({"num":)" + digest + "}",
+	          filter(R"({"num": "1234"})", NULL, { make_tuple("/num", JREFORMAT_HASH, nullptr) }));
+
+	// Digest of a container doesn't depend on formatting
+	string minified = filter(R"({"a": [1, {"b": null}]})", NULL, { make_tuple("/a", JREFORMAT_HASH, nullptr) });
+	string pretty = filter(R"({"a":[1,{"b":null}]})", "    ", { make_tuple("/a", JREFORMAT_HASH, nullptr) });
+	EXPECT_EQ(minified.substr(5, 66), pretty.substr(11, 66));
+	EXPECT_EQ("{\n    \"a\": " + minified.substr(5, 66) + "\n}\n", pretty);
+}
+
+TEST(Reformat, FilterBadRules)
+{
+	string out;
+	jreformatter_ref r = jreformatter_new(jschema_all(), NULL, append, &out);
+	EXPECT_FALSE(jreformatter_add_rule(r, "a", JREFORMAT_DROP, NULL));
+	EXPECT_FALSE(jreformatter_add_rule(r, "/a~2", JREFORMAT_DROP, NULL));
+	EXPECT_FALSE(jreformatter_add_rule(r, "/a", JREFORMAT_REPLACE, NULL));
+	EXPECT_TRUE(jreformatter_add_rule(r, "/a", JREFORMAT_DROP, NULL));
+	jreformatter_release(&r);
+}
@@ -0,0 +1,281 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <gtest/gtest.h>
+#include <pbnjson.h>
+
+#include <map>
+#include <string>
+#include <unistd.h>
+
+#include "record_generated.h"
+#include "input_generated.h"
+#include "stream_generated.h"
+#include "localref_generated.h"
+#include "xref_generated.h"
+#include "contact_generated.h"
+
+using namespace std;
+
+namespace {
+
+struct Case
+{
+	const char *schema;                // Relative to SCHEMA_DIR
+	const jschema_gen_validator *generated;
+	const char *input;
+	bool valid;
+};
+
+ostream &operator<<(ostream &out, const Case &c)
+{
+	return out << c.schema << ": " << c.input;
+}
+
+// External references are looked up next to the schema, optionally without extension
+JSchemaResolutionResult Resolve(JSchemaResolverRef resolver, jschema_ref *resolved)
+{
+	string dir = static_cast<const char *>(resolver->m_userCtxt);
+	string resource(resolver->m_resourceToResolve.m_str, resolver->m_resourceToResolve.m_len);
+	string file = dir + resource;
+	if (access(file.c_str(), F_OK) == -1)
+		file += ".schema";
+	if (access(file.c_str(), F_OK) == -1)
+		return SCHEMA_NOT_FOUND;
+
+	*resolved = jschema_fcreate(file.c_str(), NULL);
+	if (!*resolved || !jschema_resolve_ex(*resolved, resolver))
+		return SCHEMA_INVALID;
+	return SCHEMA_RESOLVED;
+}
+
+class SchemaGenerated : public ::testing::TestWithParam<Case>
+{
+protected:
+	static void TearDownTestCase()
+	{
+		for (auto &s : schemas)
+			jschema_release(&s.second);
+		schemas.clear();
+	}
+
+	// Schema compiled by the interpreter
+	static jschema_ref schema(const string &name)
+	{
+		auto it = schemas.find(name);
+		if (it != schemas.end())
+			return it->second;
+
+		string file = SCHEMA_DIR + name;
+		string dir = file.substr(0, file.rfind('/') + 1);
+		jschema_ref s = jschema_fcreate(file.c_str(), NULL);
+		if (s)
+		{
+			JSchemaResolver resolver = { 0 };
+			resolver.m_resolve = &Resolve;
+			resolver.m_userCtxt = const_cast<char *>(dir.c_str());
+			if (!jschema_resolve_ex(s, &resolver))
+				jschema_release(&s);
+		}
+		return schemas[name] = s;
+	}
+
+	static map<string, jschema_ref> schemas;
+};
+
+map<string, jschema_ref> SchemaGenerated::schemas;
+
+} // namespace
+
+// The generated code should give exactly the same answer as the schema interpreter
+TEST_P(SchemaGenerated, SameAsInterpreter)
+{
+	const Case &c = GetParam();
+	jschema_ref interpreted = schema(c.schema);
+	ASSERT_NE(nullptr, interpreted) << c.schema;
+
+	jvalue_ref value = jdom_create(j_cstr_to_buffer(c.input), jschema_all(), NULL);
+	ASSERT_TRUE(jis_valid(value)) << c.input;
+
+	EXPECT_EQ(c.valid, jvalue_validate(value, interpreted, NULL)) << c;
+	EXPECT_EQ(c.valid, c.generated->validate(value)) << c;
+
+	// Same through the events, of the traversal and of the parser
+	jschema_ref generated = jschema_gen_create(c.generated);
+	EXPECT_EQ(c.valid, jvalue_validate(value, generated, NULL)) << c;
+	jvalue_ref parsed = jdom_create(j_cstr_to_buffer(c.input), generated, NULL);
+	EXPECT_EQ(c.valid, jis_valid(parsed)) << c;
+	j_release(&parsed);
+	jschema_release(&generated);
+
+	j_release(&value);
+}
+
+// Schemas with combinators are checked as DOM built from the events
+TEST(SchemaGeneratedEvents, Streamable)
+{
+	EXPECT_EQ(nullptr, record_validator.events);
+	EXPECT_NE(nullptr, input_validator.events);
+	EXPECT_NE(nullptr, stream_validator.events);
+	EXPECT_NE(nullptr, localref_validator.events);
+	EXPECT_NE(nullptr, xref_validator.events);
+	EXPECT_EQ(nullptr, contact_validator.events);
+}
+
+// Whole values only, nothing after the end of the value
+TEST(SchemaGeneratedEvents, OneValue)
+{
+	for (const jschema_gen_validator *v : { &input_validator, &record_validator })
+	{
+		const jschema_gen_event start = { JSCHEMA_GEN_OBJECT_START };
+		const jschema_gen_event end = { JSCHEMA_GEN_OBJECT_END };
+		const jschema_gen_event key = { JSCHEMA_GEN_OBJECT_KEY, "name", 4 };
+		const jschema_gen_event str = { JSCHEMA_GEN_STRING, "ab", 2 };
+		const jschema_gen_event age = { JSCHEMA_GEN_OBJECT_KEY, "age", 3 };
+		const jschema_gen_event num = { JSCHEMA_GEN_NUMBER, "3", 1 };
+
+		jschema_gen_sax_state s;
+		jschema_gen_sax_init(&s, v);
+		EXPECT_FALSE(jschema_gen_sax_complete(&s));
+		for (const jschema_gen_event *e : { &start, &key, &str, &age, &num })
+			EXPECT_TRUE(jschema_gen_sax_check(&s, e));
+		EXPECT_FALSE(jschema_gen_sax_complete(&s));
+		EXPECT_TRUE(jschema_gen_sax_check(&s, &end));
+		EXPECT_TRUE(jschema_gen_sax_complete(&s));
+		EXPECT_FALSE(jschema_gen_sax_check(&s, &start));
+		jschema_gen_sax_clear(&s);
+	}
+}
+
+INSTANTIATE_TEST_CASE_P(Record, SchemaGenerated, ::testing::Values(
+	Case{ "generated/record.schema", &record_validator, R"({"name": "ab", "age": 3})", true },
+	Case{ "generated/record.schema", &record_validator, R"({"name": "ab"})", false },
+	Case{ "generated/record.schema", &record_validator, R"([])", false },
+	Case{ "generated/record.schema", &record_validator, R"({"name": "a", "age": 3})", false },
+	Case{ "generated/record.schema", &record_validator, R"({"name": "abcdef", "age": 3})", false },
+	Case{ "generated/record.schema", &record_validator, R"({"name": "aB", "age": 3})", false },
+	Case{ "generated/record.schema", &record_validator, R"({"name": "ab", "age": 149})", true },
+	Case{ "generated/record.schema", &record_validator, R"({"name": "ab", "age": 150})", false },
+	Case{ "generated/record.schema", &record_validator, R"({"name": "ab", "age": -1})", false },
+	Case{ "generated/record.schema", &record_validator, R"({"name": "ab", "age": 1.5})", false },
+	Case{ "generated/record.schema", &record_validator, R"({"name": "ab", "age": 2.0})", true },
+	Case{ "generated/record.schema", &record_validator, R"({"name": "ab", "age": 3, "ratio": 0.75})", true },
+	Case{ "generated/record.schema", &record_validator, R"({"name": "ab", "age": 3, "ratio": 0.7})", false },
+	Case{ "generated/record.schema", &record_validator, R"({"name": "ab", "age": 3, "tags": ["a", "b"]})", true },
+	Case{ "generated/record.schema", &record_validator, R"({"name": "ab", "age": 3, "tags": ["a", "a"]})", false },
+	Case{ "generated/record.schema", &record_validator, R"({"name": "ab", "age": 3, "tags": ["a", "b", "c", "d"]})", false },
+	Case{ "generated/record.schema", &record_validator, R"({"name": "ab", "age": 3, "tags": [1]})", false },
+	Case{ "generated/record.schema", &record_validator, R"({"name": "ab", "age": 3, "pair": [true, null]})", true },
+	Case{ "generated/record.schema", &record_validator, R"({"name": "ab", "age": 3, "pair": [true]})", true },
+	Case{ "generated/record.schema", &record_validator, R"({"name": "ab", "age": 3, "pair": [null]})", false },
+	Case{ "generated/record.schema", &record_validator, R"({"name": "ab", "age": 3, "pair": [true, null, 1]})", false },
+	Case{ "generated/record.schema", &record_validator, R"({"name": "ab", "age": 3, "kind": "cc"})", true },
+	Case{ "generated/record.schema", &record_validator, R"({"name": "ab", "age": 3, "kind": "c"})", false },
+	Case{ "generated/record.schema", &record_validator, R"({"name": "ab", "age": 3, "kind": 1.50})", true },
+	Case{ "generated/record.schema", &record_validator, R"({"name": "ab", "age": 3, "kind": 1.51})", false },
+	Case{ "generated/record.schema", &record_validator, R"({"name": "ab", "age": 3, "kind": false})", false },
+	Case{ "generated/record.schema", &record_validator, R"({"name": "ab", "age": 3, "kind": null})", true },
+	Case{ "generated/record.schema", &record_validator, R"({"name": "ab", "age": 3, "child": {}})", true },
+	Case{ "generated/record.schema", &record_validator, R"({"name": "ab", "age": 3, "child": {"next": {}}})", true },
+	Case{ "generated/record.schema", &record_validator, R"({"name": "ab", "age": 3, "child": {"next": {"x": 1}}})", false },
+	Case{ "generated/record.schema", &record_validator, R"({"name": "ab", "age": 3, "child": null})", false },
+	Case{ "generated/record.schema", &record_validator, R"({"name": "ab", "age": 3, "child": 1})", false },
+	Case{ "generated/record.schema", &record_validator, R"({"name": "ab", "age": 3, "id": "x"})", true },
+	Case{ "generated/record.schema", &record_validator, R"({"name": "ab", "age": 3, "id": ""})", false },
+	Case{ "generated/record.schema", &record_validator, R"({"name": "ab", "age": 3, "id": 0})", false },
+	Case{ "generated/record.schema", &record_validator, R"({"name": "ab", "age": 3, "id": 7})", true },
+	Case{ "generated/record.schema", &record_validator, R"({"name": "ab", "age": 3, "x-foo": "s"})", true },
+	Case{ "generated/record.schema", &record_validator, R"({"name": "ab", "age": 3, "x-foo": 1})", false },
+	Case{ "generated/record.schema", &record_validator, R"({"name": "ab", "age": 3, "y": 1})", false },
+	Case{ "generated/record.schema", &record_validator, R"({"name": "ab", "age": 3, "forbidden": 1})", false }
+));
+
+// The schemas of the other tests, with their valid and invalid inputs
+
+INSTANTIATE_TEST_CASE_P(Input, SchemaGenerated, ::testing::Values(
+	Case{ "input.schema", &input_validator, R"({"guess": 7, "returnValue": true})", true },
+	Case{ "input.schema", &input_validator, R"({})", true },
+	Case{ "input.schema", &input_validator, R"({"guess": 1})", true },
+	Case{ "input.schema", &input_validator, R"({"guess": 10})", true },
+	Case{ "input.schema", &input_validator, R"({"guess": 0.5})", false },
+	Case{ "input.schema", &input_validator, R"({"guess": 11})", false },
+	Case{ "input.schema", &input_validator, R"({"guess": "7"})", false },
+	Case{ "input.schema", &input_validator, R"([7])", false }
+));
+
+INSTANTIATE_TEST_CASE_P(StreamParser, SchemaGenerated, ::testing::Values(
+	Case{ "parse/test_stream_parser.schema", &stream_validator,
+	      R"({"null": null, "bool": true, "number": 1.1, "string": "asd", "array": [2, "qwerty"]})", true },
+	Case{ "parse/test_stream_parser.schema", &stream_validator, R"({"array": [2]})", true },
+	Case{ "parse/test_stream_parser.schema", &stream_validator, R"({"array": [2, "a", {}]})", true },
+	Case{ "parse/test_stream_parser.schema", &stream_validator, R"({"array": ["qwerty", 2]})", false },
+	Case{ "parse/test_stream_parser.schema", &stream_validator, R"({"null": false})", false },
+	Case{ "parse/test_stream_parser.schema", &stream_validator, R"({"bool": 1})", false },
+	Case{ "parse/test_stream_parser.schema", &stream_validator, R"({"number": "1.1"})", false },
+	Case{ "parse/test_stream_parser.schema", &stream_validator, R"({"string": null})", false },
+	Case{ "parse/test_stream_parser.schema", &stream_validator, R"("asd")", false }
+));
+
+INSTANTIATE_TEST_CASE_P(LocalReferences, SchemaGenerated, ::testing::Values(
+	Case{ "localref/rA.schema", &localref_validator,
+	      R"({"name": "Alisha", "flag": true, "field": {"familyName": "Lalala", "flagB": true}})", true },
+	Case{ "localref/rA.schema", &localref_validator,
+	      R"({"name": "Alisha", "flag": true, "field": {"familyName": false, "flagB": true}})", false },
+	Case{ "localref/rA.schema", &localref_validator, R"({"field": {"flagB": "true"}})", false },
+	Case{ "localref/rA.schema", &localref_validator, R"({"flag": null})", false },
+	Case{ "localref/rA.schema", &localref_validator, R"({"field": []})", false }
+));
+
+INSTANTIATE_TEST_CASE_P(CrossReferences, SchemaGenerated, ::testing::Values(
+	Case{ "xref/xA.schema", &xref_validator,
+	      R"({"name": "Alisha", "flag": true, "field": {"familyName": "Simpson",
+	          "fieldA": {"name": "Andrii", "flag": false},
+	          "fieldC": {"stringC": "Hi", "fieldB": {"familyName": "Griffin"}}}})", true },
+	Case{ "xref/xA.schema", &xref_validator,
+	      R"({"name": "Alisha", "flag": true, "field": {"familyName": "Simpson",
+	          "fieldA": {"name": "Andrii", "flag": "O NO STRING!"}}})", false },
+	Case{ "xref/xA.schema", &xref_validator,
+	      R"({"field": {"fieldC": {"fieldB": {"fieldA": {"field": {"familyName": 1}}}}}})", false },
+	Case{ "xref/xA.schema", &xref_validator,
+	      R"({"field": {"fieldC": {"fieldB": {"fieldA": {"field": {"familyName": "x"}}}}}})", true },
+	Case{ "xref/xA.schema", &xref_validator, R"({"field": {"fieldC": {"stringC": 1}}})", false }
+));
+
+INSTANTIATE_TEST_CASE_P(Contact, SchemaGenerated, ::testing::Values(
+	Case{ "contact/Contact.schema", &contact_validator, R"({})", true },
+	Case{ "contact/Contact.schema", &contact_validator, R"({"contactIds": ["1"], "displayIndex": "first name"})", true },
+	Case{ "contact/Contact.schema", &contact_validator,
+	      R"({"displayName": "", "name": {}, "birthday": "", "anniversary": "", "gender": "undisclosed"})", true },
+	Case{ "contact/Contact.schema", &contact_validator, R"({"gender": "unknown"})", false },
+	Case{ "contact/Contact.schema", &contact_validator, R"({"gender": 1})", false },
+	Case{ "contact/Contact.schema", &contact_validator, R"({"name": {"givenName": 1}})", false },
+	Case{ "contact/Contact.schema", &contact_validator,
+	      R"({"emails": [{"value": "a@b.c", "type": "home", "primary": true}]})", true },
+	Case{ "contact/Contact.schema", &contact_validator, R"({"emails": [{"primary": "yes"}]})", false },
+	Case{ "contact/Contact.schema", &contact_validator,
+	      R"({"addresses": [{"locality": "Kyiv", "value": "home"}]})", true },
+	Case{ "contact/Contact.schema", &contact_validator, R"({"addresses": [{"country": 1}]})", false },
+	Case{ "contact/Contact.schema", &contact_validator, R"({"addresses": [{"primary": 1}]})", false },
+	Case{ "contact/Contact.schema", &contact_validator,
+	      R"({"organizations": [{"name": "LG", "location": {"region": "x"}}]})", true },
+	Case{ "contact/Contact.schema", &contact_validator, R"({"organizations": [{"location": {"region": 1}}]})", false },
+	Case{ "contact/Contact.schema", &contact_validator, R"({"organizations": [{"value": false}]})", false },
+	Case{ "contact/Contact.schema", &contact_validator, R"({"accounts": [{"domain": "d", "userName": "u"}]})", true },
+	Case{ "contact/Contact.schema", &contact_validator, R"({"accounts": [{"userid": 1}]})", false },
+	Case{ "contact/Contact.schema", &contact_validator, R"({"tags": ["a", "b"]})", true },
+	Case{ "contact/Contact.schema", &contact_validator, R"({"tags": [null]})", false },
+	Case{ "contact/Contact.schema", &contact_validator, R"([])", false }
+));
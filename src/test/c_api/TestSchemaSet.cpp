@@ -0,0 +1,135 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+
+#include <gtest/gtest.h>
+#include <pbnjson.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+#include "TestUtils.hpp"
+
+using namespace std;
+
+namespace {
+
+class TestSchemaSet : public ::testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		char tmpl[] = "/tmp/pbnjson-schema-set-XXXXXX";
+		ASSERT_TRUE(mkdtemp(tmpl) != NULL);
+		dir = tmpl;
+
+		write("a.schema", R"({"type": "object", "properties": {"b": {"$ref": "b.schema"}}})");
+		write("b.schema", R"({"type": "integer"})");
+		write("c.schema", R"({"type": "string"})");
+
+		set = jschema_set_new();
+		ASSERT_TRUE(jschema_set_add_file(set, path("a.schema").c_str(), NULL));
+		ASSERT_TRUE(jschema_set_add_file(set, path("c.schema").c_str(), NULL));
+	}
+
+	void TearDown() override
+	{
+		jschema_set_release(&set);
+		for (auto name : {"a.schema", "b.schema", "c.schema"})
+			unlink(path(name).c_str());
+		rmdir(dir.c_str());
+	}
+
+	string path(const char *name) const
+	{
+		return dir + "/" + name;
+	}
+
+	void write(const char *name, const char *content) const
+	{
+		ofstream(path(name)) << content;
+	}
+
+	bool validate(const char *name, const char *json)
+	{
+		auto schema = mk_ptr(jschema_set_get(set, path(name).c_str()));
+		EXPECT_TRUE(schema.get() != NULL);
+		auto val = mk_ptr(jdom_create(j_cstr_to_buffer(json), jschema_all(), NULL));
+		return jvalue_validate(val.get(), schema.get(), NULL);
+	}
+
+	string dir;
+	jschema_set_ref set;
+};
+
+} // namespace
+
+TEST_F(TestSchemaSet, Get)
+{
+	EXPECT_TRUE(validate("a.schema", R"({"b": 1})"));
+	EXPECT_FALSE(validate("a.schema", R"({"b": "1"})"));
+	EXPECT_TRUE(validate("c.schema", R"("c")"));
+
+	EXPECT_EQ(nullptr, jschema_set_get(set, path("b.schema").c_str()));
+
+	jerror *err = NULL;
+	EXPECT_FALSE(jschema_set_add_file(set, path("missing.schema").c_str(), &err));
+	EXPECT_TRUE(err != NULL);
+	jerror_free(err);
+}
+
+TEST_F(TestSchemaSet, Refresh)
+{
+	EXPECT_EQ(0, jschema_set_refresh(set, NULL));
+
+	auto old_a = mk_ptr(jschema_set_get(set, path("a.schema").c_str()));
+	auto old_c = mk_ptr(jschema_set_get(set, path("c.schema").c_str()));
+
+	// Only the schema referencing the changed document is rebuilt
+	write("b.schema", R"({"type": "string", "minLength": 2})");
+	EXPECT_EQ(1, jschema_set_refresh(set, NULL));
+	EXPECT_TRUE(validate("a.schema", R"({"b": "12"})"));
+	EXPECT_FALSE(validate("a.schema", R"({"b": 1})"));
+
+	auto new_c = mk_ptr(jschema_set_get(set, path("c.schema").c_str()));
+	EXPECT_EQ(old_c.get(), new_c.get());
+
+	// Schemas taken before the refresh keep the previous version
+	auto val = mk_ptr(jdom_create(j_cstr_to_buffer(R"({"b": 1})"), jschema_all(), NULL));
+	EXPECT_TRUE(jvalue_validate(val.get(), old_a.get(), NULL));
+
+	EXPECT_EQ(0, jschema_set_refresh(set, NULL));
+}
+
+TEST_F(TestSchemaSet, RefreshFailure)
+{
+	write("b.schema", R"({"type": )");
+
+	jerror *err = NULL;
+	EXPECT_EQ(-1, jschema_set_refresh(set, &err));
+	EXPECT_TRUE(err != NULL);
+	jerror_free(err);
+
+	// The set is left intact and tries again on the next refresh
+	EXPECT_TRUE(validate("a.schema", R"({"b": 1})"));
+
+	write("b.schema", R"({"type": ["boolean"]})");
+	EXPECT_EQ(1, jschema_set_refresh(set, NULL));
+	EXPECT_TRUE(validate("a.schema", R"({"b": true})"));
+}
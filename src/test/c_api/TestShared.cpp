@@ -0,0 +1,215 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include <gtest/gtest.h>
+#include <pbnjson.h>
+
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+jvalue_ref makeRecord(int n)
+{
+	return jobject_create_var(
+		jkeyval(J_CSTR_TO_JVAL("id"), jnumber_create_i32(n)),
+		jkeyval(J_CSTR_TO_JVAL("name"), jstring_create(("record" + std::to_string(n)).c_str())),
+		jkeyval(J_CSTR_TO_JVAL("active"), jboolean_create(n % 2)),
+		J_END_OBJ_DECL);
+}
+
+jvalue_ref makeDom()
+{
+	jvalue_ref records = jarray_create(NULL);
+	for (int i = 0; i < 100; ++i)
+		jarray_append(records, makeRecord(i));
+
+	return jobject_create_var(
+		jkeyval(J_CSTR_TO_JVAL("records"), records),
+		jkeyval(J_CSTR_TO_JVAL("list"), jarray_create_var(NULL,
+			jnull(), jboolean_true(), jboolean_false(), jstring_empty(),
+			jnumber_create_f64(0.5), jnumber_create_i64(-1234567890123LL),
+			jnumber_create(J_CSTR_TO_BUF("1234.25")),
+			J_END_ARRAY_DECL)),
+		jkeyval(J_CSTR_TO_JVAL("empty"), jobject_create()),
+		jkeyval(J_CSTR_TO_JVAL("nested"), jobject_create_var(
+			jkeyval(J_CSTR_TO_JVAL("array"), jarray_create(NULL)),
+			J_END_OBJ_DECL)),
+		J_END_OBJ_DECL);
+}
+
+class Shared : public ::testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		name = "/pbnjson-test-" + std::to_string(getpid());
+		dom = makeDom();
+		ASSERT_TRUE(jshared_publish(name.c_str(), dom, NULL));
+	}
+
+	void TearDown() override
+	{
+		jshared_unlink(name.c_str());
+		j_release(&dom);
+	}
+
+	std::string name;
+	jvalue_ref dom;
+};
+
+} // namespace
+
+TEST_F(Shared, Accessors)
+{
+	jshared_ref shared = jshared_attach(name.c_str(), NULL);
+	ASSERT_NE(nullptr, shared);
+	jvalue_ref root = jshared_root(shared);
+
+	EXPECT_TRUE(jvalue_equal(dom, root));
+	EXPECT_EQ(0, jvalue_compare(dom, root));
+	EXPECT_EQ(4u, jobject_size(root));
+
+	jvalue_ref records = jobject_get(root, J_CSTR_TO_BUF("records"));
+	ASSERT_TRUE(jis_array(records));
+	ASSERT_EQ(100, jarray_size(records));
+	for (int i = 0; i < 100; ++i)
+	{
+		jvalue_ref record = jarray_get(records, i);
+		int32_t id = -1;
+		EXPECT_EQ(CONV_OK, jnumber_get_i32(jobject_get(record, J_CSTR_TO_BUF("id")), &id));
+		EXPECT_EQ(i, id);
+		EXPECT_TRUE(jstring_equal2(jobject_get(record, J_CSTR_TO_BUF("name")),
+		                           j_cstr_to_buffer(("record" + std::to_string(i)).c_str())));
+		bool active = false;
+		EXPECT_EQ(CONV_OK, jboolean_get(jobject_get(record, J_CSTR_TO_BUF("active")), &active));
+		EXPECT_EQ(i % 2 == 1, active);
+		EXPECT_FALSE(jis_valid(jobject_get(record, J_CSTR_TO_BUF("missing"))));
+	}
+	EXPECT_FALSE(jis_valid(jarray_get(records, 100)));
+
+	jvalue_ref list = jobject_get(root, J_CSTR_TO_BUF("list"));
+	ASSERT_EQ(7, jarray_size(list));
+	EXPECT_TRUE(jis_null(jarray_get(list, 0)));
+	EXPECT_EQ(jboolean_true(), jarray_get(list, 1));
+	EXPECT_EQ(jboolean_false(), jarray_get(list, 2));
+	EXPECT_EQ(0, jstring_size(jarray_get(list, 3)));
+
+	double f = 0;
+	EXPECT_EQ(CONV_OK, jnumber_get_f64(jarray_get(list, 4), &f));
+	EXPECT_EQ(0.5, f);
+	int64_t i = 0;
+	EXPECT_EQ(CONV_OK, jnumber_get_i64(jarray_get(list, 5), &i));
+	EXPECT_EQ(-1234567890123LL, i);
+	raw_buffer raw;
+	EXPECT_EQ(CONV_OK, jnumber_get_raw(jarray_get(list, 6), &raw));
+	EXPECT_EQ("1234.25", std::string(raw.m_str, raw.m_len));
+
+	EXPECT_EQ(0u, jobject_size(jobject_get(root, J_CSTR_TO_BUF("empty"))));
+	EXPECT_EQ(0, jarray_size(jobject_get_nested(root, "nested", "array", NULL)));
+
+	size_t members = 0;
+	jobject_iter it;
+	jobject_key_value pair;
+	ASSERT_TRUE(jobject_iter_init(&it, root));
+	while (jobject_iter_next(&it, &pair))
+	{
+		EXPECT_TRUE(jvalue_equal(jobject_get(dom, jstring_get_fast(pair.key)), pair.value));
+		++members;
+	}
+	EXPECT_EQ(4u, members);
+
+	jshared_detach(shared);
+}
+
+TEST_F(Shared, Immutable)
+{
+	jshared_ref shared = jshared_attach(name.c_str(), NULL);
+	ASSERT_NE(nullptr, shared);
+	jvalue_ref root = jshared_root(shared);
+
+	// Reference counting doesn't touch the segment
+	jvalue_ref copy = jvalue_copy(root);
+	EXPECT_EQ(root, copy);
+	j_release(&copy);
+
+	EXPECT_FALSE(jobject_set(root, J_CSTR_TO_BUF("new"), jnull()));
+	EXPECT_FALSE(jobject_remove(root, J_CSTR_TO_BUF("list")));
+	jvalue_ref list = jobject_get(root, J_CSTR_TO_BUF("list"));
+	EXPECT_FALSE(jarray_set(list, 0, jnull()));
+	EXPECT_FALSE(jarray_remove(list, 0));
+	EXPECT_FALSE(jarray_insert(list, 0, jnull()));
+	EXPECT_EQ(7, jarray_size(list));
+
+	// Copying elements out of the segment is fine
+	jvalue_ref array = jarray_create(NULL);
+	EXPECT_FALSE(jarray_splice_append(array, list, SPLICE_TRANSFER));
+	EXPECT_TRUE(jarray_splice_append(array, list, SPLICE_COPY));
+	EXPECT_TRUE(jvalue_equal(list, array));
+	j_release(&array);
+
+	jvalue_ref duplicate = jvalue_duplicate(root);
+	jshared_detach(shared);
+
+	EXPECT_TRUE(jvalue_equal(dom, duplicate));
+	EXPECT_TRUE(jobject_set(duplicate, J_CSTR_TO_BUF("new"), jnull()));
+	j_release(&duplicate);
+}
+
+TEST_F(Shared, Stringify)
+{
+	jshared_ref shared = jshared_attach(name.c_str(), NULL);
+	ASSERT_NE(nullptr, shared);
+	jvalue_ref root = jshared_root(shared);
+
+	jvalue_ref list = jobject_get(root, J_CSTR_TO_BUF("list"));
+	EXPECT_STREQ(jvalue_stringify(jobject_get(dom, J_CSTR_TO_BUF("list"))), jvalue_stringify(list));
+
+	jshared_detach(shared);
+}
+
+TEST_F(Shared, OtherProcess)
+{
+	pid_t child = fork();
+	ASSERT_NE(-1, child);
+	if (child == 0)
+	{
+		jshared_ref shared = jshared_attach(name.c_str(), NULL);
+		bool ok = shared && jvalue_equal(dom, jshared_root(shared));
+		jshared_detach(shared);
+		_exit(ok ? 0 : 1);
+	}
+
+	int status = 0;
+	ASSERT_EQ(child, waitpid(child, &status, 0));
+	EXPECT_TRUE(WIFEXITED(status));
+	EXPECT_EQ(0, WEXITSTATUS(status));
+}
+
+TEST_F(Shared, Errors)
+{
+	jerror *err = NULL;
+	EXPECT_FALSE(jshared_publish(name.c_str(), dom, &err));
+	EXPECT_NE(nullptr, err);
+	jerror_free(err);
+
+	err = NULL;
+	EXPECT_EQ(nullptr, jshared_attach("/pbnjson-test-missing", &err));
+	EXPECT_NE(nullptr, err);
+	jerror_free(err);
+}
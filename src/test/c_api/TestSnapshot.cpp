@@ -0,0 +1,121 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include <gtest/gtest.h>
+#include <pbnjson.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+
+jvalue_ref makeVersion(int n)
+{
+	return jobject_create_var(
+		jkeyval(J_CSTR_TO_JVAL("version"), jnumber_create_i32(n)),
+		jkeyval(J_CSTR_TO_JVAL("check"), jnumber_create_i32(-n)),
+		J_END_OBJ_DECL);
+}
+
+int get(jvalue_ref dom, raw_buffer key)
+{
+	int32_t n = 0;
+	EXPECT_EQ(CONV_OK, jnumber_get_i32(jobject_get(dom, key), &n));
+	return n;
+}
+
+} // namespace
+
+TEST(Snapshot, PinAndPublish)
+{
+	jsnapshot_ref snapshot = jsnapshot_create(makeVersion(1));
+	ASSERT_TRUE(snapshot != NULL);
+
+	jsnapshot_version_ref v1 = jsnapshot_pin(snapshot);
+	jvalue_ref dom1 = jsnapshot_version_get(v1);
+	EXPECT_EQ(1, get(dom1, J_CSTR_TO_BUF("version")));
+
+	jsnapshot_publish(snapshot, makeVersion(2));
+	jsnapshot_version_ref v2 = jsnapshot_pin(snapshot);
+	EXPECT_EQ(2, get(jsnapshot_version_get(v2), J_CSTR_TO_BUF("version")));
+	jsnapshot_unpin(v2);
+
+	// The pinned version survives publishing
+	EXPECT_EQ(dom1, jsnapshot_version_get(v1));
+	EXPECT_EQ(1, get(dom1, J_CSTR_TO_BUF("version")));
+	EXPECT_EQ(1U, jsnapshot_reclaim(snapshot));
+
+	jsnapshot_unpin(v1);
+	EXPECT_EQ(0U, jsnapshot_reclaim(snapshot));
+
+	jsnapshot_free(snapshot);
+}
+
+TEST(Snapshot, EmptyVersion)
+{
+	jsnapshot_ref snapshot = jsnapshot_create(NULL);
+	jsnapshot_version_ref v = jsnapshot_pin(snapshot);
+	EXPECT_TRUE(jis_null(jsnapshot_version_get(v)));
+	jsnapshot_unpin(v);
+	jsnapshot_free(snapshot);
+}
+
+TEST(Snapshot, ConcurrentReaders)
+{
+	const int versions = 500;
+	const size_t nthreads = 8;
+
+	jsnapshot_ref snapshot = jsnapshot_create(makeVersion(0));
+	std::atomic<bool> done(false);
+	std::atomic<size_t> reads(0);
+
+	auto reader = [&]() {
+		int last = 0;
+		while (!done)
+		{
+			jsnapshot_version_ref v = jsnapshot_pin(snapshot);
+			jvalue_ref dom = jsnapshot_version_get(v);
+			int version = get(dom, J_CSTR_TO_BUF("version"));
+			ASSERT_EQ(-version, get(dom, J_CSTR_TO_BUF("check")));
+			ASSERT_LE(last, version);
+			last = version;
+			jsnapshot_unpin(v);
+			++reads;
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < nthreads; ++i)
+		threads.emplace_back(reader);
+
+	for (int i = 1; i <= versions; ++i)
+		jsnapshot_publish(snapshot, makeVersion(i));
+
+	done = true;
+	for (auto &thread : threads)
+		thread.join();
+
+	EXPECT_LT(0U, reads.load());
+	EXPECT_EQ(0U, jsnapshot_reclaim(snapshot));
+
+	jsnapshot_version_ref v = jsnapshot_pin(snapshot);
+	EXPECT_EQ(versions, get(jsnapshot_version_get(v), J_CSTR_TO_BUF("version")));
+	jsnapshot_unpin(v);
+
+	jsnapshot_free(snapshot);
+}
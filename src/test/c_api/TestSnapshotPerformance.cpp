@@ -0,0 +1,131 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include <gtest/gtest.h>
+#include <pbnjson.h>
+
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const auto DURATION = chrono::seconds(2);
+
+jvalue_ref makeConfig()
+{
+	jvalue_ref config = jobject_create();
+	for (int i = 0; i < 1000; ++i)
+	{
+		string key = "key" + to_string(i);
+		jobject_set(config, j_str_to_buffer(key.c_str(), key.size()), jnumber_create_i32(i));
+	}
+	return config;
+}
+
+// Run reader on the given number of threads while the writer keeps publishing,
+// return reads per second
+double measure(size_t nthreads, function<bool(size_t)> reader, function<void()> writer)
+{
+	atomic<bool> done(false);
+	atomic<size_t> reads(0);
+
+	vector<thread> threads;
+	for (size_t t = 0; t < nthreads; ++t)
+		threads.emplace_back([&, t]() {
+			size_t n = 0;
+			while (!done)
+			{
+				if (!reader(n + t))
+					abort();
+				++n;
+			}
+			reads += n;
+		});
+
+	auto start = chrono::steady_clock::now();
+	while (chrono::steady_clock::now() - start < DURATION)
+	{
+		writer();
+		this_thread::sleep_for(chrono::milliseconds(10));
+	}
+	done = true;
+	for (auto &thread : threads)
+		thread.join();
+
+	chrono::duration<double> seconds = chrono::steady_clock::now() - start;
+	return reads / seconds.count();
+}
+
+void report(const char *label, size_t nthreads, double rate)
+{
+	cout << left << setw(10) << label << " threads: " << setw(3) << nthreads
+	     << " reads/s: " << fixed << setprecision(0) << rate << endl;
+}
+
+bool lookup(jvalue_ref config, size_t n)
+{
+	string key = "key" + to_string(n % 1000);
+	int32_t value = -1;
+	jnumber_get_i32(jobject_get(config, j_str_to_buffer(key.c_str(), key.size())), &value);
+	return value == int32_t(n % 1000);
+}
+
+} // namespace
+
+TEST(SnapshotPerformance, ReadScaling)
+{
+	const size_t max_threads = max(1u, thread::hardware_concurrency());
+
+	cout << "Lookups in a shared object while it's republished every 10ms, bigger is better." << endl;
+	for (size_t nthreads = 1; nthreads <= max_threads; nthreads *= 2)
+	{
+		jsnapshot_ref snapshot = jsnapshot_create(makeConfig());
+		double rate = measure(nthreads,
+			[&](size_t n) {
+				jsnapshot_version_ref v = jsnapshot_pin(snapshot);
+				bool ok = lookup(jsnapshot_version_get(v), n);
+				jsnapshot_unpin(v);
+				return ok;
+			},
+			[&]() { jsnapshot_publish(snapshot, makeConfig()); });
+		report("snapshot", nthreads, rate);
+		jsnapshot_free(snapshot);
+
+		mutex lock;
+		jvalue_ref config = makeConfig();
+		rate = measure(nthreads,
+			[&](size_t n) {
+				lock_guard<mutex> guard(lock);
+				return lookup(config, n);
+			},
+			[&]() {
+				jvalue_ref next = makeConfig();
+				lock_guard<mutex> guard(lock);
+				j_release(&config);
+				config = next;
+			});
+		report("mutex", nthreads, rate);
+		j_release(&config);
+	}
+}
@@ -0,0 +1,398 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include <gtest/gtest.h>
+#include <pbnjson.h>
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const char BASE64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+string base64Text(size_t len)
+{
+	string text(len, 'A');
+	for (size_t i = 0; i < len; ++i)
+		text[i] = BASE64[(i * 7 + i / 64) % 64];
+	return text;
+}
+
+// Text with every kind of escape, and what it unescapes to
+struct Escaped
+{
+	string json;
+	string value;
+
+	void add(const string &raw, const string &unescaped)
+	{
+		json += raw;
+		value += unescaped;
+	}
+};
+
+Escaped escapedText(size_t runs)
+{
+	Escaped text;
+	for (size_t i = 0; i < runs; ++i)
+	{
+		text.add(base64Text(i % 50), base64Text(i % 50));
+		switch (i % 8)
+		{
+		case 0: text.add("\\n", "\n"); break;
+		case 1: text.add("\\\"", "\""); break;
+		case 2: text.add("\\u00e9", "\xc3\xa9"); break;
+		case 3: text.add("\\ud83d\\ude00", "\xf0\x9f\x98\x80"); break;
+		case 4: text.add("\\u0000", string(1, '\0')); break;
+		case 5: text.add("\\/\\\\", "/\\"); break;
+		case 6: text.add("\\b\\f\\r\\t", "\b\f\r\t"); break;
+		case 7: text.add("\\u20AC", "\xe2\x82\xac"); break;
+		}
+	}
+	return text;
+}
+
+struct Events
+{
+	vector<string> keys;
+	vector<string> strings;
+	vector<string> fragmented;
+	string current;
+	size_t fragments = 0;
+	bool cancel = false;
+};
+
+Events *events(JSAXContextRef ctxt)
+{
+	return static_cast<Events *>(jsax_getContext(ctxt));
+}
+
+int onKey(JSAXContextRef ctxt, const char *key, size_t len)
+{
+	events(ctxt)->keys.emplace_back(key, len);
+	return 1;
+}
+
+int onString(JSAXContextRef ctxt, const char *str, size_t len)
+{
+	events(ctxt)->strings.emplace_back(str, len);
+	return 1;
+}
+
+int onFragment(JSAXContextRef ctxt, const char *fragment, size_t len, bool last)
+{
+	Events *e = events(ctxt);
+	e->current.append(fragment, len);
+	++e->fragments;
+	if (last)
+	{
+		e->fragmented.push_back(e->current);
+		e->current.clear();
+	}
+	return !e->cancel;
+}
+
+// Feed the text by pieces of the given size
+bool parse(const string &text, size_t feed, size_t threshold, Events &e)
+{
+	PJSAXCallbacks callbacks = {};
+	callbacks.m_objKey = onKey;
+	callbacks.m_string = onString;
+
+	jsaxparser_ref parser = jsaxparser_new(jschema_all(), &callbacks, &e);
+	EXPECT_TRUE(jsaxparser_set_string_fragments(parser, onFragment, threshold));
+
+	bool result = true;
+	for (size_t pos = 0; result && pos < text.size(); pos += feed)
+		result = jsaxparser_feed(parser, text.data() + pos, min(feed, text.size() - pos));
+	result = result && jsaxparser_end(parser);
+
+	jsaxparser_release(&parser);
+	return result;
+}
+
+string chunks(jvalue_ref str, size_t *count)
+{
+	jstring_chunk_iter it;
+	raw_buffer chunk;
+	string text;
+
+	*count = 0;
+	EXPECT_TRUE(jstring_chunk_iter_init(&it, str));
+	while (jstring_chunk_iter_next(&it, &chunk))
+	{
+		EXPECT_LT(0u, chunk.m_len);
+		text.append(chunk.m_str, chunk.m_len);
+		++*count;
+	}
+	return text;
+}
+
+} // namespace
+
+TEST(StringFragments, LongValues)
+{
+	string blob = base64Text(1 << 20);
+	string item = base64Text(200000);
+	string text = "{\"short\":\"abc\",\"long\":\"" + blob + "\",\"list\":[\"" + item + "\",\"x\",5,true]}";
+
+	Events e;
+	ASSERT_TRUE(parse(text, 4096, 1024, e));
+
+	EXPECT_EQ((vector<string>{"short", "long", "list"}), e.keys);
+	EXPECT_EQ((vector<string>{"abc", "x"}), e.strings);
+	ASSERT_EQ(2u, e.fragmented.size());
+	EXPECT_EQ(blob, e.fragmented[0]);
+	EXPECT_EQ(item, e.fragmented[1]);
+	EXPECT_TRUE(e.current.empty());
+}
+
+TEST(StringFragments, FeedSizes)
+{
+	Escaped value = escapedText(2000);
+	string text = "[\"" + value.json + "\",{\"k\":\"" + value.json + "\"}]";
+
+	for (size_t feed : {size_t(1), size_t(7), size_t(100), size_t(65536), text.size()})
+	{
+		SCOPED_TRACE(feed);
+		Events e;
+		ASSERT_TRUE(parse(text, feed, 1000, e));
+		EXPECT_TRUE(e.strings.empty());
+		ASSERT_EQ(2u, e.fragmented.size());
+		EXPECT_EQ(value.value, e.fragmented[0]);
+		EXPECT_EQ(value.value, e.fragmented[1]);
+	}
+
+	// The same as the strings passed whole
+	Events whole;
+	ASSERT_TRUE(parse(text, text.size(), 0, whole));
+	EXPECT_EQ((vector<string>{value.value, value.value}), whole.strings);
+}
+
+TEST(StringFragments, KeysWhole)
+{
+	string key = base64Text(5000);
+	string text = "{\"" + key + "\":\"" + key + "\"}";
+
+	for (size_t feed : {size_t(1), size_t(300), text.size()})
+	{
+		Events e;
+		ASSERT_TRUE(parse(text, feed, 1000, e));
+		EXPECT_EQ(vector<string>{key}, e.keys);
+		EXPECT_EQ(vector<string>{key}, e.fragmented);
+	}
+}
+
+TEST(StringFragments, ShortStringsAcrossPieces)
+{
+	string text = "[\"" + base64Text(500) + "\", \"" + base64Text(999) + "\", \"" + base64Text(1000) + "\"]";
+
+	Events e;
+	ASSERT_TRUE(parse(text, 100, 1000, e));
+	EXPECT_EQ((vector<string>{base64Text(500), base64Text(999)}), e.strings);
+	EXPECT_EQ(vector<string>{base64Text(1000)}, e.fragmented);
+}
+
+TEST(StringFragments, Errors)
+{
+	string blob = base64Text(3000);
+	for (const string &text : {
+		"[\"" + blob + "\\q\"]",
+		"[\"" + blob + "\x01\"]",
+		"[\"" + blob + "\\u12G4\"]",
+		"[\"" + blob + "\\ud83d\\u12\"]",
+		"[\"" + blob,
+		"[\"" + blob + "\\",
+		"[1 \"" + blob + "\"]",
+		})
+	{
+		for (size_t feed : {size_t(1), size_t(1000), text.size()})
+		{
+			Events e;
+			EXPECT_FALSE(parse(text, feed, 1000, e)) << feed << ": " << text.substr(text.size() - 10);
+		}
+	}
+
+	Events canceled;
+	canceled.cancel = true;
+	EXPECT_FALSE(parse("[\"" + blob + "\"]", 100, 1000, canceled));
+}
+
+TEST(StringFragments, DomChunks)
+{
+	string blob = base64Text(1 << 20);
+	string text = "{\"blob\":\"" + blob + "\",\"short\":\"abc\"}";
+
+	jvalue_ref dom = jdom_create(j_str_to_buffer(text.data(), text.size()), jschema_all(), NULL);
+	ASSERT_TRUE(jis_object(dom));
+
+	jvalue_ref str = jobject_get(dom, J_CSTR_TO_BUF("blob"));
+	size_t count = 0;
+	EXPECT_EQ(blob, chunks(str, &count));
+	EXPECT_LT(1u, count);
+	EXPECT_EQ(ssize_t(blob.size()), jstring_size(str));
+
+	raw_buffer copy = jstring_get(str);
+	EXPECT_EQ(blob, string(copy.m_str, copy.m_len));
+	jstring_free_buffer(copy);
+
+	// Flattened once, the chunks stay
+	raw_buffer flat = jstring_get_fast(str);
+	EXPECT_EQ(blob, string(flat.m_str, flat.m_len));
+	EXPECT_EQ(flat.m_str, jstring_get_fast(str).m_str);
+	EXPECT_EQ(blob, chunks(str, &count));
+
+	jvalue_ref same = jstring_create_utf8(blob.data(), blob.size());
+	EXPECT_TRUE(jvalue_equal(same, str));
+	j_release(&same);
+
+	EXPECT_EQ("abc", chunks(jobject_get(dom, J_CSTR_TO_BUF("short")), &count));
+	EXPECT_EQ(1u, count);
+	EXPECT_EQ("", chunks(jstring_empty(), &count));
+	EXPECT_EQ(0u, count);
+
+	jstring_chunk_iter it;
+	EXPECT_FALSE(jstring_chunk_iter_init(&it, dom));
+
+	j_release(&dom);
+}
+
+TEST(StringFragments, DomStream)
+{
+	Escaped value = escapedText(300);
+	string text = "[\"" + value.json + "\",\"" + value.json + "\"]";
+
+	jdomparser_ref parser = jdomparser_new(jschema_all());
+	ASSERT_TRUE(jdomparser_set_string_chunking(parser, 100));
+	for (size_t pos = 0; pos < text.size(); pos += 33)
+		ASSERT_TRUE(jdomparser_feed(parser, text.data() + pos, min<size_t>(33, text.size() - pos)));
+	ASSERT_TRUE(jdomparser_end(parser));
+	jvalue_ref dom = jdomparser_get_result(parser);
+	jdomparser_release(&parser);
+
+	ASSERT_EQ(2, jarray_size(dom));
+	size_t count = 0;
+	EXPECT_EQ(value.value, chunks(jarray_get(dom, 0), &count));
+	raw_buffer flat = jstring_get_fast(jarray_get(dom, 1));
+	EXPECT_EQ(value.value, string(flat.m_str, flat.m_len));
+
+	j_release(&dom);
+}
+
+TEST(StringFragments, DomChunksReaders)
+{
+	Escaped value = escapedText(3000);
+	value.add("\\u0001\\u001f", "\x01\x1f");
+	string text = "[\"" + value.json + "\",{\"k\":\"" + value.json + "\"}]";
+
+	jdomparser_ref parser = jdomparser_new(jschema_all());
+	ASSERT_TRUE(jdomparser_set_string_chunking(parser, 100));
+	ASSERT_TRUE(jdomparser_feed(parser, text.data(), text.size()));
+	ASSERT_TRUE(jdomparser_end(parser));
+	jvalue_ref dom = jdomparser_get_result(parser);
+	jdomparser_release(&parser);
+
+	jvalue_ref whole = jdom_create(j_str_to_buffer(text.data(), text.size()), jschema_all(), NULL);
+	ASSERT_TRUE(jis_array(whole));
+
+	// Serialized, compared, copied and validated chunk by chunk
+	EXPECT_STREQ(jvalue_stringify(whole), jvalue_stringify(dom));
+	EXPECT_STREQ(jvalue_prettify(whole, "  "), jvalue_prettify(dom, "  "));
+	EXPECT_TRUE(jvalue_equal(dom, whole));
+	EXPECT_TRUE(jvalue_equal(whole, dom));
+	EXPECT_EQ(0, jvalue_compare(dom, whole));
+	EXPECT_TRUE(jstring_equal2(jarray_get(dom, 0), j_str_to_buffer(value.value.data(), value.value.size())));
+
+	jvalue_ref copy = jvalue_duplicate(dom);
+	EXPECT_TRUE(jvalue_equal(copy, whole));
+	j_release(&copy);
+
+	jvalue_ref other = jstring_create_utf8(value.value.data(), value.value.size() - 1);
+	EXPECT_FALSE(jvalue_equal(jarray_get(dom, 0), other));
+	EXPECT_GT(0, jvalue_compare(other, jarray_get(dom, 0)));
+	j_release(&other);
+
+	EXPECT_TRUE(jvalue_validate(dom, jschema_all(), NULL));
+	EXPECT_TRUE(jvalue_validate_dedup(dom, jschema_all(), NULL));
+
+	size_t count = 0;
+	EXPECT_EQ(value.value, chunks(jarray_get(dom, 0), &count));
+	EXPECT_LT(1u, count);
+
+	j_release(&whole);
+	j_release(&dom);
+}
+
+TEST(StringFragments, DomIncomplete)
+{
+	// Long and held strings unterminated at the end
+	for (size_t len : {size_t(200000), size_t(100)})
+	{
+		string text = "[\"" + base64Text(len);
+
+		jdomparser_ref parser = jdomparser_new(jschema_all());
+		ASSERT_TRUE(jdomparser_set_string_chunking(parser, 1000));
+		for (size_t pos = 0; pos < text.size(); pos += 64)
+			ASSERT_TRUE(jdomparser_feed(parser, text.data() + pos, min<size_t>(64, text.size() - pos)));
+		EXPECT_FALSE(jdomparser_end(parser));
+		EXPECT_TRUE(jdomparser_get_error(parser));
+		jdomparser_release(&parser);
+	}
+}
+
+TEST(StringFragments, FlattenThreads)
+{
+	string blob = base64Text(1 << 20);
+	string text = "\"" + blob + "\"";
+	jvalue_ref str = jdom_create(j_str_to_buffer(text.data(), text.size()), jschema_all(), NULL);
+	ASSERT_TRUE(jis_string(str));
+
+	vector<const char *> flat(4);
+	vector<thread> threads;
+	for (size_t t = 0; t < flat.size(); ++t)
+		threads.emplace_back([&, t]() { flat[t] = jstring_get_fast(str).m_str; });
+	for (auto &thread : threads)
+		thread.join();
+
+	for (const char *text : flat)
+		EXPECT_EQ(flat[0], text);
+	EXPECT_EQ(blob, string(flat[0], blob.size()));
+
+	j_release(&str);
+}
+
+TEST(StringFragments, SchemaNeedsWholeStrings)
+{
+	jschema_ref schema = jschema_create(j_cstr_to_buffer("{\"type\":\"string\",\"maxLength\":10}"), NULL);
+	ASSERT_TRUE(schema);
+
+	jdomparser_ref parser = jdomparser_new(schema);
+	EXPECT_FALSE(jdomparser_set_string_chunking(parser, 100));
+	jdomparser_release(&parser);
+
+	string text = "\"" + base64Text(100000) + "\"";
+	jvalue_ref str = jdom_create(j_str_to_buffer(text.data(), text.size()), schema, NULL);
+	EXPECT_FALSE(jis_valid(str));
+	j_release(&str);
+
+	jschema_release(&schema);
+}
@@ -0,0 +1,133 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include <gtest/gtest.h>
+#include <pbnjson.h>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+const size_t PAYLOAD = 32 * 1024 * 1024;
+const size_t FEED = 64 * 1024;
+
+string makeDocument()
+{
+	static const char alphabet[] =
+		"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+	string doc = "{\"name\":\"attachment\",\"data\":\"";
+	doc.reserve(PAYLOAD + 64);
+	for (size_t i = 0; i < PAYLOAD; ++i)
+		doc += alphabet[(i * 7 + i / 64) % 64];
+	doc += "\"}";
+	return doc;
+}
+
+long maxRssKb()
+{
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss;
+}
+
+// The document is streamed as it would come from a socket
+bool parse(const string &doc, size_t threshold)
+{
+	jdomparser_ref parser = jdomparser_new(jschema_all());
+	if (!parser)
+		return false;
+	if (!jdomparser_set_string_chunking(parser, threshold))
+	{
+		jdomparser_release(&parser);
+		return false;
+	}
+
+	bool ok = true;
+	for (size_t offset = 0; ok && offset < doc.size(); offset += FEED)
+		ok = jdomparser_feed(parser, doc.data() + offset, min(FEED, doc.size() - offset));
+	ok = ok && jdomparser_end(parser);
+
+	jvalue_ref dom = jdomparser_get_result(parser);
+	ok = ok && jstring_size(jobject_get(dom, J_CSTR_TO_BUF("data"))) == PAYLOAD;
+	j_release(&dom);
+	jdomparser_release(&parser);
+	return ok;
+}
+
+// Peak memory of the parse is measured in a child, so that the runs do not affect each other
+bool measure(const string &doc, size_t threshold, long &peak_kb, double &ms)
+{
+	int fds[2];
+	if (pipe(fds))
+		return false;
+
+	pid_t pid = fork();
+	if (pid == 0)
+	{
+		close(fds[0]);
+		long before = maxRssKb();
+		auto start = chrono::steady_clock::now();
+		bool ok = parse(doc, threshold);
+		chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+		long result[2] = { maxRssKb() - before, (long) (elapsed.count() * 1000) };
+		if (write(fds[1], result, sizeof(result)) != sizeof(result))
+			ok = false;
+		_exit(ok ? 0 : 1);
+	}
+	close(fds[1]);
+
+	long result[2];
+	bool ok = pid > 0 && read(fds[0], result, sizeof(result)) == sizeof(result);
+	close(fds[0]);
+
+	int status = 0;
+	ok = ok && waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+	if (ok)
+	{
+		peak_kb = result[0];
+		ms = result[1] / 1000.0;
+	}
+	return ok;
+}
+
+} // namespace
+
+TEST(StringFragmentsPerformance, LargeString)
+{
+	string doc = makeDocument();
+
+	long whole_kb = 0, chunked_kb = 0;
+	double whole_ms = 0, chunked_ms = 0;
+	ASSERT_TRUE(measure(doc, 0, whole_kb, whole_ms));
+	ASSERT_TRUE(measure(doc, 64 * 1024, chunked_kb, chunked_ms));
+
+	cout << "Parsing of a " << PAYLOAD / (1024 * 1024) << " MiB string value, smaller is better." << endl;
+	cout << left << setw(8) << "whole" << " peak KiB: " << setw(8) << whole_kb
+	     << " ms: " << fixed << setprecision(1) << whole_ms << endl;
+	cout << left << setw(8) << "chunked" << " peak KiB: " << setw(8) << chunked_kb
+	     << " ms: " << fixed << setprecision(1) << chunked_ms << endl;
+}
@@ -0,0 +1,111 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+
+#include <gtest/gtest.h>
+#include <pbnjson.h>
+
+#include <vector>
+
+#include "TestUtils.hpp"
+
+using namespace std;
+
+namespace {
+
+jschema_ref mk_schema(char const *str)
+{
+	jschema_ref schema = jschema_create(j_cstr_to_buffer(str), NULL);
+	EXPECT_TRUE(schema != NULL);
+	return schema;
+}
+
+class TestValidateMany : public ::testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		schemas = {
+			mk_schema(R"schema({"type": "object",
+				"properties": {"method": {"enum": ["get"]}, "key": {"type": "string"}},
+				"required": ["method", "key"]})schema"),
+			mk_schema(R"schema({"type": "object",
+				"properties": {"method": {"enum": ["set"]}, "key": {"type": "string"},
+				               "value": {"type": "object"}},
+				"required": ["method", "key", "value"]})schema"),
+			mk_schema(R"schema({"type": "object",
+				"properties": {"method": {"type": "string"}},
+				"required": ["method"]})schema"),
+			mk_schema(R"schema({"type": "array", "items": {"type": "integer"}})schema"),
+		};
+	}
+
+	void TearDown() override
+	{
+		for (auto &schema : schemas)
+			jschema_release(&schema);
+	}
+
+	vector<size_t> match(char const *json)
+	{
+		auto val = mk_ptr(jdom_create(j_cstr_to_buffer(json), jschema_all(), NULL));
+		EXPECT_TRUE(jis_valid(val.get())) << json;
+
+		vector<size_t> matches(schemas.size());
+		size_t count = jvalue_validate_many(val.get(), schemas.data(), schemas.size(), matches.data());
+		matches.resize(count);
+
+		// Same as validating against every schema separately
+		vector<size_t> expected;
+		for (size_t i = 0; i < schemas.size(); ++i)
+			if (jvalue_validate(val.get(), schemas[i], NULL))
+				expected.push_back(i);
+		EXPECT_EQ(expected, matches) << json;
+
+		return matches;
+	}
+
+	vector<jschema_ref> schemas;
+};
+
+} // namespace
+
+TEST_F(TestValidateMany, Routing)
+{
+	EXPECT_EQ((vector<size_t>{0, 2}), match(R"({"method": "get", "key": "a"})"));
+	EXPECT_EQ((vector<size_t>{1, 2}), match(R"({"method": "set", "key": "a", "value": {"x": [1, 2]}})"));
+	EXPECT_EQ((vector<size_t>{2}), match(R"({"method": "set", "key": "a"})"));
+	EXPECT_EQ((vector<size_t>{2}), match(R"({"method": "del", "key": "a", "value": {}})"));
+	EXPECT_EQ((vector<size_t>{3}), match(R"([1, 2, 3])"));
+	EXPECT_EQ((vector<size_t>{}), match(R"([1, 2.5])"));
+	EXPECT_EQ((vector<size_t>{}), match(R"({"key": "a"})"));
+	EXPECT_EQ((vector<size_t>{}), match(R"("get")"));
+}
+
+TEST_F(TestValidateMany, Edge)
+{
+	size_t matches[1] = { 42 };
+	auto val = mk_ptr(jobject_create());
+	EXPECT_EQ(0u, jvalue_validate_many(val.get(), schemas.data(), 0, matches));
+	EXPECT_EQ(42u, matches[0]);
+
+	jschema_ref all[] = { jschema_all() };
+	EXPECT_EQ(1u, jvalue_validate_many(val.get(), all, 1, matches));
+	EXPECT_EQ(0u, matches[0]);
+
+	EXPECT_EQ(0u, jvalue_validate_many(jinvalid(), all, 1, matches));
+}
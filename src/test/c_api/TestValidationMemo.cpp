@@ -0,0 +1,159 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include <gtest/gtest.h>
+#include <pbnjson.h>
+
+#include "TestUtils.hpp"
+
+using namespace std;
+
+namespace {
+
+jschema_ref mk_schema(char const *str)
+{
+	jschema_ref schema = jschema_create(j_cstr_to_buffer(str), NULL);
+	EXPECT_TRUE(schema != NULL);
+	return schema;
+}
+
+jvalue_ref mk_device(char const *name, int ports)
+{
+	return jobject_create_var(
+		jkeyval(J_CSTR_TO_JVAL("name"), j_cstr_to_jval(name)),
+		jkeyval(J_CSTR_TO_JVAL("ports"), jnumber_create_i32(ports)),
+		jkeyval(J_CSTR_TO_JVAL("tags"), jarray_create_var(NULL, j_cstr_to_jval("a"), j_cstr_to_jval("b"), J_END_ARRAY_DECL)),
+		J_END_OBJ_DECL);
+}
+
+const char *device_schema = R"schema({
+	"type": "object",
+	"properties": {
+		"devices": {
+			"type": "array",
+			"items": {
+				"type": "object",
+				"properties": {
+					"name": {"type": "string", "pattern": "^[a-z]+$"},
+					"ports": {"type": "integer", "maximum": 8},
+					"tags": {"type": "array", "uniqueItems": true}
+				},
+				"required": ["name", "ports"]
+			}
+		},
+		"primary": {"$ref": "#/properties/devices/items"}
+	}
+})schema";
+
+} // namespace
+
+TEST(TestValidationMemo, SharedSubtree)
+{
+	auto schema = mk_ptr(mk_schema(device_schema));
+	auto device = mk_ptr(mk_device("eth", 4));
+
+	auto devices = mk_ptr(jarray_create(NULL));
+	for (int i = 0; i < 10; ++i)
+		jarray_append(devices.get(), jvalue_copy(device.get()));
+
+	auto root = mk_ptr(jobject_create());
+	jobject_set(root.get(), J_CSTR_TO_BUF("devices"), jvalue_copy(devices.get()));
+	jobject_set(root.get(), J_CSTR_TO_BUF("primary"), jvalue_copy(device.get()));
+
+	EXPECT_TRUE(jvalue_validate(root.get(), schema.get(), NULL));
+	EXPECT_TRUE(jvalue_validate_dedup(root.get(), schema.get(), NULL));
+
+	// The shared subtree is checked against every validator it meets
+	jobject_set(device.get(), J_CSTR_TO_BUF("ports"), jnumber_create_i32(16));
+	EXPECT_FALSE(jvalue_validate(root.get(), schema.get(), NULL));
+	EXPECT_FALSE(jvalue_validate_dedup(root.get(), schema.get(), NULL));
+
+	jobject_set(device.get(), J_CSTR_TO_BUF("ports"), jnumber_create_i32(2));
+	EXPECT_TRUE(jvalue_validate(root.get(), schema.get(), NULL));
+	jarray_append(devices.get(), mk_device("ETH", 2));
+	EXPECT_FALSE(jvalue_validate(root.get(), schema.get(), NULL));
+	EXPECT_FALSE(jvalue_validate_dedup(root.get(), schema.get(), NULL));
+}
+
+TEST(TestValidationMemo, SharedWithinCombinators)
+{
+	auto schema = mk_ptr(mk_schema(R"schema({
+		"type": "array",
+		"items": {"anyOf": [
+			{"type": "object", "properties": {"a": {"type": "array", "maxItems": 1}}},
+			{"type": "object", "properties": {"a": {"type": "array", "minItems": 3}}}
+		]}
+	})schema"));
+
+	auto shared = mk_ptr(jarray_create_var(NULL, jnumber_create_i32(1), jnumber_create_i32(2), J_END_ARRAY_DECL));
+	auto item = mk_ptr(jobject_create_var(jkeyval(J_CSTR_TO_JVAL("a"), jvalue_copy(shared.get())), J_END_OBJ_DECL));
+
+	auto root = mk_ptr(jarray_create(NULL));
+	jarray_append(root.get(), jvalue_copy(item.get()));
+	jarray_append(root.get(), jvalue_copy(item.get()));
+
+	EXPECT_FALSE(jvalue_validate(root.get(), schema.get(), NULL));
+	EXPECT_FALSE(jvalue_validate_dedup(root.get(), schema.get(), NULL));
+
+	jarray_append(shared.get(), jnumber_create_i32(3));
+	EXPECT_TRUE(jvalue_validate(root.get(), schema.get(), NULL));
+	EXPECT_TRUE(jvalue_validate_dedup(root.get(), schema.get(), NULL));
+}
+
+TEST(TestValidationMemo, StructurallyEqual)
+{
+	auto schema = mk_ptr(mk_schema(device_schema));
+
+	auto valid = mk_ptr(jdom_create(j_cstr_to_buffer(R"json({"devices": [
+		{"name": "eth", "ports": 4, "tags": ["a", "b"]},
+		{"ports": 4, "tags": ["a", "b"], "name": "eth"},
+		{"name": "eth", "ports": 4, "tags": ["a", "b"]}
+	]})json"), jschema_all(), NULL));
+	ASSERT_TRUE(jis_valid(valid.get()));
+	EXPECT_TRUE(jvalue_validate_dedup(valid.get(), schema.get(), NULL));
+
+	char const *invalid[] = {
+		// Different values after equal ones
+		R"json({"devices": [
+			{"name": "eth", "ports": 4, "tags": ["a", "b"]},
+			{"name": "eth", "ports": 4, "tags": ["b", "b"]}
+		]})json",
+		R"json({"devices": [
+			{"name": "eth", "ports": 4},
+			{"name": "eth", "ports": 4.5}
+		]})json",
+		R"json({"devices": [
+			{"name": "eth", "ports": 4},
+			{"name": "eth", "ports": "4"}
+		]})json",
+		R"json({"devices": [
+			{"name": "eth", "ports": 4},
+			{"name": "eth", "ports": 4, "tags": ["a", "a"]}
+		]})json",
+		// Equal value against different validators
+		R"json({"devices": [
+			{"name": "eth", "ports": 4}
+		], "primary": {"name": "eth"}})json",
+	};
+	for (auto json : invalid)
+	{
+		auto v = mk_ptr(jdom_create(j_cstr_to_buffer(json), jschema_all(), NULL));
+		ASSERT_TRUE(jis_valid(v.get())) << json;
+		EXPECT_FALSE(jvalue_validate_dedup(v.get(), schema.get(), NULL)) << json;
+		EXPECT_FALSE(jvalue_validate(v.get(), schema.get(), NULL)) << json;
+	}
+}
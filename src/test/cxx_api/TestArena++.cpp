@@ -0,0 +1,61 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <gtest/gtest.h>
+
+#include <pbnjson.hpp>
+
+using namespace pbnjson;
+
+namespace {
+
+JValue handle(const char *request)
+{
+	Arena arena;
+
+	JValue input = JDomParser::fromString(request);
+	JValue reply = Object();
+	reply.put("echo", input);
+	reply.put("size", input.arraySize());
+	EXPECT_LT(0u, arena.size());
+
+	return arena.copyOut(reply);
+}
+
+} // namespace
+
+TEST(Arena, Request)
+{
+	JValue reply = handle("[1, 2, \"three\"]");
+	EXPECT_TRUE(reply["size"] == 3);
+	EXPECT_EQ("three", reply["echo"][2].asString());
+	EXPECT_TRUE(reply == reply.duplicate());
+}
+
+TEST(Arena, Nested)
+{
+	Arena outer;
+	JValue kept;
+	{
+		Arena inner;
+		JValue value = Array();
+		value.append("inner");
+		kept = inner.copyOut(value);
+		EXPECT_EQ(0u, outer.size());
+	}
+	EXPECT_LT(0u, outer.size());
+	EXPECT_EQ("inner", kept[0].asString());
+}
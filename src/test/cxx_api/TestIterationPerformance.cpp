@@ -0,0 +1,89 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <gtest/gtest.h>
+#include <pbnjson.hpp>
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+using namespace std;
+using namespace pbnjson;
+
+namespace {
+
+const int ROUNDS = 200;
+
+JValue makeRecords()
+{
+	JValue records = Array();
+	for (int i = 0; i < 1000; ++i)
+	{
+		JValue record = Object();
+		record.put("id", i);
+		record.put("name", "record" + to_string(i));
+		record.put("tags", JArray{"a", "b", "c"});
+		records.append(record);
+	}
+	return records;
+}
+
+// Iterators, operator[] and temporaries copy and release the references all the time
+int64_t iterate(const JValue &records)
+{
+	int64_t sum = 0;
+	for (int round = 0; round < ROUNDS; ++round)
+	{
+		for (JValue record : records.items())
+		{
+			sum += record["id"].asNumber<int64_t>();
+			for (JValue::KeyValue member : record.children())
+				sum += member.first.asString().size();
+			sum += record["tags"].arraySize();
+		}
+	}
+	return sum;
+}
+
+double measure(const JValue &records, int64_t &sum)
+{
+	auto start = chrono::steady_clock::now();
+	sum = iterate(records);
+	chrono::duration<double, milli> ms = chrono::steady_clock::now() - start;
+	return ms.count();
+}
+
+} // namespace
+
+TEST(IterationPerformance, OwnerAndOtherThread)
+{
+	JValue records = makeRecords();
+
+	int64_t owner_sum = 0, other_sum = 0;
+	double owner = measure(records, owner_sum);
+
+	// References of other threads are counted atomically
+	double other = 0;
+	thread([&]() { other = measure(records, other_sum); }).join();
+
+	EXPECT_EQ(owner_sum, other_sum);
+
+	cout << "Iteration over 1000 records " << ROUNDS << " times, smaller is better." << endl;
+	cout << left << setw(14) << "owner thread" << " ms: " << fixed << setprecision(1) << owner << endl;
+	cout << left << setw(14) << "other thread" << " ms: " << fixed << setprecision(1) << other << endl;
+}
@@ -663,3 +663,23 @@ TEST(TestJValue, NumberEquality)
 	EXPECT_EQ( a, b );
 	EXPECT_EQ( b, a );
 }
+
+TEST(TestJValue, ObjectFromArrays)
+{
+	std::vector<JValue> keys { "id", "name", "tags" };
+
+	for (int i = 0; i < 3; ++i)
+	{
+		JObject row(keys, { i, "row", JArray { i } });
+		ASSERT_TRUE(row.isObject());
+		EXPECT_EQ(3, row.objectSize());
+		EXPECT_EQ(i, row["id"].asNumber<int32_t>());
+		EXPECT_EQ("row", row["name"].asString());
+		EXPECT_EQ(JArray { i }, row["tags"]);
+	}
+
+	EXPECT_TRUE(JObject(std::vector<JValue>{}, std::vector<JValue>{}).isObject());
+	EXPECT_FALSE(JObject(keys, { 1, 2 }).isValid());
+	EXPECT_FALSE(JObject({ "a", "a" }, { 1, 2 }).isValid());
+	EXPECT_FALSE(JObject({ "a", 1 }, { 1, 2 }).isValid());
+}
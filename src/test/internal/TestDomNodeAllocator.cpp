@@ -0,0 +1,133 @@
+// Copyright (c) 2018 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "pbnjson.hpp"
+#include "src/pbnjson_c/dom_node_allocator.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace pbnjson;
+
+namespace {
+	bool isZeroed(const void *mem, size_t size)
+	{
+		const char *p = static_cast<const char *>(mem);
+		for (size_t i = 0; i < size; ++i)
+			if (p[i]) return false;
+		return true;
+	}
+}
+
+TEST(DomNodeAllocator, AllocZeroed)
+{
+	for (size_t size = 1; size <= DOM_NODE_MAX_SIZE + 64; ++size)
+	{
+		void *mem = dom_node_alloc(size);
+		ASSERT_NE(nullptr, mem);
+		memset(mem, 0xa5, size);
+		dom_node_free(size, mem);
+
+		mem = dom_node_alloc0(size);
+		ASSERT_NE(nullptr, mem);
+		EXPECT_TRUE(isZeroed(mem, size)) << "size " << size;
+		dom_node_free(size, mem);
+	}
+
+	dom_node_free(64, nullptr);
+}
+
+TEST(DomNodeAllocator, DistinctBlocks)
+{
+	const size_t count = 10000;
+	const size_t size = 56;
+
+	std::vector<void *> blocks;
+	std::set<void *> unique;
+	for (size_t i = 0; i < count; ++i)
+	{
+		void *mem = dom_node_alloc(size);
+		ASSERT_NE(nullptr, mem);
+		memset(mem, int(i), size);
+		blocks.push_back(mem);
+		unique.insert(mem);
+	}
+	EXPECT_EQ(count, unique.size());
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		const char *p = static_cast<const char *>(blocks[i]);
+		for (size_t j = 0; j < size; ++j)
+			ASSERT_EQ(char(i), p[j]);
+	}
+
+	for (auto mem : blocks)
+		dom_node_free(size, mem);
+}
+
+#if !DOM_NODE_USE_MALLOC
+TEST(DomNodeAllocator, ReuseReleased)
+{
+	void *mem = dom_node_alloc(48);
+	dom_node_free(48, mem);
+	EXPECT_EQ(mem, dom_node_alloc(48));
+	dom_node_free(48, mem);
+}
+#endif
+
+TEST(DomNodeAllocator, CrossThreadRelease)
+{
+	const size_t count = 100000;
+
+	for (int round = 0; round < 10; ++round)
+	{
+		std::vector<void *> blocks(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			blocks[i] = dom_node_alloc0(32 + i % 200);
+			ASSERT_NE(nullptr, blocks[i]);
+		}
+
+		std::thread releaser([&]()
+			{
+				for (size_t i = 0; i < count; ++i)
+					dom_node_free(32 + i % 200, blocks[i]);
+			});
+		releaser.join();
+	}
+}
+
+TEST(DomNodeAllocator, CrossThreadDom)
+{
+	std::vector<JValue> values;
+	for (int i = 0; i < 1000; ++i)
+		values.push_back(JObject{{"number", i}, {"string", std::string(i % 300, 'x')}, {"array", JArray{1, "two", 3.0}}});
+
+	std::thread releaser([&]() { values.clear(); });
+	releaser.join();
+
+	// Nodes are reusable by this thread after the other one exits
+	for (int i = 0; i < 1000; ++i)
+	{
+		JValue v = JObject{{"number", i}, {"string", std::string(i % 300, 'y')}};
+		ASSERT_EQ(i, v["number"].asNumber<int32_t>());
+		ASSERT_EQ(std::string(i % 300, 'y'), v["string"].asString());
+	}
+}